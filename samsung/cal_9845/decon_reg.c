@@ -696,6 +696,15 @@ static void dsc_reg_set_pps_06_07_picture_height(u32 id, u32 dsc_id, u32 height)
 	dsc_write_mask(id, DSC_PPS04_07(dsc_id), val, mask);
 }
 
+static void dsc_reg_set_pps_08_09_picture_width(u32 id, u32 dsc_id, u32 width)
+{
+	u32 val, mask;
+
+	val = PPS08_09_PIC_WIDTH(width);
+	mask = PPS08_09_PIC_WIDTH_MASK;
+	dsc_write_mask(id, DSC_PPS08_11(dsc_id), val, mask);
+}
+
 static void dsc_reg_set_pps_58_59_rc_range_param0(u32 id, u32 dsc_id, u32 rc_range)
 {
 	u32 val, mask;
@@ -1289,18 +1298,19 @@ static u32 dsc_cmp_pps_enc_dec(u32 id, struct decon_dsc *p_enc,
 }
 
 static void dsc_reg_set_partial_update(u32 id, u32 dsc_id, u32 dual_slice_en,
-	u32 slice_mode_ch, u32 pic_h)
+	u32 slice_mode_ch, u32 pic_w, u32 pic_h)
 {
 	/*
 	 * Following SFRs must be considered
 	 * - dual_slice_en
 	 * - slice_mode_change
 	 * - picture_height
-	 * - picture_width (don't care @KC) : decided by DSI (-> dual: /2)
+	 * - picture_width : width of the slices fed to this encoder
 	 */
 	dsc_reg_set_dual_slice(id, dsc_id, dual_slice_en);
 	dsc_reg_set_slice_mode_change(id, dsc_id, slice_mode_ch);
 	dsc_reg_set_pps_06_07_picture_height(id, dsc_id, pic_h);
+	dsc_reg_set_pps_08_09_picture_width(id, dsc_id, pic_w);
 }
 
 /*
@@ -2123,16 +2133,19 @@ void decon_reg_set_partial_update(u32 id, struct decon_config *config,
 			partial_w, partial_h);
 
 	if (config->dsc.enabled) {
+		/* each encoder is fed the same number of slices */
+		const u32 pic_w = partial_w / config->dsc.dsc_count;
+
 		/* get correct DSC configuration */
 		dsc_get_partial_update_info(id, config->dsc.slice_count,
 				config->dsc.dsc_count, in_slice,
 				dual_slice_en, slice_mode_ch);
 		/* To support dual-display : DECON1 have to set DSC1 */
 		dsc_reg_set_partial_update(id, id, dual_slice_en[0],
-				slice_mode_ch[0], partial_h);
+				slice_mode_ch[0], pic_w, partial_h);
 		if (config->dsc.dsc_count == 2)
 			dsc_reg_set_partial_update(id, 1, dual_slice_en[1],
-					slice_mode_ch[1], partial_h);
+					slice_mode_ch[1], pic_w, partial_h);
 
 		decon_reg_update_req_compress(id);
 	}
@@ -2458,3 +2471,7 @@ void decon_reg_set_drm_write_protected(u32 id, bool protected)
 {
 	cal_set_write_protected(sub_regs_desc(id), protected);
 }
+
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_KUNIT_TEST)
+#include "decon_reg_test.c"
+#endif
@@ -0,0 +1,271 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * cal_9845/decon_reg_test.c
+ *
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *		http://www.samsung.com
+ *
+ * KUnit tests for DECON commit programming, included from decon_reg.c. The
+ * register blocks of DECON0 are driven through the fake register backend, so
+ * the tests never reach the hardware.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <kunit/test.h>
+#include <cal_regs_record.h>
+
+#define DECON_TEST_ID		0
+
+/* register blocks of a DECON touched by a commit, each recorded on its own */
+enum decon_test_block {
+	DECON_TEST_MAIN,
+	DECON_TEST_WIN,
+	DECON_TEST_WINCON,
+	DECON_TEST_SUB,
+	DECON_TEST_BLOCK_MAX,
+};
+
+static const struct {
+	enum decon_regs_type type;
+	size_t size;
+} decon_test_blocks[DECON_TEST_BLOCK_MAX] = {
+	[DECON_TEST_MAIN] = { REGS_DECON, SZ_4K },
+	[DECON_TEST_WIN] = { REGS_DECON_WIN, SZ_32K },
+	[DECON_TEST_WINCON] = { REGS_DECON_WINCON, SZ_32K },
+	[DECON_TEST_SUB] = { REGS_DECON_SUB, SZ_8K },
+};
+
+struct decon_test {
+	struct device *dev;
+	struct cal_regs_recorder *rec[DECON_TEST_BLOCK_MAX];
+};
+
+static struct cal_regs_desc *decon_test_desc(enum decon_test_block block)
+{
+	return &regs_decon[decon_test_blocks[block].type][DECON_TEST_ID];
+}
+
+static int decon_test_init(struct kunit *test)
+{
+	struct decon_test *t;
+	int i;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t);
+
+	t->dev = root_device_register("decon_reg_test");
+	KUNIT_ASSERT_FALSE(test, IS_ERR(t->dev));
+
+	for (i = 0; i < DECON_TEST_BLOCK_MAX; i++) {
+		t->rec[i] = cal_regs_recorder_create(t->dev, decon_test_blocks[i].size, 0,
+				false);
+		KUNIT_ASSERT_NOT_NULL(test, t->rec[i]);
+		cal_regs_recorder_attach(t->rec[i], decon_test_desc(i));
+	}
+	test->priv = t;
+
+	return 0;
+}
+
+static void decon_test_exit(struct kunit *test)
+{
+	struct decon_test *t = test->priv;
+	int i;
+
+	for (i = 0; i < DECON_TEST_BLOCK_MAX; i++)
+		cal_regs_recorder_detach(decon_test_desc(i));
+	root_device_unregister(t->dev);
+}
+
+static u32 decon_test_commit(enum decon_test_block block)
+{
+	return cal_regs_recorder_commit(decon_test_desc(block));
+}
+
+static void decon_test_window(struct decon_window_regs *regs, int win)
+{
+	memset(regs, 0, sizeof(*regs));
+	regs->start_pos = WIN_STRPTR_Y_F(win * 100) | WIN_STRPTR_X_F(win * 10);
+	regs->end_pos = WIN_ENDPTR_Y_F(win * 100 + 99) | WIN_ENDPTR_X_F(1079);
+	regs->colormap = 0xff102030;
+	regs->start_time = win;
+	regs->ch = win;
+	regs->plane_alpha = 0xff;
+	regs->blend = DECON_BLENDING_PREMULT;
+	regs->in_bpc = 8;
+}
+
+/*
+ * Every enabled window costs the same fixed set of writes, split between the window and
+ * the window control blocks, and the update request is a single write plus the trigger
+ * unmask in command mode.
+ */
+static void decon_test_window_commit(struct kunit *test)
+{
+	struct decon_mode mode = {
+		.op_mode = DECON_COMMAND_MODE,
+		.trig_mode = DECON_SW_TRIG,
+	};
+	struct decon_window_regs regs;
+	const int win_cnt = 3;
+	int win;
+
+	for (win = 0; win < win_cnt; win++) {
+		decon_test_window(&regs, win);
+		decon_reg_set_window_control(DECON_TEST_ID, win, &regs, win == 0);
+	}
+	decon_reg_update_req_and_unmask(DECON_TEST_ID, &mode);
+
+	/* blending 4, positions and start time 3, colormap 2 */
+	KUNIT_EXPECT_EQ(test, decon_test_commit(DECON_TEST_WIN), win_cnt * 9);
+	/* colormap enable, channel, window enable */
+	KUNIT_EXPECT_EQ(test, decon_test_commit(DECON_TEST_WINCON), win_cnt * 3);
+	KUNIT_EXPECT_EQ(test, decon_test_commit(DECON_TEST_MAIN), 2);
+	KUNIT_EXPECT_EQ(test, decon_test_commit(DECON_TEST_SUB), 0);
+
+	for (win = 0; win < win_cnt; win++) {
+		u32 con = wincon_read(DECON_TEST_ID, DECON_CON_WIN(win));
+
+		decon_test_window(&regs, win);
+		KUNIT_EXPECT_EQ(test, win_read(DECON_TEST_ID, WIN_START_POSITION(win)),
+				regs.start_pos);
+		KUNIT_EXPECT_EQ(test, win_read(DECON_TEST_ID, WIN_END_POSITION(win)),
+				regs.end_pos);
+		KUNIT_EXPECT_EQ(test, win_read(DECON_TEST_ID, WIN_START_TIME_CON(win)),
+				regs.start_time);
+		KUNIT_EXPECT_EQ(test, con & WIN_CHMAP_MASK, WIN_CHMAP_F(win));
+		KUNIT_EXPECT_TRUE(test, con & _WIN_EN_F);
+		KUNIT_EXPECT_EQ(test, !!(con & WIN_MAPCOLOR_EN_F), win == 0);
+	}
+
+	KUNIT_EXPECT_EQ(test, decon_read(DECON_TEST_ID, SHD_REG_UP_REQ),
+			SHD_REG_UP_REQ_GLOBAL | SHD_REG_UP_REQ_CMP);
+	KUNIT_EXPECT_EQ(test, decon_read_mask(DECON_TEST_ID, TRIG_CON,
+			SW_TRIG_EN | SW_TRIG_DET_EN), SW_TRIG_EN | SW_TRIG_DET_EN);
+
+	/* video mode runs off its own timing, nothing to unmask */
+	mode.op_mode = DECON_VIDEO_MODE;
+	decon_reg_update_req_and_unmask(DECON_TEST_ID, &mode);
+	KUNIT_EXPECT_EQ(test, decon_test_commit(DECON_TEST_MAIN), 1);
+}
+
+/* disabling a window flips its enable bit and leaves the rest of its setup alone */
+static void decon_test_window_disable(struct kunit *test)
+{
+	struct decon_window_regs regs;
+	u32 con;
+
+	decon_test_window(&regs, 2);
+	decon_reg_set_window_control(DECON_TEST_ID, 2, &regs, false);
+	decon_test_commit(DECON_TEST_WIN);
+	decon_test_commit(DECON_TEST_WINCON);
+
+	decon_reg_set_win_enable(DECON_TEST_ID, 2, 0);
+	KUNIT_EXPECT_EQ(test, decon_test_commit(DECON_TEST_WINCON), 1);
+	KUNIT_EXPECT_EQ(test, decon_test_commit(DECON_TEST_WIN), 0);
+
+	con = wincon_read(DECON_TEST_ID, DECON_CON_WIN(2));
+	KUNIT_EXPECT_FALSE(test, con & _WIN_EN_F);
+	KUNIT_EXPECT_EQ(test, con & WIN_CHMAP_MASK, WIN_CHMAP_F(2));
+}
+
+struct decon_test_partial {
+	u32 dsc_cnt;
+	u32 slice_cnt;
+	bool in_slice[4];
+	/* expected dual slice enable and slice mode change of the first encoder */
+	u32 dual_slice;
+	u32 slice_mode_ch;
+};
+
+static const struct decon_test_partial decon_test_partials[] = {
+	{ 2, 4, { 0, 1, 1, 0 }, 0, 1 },
+	{ 2, 4, { 1, 1, 1, 1 }, 1, 0 },
+	{ 2, 2, { 1, 1 }, 0, 1 },
+	{ 1, 2, { 1, 1 }, 1, 0 },
+	{ 1, 1, { 1 }, 0, 0 },
+};
+
+/*
+ * Partial update with DSC: every encoder gets the width of the slices it is fed, the
+ * slice mode follows the updated slices and the DECON output is sized to match.
+ */
+static void decon_test_partial_dsc(struct kunit *test)
+{
+	const u32 slice_w = 540, slice_h = 40, partial_h = 400;
+	struct decon_config config = { 0 };
+	int i;
+
+	config.mode.op_mode = DECON_COMMAND_MODE;
+	config.mode.dsi_mode = DSI_MODE_SINGLE;
+	config.dsc.enabled = true;
+	config.dsc.slice_width = slice_w;
+	config.dsc.slice_height = slice_h;
+
+	for (i = 0; i < ARRAY_SIZE(decon_test_partials); i++) {
+		const struct decon_test_partial *p = &decon_test_partials[i];
+		bool in_slice[4];
+		u32 partial_w = 0, enc, ctl, comp_w, of_size, n;
+
+		config.dsc.dsc_count = p->dsc_cnt;
+		config.dsc.slice_count = p->slice_cnt;
+		for (n = 0; n < p->slice_cnt; n++)
+			partial_w += p->in_slice[n] * slice_w;
+		memcpy(in_slice, p->in_slice, sizeof(in_slice));
+
+		decon_reg_set_partial_update(DECON_TEST_ID, &config, in_slice, partial_w,
+				partial_h);
+
+		KUNIT_EXPECT_EQ_MSG(test, decon_test_commit(DECON_TEST_SUB), 4 * p->dsc_cnt,
+				"case %d", i);
+		/* background, compressor update request, OUTFIFO */
+		KUNIT_EXPECT_EQ_MSG(test, decon_test_commit(DECON_TEST_MAIN),
+				1 + 1 + 2 + (p->dsc_cnt == 2) + 1, "case %d", i);
+
+		for (enc = 0; enc < p->dsc_cnt; enc++) {
+			KUNIT_EXPECT_EQ_MSG(test, dsc_read_mask(DECON_TEST_ID,
+					DSC_PPS08_11(enc), PPS08_09_PIC_WIDTH_MASK),
+					PPS08_09_PIC_WIDTH(partial_w / p->dsc_cnt),
+					"case %d encoder %u", i, enc);
+			KUNIT_EXPECT_EQ_MSG(test, dsc_read_mask(DECON_TEST_ID,
+					DSC_PPS04_07(enc), PPS06_07_PIC_HEIGHT_MASK),
+					PPS06_07_PIC_HEIGHT(partial_h),
+					"case %d encoder %u", i, enc);
+		}
+
+		ctl = dsc_read(DECON_TEST_ID, DSC_CONTROL_1(0));
+		KUNIT_EXPECT_EQ_MSG(test, ctl & DSC_DUAL_SLICE_EN_MASK,
+				DSC_DUAL_SLICE_EN_F(p->dual_slice), "case %d", i);
+		KUNIT_EXPECT_EQ_MSG(test, ctl & DSC_SLICE_MODE_CH_MASK,
+				DSC_SLICE_MODE_CH_F(p->slice_mode_ch), "case %d", i);
+
+		comp_w = DIV_ROUND_UP(slice_w, 3);
+		of_size = decon_read(DECON_TEST_ID, OF_SIZE_0);
+		KUNIT_EXPECT_EQ_MSG(test, OUTFIFO_WIDTH_GET(of_size),
+				ALIGN(comp_w << p->dual_slice, 4), "case %d", i);
+		KUNIT_EXPECT_EQ_MSG(test, OUTFIFO_HEIGHT_GET(of_size), partial_h,
+				"case %d", i);
+		KUNIT_EXPECT_EQ_MSG(test, decon_read(DECON_TEST_ID, BLD_BG_IMG_SIZE_PRI),
+				BLENDER_BG_HEIGHT_F(partial_h) | BLENDER_BG_WIDTH_F(partial_w),
+				"case %d", i);
+	}
+}
+
+static struct kunit_case decon_test_cases[] = {
+	KUNIT_CASE(decon_test_window_commit),
+	KUNIT_CASE(decon_test_window_disable),
+	KUNIT_CASE(decon_test_partial_dsc),
+	{}
+};
+
+static struct kunit_suite decon_test_suite = {
+	.name = "exynos-drm-decon-reg",
+	.init = decon_test_init,
+	.exit = decon_test_exit,
+	.test_cases = decon_test_cases,
+};
+
+kunit_test_suite(decon_test_suite);
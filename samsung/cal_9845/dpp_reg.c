@@ -22,7 +22,6 @@
 #include <linux/iopoll.h>
 
 #include <exynos_dpp_coef.h>
-#include <exynos_hdr_lut.h>
 #include <dpp_cal.h>
 #include <hdr_cal.h>
 
@@ -548,56 +547,95 @@ dpp_reg_set_csc_params(u32 id, u32 std, u32 range, const unsigned long attr)
 		dpp_reg_set_csc_coef(id, std, range, attr);
 }
 
+/*
+ * Scaler coefficients only depend on which of the 7 ratio classes a ratio falls
+ * in, so a bank is rewritten only when its class changes. The last class of each
+ * bank is kept per DPP and dropped whenever the DPP is (re)initialized.
+ */
+#define DPP_SC_CLASS_NONE	(-1)
+#define DPP_H_COEF_CNT		(9 * 8)
+#define DPP_V_COEF_CNT		(9 * 4)
+
+struct dpp_scl_coef_cache {
+	int h_class;
+	int v_class;
+};
+
+static struct dpp_scl_coef_cache dpp_coef_cache[REGS_DPP_ID_MAX] = {
+	[0 ... REGS_DPP_ID_MAX - 1] = {
+		.h_class = DPP_SC_CLASS_NONE,
+		.v_class = DPP_SC_CLASS_NONE,
+	},
+};
+
+static void dpp_reg_coef_cache_invalidate(u32 id)
+{
+	dpp_coef_cache[id].h_class = DPP_SC_CLASS_NONE;
+	dpp_coef_cache[id].v_class = DPP_SC_CLASS_NONE;
+}
+
+static int dpp_get_sc_class(u32 ratio)
+{
+	if (ratio <= DPP_SC_RATIO_MAX)
+		return 0;
+	else if (ratio <= DPP_SC_RATIO_7_8)
+		return 1;
+	else if (ratio <= DPP_SC_RATIO_6_8)
+		return 2;
+	else if (ratio <= DPP_SC_RATIO_5_8)
+		return 3;
+	else if (ratio <= DPP_SC_RATIO_4_8)
+		return 4;
+	else if (ratio <= DPP_SC_RATIO_3_8)
+		return 5;
+	else
+		return 6;
+}
+
+/*
+ * Within one Y or C bank, coefficient (n, s) is at register s * 9 + n, so each
+ * bank is written as one run of consecutive registers.
+ */
 static void dpp_reg_set_h_coef(u32 id, u32 h_ratio)
 {
+	u32 img[DPP_H_COEF_CNT];
 	int i, j, k, sc_ratio;
 
-	if (h_ratio <= DPP_SC_RATIO_MAX)
-		sc_ratio = 0;
-	else if (h_ratio <= DPP_SC_RATIO_7_8)
-		sc_ratio = 1;
-	else if (h_ratio <= DPP_SC_RATIO_6_8)
-		sc_ratio = 2;
-	else if (h_ratio <= DPP_SC_RATIO_5_8)
-		sc_ratio = 3;
-	else if (h_ratio <= DPP_SC_RATIO_4_8)
-		sc_ratio = 4;
-	else if (h_ratio <= DPP_SC_RATIO_3_8)
-		sc_ratio = 5;
-	else
-		sc_ratio = 6;
+	sc_ratio = dpp_get_sc_class(h_ratio);
+	if (dpp_coef_cache[id].h_class == sc_ratio)
+		return;
 
 	for (i = 0; i < 9; i++)
 		for (j = 0; j < 8; j++)
-			for (k = 0; k < 2; k++)
-				dpp_write(id, DPP_H_COEF(i, j, k),
-						h_coef_8t[sc_ratio][i][j]);
+			img[j * 9 + i] = h_coef_8t[sc_ratio][i][j];
+
+	for (k = 0; k < 2; k++)
+		cal_write_seq(dpp_regs_desc(id), DPP_H_COEF(0, 0, k), img,
+				DPP_H_COEF_CNT);
+
+	dpp_coef_cache[id].h_class = sc_ratio;
+	cal_log_debug(id, "h_coef class %d\n", sc_ratio);
 }
 
 static void dpp_reg_set_v_coef(u32 id, u32 v_ratio)
 {
+	u32 img[DPP_V_COEF_CNT];
 	int i, j, k, sc_ratio;
 
-	if (v_ratio <= DPP_SC_RATIO_MAX)
-		sc_ratio = 0;
-	else if (v_ratio <= DPP_SC_RATIO_7_8)
-		sc_ratio = 1;
-	else if (v_ratio <= DPP_SC_RATIO_6_8)
-		sc_ratio = 2;
-	else if (v_ratio <= DPP_SC_RATIO_5_8)
-		sc_ratio = 3;
-	else if (v_ratio <= DPP_SC_RATIO_4_8)
-		sc_ratio = 4;
-	else if (v_ratio <= DPP_SC_RATIO_3_8)
-		sc_ratio = 5;
-	else
-		sc_ratio = 6;
+	sc_ratio = dpp_get_sc_class(v_ratio);
+	if (dpp_coef_cache[id].v_class == sc_ratio)
+		return;
 
 	for (i = 0; i < 9; i++)
 		for (j = 0; j < 4; j++)
-			for (k = 0; k < 2; k++)
-				dpp_write(id, DPP_V_COEF(i, j, k),
-						v_coef_4t[sc_ratio][i][j]);
+			img[j * 9 + i] = v_coef_4t[sc_ratio][i][j];
+
+	for (k = 0; k < 2; k++)
+		cal_write_seq(dpp_regs_desc(id), DPP_V_COEF(0, 0, k), img,
+				DPP_V_COEF_CNT);
+
+	dpp_coef_cache[id].v_class = sc_ratio;
+	cal_log_debug(id, "v_coef class %d\n", sc_ratio);
 }
 
 static void dpp_reg_set_scale_ratio(u32 id, struct dpp_params_info *p)
@@ -607,20 +645,39 @@ static void dpp_reg_set_scale_ratio(u32 id, struct dpp_params_info *p)
 	prev_h_ratio = dpp_read_mask(id, DPP_SCL_MAIN_H_RATIO, DPP_H_RATIO_MASK);
 	prev_v_ratio = dpp_read_mask(id, DPP_SCL_MAIN_V_RATIO, DPP_V_RATIO_MASK);
 
-	if (prev_h_ratio != p->h_ratio) {
+	if (prev_h_ratio != p->h_ratio)
 		dpp_write(id, DPP_SCL_MAIN_H_RATIO, DPP_H_RATIO(p->h_ratio));
-		dpp_reg_set_h_coef(id, p->h_ratio);
-	}
+	dpp_reg_set_h_coef(id, p->h_ratio);
 
-	if (prev_v_ratio != p->v_ratio) {
+	if (prev_v_ratio != p->v_ratio)
 		dpp_write(id, DPP_SCL_MAIN_V_RATIO, DPP_V_RATIO(p->v_ratio));
-		dpp_reg_set_v_coef(id, p->v_ratio);
-	}
+	dpp_reg_set_v_coef(id, p->v_ratio);
 
 	cal_log_debug(id, "h_ratio : %#x, v_ratio : %#x\n",
 			p->h_ratio, p->v_ratio);
 }
 
+static void dpp_reg_set_scale_pos_one(u32 id, u32 reg, u32 pos)
+{
+	if (dpp_read(id, reg) != pos)
+		dpp_write(id, reg, pos);
+}
+
+/* initial scaler phase, non-zero only if partial update fetches a part of the plane */
+static void dpp_reg_set_scale_pos(u32 id, struct dpp_params_info *p,
+		const struct dpu_fmt *fmt)
+{
+	const u32 c_h_pos = p->h_pos >> fmt->hsub_shift;
+	const u32 c_v_pos = p->v_pos >> fmt->vsub_shift;
+
+	dpp_reg_set_scale_pos_one(id, DPP_SCL_YHPOSITION, p->h_pos);
+	dpp_reg_set_scale_pos_one(id, DPP_SCL_YVPOSITION, p->v_pos);
+	dpp_reg_set_scale_pos_one(id, DPP_SCL_CHPOSITION, c_h_pos);
+	dpp_reg_set_scale_pos_one(id, DPP_SCL_CVPOSITION, c_v_pos);
+
+	cal_log_debug(id, "h_pos : %#x, v_pos : %#x\n", p->h_pos, p->v_pos);
+}
+
 static void dpp_reg_set_img_size(u32 id, u32 w, u32 h)
 {
 	dpp_write(id, DPP_COM_IMG_SIZE, DPP_IMG_HEIGHT(h) | DPP_IMG_WIDTH(w));
@@ -824,6 +881,7 @@ void dpp_reg_init(u32 id, const unsigned long attr)
 	}
 
 	if (test_bit(DPP_ATTR_DPP, &attr)) {
+		dpp_reg_coef_cache_invalidate(id);
 		dpp_reg_set_irq_mask_all(id, 0);
 		dpp_reg_set_irq_enable(id);
 		dpp_reg_set_linecnt(id, 1);
@@ -919,8 +977,10 @@ void dpp_reg_configure_params(u32 id, struct dpp_params_info *p,
 	if (test_bit(DPP_ATTR_CSC, &attr) && IS_YUV(fmt))
 		dpp_reg_set_csc_params(id, p->standard, p->range, attr);
 
-	if (test_bit(DPP_ATTR_SCALE, &attr))
+	if (test_bit(DPP_ATTR_SCALE, &attr)) {
 		dpp_reg_set_scale_ratio(id, p);
+		dpp_reg_set_scale_pos(id, p, fmt);
+	}
 
 	/* configure coordinates and size of IDMA, DPP, ODMA and WB MUX */
 	dma_dpp_reg_set_coordinates(id, p, attr);
@@ -1209,3 +1269,7 @@ int __dpp_check(u32 id, const struct dpp_params_info *p, unsigned long attr)
 
 	return 0;
 }
+
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_KUNIT_TEST)
+#include "dpp_reg_test.c"
+#endif
@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * cal_9845/dpp_reg_test.c
+ *
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *		http://www.samsung.com
+ *
+ * KUnit tests for DPP scaler programming, included from dpp_reg.c. DPP0 is
+ * driven through the fake register backend, so the tests never reach the
+ * hardware.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <kunit/test.h>
+#include <cal_regs_record.h>
+
+#define DPP_TEST_ID		0
+#define DPP_TEST_REGS_SIZE	SZ_2K
+
+struct dpp_test {
+	struct device *dev;
+	struct cal_regs_recorder *rec;
+	int h_class;
+	int v_class;
+	u32 h_ratio;
+	u32 v_ratio;
+	u32 bank_writes;
+};
+
+static int dpp_test_init(struct kunit *test)
+{
+	struct dpp_test *t;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t);
+
+	t->dev = root_device_register("dpp_reg_test");
+	KUNIT_ASSERT_FALSE(test, IS_ERR(t->dev));
+
+	t->rec = cal_regs_recorder_create(t->dev, DPP_TEST_REGS_SIZE, 0, false);
+	KUNIT_ASSERT_NOT_NULL(test, t->rec);
+
+	cal_regs_recorder_attach(t->rec, dpp_regs_desc(DPP_TEST_ID));
+	dpp_reg_coef_cache_invalidate(DPP_TEST_ID);
+	t->h_class = DPP_SC_CLASS_NONE;
+	t->v_class = DPP_SC_CLASS_NONE;
+	test->priv = t;
+
+	return 0;
+}
+
+static void dpp_test_exit(struct kunit *test)
+{
+	struct dpp_test *t = test->priv;
+
+	cal_regs_recorder_detach(dpp_regs_desc(DPP_TEST_ID));
+	/* the hardware doesn't hold what the cache says anymore */
+	dpp_reg_coef_cache_invalidate(DPP_TEST_ID);
+	root_device_unregister(t->dev);
+}
+
+static void dpp_test_expect_banks(struct kunit *test, int h_class, int v_class)
+{
+	int n, s, k;
+
+	for (k = 0; k < 2; k++) {
+		for (n = 0; n < 9; n++) {
+			for (s = 0; s < 8; s++)
+				KUNIT_EXPECT_EQ(test, dpp_read(DPP_TEST_ID,
+							DPP_H_COEF(n, s, k)),
+						(u32)h_coef_8t[h_class][n][s]);
+			for (s = 0; s < 4; s++)
+				KUNIT_EXPECT_EQ(test, dpp_read(DPP_TEST_ID,
+							DPP_V_COEF(n, s, k)),
+						(u32)v_coef_4t[v_class][n][s]);
+		}
+	}
+}
+
+/*
+ * Commits @src scaled into @dst and checks that only changed ratios and banks of a
+ * changed class were written, and that the banks hold the coefficients of the class.
+ */
+static void dpp_test_commit(struct kunit *test, u32 src_w, u32 src_h, u32 dst_w,
+		u32 dst_h)
+{
+	struct dpp_test *t = test->priv;
+	struct dpp_params_info p = { 0 };
+	int h_class, v_class;
+	u32 expected = 0, writes;
+
+	p.h_ratio = mult_frac(1 << 20, src_w, dst_w);
+	p.v_ratio = mult_frac(1 << 20, src_h, dst_h);
+	h_class = dpp_get_sc_class(p.h_ratio);
+	v_class = dpp_get_sc_class(p.v_ratio);
+
+	if (p.h_ratio != t->h_ratio)
+		expected++;
+	if (p.v_ratio != t->v_ratio)
+		expected++;
+	if (h_class != t->h_class) {
+		expected += 2 * DPP_H_COEF_CNT;
+		t->bank_writes++;
+	}
+	if (v_class != t->v_class) {
+		expected += 2 * DPP_V_COEF_CNT;
+		t->bank_writes++;
+	}
+
+	dpp_reg_set_scale_ratio(DPP_TEST_ID, &p);
+	writes = cal_regs_recorder_commit(dpp_regs_desc(DPP_TEST_ID));
+	KUNIT_EXPECT_EQ_MSG(test, writes, expected, "%ux%u -> %ux%u", src_w, src_h,
+			dst_w, dst_h);
+
+	KUNIT_EXPECT_EQ(test, dpp_read(DPP_TEST_ID, DPP_SCL_MAIN_H_RATIO), p.h_ratio);
+	KUNIT_EXPECT_EQ(test, dpp_read(DPP_TEST_ID, DPP_SCL_MAIN_V_RATIO), p.v_ratio);
+	if (h_class != t->h_class || v_class != t->v_class)
+		dpp_test_expect_banks(test, h_class, v_class);
+
+	t->h_ratio = p.h_ratio;
+	t->v_ratio = p.v_ratio;
+	t->h_class = h_class;
+	t->v_class = v_class;
+}
+
+/* a pinch zoom from 2x up to 8x down and back, one commit per step */
+static void dpp_test_zoom_sweep(struct kunit *test)
+{
+	struct dpp_test *t = test->priv;
+	const u32 src_w = 1080, src_h = 1920;
+	u32 dst_w, frames = 0;
+
+	for (dst_w = 2160; dst_w >= 135; dst_w -= 15, frames++)
+		dpp_test_commit(test, src_w, src_h, dst_w, dst_w * src_h / src_w);
+	for (dst_w = 135; dst_w <= 2160; dst_w += 15, frames++)
+		dpp_test_commit(test, src_w, src_h, dst_w, dst_w * src_h / src_w);
+
+	/* each axis crosses all 7 classes down and back up */
+	KUNIT_EXPECT_EQ(test, t->bank_writes, 2 * (1 + 6 + 6));
+	/* rewriting both banks every commit would be 3 * 72 writes per frame */
+	KUNIT_EXPECT_LT(test, t->rec->total_writes,
+			(u64)frames * 2 * (DPP_H_COEF_CNT + DPP_V_COEF_CNT) / 4);
+}
+
+/* panning at a fixed ratio writes nothing after the first commit */
+static void dpp_test_pan(struct kunit *test)
+{
+	struct dpp_test *t = test->priv;
+	int i;
+
+	dpp_test_commit(test, 720, 1280, 1080, 1920);
+	for (i = 0; i < 60; i++) {
+		dpp_test_commit(test, 720, 1280, 1080, 1920);
+		KUNIT_EXPECT_EQ(test, t->rec->last_commit_writes, 0);
+	}
+}
+
+/* a freshly reset DPP gets its banks back even if the ratio register matches */
+static void dpp_test_reinit(struct kunit *test)
+{
+	struct dpp_test *t = test->priv;
+
+	dpp_test_commit(test, 1080, 1920, 540, 960);
+	dpp_reg_coef_cache_invalidate(DPP_TEST_ID);
+	t->h_class = DPP_SC_CLASS_NONE;
+	t->v_class = DPP_SC_CLASS_NONE;
+	dpp_test_commit(test, 1080, 1920, 540, 960);
+	KUNIT_EXPECT_EQ(test, t->rec->last_commit_writes,
+			2 * (DPP_H_COEF_CNT + DPP_V_COEF_CNT));
+}
+
+static struct kunit_case dpp_test_cases[] = {
+	KUNIT_CASE(dpp_test_zoom_sweep),
+	KUNIT_CASE(dpp_test_pan),
+	KUNIT_CASE(dpp_test_reinit),
+	{}
+};
+
+static struct kunit_suite dpp_test_suite = {
+	.name = "exynos-drm-dpp-reg",
+	.init = dpp_test_init,
+	.exit = dpp_test_exit,
+	.test_cases = dpp_test_cases,
+};
+
+kunit_test_suite(dpp_test_suite);
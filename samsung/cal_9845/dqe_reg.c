@@ -12,6 +12,7 @@
  * published by the Free Software Foundation.
  */
 
+#include <linux/bitmap.h>
 #include <dqe_cal.h>
 #include <decon_cal.h>
 #include <drm/samsung_drm.h>
@@ -78,18 +79,23 @@ void dqe_reg_init(u32 dqe_id, u32 width, u32 height)
 	cal_log_debug(0, "size(%ux%u)\n", width, height);
 }
 
-void dqe_reg_set_degamma_lut(u32 dqe_id, const struct drm_color_lut *lut)
+/*
+ * Degamma and regamma LUTs pack two points into a register, so convert a range of points
+ * [start, end) into the range of registers that hold them.
+ */
+static inline void dqe_lut_to_reg_range(u32 start, u32 end, u32 *reg_start, u32 *reg_end)
+{
+	*reg_start = start / 2;
+	*reg_end = DIV_ROUND_UP(end, 2);
+}
+
+static void __dqe_reg_set_degamma_lut(u32 dqe_id, const struct drm_color_lut *lut,
+				      u32 start, u32 end)
 {
 	int i, ret = 0;
 	u16 tmp_lut[DEGAMMA_LUT_SIZE] = {0};
 	u32 regs[DQE_DEGAMMALUT_REG_CNT] = {0};
-
-	cal_log_debug(0, "%s +\n", __func__);
-
-	if (!lut) {
-		degamma_write(dqe_id, DQE_DEGAMMA_CON, 0);
-		return;
-	}
+	u32 reg_start, reg_end;
 
 	for (i = 0; i < DEGAMMA_LUT_SIZE; i++)
 		tmp_lut[i] = lut[i].red;
@@ -102,37 +108,93 @@ void dqe_reg_set_degamma_lut(u32 dqe_id, const struct drm_color_lut *lut)
 		return;
 	}
 
-	for (i = 0; i < DQE_DEGAMMALUT_REG_CNT; i++) {
+	dqe_lut_to_reg_range(start, end, &reg_start, &reg_end);
+	for (i = reg_start; i < reg_end; i++) {
 		degamma_write_relaxed(dqe_id, DQE_DEGAMMALUT(i), regs[i]);
 		cal_log_debug(0, "[%d]: 0x%x\n", i, regs[i]);
 	}
+}
+
+void dqe_reg_set_degamma_lut(u32 dqe_id, const struct drm_color_lut *lut)
+{
+	cal_log_debug(0, "%s +\n", __func__);
+
+	if (!lut) {
+		degamma_write(dqe_id, DQE_DEGAMMA_CON, 0);
+		return;
+	}
+
+	__dqe_reg_set_degamma_lut(dqe_id, lut, 0, DEGAMMA_LUT_SIZE);
 	degamma_write(dqe_id, DQE_DEGAMMA_CON, DEGAMMA_EN);
 
 	cal_log_debug(0, "%s -\n", __func__);
 }
 
-void dqe_reg_set_cgc_lut(u32 dqe_id, const struct cgc_lut *lut)
+/*
+ * Rewrites only the registers holding points [start, end) of an already enabled degamma
+ * LUT. The remaining points are expected to match what was programmed before.
+ */
+void dqe_reg_set_degamma_lut_range(u32 dqe_id, const struct drm_color_lut *lut,
+				   u32 start, u32 end)
+{
+	if (!lut || start >= end || end > DEGAMMA_LUT_SIZE)
+		return;
+
+	cal_log_debug(0, "%s: [%u, %u)\n", __func__, start, end);
+
+	__dqe_reg_set_degamma_lut(dqe_id, lut, start, end);
+}
+
+static void __dqe_reg_set_cgc_lut(u32 dqe_id, const struct cgc_lut *lut, u32 start, u32 end)
 {
 	int i;
 
+	for (i = start; i < end; ++i) {
+		dqe_write_relaxed(dqe_id, DQE_CGC_LUT_R(i), lut->r_values[i]);
+		dqe_write_relaxed(dqe_id, DQE_CGC_LUT_G(i), lut->g_values[i]);
+		dqe_write_relaxed(dqe_id, DQE_CGC_LUT_B(i), lut->b_values[i]);
+	}
+}
+
+void dqe_reg_set_cgc_lut(u32 dqe_id, const struct cgc_lut *lut)
+{
 	cal_log_debug(0, "%s +\n", __func__);
 
 	if (!lut) {
 		cgc_write_mask(dqe_id, DQE_CGC_CON, 0, CGC_EN_MASK);
 		return;
 	}
-	for (i = 0; i < DRM_SAMSUNG_CGC_LUT_REG_CNT; ++i) {
-		dqe_write_relaxed(dqe_id, DQE_CGC_LUT_R(i), lut->r_values[i]);
-		dqe_write_relaxed(dqe_id, DQE_CGC_LUT_G(i), lut->g_values[i]);
-		dqe_write_relaxed(dqe_id, DQE_CGC_LUT_B(i), lut->b_values[i]);
-	}
 
+	__dqe_reg_set_cgc_lut(dqe_id, lut, 0, DRM_SAMSUNG_CGC_LUT_REG_CNT);
 	cgc_write_mask(dqe_id, DQE_CGC_CON, ~0, CGC_EN_MASK);
 
 	cal_log_debug(0, "%s -\n", __func__);
 }
 
-void dqe_reg_set_regamma_lut(u32 dqe_id, const struct drm_color_lut *lut)
+/*
+ * Rewrites only the CGC LUT register blocks set in the @blocks bitmap of an already enabled
+ * CGC. Consecutive dirty blocks are written as one run.
+ */
+void dqe_reg_set_cgc_lut_blocks(u32 dqe_id, const struct cgc_lut *lut,
+				const unsigned long *blocks)
+{
+	unsigned int rs, re;
+
+	if (!lut)
+		return;
+
+	bitmap_for_each_set_region(blocks, rs, re, 0, CGC_LUT_BLOCK_CNT) {
+		const u32 start = rs * CGC_LUT_BLOCK_REG_CNT;
+		const u32 end = min_t(u32, re * CGC_LUT_BLOCK_REG_CNT,
+				      DRM_SAMSUNG_CGC_LUT_REG_CNT);
+
+		cal_log_debug(0, "%s: [%u, %u)\n", __func__, start, end);
+		__dqe_reg_set_cgc_lut(dqe_id, lut, start, end);
+	}
+}
+
+static void __dqe_reg_set_regamma_lut(u32 dqe_id, const struct drm_color_lut *lut,
+				      u32 start, u32 end)
 {
 	enum dqe_regamma_elements {
 		REGAMMA_RED = 0,
@@ -143,13 +205,7 @@ void dqe_reg_set_regamma_lut(u32 dqe_id, const struct drm_color_lut *lut)
 	int i, ret = 0;
 	u16 tmp_lut[REGAMMA_MAX][REGAMMA_LUT_SIZE] = {0};
 	u32 regs[REGAMMA_MAX][DQE_REGAMMALUT_REG_CNT] = {0};
-
-	cal_log_debug(0, "%s +\n", __func__);
-
-	if (!lut) {
-		regamma_write(dqe_id, DQE_REGAMMA_CON, 0);
-		return;
-	}
+	u32 reg_start, reg_end;
 
 	for (i = 0; i < REGAMMA_LUT_SIZE; i++) {
 		tmp_lut[REGAMMA_RED][i] = lut[i].red;
@@ -167,7 +223,8 @@ void dqe_reg_set_regamma_lut(u32 dqe_id, const struct drm_color_lut *lut)
 		}
 	}
 
-	for (i = 0; i < DQE_REGAMMALUT_REG_CNT; i++) {
+	dqe_lut_to_reg_range(start, end, &reg_start, &reg_end);
+	for (i = reg_start; i < reg_end; i++) {
 		regamma_write_relaxed(dqe_id, DQE_REGAMMALUT_R(i), regs[REGAMMA_RED][i]);
 		regamma_write_relaxed(dqe_id, DQE_REGAMMALUT_G(i), regs[REGAMMA_GREEN][i]);
 		regamma_write_relaxed(dqe_id, DQE_REGAMMALUT_B(i), regs[REGAMMA_BLUE][i]);
@@ -175,11 +232,35 @@ void dqe_reg_set_regamma_lut(u32 dqe_id, const struct drm_color_lut *lut)
 		cal_log_debug(0, "[%d]  green: 0x%x\n", i, regs[REGAMMA_GREEN][i]);
 		cal_log_debug(0, "[%d]  blue: 0x%x\n", i, regs[REGAMMA_BLUE][i]);
 	}
+}
+
+void dqe_reg_set_regamma_lut(u32 dqe_id, const struct drm_color_lut *lut)
+{
+	cal_log_debug(0, "%s +\n", __func__);
+
+	if (!lut) {
+		regamma_write(dqe_id, DQE_REGAMMA_CON, 0);
+		return;
+	}
+
+	__dqe_reg_set_regamma_lut(dqe_id, lut, 0, REGAMMA_LUT_SIZE);
 	regamma_write(dqe_id, DQE_REGAMMA_CON, REGAMMA_EN);
 
 	cal_log_debug(0, "%s -\n", __func__);
 }
 
+/* Rewrites only the registers holding points [start, end) of an already enabled regamma LUT. */
+void dqe_reg_set_regamma_lut_range(u32 dqe_id, const struct drm_color_lut *lut,
+				   u32 start, u32 end)
+{
+	if (!lut || start >= end || end > REGAMMA_LUT_SIZE)
+		return;
+
+	cal_log_debug(0, "%s: [%u, %u)\n", __func__, start, end);
+
+	__dqe_reg_set_regamma_lut(dqe_id, lut, start, end);
+}
+
 static void dqe_reg_print_lut(u32 dqe_id, u32 start, u32 count, const u32 offset,
 						struct drm_printer *pr)
 {
@@ -650,3 +731,7 @@ void dqe_reg_wait_cgc_dma_done(u32 dqe_id, u32 timeout_us)
 {
 	dqe_reg_wait_cgc_dma_done_internal(dqe_id, timeout_us);
 }
+
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_KUNIT_TEST)
+#include "dqe_reg_test.c"
+#endif
@@ -0,0 +1,250 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * cal_9845/dqe_reg_test.c
+ *
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *		http://www.samsung.com
+ *
+ * KUnit tests for DQE LUT programming, included from dqe_reg.c. DQE0 is driven
+ * through the fake register backend, so the tests never reach the hardware.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <kunit/test.h>
+#include <cal_regs_record.h>
+
+#define DQE_TEST_ID		0
+#define DQE_TEST_REGS_SIZE	SZ_64K
+
+struct dqe_test {
+	struct device *dev;
+	struct cal_regs_recorder *rec;
+	enum dqe_version version;
+	struct drm_color_lut *lut;
+	struct cgc_lut *cgc;
+};
+
+static int dqe_test_init(struct kunit *test)
+{
+	struct dqe_test *t;
+	int i;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t);
+
+	t->lut = kunit_kcalloc(test, REGAMMA_LUT_SIZE, sizeof(*t->lut), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t->lut);
+	for (i = 0; i < REGAMMA_LUT_SIZE; i++) {
+		t->lut[i].red = i * 100 + 1;
+		t->lut[i].green = i * 100 + 2;
+		t->lut[i].blue = i * 100 + 3;
+	}
+
+	t->cgc = kunit_kzalloc(test, sizeof(*t->cgc), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t->cgc);
+	for (i = 0; i < DRM_SAMSUNG_CGC_LUT_REG_CNT; i++) {
+		t->cgc->r_values[i] = i;
+		t->cgc->g_values[i] = i << 1;
+		t->cgc->b_values[i] = i << 2;
+	}
+
+	t->dev = root_device_register("dqe_reg_test");
+	KUNIT_ASSERT_FALSE(test, IS_ERR(t->dev));
+
+	t->rec = cal_regs_recorder_create(t->dev, DQE_TEST_REGS_SIZE, 0, false);
+	KUNIT_ASSERT_NOT_NULL(test, t->rec);
+
+	cal_regs_recorder_attach(t->rec, dqe_regs_desc(DQE_TEST_ID));
+	t->version = regs_dqe[DQE_TEST_ID].version;
+	regs_dqe[DQE_TEST_ID].version = DQE_V1;
+	test->priv = t;
+
+	return 0;
+}
+
+static void dqe_test_exit(struct kunit *test)
+{
+	struct dqe_test *t = test->priv;
+
+	regs_dqe[DQE_TEST_ID].version = t->version;
+	cal_regs_recorder_detach(dqe_regs_desc(DQE_TEST_ID));
+	root_device_unregister(t->dev);
+}
+
+static u16 dqe_test_point(const struct drm_color_lut *lut, u32 i, int elem)
+{
+	switch (elem) {
+	case 1:
+		return lut[i].green;
+	case 2:
+		return lut[i].blue;
+	default:
+		return lut[i].red;
+	}
+}
+
+/* two points per register, the last register only holds the final point */
+static u32 dqe_test_lut_reg(const struct drm_color_lut *lut, u32 n, int elem)
+{
+	u32 val = DEGAMMA_LUT_L(dqe_test_point(lut, n * 2, elem)) & DEGAMMA_LUT_L_MASK;
+
+	if (n * 2 + 1 < DEGAMMA_LUT_SIZE)
+		val |= DEGAMMA_LUT_H(dqe_test_point(lut, n * 2 + 1, elem)) &
+			DEGAMMA_LUT_H_MASK;
+
+	return val;
+}
+
+static void dqe_test_degamma(struct kunit *test)
+{
+	struct dqe_test *t = test->priv;
+	u32 n;
+
+	dqe_reg_set_degamma_lut(DQE_TEST_ID, t->lut);
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(dqe_regs_desc(DQE_TEST_ID)),
+			DQE_DEGAMMALUT_REG_CNT + 1);
+	for (n = 0; n < DQE_DEGAMMALUT_REG_CNT; n++)
+		KUNIT_EXPECT_EQ_MSG(test, dqe_read(DQE_TEST_ID, DQE_DEGAMMALUT(n)),
+				dqe_test_lut_reg(t->lut, n, 0), "reg %u", n);
+	KUNIT_EXPECT_EQ(test, dqe_read(DQE_TEST_ID, DQE_DEGAMMA_CON), DEGAMMA_EN);
+
+	/* disabling only touches the control register */
+	dqe_reg_set_degamma_lut(DQE_TEST_ID, NULL);
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(dqe_regs_desc(DQE_TEST_ID)), 1);
+	KUNIT_EXPECT_EQ(test, dqe_read(DQE_TEST_ID, DQE_DEGAMMA_CON), 0);
+}
+
+static void dqe_test_degamma_range(struct kunit *test)
+{
+	struct dqe_test *t = test->priv;
+
+	dqe_reg_set_degamma_lut(DQE_TEST_ID, t->lut);
+	cal_regs_recorder_commit(dqe_regs_desc(DQE_TEST_ID));
+
+	/* an odd point shares its register with the even point before it */
+	t->lut[7].red = 0x1abc;
+	dqe_reg_set_degamma_lut_range(DQE_TEST_ID, t->lut, 7, 8);
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(dqe_regs_desc(DQE_TEST_ID)), 1);
+	KUNIT_EXPECT_EQ(test, dqe_read(DQE_TEST_ID, DQE_DEGAMMALUT(3)),
+			dqe_test_lut_reg(t->lut, 3, 0));
+
+	/* [6, 9) straddles registers 3 and 4 */
+	dqe_reg_set_degamma_lut_range(DQE_TEST_ID, t->lut, 6, 9);
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(dqe_regs_desc(DQE_TEST_ID)), 2);
+
+	/* the last point has a register of its own */
+	t->lut[DEGAMMA_LUT_SIZE - 1].red = 0x1234;
+	dqe_reg_set_degamma_lut_range(DQE_TEST_ID, t->lut, DEGAMMA_LUT_SIZE - 1,
+			DEGAMMA_LUT_SIZE);
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(dqe_regs_desc(DQE_TEST_ID)), 1);
+	KUNIT_EXPECT_EQ(test, dqe_read(DQE_TEST_ID, DQE_DEGAMMALUT(DQE_DEGAMMALUT_REG_CNT - 1)),
+			0x1234);
+
+	dqe_reg_set_degamma_lut_range(DQE_TEST_ID, t->lut, 0, DEGAMMA_LUT_SIZE);
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(dqe_regs_desc(DQE_TEST_ID)),
+			DQE_DEGAMMALUT_REG_CNT);
+
+	/* empty and out of bounds ranges are ignored */
+	dqe_reg_set_degamma_lut_range(DQE_TEST_ID, t->lut, 10, 10);
+	dqe_reg_set_degamma_lut_range(DQE_TEST_ID, t->lut, 0, DEGAMMA_LUT_SIZE + 1);
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(dqe_regs_desc(DQE_TEST_ID)), 0);
+}
+
+static void dqe_test_regamma_range(struct kunit *test)
+{
+	struct dqe_test *t = test->priv;
+	u32 n;
+
+	dqe_reg_set_regamma_lut(DQE_TEST_ID, t->lut);
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(dqe_regs_desc(DQE_TEST_ID)),
+			3 * DQE_REGAMMALUT_REG_CNT + 1);
+	for (n = 0; n < DQE_REGAMMALUT_REG_CNT; n++) {
+		KUNIT_EXPECT_EQ(test, dqe_read(DQE_TEST_ID, DQE_REGAMMALUT_R(n)),
+				dqe_test_lut_reg(t->lut, n, 0));
+		KUNIT_EXPECT_EQ(test, dqe_read(DQE_TEST_ID, DQE_REGAMMALUT_G(n)),
+				dqe_test_lut_reg(t->lut, n, 1));
+		KUNIT_EXPECT_EQ(test, dqe_read(DQE_TEST_ID, DQE_REGAMMALUT_B(n)),
+				dqe_test_lut_reg(t->lut, n, 2));
+	}
+
+	/* each register is written once per channel */
+	t->lut[63].green = 0x1fff;
+	t->lut[64].blue = 0;
+	dqe_reg_set_regamma_lut_range(DQE_TEST_ID, t->lut, 63, REGAMMA_LUT_SIZE);
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(dqe_regs_desc(DQE_TEST_ID)), 3 * 2);
+	KUNIT_EXPECT_EQ(test, dqe_read(DQE_TEST_ID, DQE_REGAMMALUT_G(31)),
+			dqe_test_lut_reg(t->lut, 31, 1));
+	KUNIT_EXPECT_EQ(test, dqe_read(DQE_TEST_ID, DQE_REGAMMALUT_B(32)), 0);
+}
+
+static void dqe_test_cgc_blocks(struct kunit *test)
+{
+	struct dqe_test *t = test->priv;
+	DECLARE_BITMAP(blocks, CGC_LUT_BLOCK_CNT);
+	const u32 last = DRM_SAMSUNG_CGC_LUT_REG_CNT - 1;
+	const u32 tail = DRM_SAMSUNG_CGC_LUT_REG_CNT -
+		(CGC_LUT_BLOCK_CNT - 1) * CGC_LUT_BLOCK_REG_CNT;
+
+	dqe_reg_set_cgc_lut(DQE_TEST_ID, t->cgc);
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(dqe_regs_desc(DQE_TEST_ID)),
+			3 * DRM_SAMSUNG_CGC_LUT_REG_CNT + 1);
+	KUNIT_EXPECT_EQ(test, dqe_read(DQE_TEST_ID, DQE_CGC_LUT_B(last)), last << 2);
+	KUNIT_EXPECT_EQ(test, dqe_read_mask(DQE_TEST_ID, DQE_CGC_CON, CGC_EN_MASK),
+			CGC_EN_MASK);
+
+	/* two adjacent blocks and the short block at the end */
+	t->cgc->r_values[CGC_LUT_BLOCK_REG_CNT] = 0x1234;
+	t->cgc->b_values[last] = 0x567;
+	bitmap_zero(blocks, CGC_LUT_BLOCK_CNT);
+	set_bit(0, blocks);
+	set_bit(1, blocks);
+	set_bit(CGC_LUT_BLOCK_CNT - 1, blocks);
+	dqe_reg_set_cgc_lut_blocks(DQE_TEST_ID, t->cgc, blocks);
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(dqe_regs_desc(DQE_TEST_ID)),
+			3 * (2 * CGC_LUT_BLOCK_REG_CNT + tail));
+	KUNIT_EXPECT_EQ(test, dqe_read(DQE_TEST_ID, DQE_CGC_LUT_R(CGC_LUT_BLOCK_REG_CNT)),
+			0x1234);
+	KUNIT_EXPECT_EQ(test, dqe_read(DQE_TEST_ID, DQE_CGC_LUT_B(last)), 0x567);
+
+	bitmap_zero(blocks, CGC_LUT_BLOCK_CNT);
+	dqe_reg_set_cgc_lut_blocks(DQE_TEST_ID, t->cgc, blocks);
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(dqe_regs_desc(DQE_TEST_ID)), 0);
+}
+
+/* later DQE versions move the gamma blocks, the LUT registers land at the shifted offsets */
+static void dqe_test_version_offset(struct kunit *test)
+{
+	struct dqe_test *t = test->priv;
+	const u32 offset = regs_dqe_offset[DQE_V2].degamma_offset;
+
+	regs_dqe[DQE_TEST_ID].version = DQE_V2;
+
+	dqe_reg_set_degamma_lut(DQE_TEST_ID, t->lut);
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(dqe_regs_desc(DQE_TEST_ID)),
+			DQE_DEGAMMALUT_REG_CNT + 1);
+	KUNIT_EXPECT_EQ(test, dqe_read(DQE_TEST_ID, DQE_DEGAMMA_CON + offset), DEGAMMA_EN);
+	KUNIT_EXPECT_EQ(test, dqe_read(DQE_TEST_ID, DQE_DEGAMMALUT(1) + offset),
+			dqe_test_lut_reg(t->lut, 1, 0));
+	KUNIT_EXPECT_EQ(test, dqe_read(DQE_TEST_ID, DQE_DEGAMMA_CON), 0);
+}
+
+static struct kunit_case dqe_test_cases[] = {
+	KUNIT_CASE(dqe_test_degamma),
+	KUNIT_CASE(dqe_test_degamma_range),
+	KUNIT_CASE(dqe_test_regamma_range),
+	KUNIT_CASE(dqe_test_cgc_blocks),
+	KUNIT_CASE(dqe_test_version_offset),
+	{}
+};
+
+static struct kunit_suite dqe_test_suite = {
+	.name = "exynos-drm-dqe-reg",
+	.init = dqe_test_init,
+	.exit = dqe_test_exit,
+	.test_cases = dqe_test_cases,
+};
+
+kunit_test_suite(dqe_test_suite);
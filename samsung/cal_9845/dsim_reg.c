@@ -19,10 +19,8 @@
 #include <dsim_cal.h>
 #include <cal_config.h>
 
-static struct cal_regs_desc regs_desc[REGS_DSIM_TYPE_MAX][MAX_DSI_CNT];
+struct cal_regs_desc regs_dsim[REGS_DSIM_TYPE_MAX][MAX_DSI_CNT];
 
-#define dsim_regs_desc(id)				\
-	(&regs_desc[REGS_DSIM_DSI][id])
 #define dsim_read(id, offset)				\
 	cal_read(dsim_regs_desc(id), offset)
 #define dsim_write(id, offset, val)			\
@@ -33,7 +31,7 @@ static struct cal_regs_desc regs_desc[REGS_DSIM_TYPE_MAX][MAX_DSI_CNT];
 	cal_write_mask(dsim_regs_desc(id), offset, val, mask)
 
 #define dphy_regs_desc(id)				\
-	(&regs_desc[REGS_DSIM_PHY][id])
+	(&regs_dsim[REGS_DSIM_PHY][id])
 #define dsim_phy_read(id, offset)			\
 	cal_read(dphy_regs_desc(id), offset)
 #define dsim_phy_write(id, offset, val)			\
@@ -44,7 +42,7 @@ static struct cal_regs_desc regs_desc[REGS_DSIM_TYPE_MAX][MAX_DSI_CNT];
 	cal_write_mask(dphy_regs_desc(id), offset, val, mask)
 
 #define dphy_bias_regs_desc(id)				\
-	(&regs_desc[REGS_DSIM_PHY_BIAS][id])
+	(&regs_dsim[REGS_DSIM_PHY_BIAS][id])
 #define dsim_phy_extra_write(id, offset, val)		\
 	cal_write(dphy_bias_regs_desc(id), offset, val)
 #define dsim_phy_extra_read_mask(id, offset, mask)       \
@@ -53,7 +51,7 @@ static struct cal_regs_desc regs_desc[REGS_DSIM_TYPE_MAX][MAX_DSI_CNT];
 	cal_write_mask(dphy_bias_regs_desc(id), offset, val, mask);
 
 #define sys_regs_desc(id)				\
-	(&regs_desc[REGS_DSIM_SYS][id])
+	(&regs_dsim[REGS_DSIM_SYS][id])
 #define dsim_sys_read(id, offset)			\
 	cal_read(sys_regs_desc(id), offset)
 #define dsim_sys_write(id, offset, val)			\
@@ -2036,7 +2034,7 @@ void dsim_regs_desc_init(void __iomem *regs, phys_addr_t start, const char *name
 		enum dsim_regs_type type, unsigned int id)
 {
 	cal_regs_desc_check(type, id, REGS_DSIM_TYPE_MAX, MAX_DSI_CNT);
-	cal_regs_desc_set(regs_desc, regs, start, name, type, id);
+	cal_regs_desc_set(regs_dsim, regs, start, name, type, id);
 }
 
 static void dpu_sysreg_select_dphy_rst_control(u32 id, u32 sel)
@@ -2248,6 +2246,11 @@ void dsim_reg_wr_tx_payload(u32 id, u32 payload)
 	dsim_write(id, DSIM_PAYLOAD, payload);
 }
 
+void dsim_reg_wr_tx_payload_burst(u32 id, const u32 *payload, u32 cnt)
+{
+	cal_write_burst(dsim_regs_desc(id), DSIM_PAYLOAD, payload, cnt);
+}
+
 u32 dsim_reg_header_fifo_is_empty(u32 id)
 {
 	return dsim_read_mask(id, DSIM_FIFOCTRL, DSIM_FIFOCTRL_EMPTY_PH_SFR);
@@ -2531,3 +2534,7 @@ void dsim_reg_set_drm_write_protected(u32 id, bool write_protected)
 {
 	cal_set_write_protected(dsim_regs_desc(id), write_protected);
 }
+
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_KUNIT_TEST)
+#include "dsim_reg_test.c"
+#endif
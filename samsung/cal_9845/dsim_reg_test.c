@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * cal_9845/dsim_reg_test.c
+ *
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *		http://www.samsung.com
+ *
+ * KUnit tests for DSIM command and resolution programming, included from
+ * dsim_reg.c. DSIM0 is driven through the fake register backend, so the tests
+ * never reach the hardware.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <kunit/test.h>
+#include <cal_regs_record.h>
+
+#define DSIM_TEST_ID		0
+#define DSIM_TEST_REGS_SIZE	SZ_4K
+#define DSIM_TEST_LOG_SIZE	64
+
+struct dsim_test {
+	struct device *dev;
+	struct cal_regs_recorder *rec;
+};
+
+static int dsim_test_init(struct kunit *test)
+{
+	struct dsim_test *t;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t);
+
+	t->dev = root_device_register("dsim_reg_test");
+	KUNIT_ASSERT_FALSE(test, IS_ERR(t->dev));
+
+	t->rec = cal_regs_recorder_create(t->dev, DSIM_TEST_REGS_SIZE, DSIM_TEST_LOG_SIZE,
+			false);
+	KUNIT_ASSERT_NOT_NULL(test, t->rec);
+
+	cal_regs_recorder_attach(t->rec, dsim_regs_desc(DSIM_TEST_ID));
+	test->priv = t;
+
+	return 0;
+}
+
+static void dsim_test_exit(struct kunit *test)
+{
+	struct dsim_test *t = test->priv;
+
+	cal_regs_recorder_detach(dsim_regs_desc(DSIM_TEST_ID));
+	root_device_unregister(t->dev);
+}
+
+static u32 dsim_test_commit(void)
+{
+	return cal_regs_recorder_commit(dsim_regs_desc(DSIM_TEST_ID));
+}
+
+static void dsim_test_tx_header(struct kunit *test)
+{
+	dsim_reg_wr_tx_header(DSIM_TEST_ID, MIPI_DSI_DCS_LONG_WRITE, 0x10, 0x02, false);
+	KUNIT_EXPECT_EQ(test, dsim_test_commit(), 1);
+	KUNIT_EXPECT_EQ(test, dsim_read(DSIM_TEST_ID, DSIM_PKTHDR),
+			DSIM_PKTHDR_ID(MIPI_DSI_DCS_LONG_WRITE) | DSIM_PKTHDR_DATA0(0x10) |
+			DSIM_PKTHDR_DATA1(0x02));
+
+	dsim_reg_wr_tx_header(DSIM_TEST_ID, MIPI_DSI_DCS_READ, 0x0a, 0, true);
+	KUNIT_EXPECT_EQ(test, dsim_test_commit(), 1);
+	KUNIT_EXPECT_EQ(test, dsim_read(DSIM_TEST_ID, DSIM_PKTHDR),
+			DSIM_PKTHDR_BTA_TYPE(1) | DSIM_PKTHDR_ID(MIPI_DSI_DCS_READ) |
+			DSIM_PKTHDR_DATA0(0x0a));
+}
+
+/* a burst pushes every word into the payload FIFO port, in order */
+static void dsim_test_tx_payload_burst(struct kunit *test)
+{
+	struct dsim_test *t = test->priv;
+	u32 words[DSIM_TEST_LOG_SIZE / 2];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(words); i++)
+		words[i] = 0x01010101 * i;
+
+	dsim_reg_wr_tx_payload_burst(DSIM_TEST_ID, words, ARRAY_SIZE(words));
+	KUNIT_EXPECT_EQ(test, dsim_test_commit(), ARRAY_SIZE(words));
+
+	KUNIT_ASSERT_EQ(test, t->rec->log_cnt, ARRAY_SIZE(words));
+	for (i = 0; i < ARRAY_SIZE(words); i++) {
+		KUNIT_EXPECT_EQ(test, t->rec->log[i].offset, DSIM_PAYLOAD);
+		KUNIT_EXPECT_EQ(test, t->rec->log[i].val, words[i]);
+	}
+
+	dsim_reg_wr_tx_payload_burst(DSIM_TEST_ID, words, 0);
+	KUNIT_EXPECT_EQ(test, dsim_test_commit(), 0);
+}
+
+/*
+ * Partial update in command mode only resizes the frame: no porches are written, and with
+ * DSC the horizontal resolution is the compressed width of all slices.
+ */
+static void dsim_test_partial_update(struct kunit *test)
+{
+	struct dsim_reg_config config = { 0 };
+
+	config.mode = DSIM_COMMAND_MODE;
+	config.p_timing.vactive = 1200;
+	config.p_timing.hactive = 1080;
+
+	dsim_reg_set_partial_update(DSIM_TEST_ID, &config);
+	KUNIT_EXPECT_EQ(test, dsim_test_commit(), 3);
+	KUNIT_EXPECT_EQ(test, dsim_read(DSIM_TEST_ID, DSIM_RESOL),
+			DSIM_RESOL_VRESOL(1200) | DSIM_RESOL_HRESOL(1080));
+	KUNIT_EXPECT_EQ(test, dsim_read(DSIM_TEST_ID, DSIM_NUM_OF_TRANSFER),
+			DSIM_NUM_OF_TRANSFER_PER_FRAME(1200));
+
+	config.dsc.enabled = true;
+	config.dsc.slice_count = 2;
+	config.dsc.slice_width = 540;
+	config.p_timing.vactive = 400;
+
+	dsim_reg_set_partial_update(DSIM_TEST_ID, &config);
+	KUNIT_EXPECT_EQ(test, dsim_test_commit(), 3);
+	KUNIT_EXPECT_EQ(test, dsim_read(DSIM_TEST_ID, DSIM_RESOL),
+			DSIM_RESOL_VRESOL(400) |
+			DSIM_RESOL_HRESOL(get_comp_dsc_width(&config.dsc) * 2));
+}
+
+static struct kunit_case dsim_test_cases[] = {
+	KUNIT_CASE(dsim_test_tx_header),
+	KUNIT_CASE(dsim_test_tx_payload_burst),
+	KUNIT_CASE(dsim_test_partial_update),
+	{}
+};
+
+static struct kunit_suite dsim_test_suite = {
+	.name = "exynos-drm-dsim-reg",
+	.init = dsim_test_init,
+	.exit = dsim_test_exit,
+	.test_cases = dsim_test_cases,
+};
+
+kunit_test_suite(dsim_test_suite);
@@ -16,6 +16,9 @@
 #include <hdr_cal.h>
 #include <dpp_cal.h>
 #include <drm/drm_print.h>
+#include <linux/xxhash.h>
+
+#include <exynos_hdr_lut.h>
 
 #include "regs-hdr.h"
 
@@ -33,6 +36,40 @@ static struct cal_regs_desc regs_hdr[REGS_DPP_ID_MAX - 1];
 #define hdr_write_relaxed(id, offset, val)	\
 	cal_write_relaxed(hdr_regs_desc(id), offset, val)
 
+/*
+ * Each HDR block is programmed as one run of consecutive registers, whose packed
+ * image is kept here along with the LUT it was packed from and its hash. Registers
+ * keep their content while a block is disabled, so re-enabling a LUT with the same
+ * content only needs the enable bit.
+ */
+#define HDR_OETF_IMG_CNT	(HDR_OETF_POSX_LUT_REG_CNT + HDR_OETF_POSY_LUT_REG_CNT)
+#define HDR_EOTF_IMG_CNT	(HDR_EOTF_POSX_LUT_REG_CNT + HDR_EOTF_POSY_LUT_REG_CNT)
+#define HDR_GM_IMG_CNT		(HDR_GM_COEF_REG_CNT + HDR_GM_OFFS_REG_CNT)
+#define HDR_TM_IMG_CNT		(3 + HDR_TM_POSX_LUT_REG_CNT + HDR_TM_POSY_LUT_REG_CNT)
+
+struct hdr_shadow_img {
+	u64 hash;
+	bool valid;
+};
+
+struct hdr_shadow {
+	struct hdr_shadow_img eotf;
+	struct hdr_shadow_img oetf;
+	struct hdr_shadow_img gm;
+	struct hdr_shadow_img tm;
+	u32 eotf_img[HDR_EOTF_IMG_CNT];
+	u32 oetf_img[HDR_OETF_IMG_CNT];
+	u32 gm_img[HDR_GM_IMG_CNT];
+	u32 tm_img[HDR_TM_IMG_CNT];
+	/* the hash only rules out a match, the LUTs confirm it */
+	struct hdr_eotf_lut eotf_src;
+	struct hdr_oetf_lut oetf_src;
+	struct hdr_gm_data gm_src;
+	struct hdr_tm_data tm_src;
+};
+
+static struct hdr_shadow hdr_shadow[REGS_DPP_ID_MAX - 1];
+
 void hdr_regs_desc_init(void __iomem *regs, phys_addr_t start, const char *name, u32 id)
 {
 	regs_hdr[id].regs = regs;
@@ -40,6 +77,278 @@ void hdr_regs_desc_init(void __iomem *regs, phys_addr_t start, const char *name,
 	regs_hdr[id].start = start;
 }
 
+void hdr_reg_shadow_invalidate(u32 id)
+{
+	struct hdr_shadow *shadow;
+
+	if (id >= ARRAY_SIZE(hdr_shadow))
+		return;
+
+	shadow = &hdr_shadow[id];
+	shadow->eotf.valid = false;
+	shadow->oetf.valid = false;
+	shadow->gm.valid = false;
+	shadow->tm.valid = false;
+}
+
+/*
+ * Returns true if registers already hold the image packed from @lut, whose hash is
+ * @hash. Otherwise keeps @lut in @copy and marks the shadow image invalid until the
+ * caller has written it.
+ */
+static bool hdr_shadow_match(struct hdr_shadow_img *img, u64 hash, void *copy,
+		const void *lut, size_t size)
+{
+	if (img->valid && img->hash == hash && !memcmp(copy, lut, size))
+		return true;
+
+	memcpy(copy, lut, size);
+	img->hash = hash;
+	img->valid = false;
+
+	return false;
+}
+
+static int hdr_pack_eotf_lut(const struct hdr_eotf_lut *lut, u32 *img)
+{
+	int i, ret;
+
+	ret = cal_pack_lut_into_reg_pairs(lut->posx, DRM_SAMSUNG_HDR_EOTF_LUT_LEN,
+			EOTF_POSX_L_MASK, EOTF_POSX_H_MASK, img,
+			HDR_EOTF_POSX_LUT_REG_CNT);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < HDR_EOTF_POSY_LUT_REG_CNT; i++)
+		img[HDR_EOTF_POSX_LUT_REG_CNT + i] = lut->posy[i];
+
+	return 0;
+}
+
+static int hdr_pack_oetf_lut(const struct hdr_oetf_lut *lut, u32 *img)
+{
+	int ret;
+
+	ret = cal_pack_lut_into_reg_pairs(lut->posx, DRM_SAMSUNG_HDR_OETF_LUT_LEN,
+			OETF_POSX_L_MASK, OETF_POSX_H_MASK, img,
+			HDR_OETF_POSX_LUT_REG_CNT);
+	if (ret)
+		return ret;
+
+	return cal_pack_lut_into_reg_pairs(lut->posy, DRM_SAMSUNG_HDR_OETF_LUT_LEN,
+			OETF_POSY_L_MASK, OETF_POSY_H_MASK,
+			&img[HDR_OETF_POSX_LUT_REG_CNT], HDR_OETF_POSY_LUT_REG_CNT);
+}
+
+static void hdr_pack_gm(const struct hdr_gm_data *data, u32 *img)
+{
+	int i;
+
+	for (i = 0; i < HDR_GM_COEF_REG_CNT; i++)
+		img[i] = data->coeffs[i];
+	for (i = 0; i < HDR_GM_OFFS_REG_CNT; i++)
+		img[HDR_GM_COEF_REG_CNT + i] = data->offsets[i];
+}
+
+/*
+ * Presets are built from the tables in exynos_hdr_lut.h once, and packed with
+ * the same helpers as LUTs coming from plane blobs. A preset selected on a plane
+ * hands out pointers to its LUTs, which setters recognize so that neither the
+ * hash nor the packing is redone per commit.
+ */
+struct hdr_preset_data {
+	struct hdr_eotf_lut eotf;
+	struct hdr_oetf_lut oetf;
+	struct hdr_gm_data gm;
+	u64 eotf_hash;
+	u64 oetf_hash;
+	u64 gm_hash;
+	u32 eotf_img[HDR_EOTF_IMG_CNT];
+	u32 oetf_img[HDR_OETF_IMG_CNT];
+	u32 gm_img[HDR_GM_IMG_CNT];
+	struct hdr_preset_luts luts;
+};
+
+struct hdr_preset_src {
+	const u32 *eotf_x;
+	const u32 *eotf_y;
+	const u32 *gm_coef;
+};
+
+/*
+ * Each exynos_hdr_lut.h EOTF table holds 64 curve points followed by the distance
+ * from the last of them to the end point of the curve.
+ */
+#define HDR_SRC_EOTF_PTS	MAX_EOTF
+
+static const struct hdr_preset_src hdr_preset_srcs[HDR_PRESET_MAX] = {
+	[HDR_PRESET_PQ1000_P3] = {
+		eotf_x_axis_st2084_1000, eotf_y_axis_st2084_1000, gm_coef_2020_p3,
+	},
+	[HDR_PRESET_PQ4000_P3] = {
+		eotf_x_axis_st2084_4000, eotf_y_axis_st2084_4000, gm_coef_2020_p3,
+	},
+	[HDR_PRESET_HLG_P3] = {
+		eotf_x_axis_hlg, eotf_y_axis_hlg, gm_coef_2020_p3,
+	},
+	[HDR_PRESET_SRGB_P3] = {
+		eotf_x_axis_srgb, eotf_y_axis_srgb, gm_coef_709_p3,
+	},
+};
+
+static struct hdr_preset_data hdr_presets[HDR_PRESET_MAX];
+static bool hdr_presets_ready;
+
+static u32 hdr_lut_interp(const u32 *x, const u32 *y, u32 cnt, u32 v)
+{
+	u32 i;
+
+	if (v <= x[0])
+		return y[0];
+
+	for (i = 1; i < cnt; i++) {
+		if (v <= x[i])
+			return y[i - 1] + (y[i] - y[i - 1]) * (v - x[i - 1]) /
+				(x[i] - x[i - 1]);
+	}
+
+	return y[cnt - 1];
+}
+
+static void hdr_preset_src_points(const u32 *x, const u32 *y, u32 *px, u32 *py)
+{
+	const u32 last = HDR_SRC_EOTF_PTS - 1;
+
+	memcpy(px, x, last * sizeof(*px));
+	memcpy(py, y, last * sizeof(*py));
+	px[last] = x[last - 1] + x[last];
+	py[last] = y[last - 1] + y[last];
+}
+
+/*
+ * exynos_hdr_lut.h tables carry 10-bit input and 14-bit output up to an end point
+ * at input 1024, while this EOTF takes 129 points with 16-bit output, so they are
+ * resampled on an even grid. The last grid point sits on the end point, only its
+ * input is clamped to 10 bits.
+ */
+static void hdr_preset_build_eotf(struct hdr_eotf_lut *lut, const u32 *x,
+		const u32 *y)
+{
+	const u32 step = 1024 / (DRM_SAMSUNG_HDR_EOTF_LUT_LEN - 1);
+	u32 px[HDR_SRC_EOTF_PTS], py[HDR_SRC_EOTF_PTS];
+	u32 i;
+
+	hdr_preset_src_points(x, y, px, py);
+
+	for (i = 0; i < DRM_SAMSUNG_HDR_EOTF_LUT_LEN; i++) {
+		lut->posx[i] = min_t(u32, i * step, 1023);
+		lut->posy[i] = min_t(u32,
+			hdr_lut_interp(px, py, HDR_SRC_EOTF_PTS, i * step) << 2,
+			U16_MAX);
+	}
+}
+
+/*
+ * The panel side is encoded with the inverse of the sRGB EOTF. Its end point
+ * covers the whole 16-bit input range.
+ */
+static void hdr_preset_build_oetf(struct hdr_oetf_lut *lut)
+{
+	const u32 last = DRM_SAMSUNG_HDR_OETF_LUT_LEN - 1;
+	const u32 stride = (HDR_SRC_EOTF_PTS - 1) / last;
+	u32 px[HDR_SRC_EOTF_PTS], py[HDR_SRC_EOTF_PTS];
+	u32 i;
+
+	hdr_preset_src_points(eotf_x_axis_srgb, eotf_y_axis_srgb, px, py);
+
+	for (i = 0; i < last; i++) {
+		lut->posx[i] = py[i * stride] << 2;
+		lut->posy[i] = px[i * stride];
+	}
+	lut->posx[last] = U16_MAX;
+	lut->posy[last] = min_t(u32, px[last * stride], 1023);
+}
+
+/* exynos_hdr_lut.h matrices are S.14, GM takes S2.16 */
+static void hdr_preset_build_gm(struct hdr_gm_data *data, const u32 *coef)
+{
+	int i;
+
+	for (i = 0; i < HDR_GM_COEF_REG_CNT; i++)
+		data->coeffs[i] = (s32)coef[i] * 4;
+	for (i = 0; i < HDR_GM_OFFS_REG_CNT; i++)
+		data->offsets[i] = 0;
+}
+
+int hdr_reg_init_presets(void)
+{
+	struct hdr_preset_data *preset;
+	const struct hdr_preset_src *src;
+	int i, ret;
+
+	if (hdr_presets_ready)
+		return 0;
+
+	BUILD_BUG_ON((HDR_SRC_EOTF_PTS - 1) % (DRM_SAMSUNG_HDR_OETF_LUT_LEN - 1));
+
+	for (i = HDR_PRESET_NONE + 1; i < HDR_PRESET_MAX; i++) {
+		preset = &hdr_presets[i];
+		src = &hdr_preset_srcs[i];
+
+		hdr_preset_build_eotf(&preset->eotf, src->eotf_x, src->eotf_y);
+		hdr_preset_build_oetf(&preset->oetf);
+		hdr_preset_build_gm(&preset->gm, src->gm_coef);
+
+		ret = hdr_pack_eotf_lut(&preset->eotf, preset->eotf_img);
+		if (!ret)
+			ret = hdr_pack_oetf_lut(&preset->oetf, preset->oetf_img);
+		if (ret) {
+			pr_err("%s: failed to pack preset %d(%d)\n", __func__, i, ret);
+			return ret;
+		}
+		hdr_pack_gm(&preset->gm, preset->gm_img);
+
+		preset->eotf_hash = xxh64(&preset->eotf, sizeof(preset->eotf), 0);
+		preset->oetf_hash = xxh64(&preset->oetf, sizeof(preset->oetf), 0);
+		preset->gm_hash = xxh64(&preset->gm, sizeof(preset->gm), 0);
+
+		preset->luts.eotf_lut = &preset->eotf;
+		preset->luts.oetf_lut = &preset->oetf;
+		preset->luts.gm = &preset->gm;
+	}
+
+	hdr_presets_ready = true;
+
+	return 0;
+}
+
+const struct hdr_preset_luts *hdr_reg_get_preset(enum hdr_preset preset)
+{
+	if (!hdr_presets_ready || preset <= HDR_PRESET_NONE ||
+			preset >= HDR_PRESET_MAX)
+		return NULL;
+
+	return &hdr_presets[preset].luts;
+}
+
+static const struct hdr_preset_data *hdr_preset_lookup(const void *data)
+{
+	const struct hdr_preset_data *preset;
+	int i;
+
+	if (!hdr_presets_ready)
+		return NULL;
+
+	for (i = HDR_PRESET_NONE + 1; i < HDR_PRESET_MAX; i++) {
+		preset = &hdr_presets[i];
+		if (data == &preset->eotf || data == &preset->oetf ||
+				data == &preset->gm)
+			return preset;
+	}
+
+	return NULL;
+}
+
 void hdr_reg_set_hdr(u32 id, bool en)
 {
 	cal_log_debug(id, "%s +\n", __func__);
@@ -50,9 +359,10 @@ void hdr_reg_set_hdr(u32 id, bool en)
 
 void hdr_reg_set_eotf_lut(u32 id, struct hdr_eotf_lut *lut)
 {
-	int i;
-	int ret = 0;
-	u32 regs[HDR_EOTF_POSX_LUT_REG_CNT] = {0};
+	struct hdr_shadow *shadow = &hdr_shadow[id];
+	const struct hdr_preset_data *preset;
+	const u32 *img = shadow->eotf_img;
+	u64 hash;
 
 	cal_log_debug(id, "%s +\n", __func__);
 
@@ -62,21 +372,25 @@ void hdr_reg_set_eotf_lut(u32 id, struct hdr_eotf_lut *lut)
 		return;
 	}
 
-	ret = cal_pack_lut_into_reg_pairs(lut->posx, DRM_SAMSUNG_HDR_EOTF_LUT_LEN,
-			EOTF_POSX_L_MASK, EOTF_POSX_H_MASK, regs,
-			HDR_EOTF_POSX_LUT_REG_CNT);
-	if(ret) {
-		cal_log_err(id, "Failed to pack eotf_posx\n");
+	preset = hdr_preset_lookup(lut);
+	if (preset) {
+		hash = preset->eotf_hash;
+		img = preset->eotf_img;
 	} else {
-		for (i = 0; i < HDR_EOTF_POSX_LUT_REG_CNT; i++) {
-			hdr_write_relaxed(id, HDR_LSI_L_EOTF_POSX(i), regs[i]);
-			cal_log_debug(id, "POSX[%d]: 0x%x\n", i, regs[i]);
-		}
+		hash = xxh64(lut, sizeof(*lut), 0);
 	}
 
-	for (i = 0; i < HDR_EOTF_POSY_LUT_REG_CNT; i++) {
-		hdr_write_relaxed(id, HDR_LSI_L_EOTF_POSY(i), lut->posy[i]);
-		cal_log_debug(id, "POSY[%d]: 0x%x\n", i, lut->posy[i]);
+	if (!hdr_shadow_match(&shadow->eotf, hash, &shadow->eotf_src, lut,
+				sizeof(*lut))) {
+		if (!preset && hdr_pack_eotf_lut(lut, shadow->eotf_img)) {
+			cal_log_err(id, "Failed to pack eotf\n");
+			return;
+		}
+
+		cal_write_seq(hdr_regs_desc(id), HDR_LSI_L_EOTF_POSX(0), img,
+				HDR_EOTF_IMG_CNT);
+		shadow->eotf.valid = true;
+		cal_log_debug(id, "wrote %d regs\n", HDR_EOTF_IMG_CNT);
 	}
 
 	hdr_write_mask(id, HDR_LSI_L_MOD_CTRL, MOD_CTRL_EEN(1),
@@ -87,7 +401,10 @@ void hdr_reg_set_eotf_lut(u32 id, struct hdr_eotf_lut *lut)
 
 void hdr_reg_set_oetf_lut(u32 id, struct hdr_oetf_lut *lut)
 {
-	int i;
+	struct hdr_shadow *shadow = &hdr_shadow[id];
+	const struct hdr_preset_data *preset;
+	const u32 *img = shadow->oetf_img;
+	u64 hash;
 
 	cal_log_debug(id, "%s +\n", __func__);
 
@@ -97,34 +414,25 @@ void hdr_reg_set_oetf_lut(u32 id, struct hdr_oetf_lut *lut)
 		return;
 	}
 
-	{
-		u32 regs[HDR_OETF_POSX_LUT_REG_CNT] = {0};
-		int ret = cal_pack_lut_into_reg_pairs(lut->posx,
-				DRM_SAMSUNG_HDR_OETF_LUT_LEN, OETF_POSX_L_MASK,
-				OETF_POSX_H_MASK, regs, HDR_OETF_POSX_LUT_REG_CNT);
-		if (ret) {
-			cal_log_err(id, "Failed to pack oetf_posx\n");
-		} else {
-			for (i = 0; i < HDR_OETF_POSX_LUT_REG_CNT; i++) {
-				hdr_write_relaxed(id, HDR_LSI_L_OETF_POSX(i), regs[i]);
-				cal_log_debug(id, "POSX[%d]: 0x%x\n", i, regs[i]);
-			}
-		}
+	preset = hdr_preset_lookup(lut);
+	if (preset) {
+		hash = preset->oetf_hash;
+		img = preset->oetf_img;
+	} else {
+		hash = xxh64(lut, sizeof(*lut), 0);
 	}
 
-	{
-		u32 regs[HDR_OETF_POSY_LUT_REG_CNT] = {0};
-		int ret = cal_pack_lut_into_reg_pairs(lut->posy,
-				DRM_SAMSUNG_HDR_OETF_LUT_LEN, OETF_POSY_L_MASK,
-				OETF_POSY_H_MASK, regs, HDR_OETF_POSY_LUT_REG_CNT);
-		if (ret) {
-			cal_log_err(id, "Failed to pack oetf_posy\n");
-		} else {
-			for (i = 0; i < HDR_OETF_POSY_LUT_REG_CNT; i++) {
-				hdr_write_relaxed(id, HDR_LSI_L_OETF_POSY(i), regs[i]);
-				cal_log_debug(id, "POSY[%d]: 0x%x\n", i, regs[i]);
-			}
+	if (!hdr_shadow_match(&shadow->oetf, hash, &shadow->oetf_src, lut,
+				sizeof(*lut))) {
+		if (!preset && hdr_pack_oetf_lut(lut, shadow->oetf_img)) {
+			cal_log_err(id, "Failed to pack oetf\n");
+			return;
 		}
+
+		cal_write_seq(hdr_regs_desc(id), HDR_LSI_L_OETF_POSX(0), img,
+				HDR_OETF_IMG_CNT);
+		shadow->oetf.valid = true;
+		cal_log_debug(id, "wrote %d regs\n", HDR_OETF_IMG_CNT);
 	}
 
 	hdr_write_mask(id, HDR_LSI_L_MOD_CTRL, MOD_CTRL_OEN(1),
@@ -140,7 +448,10 @@ void hdr_reg_set_oetf_lut(u32 id, struct hdr_oetf_lut *lut)
  */
 void hdr_reg_set_gm(u32 id, struct hdr_gm_data *data)
 {
-	int i;
+	struct hdr_shadow *shadow = &hdr_shadow[id];
+	const struct hdr_preset_data *preset;
+	const u32 *img = shadow->gm_img;
+	u64 hash;
 
 	cal_log_debug(id, "%s +\n", __func__);
 
@@ -150,14 +461,23 @@ void hdr_reg_set_gm(u32 id, struct hdr_gm_data *data)
 		return;
 	}
 
-	for (i = 0; i < HDR_GM_COEF_REG_CNT; ++i) {
-		hdr_write_relaxed(id, HDR_LSI_L_GM_COEF(i), data->coeffs[i]);
-		cal_log_debug(id, "COEFFS[%d]: 0x%x\n", i, data->coeffs[i]);
+	preset = hdr_preset_lookup(data);
+	if (preset) {
+		hash = preset->gm_hash;
+		img = preset->gm_img;
+	} else {
+		hash = xxh64(data, sizeof(*data), 0);
 	}
 
-	for (i = 0; i < HDR_GM_OFFS_REG_CNT; ++i) {
-		hdr_write_relaxed(id, HDR_LSI_L_GM_OFFS(i), data->offsets[i]);
-		cal_log_debug(id, "OFFSETS[%d]: 0x%x\n", i, data->offsets[i]);
+	if (!hdr_shadow_match(&shadow->gm, hash, &shadow->gm_src, data,
+				sizeof(*data))) {
+		if (!preset)
+			hdr_pack_gm(data, shadow->gm_img);
+
+		cal_write_seq(hdr_regs_desc(id), HDR_LSI_L_GM_COEF(0), img,
+				HDR_GM_IMG_CNT);
+		shadow->gm.valid = true;
+		cal_log_debug(id, "wrote %d regs\n", HDR_GM_IMG_CNT);
 	}
 
 	hdr_write_mask(id, HDR_LSI_L_MOD_CTRL, MOD_CTRL_GEN(1),
@@ -168,10 +488,9 @@ void hdr_reg_set_gm(u32 id, struct hdr_gm_data *data)
 
 void hdr_reg_set_tm(u32 id, struct hdr_tm_data *tm)
 {
-	int i;
-	int ret;
-	u32 val;
-	u32 regs[HDR_TM_POSX_LUT_REG_CNT] = {0};
+	struct hdr_shadow *shadow = &hdr_shadow[id];
+	u32 *img = shadow->tm_img;
+	int i, ret;
 
 	cal_log_debug(id, "%s +\n", __func__);
 
@@ -180,34 +499,28 @@ void hdr_reg_set_tm(u32 id, struct hdr_tm_data *tm)
 		return;
 	}
 
-	val = TM_COEFB(tm->coeff_b) | TM_COEFG(tm->coeff_g) |
-		TM_COEFR(tm->coeff_r);
-	hdr_write_relaxed(id, HDR_LSI_L_TM_COEF, val);
-	cal_log_debug(id, "COEFF: 0x%x\n", val);
-
-	val = TM_RNGX_MAXX(tm->rng_x_max) | TM_RNGX_MINX(tm->rng_x_min);
-	hdr_write_relaxed(id, HDR_LSI_L_TM_RNGX, val);
-	cal_log_debug(id, "RNGX: 0x%x\n", val);
-
-	val = TM_RNGY_MAXY(tm->rng_y_max) | TM_RNGY_MINY(tm->rng_y_min);
-	hdr_write_relaxed(id, HDR_LSI_L_TM_RNGY, val);
-	cal_log_debug(id, "RNGY: 0x%x\n", val);
-
-
-	ret = cal_pack_lut_into_reg_pairs(tm->posx, DRM_SAMSUNG_HDR_TM_LUT_LEN,
-			TM_POSX_L_MASK, TM_POSX_H_MASK, regs, HDR_TM_POSX_LUT_REG_CNT);
-	if(ret) {
-		cal_log_err(id, "Failed to pack tm_posx\n");
-	} else {
-		for (i = 0; i < HDR_TM_POSX_LUT_REG_CNT; i++) {
-			hdr_write_relaxed(id, HDR_LSI_L_TM_POSX(i), regs[i]);
-			cal_log_debug(id, "POSX[%d]: 0x%x\n", i, regs[i]);
+	if (!hdr_shadow_match(&shadow->tm, xxh64(tm, sizeof(*tm), 0),
+				&shadow->tm_src, tm, sizeof(*tm))) {
+		/* TM_COEF, TM_RNGX and TM_RNGY directly precede TM_POSX */
+		img[0] = TM_COEFB(tm->coeff_b) | TM_COEFG(tm->coeff_g) |
+			TM_COEFR(tm->coeff_r);
+		img[1] = TM_RNGX_MAXX(tm->rng_x_max) | TM_RNGX_MINX(tm->rng_x_min);
+		img[2] = TM_RNGY_MAXY(tm->rng_y_max) | TM_RNGY_MINY(tm->rng_y_min);
+
+		ret = cal_pack_lut_into_reg_pairs(tm->posx, DRM_SAMSUNG_HDR_TM_LUT_LEN,
+				TM_POSX_L_MASK, TM_POSX_H_MASK, &img[3],
+				HDR_TM_POSX_LUT_REG_CNT);
+		if (ret) {
+			cal_log_err(id, "Failed to pack tm_posx\n");
+			return;
 		}
-	}
+		for (i = 0; i < HDR_TM_POSY_LUT_REG_CNT; i++)
+			img[3 + HDR_TM_POSX_LUT_REG_CNT + i] = tm->posy[i];
 
-	for (i = 0; i < HDR_TM_POSY_LUT_REG_CNT; i++) {
-		hdr_write_relaxed(id, HDR_LSI_L_TM_POSY(i), tm->posy[i]);
-		cal_log_debug(id, "POSY[%d]: 0x%x\n", i, tm->posy[i]);
+		cal_write_seq(hdr_regs_desc(id), HDR_LSI_L_TM_COEF, img,
+				HDR_TM_IMG_CNT);
+		shadow->tm.valid = true;
+		cal_log_debug(id, "wrote %d regs\n", HDR_TM_IMG_CNT);
 	}
 
 	hdr_write_mask(id, HDR_LSI_L_MOD_CTRL, ~0, MOD_CTRL_TEN_MASK);
@@ -322,3 +635,7 @@ void hdr_reg_print_tm(u32 id, struct drm_printer *p)
 	hdr_reg_print(id, HDR_LSI_L_TM_POSY(0), DRM_SAMSUNG_HDR_TM_LUT_LEN,
 							ELEM_SIZE_32, p);
 }
+
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_KUNIT_TEST)
+#include "hdr_reg_test.c"
+#endif
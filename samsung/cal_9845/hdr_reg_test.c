@@ -0,0 +1,416 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * cal_9845/hdr_reg_test.c
+ *
+ * Copyright (c) 2020 Samsung Electronics Co., Ltd.
+ *		http://www.samsung.com
+ *
+ * KUnit tests for HDR LUT programming, included from hdr_reg.c. HDR0 is driven
+ * through the fake register backend, so the tests never reach the hardware.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <kunit/test.h>
+#include <cal_regs_record.h>
+
+#define HDR_TEST_ID		0
+#define HDR_TEST_REGS_SIZE	SZ_2K
+
+struct hdr_test {
+	struct device *dev;
+	struct cal_regs_recorder *rec;
+};
+
+static int hdr_test_init(struct kunit *test)
+{
+	struct hdr_test *t;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t);
+
+	t->dev = root_device_register("hdr_reg_test");
+	KUNIT_ASSERT_FALSE(test, IS_ERR(t->dev));
+
+	t->rec = cal_regs_recorder_create(t->dev, HDR_TEST_REGS_SIZE, 0, false);
+	KUNIT_ASSERT_NOT_NULL(test, t->rec);
+
+	cal_regs_recorder_attach(t->rec, hdr_regs_desc(HDR_TEST_ID));
+	hdr_reg_shadow_invalidate(HDR_TEST_ID);
+	test->priv = t;
+
+	return 0;
+}
+
+static void hdr_test_exit(struct kunit *test)
+{
+	struct hdr_test *t = test->priv;
+
+	cal_regs_recorder_detach(hdr_regs_desc(HDR_TEST_ID));
+	/* the hardware doesn't hold what the shadow says anymore */
+	hdr_reg_shadow_invalidate(HDR_TEST_ID);
+	root_device_unregister(t->dev);
+}
+
+static u32 hdr_test_commit(void)
+{
+	return cal_regs_recorder_commit(hdr_regs_desc(HDR_TEST_ID));
+}
+
+static struct hdr_eotf_lut *hdr_test_eotf(struct kunit *test, u32 seed)
+{
+	struct hdr_eotf_lut *lut;
+	int i;
+
+	lut = kunit_kzalloc(test, sizeof(*lut), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, lut);
+
+	for (i = 0; i < DRM_SAMSUNG_HDR_EOTF_LUT_LEN; i++) {
+		lut->posx[i] = i * 7;
+		lut->posy[i] = i * 500 + seed;
+	}
+
+	return lut;
+}
+
+static struct hdr_oetf_lut *hdr_test_oetf(struct kunit *test, u32 seed)
+{
+	struct hdr_oetf_lut *lut;
+	int i;
+
+	lut = kunit_kzalloc(test, sizeof(*lut), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, lut);
+
+	for (i = 0; i < DRM_SAMSUNG_HDR_OETF_LUT_LEN; i++) {
+		lut->posx[i] = i * 2000;
+		lut->posy[i] = i * 30 + seed;
+	}
+
+	return lut;
+}
+
+static struct hdr_gm_data *hdr_test_gm(struct kunit *test, u32 seed)
+{
+	struct hdr_gm_data *gm;
+	int i;
+
+	gm = kunit_kzalloc(test, sizeof(*gm), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, gm);
+
+	for (i = 0; i < HDR_GM_COEF_REG_CNT; i++)
+		gm->coeffs[i] = (i % 4) ? 0 : 0x10000 + seed;
+	for (i = 0; i < HDR_GM_OFFS_REG_CNT; i++)
+		gm->offsets[i] = seed;
+
+	return gm;
+}
+
+static struct hdr_tm_data *hdr_test_tm(struct kunit *test, u32 seed)
+{
+	struct hdr_tm_data *tm;
+	int i;
+
+	tm = kunit_kzalloc(test, sizeof(*tm), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, tm);
+
+	tm->coeff_r = 0x4c + seed;
+	tm->coeff_g = 0x96;
+	tm->coeff_b = 0x1d;
+	tm->rng_x_min = 0;
+	tm->rng_x_max = 0x3ff;
+	tm->rng_y_min = 0;
+	tm->rng_y_max = 0x1ff;
+	for (i = 0; i < DRM_SAMSUNG_HDR_TM_LUT_LEN; i++) {
+		tm->posx[i] = i * 32;
+		tm->posy[i] = i * 1000 + seed;
+	}
+
+	return tm;
+}
+
+/* the register image is what the blob packs into, at the documented offsets */
+static void hdr_test_eotf_image(struct kunit *test)
+{
+	struct hdr_eotf_lut *lut = hdr_test_eotf(test, 1);
+	u32 reg;
+	int i;
+
+	hdr_reg_set_eotf_lut(HDR_TEST_ID, lut);
+
+	for (i = 0; i < DRM_SAMSUNG_HDR_EOTF_LUT_LEN; i++) {
+		reg = hdr_read(HDR_TEST_ID, HDR_LSI_L_EOTF_POSX(i / 2));
+		KUNIT_EXPECT_EQ(test, (i & 1) ? cal_mask(reg, EOTF_POSX_H_MASK) :
+				cal_mask(reg, EOTF_POSX_L_MASK), (u32)lut->posx[i]);
+		KUNIT_EXPECT_EQ(test, hdr_read(HDR_TEST_ID, HDR_LSI_L_EOTF_POSY(i)),
+				(u32)lut->posy[i]);
+	}
+
+	KUNIT_EXPECT_TRUE(test, hdr_read_mask(HDR_TEST_ID, HDR_LSI_L_MOD_CTRL,
+				MOD_CTRL_EEN_MASK));
+}
+
+/* replays SDR<->HDR transitions of one stage and counts writes per commit */
+static void hdr_test_eotf_writes(struct kunit *test)
+{
+	struct hdr_eotf_lut *lut = hdr_test_eotf(test, 1);
+	struct hdr_eotf_lut *same = hdr_test_eotf(test, 1);
+	struct hdr_eotf_lut *other = hdr_test_eotf(test, 2);
+
+	hdr_reg_set_eotf_lut(HDR_TEST_ID, lut);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), HDR_EOTF_IMG_CNT + 1);
+
+	hdr_reg_set_eotf_lut(HDR_TEST_ID, lut);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), 1);
+
+	/* to SDR and back to the same content in a new blob: only the enable bit */
+	hdr_reg_set_eotf_lut(HDR_TEST_ID, NULL);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), 1);
+	KUNIT_EXPECT_FALSE(test, hdr_read_mask(HDR_TEST_ID, HDR_LSI_L_MOD_CTRL,
+				MOD_CTRL_EEN_MASK));
+
+	hdr_reg_set_eotf_lut(HDR_TEST_ID, same);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), 1);
+
+	hdr_reg_set_eotf_lut(HDR_TEST_ID, other);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), HDR_EOTF_IMG_CNT + 1);
+	KUNIT_EXPECT_EQ(test, hdr_read(HDR_TEST_ID, HDR_LSI_L_EOTF_POSY(0)),
+			(u32)other->posy[0]);
+
+	/* after a power cycle everything is written again */
+	hdr_reg_shadow_invalidate(HDR_TEST_ID);
+	hdr_reg_set_eotf_lut(HDR_TEST_ID, other);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), HDR_EOTF_IMG_CNT + 1);
+}
+
+/* a LUT whose hash collides with the programmed one is still written */
+static void hdr_test_hash_collision(struct kunit *test)
+{
+	struct hdr_shadow *shadow = &hdr_shadow[HDR_TEST_ID];
+	struct hdr_eotf_lut *lut = hdr_test_eotf(test, 1);
+	struct hdr_eotf_lut *other = hdr_test_eotf(test, 2);
+	struct hdr_tm_data *tm = hdr_test_tm(test, 1);
+	struct hdr_tm_data *tm_other = hdr_test_tm(test, 2);
+
+	hdr_reg_set_eotf_lut(HDR_TEST_ID, lut);
+	hdr_reg_set_tm(HDR_TEST_ID, tm);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), HDR_EOTF_IMG_CNT + 1 + HDR_TM_IMG_CNT + 1);
+
+	shadow->eotf.hash = xxh64(other, sizeof(*other), 0);
+	hdr_reg_set_eotf_lut(HDR_TEST_ID, other);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), HDR_EOTF_IMG_CNT + 1);
+	KUNIT_EXPECT_EQ(test, hdr_read(HDR_TEST_ID, HDR_LSI_L_EOTF_POSY(0)),
+			(u32)other->posy[0]);
+
+	shadow->tm.hash = xxh64(tm_other, sizeof(*tm_other), 0);
+	hdr_reg_set_tm(HDR_TEST_ID, tm_other);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), HDR_TM_IMG_CNT + 1);
+	KUNIT_EXPECT_EQ(test, hdr_read(HDR_TEST_ID, HDR_LSI_L_TM_POSY(1)), tm_other->posy[1]);
+}
+
+static void hdr_test_stage_writes(struct kunit *test)
+{
+	struct hdr_oetf_lut *oetf = hdr_test_oetf(test, 1);
+	struct hdr_gm_data *gm = hdr_test_gm(test, 1);
+	struct hdr_tm_data *tm = hdr_test_tm(test, 1);
+
+	hdr_reg_set_oetf_lut(HDR_TEST_ID, oetf);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), HDR_OETF_IMG_CNT + 1);
+	hdr_reg_set_gm(HDR_TEST_ID, gm);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), HDR_GM_IMG_CNT + 1);
+	hdr_reg_set_tm(HDR_TEST_ID, tm);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), HDR_TM_IMG_CNT + 1);
+
+	KUNIT_EXPECT_EQ(test, hdr_read(HDR_TEST_ID, HDR_LSI_L_GM_OFFS(0)), gm->offsets[0]);
+	KUNIT_EXPECT_EQ(test, hdr_read(HDR_TEST_ID, HDR_LSI_L_TM_POSY(1)), tm->posy[1]);
+
+	/* stages are tracked independently */
+	hdr_reg_set_oetf_lut(HDR_TEST_ID, NULL);
+	hdr_reg_set_gm(HDR_TEST_ID, NULL);
+	hdr_reg_set_tm(HDR_TEST_ID, NULL);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), 3);
+
+	hdr_reg_set_oetf_lut(HDR_TEST_ID, oetf);
+	hdr_reg_set_gm(HDR_TEST_ID, hdr_test_gm(test, 2));
+	hdr_reg_set_tm(HDR_TEST_ID, tm);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), 1 + HDR_GM_IMG_CNT + 1 + 1);
+}
+
+/*
+ * A preset and blobs holding the same LUTs must leave identical registers behind,
+ * and since they hash the same, switching between them writes nothing but enables.
+ */
+static void hdr_test_preset_matches_blobs(struct kunit *test)
+{
+	const enum hdr_preset *preset = test->param_value;
+	struct hdr_test *t = test->priv;
+	const struct hdr_preset_luts *luts;
+	struct hdr_eotf_lut *eotf;
+	struct hdr_oetf_lut *oetf;
+	struct hdr_gm_data *gm;
+	u32 *img;
+	int i;
+
+	KUNIT_ASSERT_EQ(test, hdr_reg_init_presets(), 0);
+	luts = hdr_reg_get_preset(*preset);
+	KUNIT_ASSERT_NOT_NULL(test, luts);
+
+	eotf = kunit_kmalloc(test, sizeof(*eotf), GFP_KERNEL);
+	oetf = kunit_kmalloc(test, sizeof(*oetf), GFP_KERNEL);
+	gm = kunit_kmalloc(test, sizeof(*gm), GFP_KERNEL);
+	img = kunit_kcalloc(test, HDR_TEST_REGS_SIZE / 4, sizeof(u32), GFP_KERNEL);
+	KUNIT_ASSERT_TRUE(test, eotf && oetf && gm && img);
+	memcpy(eotf, luts->eotf_lut, sizeof(*eotf));
+	memcpy(oetf, luts->oetf_lut, sizeof(*oetf));
+	memcpy(gm, luts->gm, sizeof(*gm));
+
+	hdr_reg_set_eotf_lut(HDR_TEST_ID, luts->eotf_lut);
+	hdr_reg_set_oetf_lut(HDR_TEST_ID, luts->oetf_lut);
+	hdr_reg_set_gm(HDR_TEST_ID, luts->gm);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(),
+			HDR_EOTF_IMG_CNT + HDR_OETF_IMG_CNT + HDR_GM_IMG_CNT + 3);
+	for (i = 0; i < HDR_TEST_REGS_SIZE / 4; i++)
+		img[i] = hdr_read(HDR_TEST_ID, i * 4);
+
+	hdr_reg_set_eotf_lut(HDR_TEST_ID, eotf);
+	hdr_reg_set_oetf_lut(HDR_TEST_ID, oetf);
+	hdr_reg_set_gm(HDR_TEST_ID, gm);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), 3);
+
+	/* force the blob path to pack and write everything itself */
+	hdr_reg_shadow_invalidate(HDR_TEST_ID);
+	memset(t->rec->shadow, 0, t->rec->shadow_size);
+	hdr_reg_set_eotf_lut(HDR_TEST_ID, eotf);
+	hdr_reg_set_oetf_lut(HDR_TEST_ID, oetf);
+	hdr_reg_set_gm(HDR_TEST_ID, gm);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(),
+			HDR_EOTF_IMG_CNT + HDR_OETF_IMG_CNT + HDR_GM_IMG_CNT + 3);
+
+	for (i = 0; i < HDR_TEST_REGS_SIZE / 4; i++)
+		KUNIT_EXPECT_EQ_MSG(test, hdr_read(HDR_TEST_ID, i * 4), img[i],
+				"register 0x%03x", i * 4);
+}
+
+static const enum hdr_preset hdr_test_presets[] = {
+	HDR_PRESET_PQ1000_P3,
+	HDR_PRESET_PQ4000_P3,
+	HDR_PRESET_HLG_P3,
+	HDR_PRESET_SRGB_P3,
+};
+
+static void hdr_test_preset_desc(const enum hdr_preset *preset, char *desc)
+{
+	snprintf(desc, KUNIT_PARAM_DESC_SIZE, "preset %d", *preset);
+}
+
+KUNIT_ARRAY_PARAM(hdr_test_preset, hdr_test_presets, hdr_test_preset_desc);
+
+/*
+ * Preset EOTF outputs at inputs 0, 256, 512 and the top code. The inner inputs are
+ * points of the exynos_hdr_lut.h tables, so the output is the table value scaled
+ * from 14 to 16 bits. The top code sits on the end point of the curve (1024, 16383),
+ * which the tables store as a distance from their last point.
+ */
+struct hdr_test_curve {
+	enum hdr_preset preset;
+	u16 posy[4];
+};
+
+static const struct hdr_test_curve hdr_test_curves[] = {
+	/* eotf_y_axis_st2084_1000[6] = 85, [21] = 1523 */
+	{ HDR_PRESET_PQ1000_P3, { 0, 85 * 4, 1523 * 4, 16383 * 4 } },
+	/* eotf_y_axis_st2084_4000[38] = 85, [48] = 1519 */
+	{ HDR_PRESET_PQ4000_P3, { 0, 85 * 4, 1519 * 4, 16383 * 4 } },
+	/* eotf_y_axis_hlg[8] = 341, [16] = 1365, 15699 + 684 at the end */
+	{ HDR_PRESET_HLG_P3, { 0, 341 * 4, 1365 * 4, 16383 * 4 } },
+	/* eotf_y_axis_srgb[14] = 832, [30] = 3499, 16202 + 181 at the end */
+	{ HDR_PRESET_SRGB_P3, { 0, 832 * 4, 3499 * 4, 16383 * 4 } },
+};
+
+static void hdr_test_curve_desc(const struct hdr_test_curve *curve, char *desc)
+{
+	snprintf(desc, KUNIT_PARAM_DESC_SIZE, "preset %d", curve->preset);
+}
+
+KUNIT_ARRAY_PARAM(hdr_test_curve, hdr_test_curves, hdr_test_curve_desc);
+
+static void hdr_test_preset_curve(struct kunit *test)
+{
+	const struct hdr_test_curve *curve = test->param_value;
+	const u32 last = DRM_SAMSUNG_HDR_EOTF_LUT_LEN - 1;
+	const u32 idx[] = { 0, last / 4, last / 2, last };
+	const struct hdr_preset_luts *luts;
+	const struct hdr_oetf_lut *oetf;
+	int i;
+
+	KUNIT_ASSERT_EQ(test, hdr_reg_init_presets(), 0);
+	luts = hdr_reg_get_preset(curve->preset);
+	KUNIT_ASSERT_NOT_NULL(test, luts);
+
+	KUNIT_EXPECT_EQ(test, luts->eotf_lut->posx[last / 4], 256);
+	KUNIT_EXPECT_EQ(test, luts->eotf_lut->posx[last / 2], 512);
+	KUNIT_EXPECT_EQ(test, luts->eotf_lut->posx[last], 1023);
+	for (i = 0; i < ARRAY_SIZE(idx); i++)
+		KUNIT_EXPECT_EQ_MSG(test, luts->eotf_lut->posy[idx[i]], curve->posy[i],
+				"eotf point %u", idx[i]);
+
+	/* all presets share the panel OETF, the inverse of the sRGB EOTF */
+	oetf = luts->oetf_lut;
+	KUNIT_EXPECT_EQ(test, oetf->posx[0], 0);
+	KUNIT_EXPECT_EQ(test, oetf->posy[0], 0);
+	/* eotf_x_axis_srgb[32] = 544, eotf_y_axis_srgb[32] = 3991 */
+	KUNIT_EXPECT_EQ(test, oetf->posx[DRM_SAMSUNG_HDR_OETF_LUT_LEN / 2], 3991 * 4);
+	KUNIT_EXPECT_EQ(test, oetf->posy[DRM_SAMSUNG_HDR_OETF_LUT_LEN / 2], 544);
+	KUNIT_EXPECT_EQ(test, oetf->posx[DRM_SAMSUNG_HDR_OETF_LUT_LEN - 1], U16_MAX);
+	KUNIT_EXPECT_EQ(test, oetf->posy[DRM_SAMSUNG_HDR_OETF_LUT_LEN - 1], 1023);
+}
+
+/* switching presets only rewrites the stages whose content differs */
+static void hdr_test_preset_switch(struct kunit *test)
+{
+	const struct hdr_preset_luts *pq1000, *pq4000;
+
+	KUNIT_ASSERT_EQ(test, hdr_reg_init_presets(), 0);
+	pq1000 = hdr_reg_get_preset(HDR_PRESET_PQ1000_P3);
+	pq4000 = hdr_reg_get_preset(HDR_PRESET_PQ4000_P3);
+	KUNIT_ASSERT_TRUE(test, pq1000 && pq4000);
+
+	hdr_reg_set_eotf_lut(HDR_TEST_ID, pq1000->eotf_lut);
+	hdr_reg_set_oetf_lut(HDR_TEST_ID, pq1000->oetf_lut);
+	hdr_reg_set_gm(HDR_TEST_ID, pq1000->gm);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(),
+			HDR_EOTF_IMG_CNT + HDR_OETF_IMG_CNT + HDR_GM_IMG_CNT + 3);
+
+	/* SDR frame in between */
+	hdr_reg_set_eotf_lut(HDR_TEST_ID, NULL);
+	hdr_reg_set_oetf_lut(HDR_TEST_ID, NULL);
+	hdr_reg_set_gm(HDR_TEST_ID, NULL);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), 3);
+
+	/* both PQ presets share the panel OETF and the BT.2020 to P3 gamut */
+	hdr_reg_set_eotf_lut(HDR_TEST_ID, pq4000->eotf_lut);
+	hdr_reg_set_oetf_lut(HDR_TEST_ID, pq4000->oetf_lut);
+	hdr_reg_set_gm(HDR_TEST_ID, pq4000->gm);
+	KUNIT_EXPECT_EQ(test, hdr_test_commit(), HDR_EOTF_IMG_CNT + 3);
+}
+
+static struct kunit_case hdr_test_cases[] = {
+	KUNIT_CASE(hdr_test_eotf_image),
+	KUNIT_CASE(hdr_test_eotf_writes),
+	KUNIT_CASE(hdr_test_hash_collision),
+	KUNIT_CASE(hdr_test_stage_writes),
+	KUNIT_CASE_PARAM(hdr_test_preset_matches_blobs, hdr_test_preset_gen_params),
+	KUNIT_CASE_PARAM(hdr_test_preset_curve, hdr_test_curve_gen_params),
+	KUNIT_CASE(hdr_test_preset_switch),
+	{}
+};
+
+static struct kunit_suite hdr_test_suite = {
+	.name = "exynos-drm-hdr-reg",
+	.init = hdr_test_init,
+	.exit = hdr_test_exit,
+	.test_cases = hdr_test_cases,
+};
+
+kunit_test_suite(hdr_test_suite);
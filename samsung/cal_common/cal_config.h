@@ -62,13 +62,36 @@ enum elem_size {
 	ELEM_SIZE_32 = 32,
 };
 
+struct cal_regs_desc;
+
+/*
+ * Register backend which, when attached to a cal_regs_desc, receives every
+ * access made through the cal_read/cal_write family instead of the MMIO
+ * window. Used to record or fake register traffic of a CAL block.
+ */
+struct cal_regs_backend {
+	uint32_t (*read)(struct cal_regs_desc *regs_desc, uint32_t offset);
+	void (*write)(struct cal_regs_desc *regs_desc, uint32_t offset,
+			uint32_t val);
+};
+
 struct cal_regs_desc {
 	const char *name;
 	void __iomem *regs;
 	volatile bool write_protected;
 	phys_addr_t start;
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_CAL_REGS_BACKEND)
+	const struct cal_regs_backend *backend;
+	void *backend_priv;
+#endif
 };
 
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_CAL_REGS_BACKEND)
+#define cal_regs_backend(regs_desc)	((regs_desc)->backend)
+#else
+#define cal_regs_backend(regs_desc)	((const struct cal_regs_backend *)NULL)
+#endif
+
 /* common function macro for register control file */
 /* to get cal_regs_desc */
 #define cal_regs_desc_check(type, id, type_max, id_max)		\
@@ -83,14 +106,8 @@ struct cal_regs_desc {
 	 cal_log_debug(id, "name(%s) type(%d) regs(%p)\n", name, type, regs);\
 	 })
 
-/* SFR read/write */
-static inline uint32_t cal_read(struct cal_regs_desc *regs_desc,
-		uint32_t offset)
-{
-	return readl(regs_desc->regs + offset);
-}
-
-static inline void cal_write(struct cal_regs_desc *regs_desc,
+/* SFR read/write, bypassing any attached backend */
+static inline void cal_write_hw(struct cal_regs_desc *regs_desc,
 		uint32_t offset, uint32_t val)
 {
 	if (unlikely(regs_desc->write_protected)) {
@@ -103,16 +120,48 @@ static inline void cal_write(struct cal_regs_desc *regs_desc,
 	}
 }
 
+/* SFR read/write */
+static inline uint32_t cal_read(struct cal_regs_desc *regs_desc,
+		uint32_t offset)
+{
+	const struct cal_regs_backend *backend = cal_regs_backend(regs_desc);
+
+	if (unlikely(backend))
+		return backend->read(regs_desc, offset);
+
+	return readl(regs_desc->regs + offset);
+}
+
+static inline void cal_write(struct cal_regs_desc *regs_desc,
+		uint32_t offset, uint32_t val)
+{
+	const struct cal_regs_backend *backend = cal_regs_backend(regs_desc);
+
+	if (unlikely(backend))
+		backend->write(regs_desc, offset, val);
+	else
+		cal_write_hw(regs_desc, offset, val);
+}
+
 static inline uint32_t cal_read_relaxed(struct cal_regs_desc *regs_desc,
 		uint32_t offset)
 {
+	const struct cal_regs_backend *backend = cal_regs_backend(regs_desc);
+
+	if (unlikely(backend))
+		return backend->read(regs_desc, offset);
+
 	return readl_relaxed(regs_desc->regs + offset);
 }
 
 static inline void cal_write_relaxed(struct cal_regs_desc *regs_desc,
 		uint32_t offset, uint32_t val)
 {
-	if (unlikely(regs_desc->write_protected)) {
+	const struct cal_regs_backend *backend = cal_regs_backend(regs_desc);
+
+	if (unlikely(backend)) {
+		backend->write(regs_desc, offset, val);
+	} else if (unlikely(regs_desc->write_protected)) {
 		int ret = set_priv_reg(regs_desc->start + offset, val);
 		if (ret)
 			pr_err("%s: smc update error %d for %llx\n", __func__,
@@ -122,6 +171,44 @@ static inline void cal_write_relaxed(struct cal_regs_desc *regs_desc,
 	}
 }
 
+/*
+ * Writes @count words to the same register, e.g. a FIFO port. The stores are
+ * relaxed and ordered against prior memory accesses by a single barrier.
+ */
+static inline void cal_write_burst(struct cal_regs_desc *regs_desc,
+		uint32_t offset, const uint32_t *buf, uint32_t count)
+{
+	uint32_t i;
+
+	if (unlikely(cal_regs_backend(regs_desc) ||
+		     regs_desc->write_protected)) {
+		for (i = 0; i < count; i++)
+			cal_write(regs_desc, offset, buf[i]);
+	} else {
+		dma_wmb();
+		writesl(regs_desc->regs + offset, buf, count);
+	}
+}
+
+/*
+ * Writes @count words to consecutive registers starting at @offset, e.g. a LUT.
+ * The stores are relaxed and ordered against later accesses by a single barrier.
+ */
+static inline void cal_write_seq(struct cal_regs_desc *regs_desc,
+		uint32_t offset, const uint32_t *buf, uint32_t count)
+{
+	uint32_t i;
+
+	if (unlikely(cal_regs_backend(regs_desc) ||
+		     regs_desc->write_protected)) {
+		for (i = 0; i < count; i++)
+			cal_write(regs_desc, offset + i * sizeof(uint32_t), buf[i]);
+	} else {
+		__iowrite32_copy(regs_desc->regs + offset, buf, count);
+		wmb();
+	}
+}
+
 static inline uint32_t cal_read_mask(struct cal_regs_desc *regs_desc,
 		uint32_t offset, uint32_t mask)
 {
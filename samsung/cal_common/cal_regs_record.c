@@ -0,0 +1,223 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * cal_common/cal_regs_record.c
+ *
+ * Copyright (c) 2021 Samsung Electronics Co., Ltd.
+ *		http://www.samsung.com
+ *
+ * Recording register backend for Samsung EXYNOS Display Driver CAL.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/device.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <drm/drm_print.h>
+
+#include <cal_regs_record.h>
+
+static inline struct cal_regs_recorder *
+to_recorder(struct cal_regs_desc *regs_desc)
+{
+	return regs_desc->backend_priv;
+}
+
+static uint32_t cal_regs_record_read(struct cal_regs_desc *regs_desc,
+		uint32_t offset)
+{
+	struct cal_regs_recorder *rec = to_recorder(regs_desc);
+	unsigned long flags;
+	uint32_t val = 0;
+
+	if (rec->passthrough)
+		return readl(regs_desc->regs + offset);
+
+	spin_lock_irqsave(&rec->lock, flags);
+	if (!WARN_ON(offset + sizeof(u32) > rec->shadow_size))
+		val = rec->shadow[offset / sizeof(u32)];
+	spin_unlock_irqrestore(&rec->lock, flags);
+
+	return val;
+}
+
+static void cal_regs_record_write(struct cal_regs_desc *regs_desc,
+		uint32_t offset, uint32_t val)
+{
+	struct cal_regs_recorder *rec = to_recorder(regs_desc);
+	unsigned long flags;
+
+	spin_lock_irqsave(&rec->lock, flags);
+	if (rec->log_cnt < rec->log_size) {
+		struct cal_regs_record_entry *entry = &rec->log[rec->log_cnt++];
+
+		entry->name = regs_desc->name;
+		entry->offset = offset;
+		entry->val = val;
+	} else {
+		rec->log_dropped++;
+	}
+	rec->commit_writes++;
+	rec->total_writes++;
+
+	if (!rec->passthrough && !WARN_ON(offset + sizeof(u32) > rec->shadow_size))
+		rec->shadow[offset / sizeof(u32)] = val;
+	spin_unlock_irqrestore(&rec->lock, flags);
+
+	if (rec->passthrough)
+		cal_write_hw(regs_desc, offset, val);
+}
+
+static const struct cal_regs_backend cal_regs_record_backend = {
+	.read = cal_regs_record_read,
+	.write = cal_regs_record_write,
+};
+
+/*
+ * Recorders are device managed so that a stale backend pointer observed by a
+ * concurrent register access right after detach still refers to valid memory.
+ */
+struct cal_regs_recorder *cal_regs_recorder_create(struct device *dev,
+		size_t shadow_size, uint32_t log_size, bool passthrough)
+{
+	struct cal_regs_recorder *rec;
+
+	rec = devm_kzalloc(dev, sizeof(*rec), GFP_KERNEL);
+	if (!rec)
+		return NULL;
+
+	if (!passthrough) {
+		rec->shadow = devm_kzalloc(dev, ALIGN(shadow_size, sizeof(u32)),
+				GFP_KERNEL);
+		if (!rec->shadow)
+			return NULL;
+		rec->shadow_size = shadow_size;
+	}
+
+	if (log_size) {
+		rec->log = devm_kcalloc(dev, log_size, sizeof(*rec->log),
+				GFP_KERNEL);
+		if (!rec->log)
+			return NULL;
+		rec->log_size = log_size;
+	}
+
+	spin_lock_init(&rec->lock);
+	rec->passthrough = passthrough;
+
+	return rec;
+}
+EXPORT_SYMBOL(cal_regs_recorder_create);
+
+void cal_regs_recorder_attach(struct cal_regs_recorder *rec,
+		struct cal_regs_desc *regs_desc)
+{
+	WRITE_ONCE(regs_desc->backend_priv, rec);
+	smp_wmb();
+	WRITE_ONCE(regs_desc->backend, &cal_regs_record_backend);
+}
+EXPORT_SYMBOL(cal_regs_recorder_attach);
+
+void cal_regs_recorder_detach(struct cal_regs_desc *regs_desc)
+{
+	WRITE_ONCE(regs_desc->backend, NULL);
+}
+EXPORT_SYMBOL(cal_regs_recorder_detach);
+
+void cal_regs_recorder_reset(struct cal_regs_recorder *rec)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&rec->lock, flags);
+	rec->log_cnt = 0;
+	rec->log_dropped = 0;
+	rec->commit_writes = 0;
+	rec->last_commit_writes = 0;
+	rec->max_commit_writes = 0;
+	rec->commit_cnt = 0;
+	rec->total_writes = 0;
+	spin_unlock_irqrestore(&rec->lock, flags);
+}
+EXPORT_SYMBOL(cal_regs_recorder_reset);
+
+/*
+ * Closes the current commit of the block described by @regs_desc and returns
+ * the number of register writes it took. Does nothing if no recorder is
+ * attached.
+ */
+uint32_t cal_regs_recorder_commit(struct cal_regs_desc *regs_desc)
+{
+	struct cal_regs_recorder *rec;
+	unsigned long flags;
+	uint32_t writes;
+
+	if (likely(!READ_ONCE(regs_desc->backend)))
+		return 0;
+
+	smp_rmb();
+	rec = READ_ONCE(regs_desc->backend_priv);
+
+	spin_lock_irqsave(&rec->lock, flags);
+	writes = rec->commit_writes;
+	rec->last_commit_writes = writes;
+	rec->max_commit_writes = max(rec->max_commit_writes, writes);
+	rec->commit_writes = 0;
+	rec->commit_cnt++;
+	spin_unlock_irqrestore(&rec->lock, flags);
+
+	return writes;
+}
+EXPORT_SYMBOL(cal_regs_recorder_commit);
+
+/*
+ * The log is copied out under the lock and printed after releasing it, so that
+ * register accesses of the recorded block aren't held off while printing.
+ */
+void cal_regs_recorder_print(struct cal_regs_recorder *rec,
+		struct drm_printer *p)
+{
+	struct cal_regs_record_entry *log = NULL;
+	uint32_t log_cnt, log_dropped, commit_cnt, last, max_writes;
+	u64 done_writes, total_writes;
+	unsigned long flags;
+	uint32_t i;
+
+	if (rec->log_size) {
+		log = kvmalloc_array(rec->log_size, sizeof(*log), GFP_KERNEL);
+		if (!log)
+			drm_printf(p, "failed to allocate log copy\n");
+	}
+
+	spin_lock_irqsave(&rec->lock, flags);
+	log_cnt = log ? rec->log_cnt : 0;
+	if (log_cnt)
+		memcpy(log, rec->log, log_cnt * sizeof(*log));
+	log_dropped = rec->log_dropped;
+	commit_cnt = rec->commit_cnt;
+	last = rec->last_commit_writes;
+	max_writes = rec->max_commit_writes;
+	total_writes = rec->total_writes;
+	done_writes = rec->total_writes - rec->commit_writes;
+	spin_unlock_irqrestore(&rec->lock, flags);
+
+	drm_printf(p, "mode: %s\n", rec->passthrough ? "passthrough" : "fake");
+	drm_printf(p, "commits: %u total writes: %llu\n", commit_cnt,
+			total_writes);
+	drm_printf(p, "writes per commit: last %u max %u avg %llu\n",
+			last, max_writes,
+			commit_cnt ? div_u64(done_writes, commit_cnt) : 0);
+	drm_printf(p, "recorded: %u dropped: %u\n", log_cnt, log_dropped);
+	for (i = 0; i < log_cnt; i++)
+		drm_printf(p, "%s+0x%04x <- 0x%08x\n",
+				log[i].name ? log[i].name : "",
+				log[i].offset, log[i].val);
+
+	kvfree(log);
+}
+EXPORT_SYMBOL(cal_regs_recorder_print);
+
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_KUNIT_TEST)
+#include "cal_regs_record_test.c"
+#endif
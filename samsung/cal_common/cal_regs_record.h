@@ -0,0 +1,72 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ *
+ * Copyright (c) 2021 Samsung Electronics Co., Ltd.
+ *		http://www.samsung.com
+ *
+ * Recording register backend for Samsung EXYNOS Display Driver CAL.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#ifndef __CAL_REGS_RECORD_H__
+#define __CAL_REGS_RECORD_H__
+
+#include <linux/spinlock.h>
+#include <cal_config.h>
+
+struct drm_printer;
+
+struct cal_regs_record_entry {
+	const char *name;
+	uint32_t offset;
+	uint32_t val;
+};
+
+/*
+ * Records every register write of the cal_regs_desc it is attached to. In
+ * fake mode accesses land in a shadow copy of the register window and never
+ * reach the hardware, in passthrough mode they are forwarded to the hardware
+ * after being recorded. Writes are also counted per commit, where the owner
+ * of the block marks commit boundaries with cal_regs_recorder_commit().
+ */
+struct cal_regs_recorder {
+	spinlock_t lock;
+	bool passthrough;
+
+	/* shadow register window, fake mode only */
+	uint32_t *shadow;
+	size_t shadow_size;
+
+	/* writes recorded since the last reset, excess writes are dropped */
+	struct cal_regs_record_entry *log;
+	uint32_t log_size;
+	uint32_t log_cnt;
+	uint32_t log_dropped;
+
+	uint32_t commit_writes;
+	uint32_t last_commit_writes;
+	uint32_t max_commit_writes;
+	uint32_t commit_cnt;
+	u64 total_writes;
+};
+
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_CAL_REGS_BACKEND)
+struct cal_regs_recorder *cal_regs_recorder_create(struct device *dev,
+		size_t shadow_size, uint32_t log_size, bool passthrough);
+void cal_regs_recorder_attach(struct cal_regs_recorder *rec,
+		struct cal_regs_desc *regs_desc);
+void cal_regs_recorder_detach(struct cal_regs_desc *regs_desc);
+void cal_regs_recorder_reset(struct cal_regs_recorder *rec);
+uint32_t cal_regs_recorder_commit(struct cal_regs_desc *regs_desc);
+void cal_regs_recorder_print(struct cal_regs_recorder *rec,
+		struct drm_printer *p);
+#else
+static inline uint32_t cal_regs_recorder_commit(struct cal_regs_desc *regs_desc)
+{
+	return 0;
+}
+#endif
+
+#endif /* __CAL_REGS_RECORD_H__ */
@@ -0,0 +1,229 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * cal_common/cal_regs_record_test.c
+ *
+ * Copyright (c) 2021 Samsung Electronics Co., Ltd.
+ *		http://www.samsung.com
+ *
+ * KUnit tests for the recording register backend, included from
+ * cal_regs_record.c.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <kunit/test.h>
+
+#define TEST_SHADOW_SIZE	0x100
+#define TEST_LOG_SIZE		16
+
+struct cal_regs_record_test {
+	struct device *dev;
+	struct cal_regs_recorder *rec;
+	/* no MMIO window, any access reaching the hardware faults */
+	struct cal_regs_desc desc;
+	u32 printed;
+};
+
+static int cal_regs_record_test_init(struct kunit *test)
+{
+	struct cal_regs_record_test *t;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t);
+
+	t->dev = root_device_register("cal_regs_record_test");
+	KUNIT_ASSERT_FALSE(test, IS_ERR(t->dev));
+
+	t->rec = cal_regs_recorder_create(t->dev, TEST_SHADOW_SIZE,
+			TEST_LOG_SIZE, false);
+	KUNIT_ASSERT_NOT_NULL(test, t->rec);
+
+	t->desc.name = "test";
+	cal_regs_recorder_attach(t->rec, &t->desc);
+	test->priv = t;
+
+	return 0;
+}
+
+static void cal_regs_record_test_exit(struct kunit *test)
+{
+	struct cal_regs_record_test *t = test->priv;
+
+	cal_regs_recorder_detach(&t->desc);
+	root_device_unregister(t->dev);
+}
+
+static void cal_regs_record_test_expect_entry(struct kunit *test, uint32_t idx,
+		uint32_t offset, uint32_t val)
+{
+	struct cal_regs_record_test *t = test->priv;
+
+	KUNIT_ASSERT_LT(test, idx, t->rec->log_cnt);
+	KUNIT_EXPECT_STREQ(test, t->rec->log[idx].name, "test");
+	KUNIT_EXPECT_EQ(test, t->rec->log[idx].offset, offset);
+	KUNIT_EXPECT_EQ(test, t->rec->log[idx].val, val);
+}
+
+static void cal_regs_record_test_fake_access(struct kunit *test)
+{
+	struct cal_regs_record_test *t = test->priv;
+
+	cal_write(&t->desc, 0x10, 0x12345678);
+	cal_write_relaxed(&t->desc, 0x14, 0x9abcdef0);
+
+	KUNIT_EXPECT_EQ(test, cal_read(&t->desc, 0x10), 0x12345678);
+	KUNIT_EXPECT_EQ(test, cal_read_relaxed(&t->desc, 0x14), 0x9abcdef0);
+	KUNIT_EXPECT_EQ(test, cal_read(&t->desc, 0x18), 0);
+
+	KUNIT_EXPECT_EQ(test, t->rec->log_cnt, 2);
+	cal_regs_record_test_expect_entry(test, 0, 0x10, 0x12345678);
+	cal_regs_record_test_expect_entry(test, 1, 0x14, 0x9abcdef0);
+}
+
+static void cal_regs_record_test_write_mask(struct kunit *test)
+{
+	struct cal_regs_record_test *t = test->priv;
+
+	cal_write(&t->desc, 0x20, 0xff00ff00);
+	cal_write_mask(&t->desc, 0x20, 0x00ab0000, 0x00ff0000);
+
+	KUNIT_EXPECT_EQ(test, cal_read(&t->desc, 0x20), 0xffabff00);
+	KUNIT_EXPECT_EQ(test, cal_read_mask(&t->desc, 0x20, 0xff00), 0xff00);
+
+	/* the read half of a masked write isn't a write */
+	KUNIT_EXPECT_EQ(test, t->rec->log_cnt, 2);
+	cal_regs_record_test_expect_entry(test, 1, 0x20, 0xffabff00);
+}
+
+static void cal_regs_record_test_seq_and_burst(struct kunit *test)
+{
+	struct cal_regs_record_test *t = test->priv;
+	const uint32_t buf[] = { 1, 2, 3, 4 };
+	int i;
+
+	cal_write_seq(&t->desc, 0x40, buf, ARRAY_SIZE(buf));
+	for (i = 0; i < ARRAY_SIZE(buf); i++) {
+		KUNIT_EXPECT_EQ(test, cal_read(&t->desc, 0x40 + i * 4), buf[i]);
+		cal_regs_record_test_expect_entry(test, i, 0x40 + i * 4, buf[i]);
+	}
+
+	cal_write_burst(&t->desc, 0x60, buf, ARRAY_SIZE(buf));
+	for (i = 0; i < ARRAY_SIZE(buf); i++)
+		cal_regs_record_test_expect_entry(test, ARRAY_SIZE(buf) + i, 0x60,
+				buf[i]);
+	KUNIT_EXPECT_EQ(test, cal_read(&t->desc, 0x60), buf[ARRAY_SIZE(buf) - 1]);
+	KUNIT_EXPECT_EQ(test, cal_read(&t->desc, 0x64), 0);
+}
+
+/* replays commits of a known number of writes and checks the accounting */
+static void cal_regs_record_test_commit_counts(struct kunit *test)
+{
+	struct cal_regs_record_test *t = test->priv;
+	const uint32_t writes[] = { 3, 0, 7, 1, 7 };
+	uint32_t i, j, total = 0;
+
+	for (i = 0; i < ARRAY_SIZE(writes); i++) {
+		for (j = 0; j < writes[i]; j++)
+			cal_write(&t->desc, j * 4, i);
+
+		KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(&t->desc),
+				writes[i]);
+		KUNIT_EXPECT_EQ(test, t->rec->last_commit_writes, writes[i]);
+		total += writes[i];
+	}
+
+	KUNIT_EXPECT_EQ(test, t->rec->commit_cnt, ARRAY_SIZE(writes));
+	KUNIT_EXPECT_EQ(test, t->rec->max_commit_writes, 7);
+	KUNIT_EXPECT_EQ(test, t->rec->total_writes, total);
+	KUNIT_EXPECT_EQ(test, t->rec->commit_writes, 0);
+
+	/* the last commit left its values in the shadow */
+	for (j = 0; j < 7; j++)
+		KUNIT_EXPECT_EQ(test, cal_read(&t->desc, j * 4), 4);
+}
+
+static void cal_regs_record_test_log_overflow(struct kunit *test)
+{
+	struct cal_regs_record_test *t = test->priv;
+	uint32_t i;
+
+	for (i = 0; i < TEST_LOG_SIZE + 5; i++)
+		cal_write(&t->desc, 0, i);
+
+	KUNIT_EXPECT_EQ(test, t->rec->log_cnt, TEST_LOG_SIZE);
+	KUNIT_EXPECT_EQ(test, t->rec->log_dropped, 5);
+	cal_regs_record_test_expect_entry(test, TEST_LOG_SIZE - 1, 0,
+			TEST_LOG_SIZE - 1);
+
+	/* dropped entries are still counted and still reach the shadow */
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(&t->desc),
+			TEST_LOG_SIZE + 5);
+	KUNIT_EXPECT_EQ(test, cal_read(&t->desc, 0), TEST_LOG_SIZE + 4);
+
+	cal_regs_recorder_reset(t->rec);
+	KUNIT_EXPECT_EQ(test, t->rec->log_cnt, 0);
+	KUNIT_EXPECT_EQ(test, t->rec->log_dropped, 0);
+	KUNIT_EXPECT_EQ(test, t->rec->commit_cnt, 0);
+	KUNIT_EXPECT_EQ(test, t->rec->total_writes, 0);
+}
+
+static void cal_regs_record_test_detached(struct kunit *test)
+{
+	struct cal_regs_record_test *t = test->priv;
+
+	cal_write(&t->desc, 0, 1);
+	cal_regs_recorder_detach(&t->desc);
+
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(&t->desc), 0);
+	KUNIT_EXPECT_EQ(test, t->rec->commit_cnt, 0);
+}
+
+/* register accesses from the printer must not deadlock against the print */
+static void cal_regs_record_test_printfn(struct drm_printer *p,
+		struct va_format *vaf)
+{
+	struct cal_regs_record_test *t = p->arg;
+
+	cal_write(&t->desc, 0x80, t->printed++);
+}
+
+static void cal_regs_record_test_print(struct kunit *test)
+{
+	struct cal_regs_record_test *t = test->priv;
+	struct drm_printer p = {
+		.printfn = cal_regs_record_test_printfn,
+		.arg = t,
+	};
+	uint32_t i;
+
+	for (i = 0; i < 4; i++)
+		cal_write(&t->desc, i * 4, i);
+
+	cal_regs_recorder_print(t->rec, &p);
+
+	/* 4 header lines and one line per recorded write */
+	KUNIT_EXPECT_EQ(test, t->printed, 4 + 4);
+	KUNIT_EXPECT_EQ(test, t->rec->log_cnt, 4 + t->printed);
+}
+
+static struct kunit_case cal_regs_record_test_cases[] = {
+	KUNIT_CASE(cal_regs_record_test_fake_access),
+	KUNIT_CASE(cal_regs_record_test_write_mask),
+	KUNIT_CASE(cal_regs_record_test_seq_and_burst),
+	KUNIT_CASE(cal_regs_record_test_commit_counts),
+	KUNIT_CASE(cal_regs_record_test_log_overflow),
+	KUNIT_CASE(cal_regs_record_test_detached),
+	KUNIT_CASE(cal_regs_record_test_print),
+	{}
+};
+
+static struct kunit_suite cal_regs_record_test_suite = {
+	.name = "exynos-drm-cal-regs-record",
+	.init = cal_regs_record_test_init,
+	.exit = cal_regs_record_test_exit,
+	.test_cases = cal_regs_record_test_cases,
+};
+
+kunit_test_suite(cal_regs_record_test_suite);
@@ -211,6 +211,9 @@ struct dpp_params_info {
 	u32 dataspace;
 	int h_ratio;
 	int v_ratio;
+	/* scaler position of the first output pixel, 12.20 fixed point */
+	u32 h_pos;
+	u32 v_pos;
 	u32 standard;
 	u32 transfer;
 	u32 range;
@@ -22,6 +22,13 @@
 #define DEGAMMA_LUT_SIZE		65
 #define REGAMMA_LUT_SIZE		65
 #define CGC_LUT_SIZE			4913
+/*
+ * CGC LUT registers are rewritten in blocks, each covering a contiguous 128 point slab of
+ * the 17x17x17 cube.
+ */
+#define CGC_LUT_BLOCK_REG_CNT		64
+#define CGC_LUT_BLOCK_CNT		\
+	DIV_ROUND_UP(DRM_SAMSUNG_CGC_LUT_REG_CNT, CGC_LUT_BLOCK_REG_CNT)
 #define HIST_BIN_SIZE			256
 #define LPD_ATC_REG_CNT			45
 #define GAMMA_MATRIX_COEFFS_CNT		9
@@ -174,8 +181,14 @@ void dqe_regs_desc_init(void __iomem *regs, phys_addr_t start, const char *name,
 			enum dqe_version ver, u32 dqe_id);
 void dqe_reg_init(u32 dqe_id, u32 width, u32 height);
 void dqe_reg_set_degamma_lut(u32 dqe_id, const struct drm_color_lut *lut);
+void dqe_reg_set_degamma_lut_range(u32 dqe_id, const struct drm_color_lut *lut,
+				   u32 start, u32 end);
 void dqe_reg_set_cgc_lut(u32 dqe_id, const struct cgc_lut *lut);
+void dqe_reg_set_cgc_lut_blocks(u32 dqe_id, const struct cgc_lut *lut,
+				const unsigned long *blocks);
 void dqe_reg_set_regamma_lut(u32 dqe_id, const struct drm_color_lut *lut);
+void dqe_reg_set_regamma_lut_range(u32 dqe_id, const struct drm_color_lut *lut,
+				   u32 start, u32 end);
 void dqe_reg_set_cgc_dither(u32 dqe_id, struct dither_config *config);
 void dqe_reg_set_disp_dither(u32 dqe_id, struct dither_config *config);
 void dqe_reg_set_linear_matrix(u32 dqe_id, const struct exynos_matrix *lm);
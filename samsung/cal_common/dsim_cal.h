@@ -13,6 +13,7 @@
 #ifndef __SAMSUNG_DSIM_CAL_H__
 #define __SAMSUNG_DSIM_CAL_H__
 
+#include <cal_config.h>
 #include <exynos_panel.h>
 
 #define MAX_DSI_CNT 2
@@ -75,6 +76,10 @@ enum dsim_regs_type {
 	REGS_DSIM_TYPE_MAX
 };
 
+extern struct cal_regs_desc regs_dsim[REGS_DSIM_TYPE_MAX][MAX_DSI_CNT];
+
+#define dsim_regs_desc(id)			(&regs_dsim[REGS_DSIM_DSI][id])
+
 enum {
 	DSIM_COLOR_BAR = 0,
 	DSIM_GRAY_GRADATION,
@@ -216,6 +221,7 @@ void dsim_reg_clear_int(u32 id, u32 int_src);
 /* DSIM read/write command control */
 void dsim_reg_wr_tx_header(u32 id, u8 di, u8 d0, u8 d1, bool bta);
 void dsim_reg_wr_tx_payload(u32 id, u32 payload);
+void dsim_reg_wr_tx_payload_burst(u32 id, const u32 *payload, u32 cnt);
 u32 dsim_reg_header_fifo_is_empty(u32 id);
 u32 dsim_reg_payload_fifo_is_empty(u32 id);
 u32 dsim_reg_get_rx_fifo(u32 id);
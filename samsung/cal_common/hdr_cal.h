@@ -15,7 +15,26 @@
 
 #include <drm/samsung_drm.h>
 
+/* built-in EOTF/OETF/GM combinations, see hdr_reg_init_presets() */
+enum hdr_preset {
+	HDR_PRESET_NONE = 0,
+	HDR_PRESET_PQ1000_P3,
+	HDR_PRESET_PQ4000_P3,
+	HDR_PRESET_HLG_P3,
+	HDR_PRESET_SRGB_P3,
+	HDR_PRESET_MAX,
+};
+
+struct hdr_preset_luts {
+	struct hdr_eotf_lut *eotf_lut;
+	struct hdr_oetf_lut *oetf_lut;
+	struct hdr_gm_data *gm;
+};
+
 void hdr_regs_desc_init(void __iomem *regs, phys_addr_t start, const char *name, u32 id);
+void hdr_reg_shadow_invalidate(u32 id);
+int hdr_reg_init_presets(void);
+const struct hdr_preset_luts *hdr_reg_get_preset(enum hdr_preset preset);
 void hdr_reg_set_hdr(u32 id, bool en);
 void hdr_reg_set_eotf_lut(u32 id, struct hdr_eotf_lut *lut);
 void hdr_reg_set_oetf_lut(u32 id, struct hdr_oetf_lut *lut);
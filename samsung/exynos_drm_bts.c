@@ -34,6 +34,8 @@
 #endif
 
 #include <linux/kernel.h>
+#include <linux/moduleparam.h>
+#include <linux/sort.h>
 #include <trace/dpu_trace.h>
 #include "exynos_drm_decon.h"
 #include "exynos_drm_format.h"
@@ -53,6 +55,11 @@
 #define DPU_INFO_BTS(fmt, args...)	pr_info("[BTS] "fmt,  ##args)
 #define DPU_ERR_BTS(fmt, args...)	pr_err("[BTS] "fmt, ##args)
 
+static bool dpu_bts_legacy_overlap;
+module_param_named(bts_legacy_overlap, dpu_bts_legacy_overlap, bool, 0644);
+MODULE_PARM_DESC(bts_legacy_overlap,
+		 "use window start line based overlap bw calculation instead of sweep line");
+
 /*
  * 1. function clock
  *    panel_clk = panel_w * panel_h * fps * margin / ppc
@@ -451,7 +458,7 @@ static u32 dpu_bts_find_max_overlap_bw(struct decon_device *decon,
 	u32 max_overlap_bw = 0;
 
 	/* overlap rt bandwidth requirement */
-	/* TODO: take write rt bandwidth into account */
+	/* write rt bandwidth is only accounted for by the sweep line calculation */
 	for (i = 0; i < decon->win_cnt; i++) {
 		u32 overlap_bw;
 
@@ -477,15 +484,33 @@ static u32 dpu_bts_find_max_overlap_bw(struct decon_device *decon,
 	return max_overlap_bw;
 }
 
+static u32 dpu_bts_find_max_ch_bw(struct decon_device *decon, u32 disp_ch_bw[MAX_AXI_PORT])
+{
+	u32 max_disp_ch_bw;
+	int i;
+
+	/* must be considered other decon's bw */
+	dpu_bts_sum_all_decon_bw(decon, disp_ch_bw);
+
+	for (i = 0; i < MAX_AXI_PORT; ++i)
+		if (disp_ch_bw[i])
+			DPU_DEBUG_BTS("  AXI_DPU%d = %u\n", i, disp_ch_bw[i]);
+
+	max_disp_ch_bw = disp_ch_bw[0];
+	for (i = 1; i < MAX_AXI_PORT; ++i)
+		max_disp_ch_bw = max(max_disp_ch_bw, disp_ch_bw[i]);
+
+	return max_disp_ch_bw;
+}
+
 static u32 dpu_bts_find_max_disp_ch_bw(struct decon_device *decon,
 		struct dpu_bts_win_config *config)
 {
 	int i, j;
 	u32 disp_ch_bw[MAX_AXI_PORT];
-	u32 max_disp_ch_bw;
 
 	/* DPU AXI bandwidth requirement */
-	/* TODO: take write rt bandwidth into account */
+	/* write rt bandwidth is only accounted for by the sweep line calculation */
 	memset(disp_ch_bw, 0, sizeof(disp_ch_bw));
 	for (i = 0; i < decon->win_cnt; i++) {
 		int dpp_ch = config[i].dpp_ch;
@@ -515,18 +540,137 @@ static u32 dpu_bts_find_max_disp_ch_bw(struct decon_device *decon,
 		disp_ch_bw[ch_num] = max(disp_ch_bw[ch_num], overlap_ch_bw);
 	}
 
-	/* must be considered other decon's bw */
-	dpu_bts_sum_all_decon_bw(decon, disp_ch_bw);
+	return dpu_bts_find_max_ch_bw(decon, disp_ch_bw);
+}
 
-	for (i = 0; i < MAX_AXI_PORT; ++i)
-		if (disp_ch_bw[i])
-			DPU_DEBUG_BTS("  AXI_DPU%d = %u\n", i, disp_ch_bw[i]);
+/*
+ * Vertical boundary of a layer for overlap calculation. Layer bandwidth is added at its
+ * first line (bw > 0) and removed after its last line (bw < 0).
+ */
+struct dpu_bts_edge {
+	u32 y;
+	s32 bw;
+	u32 ch_num;
+};
 
-	max_disp_ch_bw = disp_ch_bw[0];
-	for (i = 1; i < MAX_AXI_PORT; ++i)
-		max_disp_ch_bw = max(max_disp_ch_bw, disp_ch_bw[i]);
+static int dpu_bts_edge_cmp(const void *a, const void *b)
+{
+	const struct dpu_bts_edge *e0 = a, *e1 = b;
 
-	return max_disp_ch_bw;
+	if (e0->y != e1->y)
+		return e0->y < e1->y ? -1 : 1;
+
+	/* layers are half open [y1, y2), remove ending layers before adding starting ones */
+	if (e0->bw != e1->bw)
+		return e0->bw < e1->bw ? -1 : 1;
+
+	return 0;
+}
+
+static u32 dpu_bts_add_win_edges(struct decon_device *decon,
+		const struct dpu_bts_win_config *config, struct dpu_bts_edge *edges)
+{
+	u32 cnt = 0;
+	int i;
+
+	for (i = 0; i < decon->win_cnt; i++) {
+		const int dpp_ch = config[i].dpp_ch;
+		const struct dpu_bts_bw *rt_bw = &decon->bts.rt_bw[dpp_ch];
+		const int y1 = max(config[i].dst_y, 0);
+		const int y2 = max(config[i].dst_y + (int)config[i].dst_h, 0);
+
+		/*
+		 * Layers entirely above the panel are skipped, their end edge would sort before
+		 * their start edge and take the running sum below zero.
+		 */
+		if (config[i].state != DPU_WIN_STATE_BUFFER || !rt_bw->val || y2 <= y1)
+			continue;
+
+		edges[cnt].y = y1;
+		edges[cnt].bw = rt_bw->val;
+		edges[cnt].ch_num = rt_bw->ch_num;
+		cnt++;
+
+		edges[cnt].y = y2;
+		edges[cnt].bw = -(s32)rt_bw->val;
+		edges[cnt].ch_num = rt_bw->ch_num;
+		cnt++;
+	}
+
+	return cnt;
+}
+
+/*
+ * ODMA writes out the blended frame line by line while the layers are being read, so the
+ * writeback stream overlaps with every line of the panel.
+ */
+static u32 dpu_bts_add_wb_edges(struct decon_device *decon,
+		const struct dpu_bts_win_config *config, struct dpu_bts_edge *edges)
+{
+	const struct dpu_bts_bw *rt_bw;
+
+	if (config->state != DPU_WIN_STATE_BUFFER)
+		return 0;
+
+	if (config->dpp_ch < 0 || config->dpp_ch >= MAX_DPP_CNT) {
+		pr_err("invalid writeback channel %d\n", config->dpp_ch);
+		return 0;
+	}
+
+	rt_bw = &decon->bts.rt_bw[config->dpp_ch];
+	if (!rt_bw->val)
+		return 0;
+
+	edges[0].y = 0;
+	edges[0].bw = rt_bw->val;
+	edges[0].ch_num = rt_bw->ch_num;
+
+	edges[1].y = decon->config.image_height;
+	edges[1].bw = -(s32)rt_bw->val;
+	edges[1].ch_num = rt_bw->ch_num;
+
+	return 2;
+}
+
+/*
+ * Sweep through layer boundaries sorted by line to find the exact peak of concurrent
+ * read and writeback bandwidth, both overall and per AXI channel. Unlike the legacy
+ * calculation this takes into account that staggered layers may never be read at the
+ * same time.
+ */
+static void dpu_bts_sweep_overlap_bw(struct decon_device *decon,
+		const struct dpu_bts_win_config *config, u32 *max_overlap_bw,
+		u32 disp_ch_bw[MAX_AXI_PORT])
+{
+	struct dpu_bts_edge edges[(MAX_WIN_PER_DECON + 1) * 2];
+	s64 ch_bw[MAX_AXI_PORT] = { 0 };
+	s64 overlap_bw = 0;
+	u32 cnt;
+	int i;
+
+	*max_overlap_bw = 0;
+	memset(disp_ch_bw, 0, sizeof(u32) * MAX_AXI_PORT);
+
+	cnt = dpu_bts_add_win_edges(decon, config, edges);
+	cnt += dpu_bts_add_wb_edges(decon, &decon->bts.wb_config, &edges[cnt]);
+	sort(edges, cnt, sizeof(edges[0]), dpu_bts_edge_cmp, NULL);
+
+	for (i = 0; i < cnt; i++) {
+		const u32 ch_num = edges[i].ch_num;
+
+		overlap_bw += edges[i].bw;
+		if (edges[i].bw > 0)
+			*max_overlap_bw = max_t(u32, *max_overlap_bw, overlap_bw);
+
+		if (ch_num >= MAX_AXI_PORT) {
+			pr_err("invalid DPU AXI channel number %u\n", ch_num);
+			continue;
+		}
+
+		ch_bw[ch_num] += edges[i].bw;
+		if (edges[i].bw > 0)
+			disp_ch_bw[ch_num] = max_t(u32, disp_ch_bw[ch_num], ch_bw[ch_num]);
+	}
 }
 
 static void dpu_bts_find_max_disp_freq(struct decon_device *decon)
@@ -534,21 +678,30 @@ static void dpu_bts_find_max_disp_freq(struct decon_device *decon)
 	int i;
 	u32 max_overlap_bw;
 	u32 max_disp_ch_bw;
+	u32 disp_ch_bw[MAX_AXI_PORT];
 	u32 disp_op_freq = 0;
 	struct dpu_bts_win_config *config = decon->bts.win_config;
 
-	max_overlap_bw = dpu_bts_find_max_overlap_bw(decon, config);
-	max_disp_ch_bw = dpu_bts_find_max_disp_ch_bw(decon, config);
+	dpu_bts_sweep_overlap_bw(decon, config, &max_overlap_bw, disp_ch_bw);
+
+	if (unlikely(dpu_bts_legacy_overlap)) {
+		DPU_DEBUG_BTS("  sweep line overlap bw(%u)\n", max_overlap_bw);
+		max_overlap_bw = dpu_bts_find_max_overlap_bw(decon, config);
+		max_disp_ch_bw = dpu_bts_find_max_disp_ch_bw(decon, config);
+	} else {
+		max_disp_ch_bw = dpu_bts_find_max_ch_bw(decon, disp_ch_bw);
+	}
 	decon->bts.max_disp_freq = max_disp_ch_bw * 100 /
 			(decon->bts.bus_width * decon->bts.bus_util_pct);
 
 	/* TODO: the final INT should be max(max_peak_bw, total_peak_bw / NUM_DRAM_CH). It nees
 	 * some changes in bts driver to allow client request peak_bw. Before we lock down the
 	 * design, DPU requests max(max_ch_bw, max_overlap_bw / NUM_INTERCONNECT_CH) as peak.
-	 * After we take write bw into account, we don't need to check write bw here.
+	 * Write bw is already part of the overlap unless the legacy calculation is used.
 	 */
-	decon->bts.peak = max3(max_disp_ch_bw, max_overlap_bw / NUM_INTERCONNECT_CH,
-				decon->bts.write_bw);
+	decon->bts.peak = max(max_disp_ch_bw, max_overlap_bw / NUM_INTERCONNECT_CH);
+	if (unlikely(dpu_bts_legacy_overlap))
+		decon->bts.peak = max(decon->bts.peak, decon->bts.write_bw);
 	decon->bts.rt_avg_bw = max_overlap_bw;
 
 	for (i = 0; i < decon->win_cnt; ++i) {
@@ -652,7 +805,7 @@ static void dpu_bts_convert_config_to_info(struct bts_dpp_info *dpp,
 	const struct dpu_fmt *fmt_info;
 
 	fmt_info = dpu_find_fmt_info(config->format);
-	dpp->bpp = fmt_info->bpp + fmt_info->padding;
+	dpp->bpp = fmt_info->total_bpp;
 	dpp->src_w = config->src_w;
 	dpp->src_h = config->src_h;
 	dpp->dst.x1 = config->dst_x;
@@ -921,3 +1074,7 @@ struct dpu_bts_ops dpu_bts_control = {
 	.release_bw	= dpu_bts_release_resources,
 	.deinit		= dpu_bts_deinit,
 };
+
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_KUNIT_TEST)
+#include "exynos_drm_bts_test.c"
+#endif
@@ -0,0 +1,302 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the overlap bandwidth calculation, included from exynos_drm_bts.c.
+ *
+ * Copyright (C) 2020 Samsung Electronics Co.Ltd
+ */
+
+#include <kunit/test.h>
+#include <linux/prandom.h>
+
+#define BTS_TEST_HEIGHT		2400
+#define BTS_TEST_LAYOUTS	500
+
+struct bts_test_peak {
+	u32 overlap_bw;
+	u32 ch_bw[MAX_AXI_PORT];
+};
+
+static int bts_test_init(struct kunit *test)
+{
+	struct decon_device *decon;
+
+	decon = kunit_kzalloc(test, sizeof(*decon), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, decon);
+
+	decon->win_cnt = MAX_WIN_PER_DECON;
+	decon->config.image_height = BTS_TEST_HEIGHT;
+	decon->bts.wb_config.state = DPU_WIN_STATE_DISABLED;
+	test->priv = decon;
+
+	return 0;
+}
+
+/* reference peak: the bandwidth of every buffer layer and writeback summed line by line */
+static void bts_test_scan_peak(const struct decon_device *decon,
+		const struct dpu_bts_win_config *config, struct bts_test_peak *peak)
+{
+	const struct dpu_bts_win_config *wb = &decon->bts.wb_config;
+	int y, i;
+
+	memset(peak, 0, sizeof(*peak));
+
+	for (y = 0; y < 2 * BTS_TEST_HEIGHT; y++) {
+		u32 line_ch_bw[MAX_AXI_PORT] = { 0 };
+		u32 line_bw = 0;
+
+		for (i = 0; i < decon->win_cnt; i++) {
+			const struct dpu_bts_bw *rt_bw = &decon->bts.rt_bw[config[i].dpp_ch];
+
+			if (config[i].state != DPU_WIN_STATE_BUFFER || y < config[i].dst_y ||
+					y >= config[i].dst_y + (int)config[i].dst_h)
+				continue;
+
+			line_bw += rt_bw->val;
+			line_ch_bw[rt_bw->ch_num] += rt_bw->val;
+		}
+
+		if (wb->state == DPU_WIN_STATE_BUFFER && y < decon->config.image_height) {
+			const struct dpu_bts_bw *rt_bw = &decon->bts.rt_bw[wb->dpp_ch];
+
+			line_bw += rt_bw->val;
+			line_ch_bw[rt_bw->ch_num] += rt_bw->val;
+		}
+
+		peak->overlap_bw = max(peak->overlap_bw, line_bw);
+		for (i = 0; i < MAX_AXI_PORT; i++)
+			peak->ch_bw[i] = max(peak->ch_bw[i], line_ch_bw[i]);
+	}
+}
+
+static void bts_test_sweep(struct decon_device *decon, const struct dpu_bts_win_config *config,
+		struct bts_test_peak *peak)
+{
+	dpu_bts_sweep_overlap_bw(decon, config, &peak->overlap_bw, peak->ch_bw);
+}
+
+static u32 bts_test_max_ch_bw(const struct bts_test_peak *peak)
+{
+	u32 max_bw = 0;
+	int i;
+
+	for (i = 0; i < MAX_AXI_PORT; i++)
+		max_bw = max(max_bw, peak->ch_bw[i]);
+
+	return max_bw;
+}
+
+static void bts_test_random_layout(struct decon_device *decon,
+		struct dpu_bts_win_config *config, struct rnd_state *rnd)
+{
+	int i;
+
+	memset(config, 0, sizeof(*config) * MAX_WIN_PER_DECON);
+
+	for (i = 0; i < decon->win_cnt; i++) {
+		struct dpu_bts_bw *rt_bw = &decon->bts.rt_bw[i];
+		const u32 r = prandom_u32_state(rnd);
+
+		/* mostly buffers, sometimes a color fill or a disabled window in between */
+		config[i].state = (r % 8) ? DPU_WIN_STATE_BUFFER :
+			((r >> 3) & 1) ? DPU_WIN_STATE_COLOR : DPU_WIN_STATE_DISABLED;
+		config[i].dpp_ch = i;
+		/* partly above the panel and empty layers included */
+		config[i].dst_y = (int)(prandom_u32_state(rnd) % (BTS_TEST_HEIGHT * 5 / 4)) -
+			BTS_TEST_HEIGHT / 4;
+		config[i].dst_h = prandom_u32_state(rnd) % (BTS_TEST_HEIGHT + 1);
+
+		rt_bw->val = prandom_u32_state(rnd) % (1 << 20) + 1;
+		rt_bw->ch_num = prandom_u32_state(rnd) % MAX_AXI_PORT;
+	}
+}
+
+/*
+ * Random layouts: the sweep line finds exactly the peak of the line by line sum, which
+ * the legacy start line calculation never goes below.
+ */
+static void bts_test_random(struct kunit *test)
+{
+	struct decon_device *decon = test->priv;
+	struct dpu_bts_win_config config[MAX_WIN_PER_DECON];
+	struct bts_test_peak sweep, scan;
+	struct rnd_state rnd;
+	u32 tighter = 0;
+	int n, i;
+
+	prandom_seed_state(&rnd, 0x9845);
+
+	for (n = 0; n < BTS_TEST_LAYOUTS; n++) {
+		u32 legacy_bw, legacy_ch_bw;
+
+		bts_test_random_layout(decon, config, &rnd);
+		bts_test_scan_peak(decon, config, &scan);
+		bts_test_sweep(decon, config, &sweep);
+
+		KUNIT_EXPECT_EQ_MSG(test, sweep.overlap_bw, scan.overlap_bw, "layout %d", n);
+		for (i = 0; i < MAX_AXI_PORT; i++)
+			KUNIT_EXPECT_EQ_MSG(test, sweep.ch_bw[i], scan.ch_bw[i],
+					"layout %d channel %d", n, i);
+
+		memset(decon->bts.ch_bw, 0, sizeof(decon->bts.ch_bw));
+		legacy_bw = dpu_bts_find_max_overlap_bw(decon, config);
+		legacy_ch_bw = dpu_bts_find_max_disp_ch_bw(decon, config);
+		KUNIT_EXPECT_LE_MSG(test, sweep.overlap_bw, legacy_bw, "layout %d", n);
+		KUNIT_EXPECT_LE_MSG(test, bts_test_max_ch_bw(&sweep), legacy_ch_bw,
+				"layout %d", n);
+
+		if (sweep.overlap_bw < legacy_bw)
+			tighter++;
+	}
+
+	kunit_info(test, "sweep line below legacy estimate in %u of %d layouts\n", tighter,
+		   BTS_TEST_LAYOUTS);
+}
+
+/*
+ * Layers stacked top to bottom never share a line, whatever their order in the config. A
+ * layer ending on the line the next one starts on doesn't overlap with it.
+ */
+static void bts_test_stacked(struct kunit *test)
+{
+	struct decon_device *decon = test->priv;
+	struct dpu_bts_win_config config[MAX_WIN_PER_DECON] = { 0 };
+	const u32 band = BTS_TEST_HEIGHT / 3;
+	struct bts_test_peak sweep;
+	int i;
+
+	decon->win_cnt = 3;
+	for (i = 0; i < decon->win_cnt; i++) {
+		config[i].state = DPU_WIN_STATE_BUFFER;
+		config[i].dpp_ch = i;
+		config[i].dst_y = (2 - i) * band;
+		config[i].dst_h = band;
+		decon->bts.rt_bw[i].val = 1000 * (i + 1);
+		decon->bts.rt_bw[i].ch_num = 0;
+	}
+
+	bts_test_sweep(decon, config, &sweep);
+	KUNIT_EXPECT_EQ(test, sweep.overlap_bw, 3000);
+	KUNIT_EXPECT_EQ(test, sweep.ch_bw[0], 3000);
+
+	/* one more line and the top layer runs into the one below it */
+	config[2].dst_h = band + 1;
+	bts_test_sweep(decon, config, &sweep);
+	KUNIT_EXPECT_EQ(test, sweep.overlap_bw, 3000 + 2000);
+
+	/* a layer scrolled out above the panel is never read */
+	config[2].dst_y = -(int)band - 1;
+	bts_test_sweep(decon, config, &sweep);
+	KUNIT_EXPECT_EQ(test, sweep.overlap_bw, 2000);
+}
+
+static void bts_test_set_wb(struct decon_device *decon, int dpp_ch, u32 bw, u32 ch_num)
+{
+	struct dpu_bts_win_config *wb = &decon->bts.wb_config;
+
+	memset(wb, 0, sizeof(*wb));
+	wb->state = DPU_WIN_STATE_BUFFER;
+	wb->dpp_ch = dpp_ch;
+	if (dpp_ch >= 0 && dpp_ch < MAX_DPP_CNT) {
+		decon->bts.rt_bw[dpp_ch].val = bw;
+		decon->bts.rt_bw[dpp_ch].ch_num = ch_num;
+	}
+}
+
+/* writeback covers the whole panel, and only adds edges if it is actually writing */
+static void bts_test_wb_edges(struct kunit *test)
+{
+	struct decon_device *decon = test->priv;
+	const int wb_ch = MAX_DPP_CNT - 1;
+	struct dpu_bts_edge edges[2];
+
+	bts_test_set_wb(decon, wb_ch, 500, 1);
+	KUNIT_ASSERT_EQ(test, dpu_bts_add_wb_edges(decon, &decon->bts.wb_config, edges), 2);
+	KUNIT_EXPECT_EQ(test, edges[0].y, 0);
+	KUNIT_EXPECT_EQ(test, edges[0].bw, 500);
+	KUNIT_EXPECT_EQ(test, edges[0].ch_num, 1);
+	KUNIT_EXPECT_EQ(test, edges[1].y, BTS_TEST_HEIGHT);
+	KUNIT_EXPECT_EQ(test, edges[1].bw, -500);
+	KUNIT_EXPECT_EQ(test, edges[1].ch_num, 1);
+
+	decon->bts.wb_config.state = DPU_WIN_STATE_DISABLED;
+	KUNIT_EXPECT_EQ(test, dpu_bts_add_wb_edges(decon, &decon->bts.wb_config, edges), 0);
+
+	bts_test_set_wb(decon, wb_ch, 0, 1);
+	KUNIT_EXPECT_EQ(test, dpu_bts_add_wb_edges(decon, &decon->bts.wb_config, edges), 0);
+
+	bts_test_set_wb(decon, -1, 500, 1);
+	KUNIT_EXPECT_EQ(test, dpu_bts_add_wb_edges(decon, &decon->bts.wb_config, edges), 0);
+	bts_test_set_wb(decon, MAX_DPP_CNT, 500, 1);
+	KUNIT_EXPECT_EQ(test, dpu_bts_add_wb_edges(decon, &decon->bts.wb_config, edges), 0);
+}
+
+/* writeback bandwidth is part of the peak on every line, overall and on its own channel */
+static void bts_test_wb_overlap(struct kunit *test)
+{
+	struct decon_device *decon = test->priv;
+	struct dpu_bts_win_config config[MAX_WIN_PER_DECON];
+	const int wb_ch = MAX_DPP_CNT - 1;
+	struct bts_test_peak sweep, scan;
+	struct rnd_state rnd;
+	int n, i;
+
+	memset(config, 0, sizeof(config));
+	decon->win_cnt = 2;
+	for (i = 0; i < decon->win_cnt; i++) {
+		config[i].state = DPU_WIN_STATE_BUFFER;
+		config[i].dpp_ch = i;
+		config[i].dst_y = i * BTS_TEST_HEIGHT / 2;
+		config[i].dst_h = BTS_TEST_HEIGHT / 2;
+		decon->bts.rt_bw[i].val = 1000 * (i + 1);
+		decon->bts.rt_bw[i].ch_num = 0;
+	}
+	bts_test_set_wb(decon, wb_ch, 500, 1);
+
+	bts_test_sweep(decon, config, &sweep);
+	KUNIT_EXPECT_EQ(test, sweep.overlap_bw, 2000 + 500);
+	KUNIT_EXPECT_EQ(test, sweep.ch_bw[0], 2000);
+	KUNIT_EXPECT_EQ(test, sweep.ch_bw[1], 500);
+
+	/* sharing a channel with the layers */
+	decon->bts.rt_bw[wb_ch].ch_num = 0;
+	bts_test_sweep(decon, config, &sweep);
+	KUNIT_EXPECT_EQ(test, sweep.ch_bw[0], 2000 + 500);
+	KUNIT_EXPECT_EQ(test, sweep.ch_bw[1], 0);
+
+	/* writing back the whole panel with nothing to read */
+	config[0].state = DPU_WIN_STATE_DISABLED;
+	config[1].state = DPU_WIN_STATE_COLOR;
+	bts_test_sweep(decon, config, &sweep);
+	KUNIT_EXPECT_EQ(test, sweep.overlap_bw, 500);
+
+	decon->win_cnt = MAX_WIN_PER_DECON;
+	prandom_seed_state(&rnd, 0x9845);
+	for (n = 0; n < BTS_TEST_LAYOUTS / 5; n++) {
+		bts_test_random_layout(decon, config, &rnd);
+		bts_test_set_wb(decon, wb_ch, prandom_u32_state(&rnd) % (1 << 20) + 1,
+				prandom_u32_state(&rnd) % MAX_AXI_PORT);
+
+		bts_test_scan_peak(decon, config, &scan);
+		bts_test_sweep(decon, config, &sweep);
+		KUNIT_EXPECT_EQ_MSG(test, sweep.overlap_bw, scan.overlap_bw, "layout %d", n);
+		for (i = 0; i < MAX_AXI_PORT; i++)
+			KUNIT_EXPECT_EQ_MSG(test, sweep.ch_bw[i], scan.ch_bw[i],
+					"layout %d channel %d", n, i);
+	}
+}
+
+static struct kunit_case bts_test_cases[] = {
+	KUNIT_CASE(bts_test_random),
+	KUNIT_CASE(bts_test_stacked),
+	KUNIT_CASE(bts_test_wb_edges),
+	KUNIT_CASE(bts_test_wb_overlap),
+	{}
+};
+
+static struct kunit_suite bts_test_suite = {
+	.name = "exynos-drm-bts",
+	.init = bts_test_init,
+	.test_cases = bts_test_cases,
+};
+
+kunit_test_suite(bts_test_suite);
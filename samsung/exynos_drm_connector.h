@@ -10,8 +10,10 @@
 #ifndef _EXYNOS_DRM_CONNECTOR_H_
 #define _EXYNOS_DRM_CONNECTOR_H_
 
+#include <linux/completion.h>
 #include <drm/drm_atomic.h>
 #include <drm/drm_connector.h>
+#include <drm/drm_mipi_dsi.h>
 #include <drm/samsung_drm.h>
 #include <drm/drm_dsc.h>
 
@@ -32,6 +34,12 @@ struct exynos_drm_connector;
 /* packetgo feature to batch msgs can wait for vblank, use this flag to ignore */
 #define EXYNOS_DSI_MSG_IGNORE_VBLANK  BIT(14)
 
+/*
+ * queue msg and return without waiting for packetgo, msg is released to the
+ * FIFO at the next vblank. Completion can be tracked with the cmd queue fence
+ */
+#define EXYNOS_DSI_MSG_ASYNC  BIT(13)
+
 struct exynos_drm_connector_properties {
 	struct drm_property *max_luminance;
 	struct drm_property *max_avg_luminance;
@@ -130,6 +138,12 @@ struct exynos_drm_connector_state {
 	/* @pending_update_flags: flags for pending update */
 	unsigned int pending_update_flags;
 
+	/*
+	 * @update_pct: share of the display updated by this commit in percent,
+	 *		0 if no plane was updated. Filled in at commit time.
+	 */
+	unsigned int update_pct;
+
 	/*
 	 * @te_from: Specify ddi interface where TE signals are received by decon.
 	 *	     This is required for dsi command mode hw trigger.
@@ -180,6 +194,11 @@ struct exynos_drm_connector_helper_funcs {
 	void (*atomic_commit)(struct exynos_drm_connector *exynos_connector,
 			      struct exynos_drm_connector_state *exynos_old_state,
 			      struct exynos_drm_connector_state *exynos_new_state);
+	/*
+	 * optional, called when the crtc enters or leaves self refresh without an atomic
+	 * commit, in place of the bridge disable/enable of the atomic path
+	 */
+	void (*set_self_refresh)(struct exynos_drm_connector *exynos_connector, bool enable);
 };
 
 struct exynos_drm_connector {
@@ -202,6 +221,31 @@ int exynos_drm_connector_create_properties(struct drm_device *dev);
 struct exynos_drm_connector_properties *
 exynos_drm_connector_get_properties(struct exynos_drm_connector *exynos_conector);
 
+u64 exynos_dsi_cmd_queue_fence(struct mipi_dsi_device *dsi);
+int exynos_dsi_cmd_queue_wait(struct mipi_dsi_device *dsi, u64 fence);
+
+/**
+ * struct exynos_dsi_read_req - asynchronous DSI read request
+ * @msg: read message, rx_buf must stay valid until the request completes
+ * @complete: optional callback invoked from the host worker before @done is
+ *	      signaled, must not sleep for long
+ * @done: signaled once the read finished
+ * @ret: number of bytes read or negative error code
+ * @cmd: storage for the command byte when built by a helper
+ * @node: host private
+ */
+struct exynos_dsi_read_req {
+	struct mipi_dsi_msg msg;
+	void (*complete)(struct exynos_dsi_read_req *req);
+	struct completion done;
+	ssize_t ret;
+	u8 cmd;
+	struct list_head node;
+};
+
+int exynos_dsi_read_async(struct mipi_dsi_device *dsi,
+			  struct exynos_dsi_read_req *req);
+
 static inline struct exynos_drm_connector_state *
 crtc_get_exynos_connector_state(const struct drm_atomic_state *state,
 				const struct drm_crtc_state *crtc_state)
@@ -13,7 +13,9 @@
 #include <linux/kernel.h>
 #include <linux/debugfs.h>
 #include <linux/ktime.h>
+#include <linux/log2.h>
 #include <linux/moduleparam.h>
+#include <linux/percpu.h>
 #include <linux/pm_runtime.h>
 #include <linux/time.h>
 #include <video/mipi_display.h>
@@ -39,7 +41,7 @@
 #include "exynos_drm_dsim.h"
 #include "exynos_drm_writeback.h"
 
-/* Default is 1024 entries array for event log buffer */
+/* Default is 1024 entries for each per-cpu event log ring */
 static unsigned int dpu_event_log_max = 1024;
 static unsigned int dpu_event_print_max = 512;
 static unsigned int dpu_event_print_underrun = 128;
@@ -47,28 +49,65 @@ static unsigned int dpu_event_print_fail_update_bw = 32;
 
 module_param_named(event_log_max, dpu_event_log_max, uint, 0);
 module_param_named(event_print_max, dpu_event_print_max, uint, 0600);
-MODULE_PARM_DESC(event_log_max, "entry count of event log buffer array");
+MODULE_PARM_DESC(event_log_max, "entry count of each per-cpu event log buffer array");
 MODULE_PARM_DESC(event_print_max, "print entry count of event log buffer");
 
-/* If event are happened continuously, then ignore */
+/* per-cpu rings are never smaller than this */
+#define DPU_EVENT_LOG_PERCPU_MIN	128
+
+/* event_log_cnt is a power of 2, so ring index stays continuous when idx wraps */
+static inline u32 dpu_event_ring_idx(const struct decon_device *decon, u32 idx)
+{
+	return idx & (decon->d.event_log_cnt - 1);
+}
+
+/*
+ * If event are happened continuously, then ignore.
+ * Must be called with preemption disabled, only looks at this cpu ring.
+ */
 static bool dpu_event_ignore
 	(enum dpu_event_type type, struct decon_device *decon)
 {
-	int latest = atomic_read(&decon->d.event_log_idx) % dpu_event_log_max;
-	int idx, offset;
-
-	if (IS_ERR_OR_NULL(decon->d.event_log))
-		return true;
+	const struct dpu_log_ring *ring = this_cpu_ptr(decon->d.event_log);
+	u32 latest = atomic_read(&ring->idx);
+	int offset;
 
 	for (offset = 0; offset < DPU_EVENT_KEEP_CNT; ++offset) {
-		idx = (latest + dpu_event_log_max - offset) % dpu_event_log_max;
-		if (type != decon->d.event_log[idx].type)
+		const u32 idx = dpu_event_ring_idx(decon, latest - offset);
+
+		if (type != READ_ONCE(ring->logs[idx].type))
 			return false;
 	}
 
 	return true;
 }
 
+/*
+ * Claim next log in this cpu ring. No locks are taken, logs written from irq
+ * context preempting a writer on the same cpu simply claim the next slot.
+ * Must be paired with dpu_event_put() which publishes the log.
+ */
+static struct dpu_log *dpu_event_get(struct decon_device *decon)
+{
+	struct dpu_log_ring *ring = get_cpu_ptr(decon->d.event_log);
+	const u32 idx = dpu_event_ring_idx(decon, atomic_inc_return(&ring->idx));
+	struct dpu_log *log = &ring->logs[idx];
+
+	WRITE_ONCE(log->type, DPU_EVT_NONE);
+	smp_wmb();
+	log->time = ktime_get();
+
+	return log;
+}
+
+static void dpu_event_put(struct decon_device *decon, struct dpu_log *log,
+			  enum dpu_event_type type)
+{
+	smp_wmb();
+	WRITE_ONCE(log->type, type);
+	put_cpu_ptr(decon->d.event_log);
+}
+
 #if IS_ENABLED(CONFIG_ARM_EXYNOS_DEVFREQ)
 static void dpu_event_save_freqs(struct dpu_log_freqs *freqs)
 {
@@ -101,8 +140,7 @@ void DPU_EVENT_LOG(enum dpu_event_type type, int index, void *priv)
 	const struct drm_format_info *fb_format;
 	struct exynos_partial *partial;
 	struct drm_rect *partial_region;
-	unsigned long flags;
-	int idx;
+	u32 rsc_ch = 0, rsc_win = 0;
 	bool skip_excessive = true;
 
 	if (index < 0) {
@@ -111,7 +149,7 @@ void DPU_EVENT_LOG(enum dpu_event_type type, int index, void *priv)
 	}
 
 	decon = get_decon_drvdata(index);
-	if (IS_ERR_OR_NULL(decon->d.event_log))
+	if (!decon->d.event_log)
 		return;
 
 	switch (type) {
@@ -146,20 +184,26 @@ void DPU_EVENT_LOG(enum dpu_event_type type, int index, void *priv)
 		break;
 	}
 
+	/* register read may sleep, so it has to be done before claiming a log */
+	if (type == DPU_EVT_DECON_RSC_OCCUPANCY) {
+		pm_runtime_get_sync(decon->dev);
+		rsc_ch = decon_reg_get_rsc_ch(decon->id);
+		rsc_win = decon_reg_get_rsc_win(decon->id);
+		pm_runtime_put_sync(decon->dev);
+	}
+
 	/*
 	 * If the same event occurs DPU_EVENT_KEEP_CNT times
 	 * continuously, it will be skipped.
 	 */
-	if (skip_excessive && dpu_event_ignore(type, decon))
+	preempt_disable();
+	if (skip_excessive && dpu_event_ignore(type, decon)) {
+		preempt_enable();
 		return;
+	}
 
-	spin_lock_irqsave(&decon->d.event_lock, flags);
-	idx = atomic_inc_return(&decon->d.event_log_idx) % dpu_event_log_max;
-	log = &decon->d.event_log[idx];
-	log->type = DPU_EVT_NONE;
-	spin_unlock_irqrestore(&decon->d.event_lock, flags);
-
-	log->time = ktime_get();
+	log = dpu_event_get(decon);
+	preempt_enable();
 
 	switch (type) {
 	case DPU_EVT_DPP_FRAMEDONE:
@@ -185,10 +229,8 @@ void DPU_EVENT_LOG(enum dpu_event_type type, int index, void *priv)
 		log->data.dpp.comp_src = dpp->comp_src;
 		break;
 	case DPU_EVT_DECON_RSC_OCCUPANCY:
-		pm_runtime_get_sync(decon->dev);
-		log->data.rsc.rsc_ch = decon_reg_get_rsc_ch(decon->id);
-		log->data.rsc.rsc_win = decon_reg_get_rsc_win(decon->id);
-		pm_runtime_put_sync(decon->dev);
+		log->data.rsc.rsc_ch = rsc_ch;
+		log->data.rsc.rsc_win = rsc_win;
 		break;
 	case DPU_EVT_DECON_RUNTIME_SUSPEND:
 	case DPU_EVT_DECON_RUNTIME_RESUME:
@@ -277,7 +319,7 @@ void DPU_EVENT_LOG(enum dpu_event_type type, int index, void *priv)
 		break;
 	}
 
-	log->type = type;
+	dpu_event_put(decon, log, type);
 }
 
 /*
@@ -291,8 +333,7 @@ void DPU_EVENT_LOG_ATOMIC_COMMIT(int index)
 {
 	struct decon_device *decon;
 	struct dpu_log *log;
-	unsigned long flags;
-	int idx, i, dpp_ch;
+	int i, dpp_ch;
 
 	if (index < 0) {
 		DRM_ERROR("%s: decon id is not valid(%d)\n", __func__, index);
@@ -301,16 +342,10 @@ void DPU_EVENT_LOG_ATOMIC_COMMIT(int index)
 
 	decon = get_decon_drvdata(index);
 
-	if (IS_ERR_OR_NULL(decon->d.event_log))
+	if (!decon->d.event_log)
 		return;
 
-	spin_lock_irqsave(&decon->d.event_lock, flags);
-	idx = atomic_inc_return(&decon->d.event_log_idx) % dpu_event_log_max;
-	log = &decon->d.event_log[idx];
-	log->type = DPU_EVT_NONE;
-	spin_unlock_irqrestore(&decon->d.event_lock, flags);
-
-	log->time = ktime_get();
+	log = dpu_event_get(decon);
 
 	decon->d.auto_refresh_frames = 0;
 
@@ -327,36 +362,11 @@ void DPU_EVENT_LOG_ATOMIC_COMMIT(int index)
 		}
 	}
 
-	log->type = DPU_EVT_ATOMIC_COMMIT;
+	dpu_event_put(decon, log, DPU_EVT_ATOMIC_COMMIT);
 }
 
 extern void *return_address(unsigned int);
 
-static struct dpu_log *dpu_event_get_next(struct decon_device *decon)
-{
-	struct dpu_log *log;
-	unsigned long flags;
-	int idx;
-
-	if (!decon) {
-		pr_err("%s: invalid decon\n", __func__);
-		return NULL;
-	}
-
-	if (IS_ERR_OR_NULL(decon->d.event_log))
-		return NULL;
-
-	spin_lock_irqsave(&decon->d.event_lock, flags);
-	idx = atomic_inc_return(&decon->d.event_log_idx) % dpu_event_log_max;
-	log = &decon->d.event_log[idx];
-	log->type = DPU_EVT_NONE;
-	spin_unlock_irqrestore(&decon->d.event_lock, flags);
-
-	log->time = ktime_get();
-
-	return log;
-}
-
 /*
  * DPU_EVENT_LOG_CMD() - store DSIM command information
  * @index: event log index
@@ -373,11 +383,17 @@ DPU_EVENT_LOG_CMD(struct dsim_device *dsim, u8 type, u8 d0, u16 len)
 {
 	int i;
 	struct decon_device *decon = (struct decon_device *)dsim_get_decon(dsim);
-	struct dpu_log *log = dpu_event_get_next(decon);
+	struct dpu_log *log;
 
-	if (!log)
+	if (!decon) {
+		pr_err("%s: invalid decon\n", __func__);
+		return;
+	}
+
+	if (!decon->d.event_log)
 		return;
 
+	log = dpu_event_get(decon);
 	log->data.cmd.id = type;
 	log->data.cmd.d0 = d0;
 	log->data.cmd.len = len;
@@ -386,7 +402,7 @@ DPU_EVENT_LOG_CMD(struct dsim_device *dsim, u8 type, u8 d0, u16 len)
 		log->data.cmd.caller[i] =
 			(void *)((size_t)return_address(i + 1));
 
-	log->type = DPU_EVT_DSIM_COMMAND;
+	dpu_event_put(decon, log, DPU_EVT_DSIM_COMMAND);
 }
 
 static void dpu_print_log_atomic(struct dpu_log_atomic *atomic,
@@ -627,14 +643,114 @@ static bool is_skip_dpu_event_dump(enum dpu_event_type type, enum dpu_event_cond
 	return false;
 }
 
+/* copy a log out of the ring, returns false if it was being written meanwhile */
+static bool dpu_event_copy(const struct dpu_log *src, struct dpu_log *dst)
+{
+	const enum dpu_event_type type = READ_ONCE(src->type);
+
+	smp_rmb();
+	memcpy(dst, src, sizeof(*dst));
+	smp_rmb();
+	dst->type = type;
+
+	return type != DPU_EVT_NONE && type == READ_ONCE(src->type);
+}
+
+static inline ktime_t dpu_event_ring_time(const struct decon_device *decon,
+					  const struct dpu_log_ring *ring, u32 pos)
+{
+	return READ_ONCE(ring->logs[dpu_event_ring_idx(decon, pos)].time);
+}
+
+/*
+ * Select up to @max_logs latest logs across all per-cpu rings. On return each ring's
+ * dump_pos/dump_cnt describe the oldest selected log and count of logs selected from it.
+ *
+ * Once a ring that has wrapped runs out of logs, selection stops: older logs of the other
+ * rings are from a period where that ring already lost its logs, and would show up in the
+ * merged dump as if nothing happened on that cpu.
+ */
+static void dpu_event_log_select(const struct decon_device *decon, size_t max_logs)
+{
+	struct dpu_log_ring *ring, *newest;
+	size_t cnt;
+	int cpu;
+	bool clipped = false;
+
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu_ptr(decon->d.event_log, cpu);
+		ring->dump_pos = atomic_read(&ring->idx);
+		ring->dump_cnt = 0;
+		/* idx starts from -1, so idx + 1 is the count of logs ever written */
+		ring->dump_avail = min_t(u32, ring->dump_pos + 1, decon->d.event_log_cnt);
+	}
+
+	/* walk back from the newest log of each ring, picking the newest one each time */
+	for (cnt = 0; cnt < max_logs; ++cnt) {
+		newest = NULL;
+		for_each_possible_cpu(cpu) {
+			ring = per_cpu_ptr(decon->d.event_log, cpu);
+			if (ring->dump_cnt >= ring->dump_avail) {
+				if (ring->dump_avail == decon->d.event_log_cnt) {
+					clipped = true;
+					break;
+				}
+				continue;
+			}
+
+			if (!newest || ktime_after(
+					dpu_event_ring_time(decon, ring, ring->dump_pos),
+					dpu_event_ring_time(decon, newest, newest->dump_pos)))
+				newest = ring;
+		}
+
+		if (!newest || clipped)
+			break;
+
+		newest->dump_cnt++;
+		newest->dump_pos--;
+	}
+
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu_ptr(decon->d.event_log, cpu);
+		ring->dump_pos++;
+	}
+}
+
+/* Pop oldest selected log across all per-cpu rings */
+static bool dpu_event_log_next(const struct decon_device *decon, struct dpu_log *log)
+{
+	struct dpu_log_ring *ring, *oldest = NULL;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu_ptr(decon->d.event_log, cpu);
+		if (!ring->dump_cnt)
+			continue;
+
+		if (!oldest || ktime_before(dpu_event_ring_time(decon, ring, ring->dump_pos),
+				dpu_event_ring_time(decon, oldest, oldest->dump_pos)))
+			oldest = ring;
+	}
+
+	if (!oldest)
+		return false;
+
+	if (!dpu_event_copy(&oldest->logs[dpu_event_ring_idx(decon, oldest->dump_pos)], log))
+		log->type = DPU_EVT_NONE;
+
+	oldest->dump_pos++;
+	oldest->dump_cnt--;
+
+	return true;
+}
+
 static void dpu_event_log_print(const struct decon_device *decon, struct drm_printer *p,
 				size_t max_logs, enum dpu_event_condition condition)
 {
-	int idx = atomic_read(&decon->d.event_log_idx);
 	struct decon_device *decon_dev = (struct decon_device *)decon;
 	struct dpu_log dump_log;
 	struct dpu_log *log = &dump_log;
-	int latest = idx % dpu_event_log_max;
 	struct timespec64 ts;
 	const char *str_comp;
 	char buf[LOG_BUF_SIZE];
@@ -642,30 +758,24 @@ static void dpu_event_log_print(const struct decon_device *decon, struct drm_pri
 	int len;
 	unsigned long flags;
 
-	if (IS_ERR_OR_NULL(decon_dev->d.event_log))
+	if (!decon_dev->d.event_log)
+		return;
+
+	/* dump may be requested from irq context, don't wait for a dump already in progress */
+	if (!spin_trylock_irqsave(&decon_dev->d.event_lock, flags)) {
+		drm_printf(p, "event log dump already in progress\n");
 		return;
+	}
 
 	drm_printf(p, "----------------------------------------------------\n");
 	drm_printf(p, "%14s  %20s  %20s\n", "Time", "Event ID", "Remarks");
 	drm_printf(p, "----------------------------------------------------\n");
 
-	/* Seek a oldest from current index */
-	if (max_logs > dpu_event_log_max)
-		max_logs = dpu_event_log_max;
-
-	if (idx < max_logs)
-		idx = 0;
-	else
-		idx = (idx - max_logs) % dpu_event_log_max;
+	dpu_event_log_select(decon, max_logs);
 
-	do {
-		if (++idx >= dpu_event_log_max)
-			idx = 0;
-
-		/* Seek a index and copy log for dump */
-		spin_lock_irqsave(&decon_dev->d.event_lock, flags);
-		memcpy(&dump_log, &decon_dev->d.event_log[idx], sizeof(dump_log));
-		spin_unlock_irqrestore(&decon_dev->d.event_lock, flags);
+	while (dpu_event_log_next(decon, log)) {
+		if (log->type == DPU_EVT_NONE)
+			continue;
 
 		if (is_skip_dpu_event_dump(log->type, condition))
 			continue;
@@ -673,10 +783,6 @@ static void dpu_event_log_print(const struct decon_device *decon, struct drm_pri
 		/* TIME */
 		ts = ktime_to_timespec64(log->time);
 
-		/* If there is no timestamp, then exit directly */
-		if (!ts.tv_sec)
-			break;
-
 		len = scnprintf(buf, sizeof(buf), "[%6lld.%06ld] %20s", ts.tv_sec,
 				ts.tv_nsec / NSEC_PER_USEC, get_event_name(log->type));
 
@@ -815,9 +921,11 @@ static void dpu_event_log_print(const struct decon_device *decon, struct drm_pri
 		default:
 			break;
 		}
-	} while (latest != idx);
+	}
 
 	drm_printf(p, "----------------------------------------------------\n");
+
+	spin_unlock_irqrestore(&decon_dev->d.event_lock, flags);
 }
 
 static int dpu_debug_event_show(struct seq_file *s, void *unused)
@@ -825,7 +933,8 @@ static int dpu_debug_event_show(struct seq_file *s, void *unused)
 	struct decon_device *decon = s->private;
 	struct drm_printer p = drm_seq_file_printer(s);
 
-	dpu_event_log_print(decon, &p, dpu_event_log_max, DPU_EVT_CONDITION_ALL);
+	dpu_event_log_print(decon, &p, decon->d.event_log_cnt * num_possible_cpus(),
+			    DPU_EVT_CONDITION_ALL);
 	return 0;
 }
 
@@ -841,6 +950,62 @@ static const struct file_operations dpu_event_fops = {
 	.release = seq_release,
 };
 
+static int dpu_debug_event_raw_show(struct seq_file *s, void *unused)
+{
+	const struct decon_device *decon = s->private;
+	const struct dpu_log_raw_header header = {
+		.magic = DPU_EVENT_LOG_RAW_MAGIC,
+		.version = DPU_EVENT_LOG_RAW_VERSION,
+		.record_size = sizeof(struct dpu_log),
+		.ring_cnt = num_possible_cpus(),
+		.ring_size = decon->d.event_log_cnt,
+	};
+	struct dpu_log log;
+	int cpu;
+	u32 i;
+
+	seq_write(s, &header, sizeof(header));
+
+	for_each_possible_cpu(cpu) {
+		const struct dpu_log_ring *ring = per_cpu_ptr(decon->d.event_log, cpu);
+		const struct dpu_log_raw_ring raw_ring = {
+			.cpu = cpu,
+			.record_cnt = decon->d.event_log_cnt,
+		};
+		const u32 latest = atomic_read(&ring->idx);
+
+		seq_write(s, &raw_ring, sizeof(raw_ring));
+
+		/* oldest log is right after the latest one */
+		for (i = 1; i <= decon->d.event_log_cnt; ++i) {
+			if (!dpu_event_copy(&ring->logs[dpu_event_ring_idx(decon, latest + i)],
+					    &log)) {
+				memset(&log, 0, sizeof(log));
+				log.type = DPU_EVT_NONE;
+			} else if (log.type == DPU_EVT_DSIM_COMMAND) {
+				/* return addresses would give away the kernel layout */
+				memset(log.data.cmd.caller, 0, sizeof(log.data.cmd.caller));
+			}
+
+			seq_write(s, &log, sizeof(log));
+		}
+	}
+
+	return 0;
+}
+
+static int dpu_debug_event_raw_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dpu_debug_event_raw_show, inode->i_private);
+}
+
+static const struct file_operations dpu_event_raw_fops = {
+	.open = dpu_debug_event_raw_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static bool is_dqe_supported(struct drm_device *drm_dev, u32 dqe_id)
 {
 	struct drm_crtc *crtc;
@@ -1198,9 +1363,101 @@ exynos_debugfs_add_degamma(struct degamma_debug_override *degamma,
 	return dent;
 }
 
+/* in-kernel histogram client keeping the last bins it got for inspection */
+struct debugfs_hist_client {
+	struct exynos_histogram_client client;
+	struct exynos_dqe *dqe;
+	/* serializes subscribe and unsubscribe */
+	struct mutex lock;
+	bool subscribed;
+	/* protects bins and count, updated from frame done irq */
+	spinlock_t bins_lock;
+	struct histogram_bins bins;
+	u32 count;
+};
+
+static void hist_client_notify(struct exynos_histogram_client *client,
+			       const struct histogram_bins *bins)
+{
+	struct debugfs_hist_client *hc =
+		container_of(client, struct debugfs_hist_client, client);
+
+	spin_lock(&hc->bins_lock);
+	hc->bins = *bins;
+	hc->count++;
+	spin_unlock(&hc->bins_lock);
+}
+
+static int hist_client_show(struct seq_file *s, void *unused)
+{
+	struct debugfs_hist_client *hc = s->private;
+	struct histogram_bins *bins;
+	unsigned long flags;
+	u32 count;
+	int i;
+
+	bins = kmalloc(sizeof(*bins), GFP_KERNEL);
+	if (!bins)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&hc->bins_lock, flags);
+	*bins = hc->bins;
+	count = hc->count;
+	spin_unlock_irqrestore(&hc->bins_lock, flags);
+
+	seq_printf(s, "%s, interval(%u) count(%u)\n",
+		   hc->subscribed ? "subscribed" : "unsubscribed",
+		   hc->client.interval, count);
+	for (i = 0; i < HISTOGRAM_BIN_COUNT; i++)
+		seq_printf(s, "%u%c", bins->data[i], ((i + 1) % 16) ? ' ' : '\n');
+
+	kfree(bins);
+
+	return 0;
+}
+
+static int hist_client_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, hist_client_show, inode->i_private);
+}
+
+static ssize_t hist_client_write(struct file *file, const char __user *buffer,
+				 size_t len, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct debugfs_hist_client *hc = s->private;
+	int ret;
+	bool en;
+
+	ret = kstrtobool_from_user(buffer, len, &en);
+	if (ret)
+		return ret;
+
+	mutex_lock(&hc->lock);
+	if (en && !hc->subscribed) {
+		ret = exynos_histogram_subscribe(hc->dqe, &hc->client);
+		hc->subscribed = !ret;
+	} else if (!en && hc->subscribed) {
+		exynos_histogram_unsubscribe(hc->dqe, &hc->client);
+		hc->subscribed = false;
+	}
+	mutex_unlock(&hc->lock);
+
+	return ret ? ret : len;
+}
+
+static const struct file_operations hist_client_fops = {
+	.open = hist_client_open,
+	.read = seq_read,
+	.write = hist_client_write,
+	.llseek = seq_lseek,
+	.release = seq_release,
+};
+
 static struct dentry *exynos_debugfs_add_histogram(struct exynos_dqe *dqe,
 		struct dentry *parent, struct drm_device *drm)
 {
+	struct debugfs_hist_client *hc;
 	struct dentry *dent;
 
 	dent = debugfs_create_dir("histogram", parent);
@@ -1212,6 +1469,18 @@ static struct dentry *exynos_debugfs_add_histogram(struct exynos_dqe *dqe,
 	debugfs_create_bool("verbose", 0664, dent, &dqe->verbose_hist);
 	exynos_debugfs_add_dump(DUMP_TYPE_HISTOGRAM, 0444, dent, 0, 0, drm);
 
+	/* full frame client with crtc state weights */
+	hc = drmm_kzalloc(drm, sizeof(*hc), GFP_KERNEL);
+	if (!hc)
+		return dent;
+
+	hc->dqe = dqe;
+	hc->client.notify = hist_client_notify;
+	mutex_init(&hc->lock);
+	spin_lock_init(&hc->bins_lock);
+	debugfs_create_u32("client_interval", 0664, dent, &hc->client.interval);
+	debugfs_create_file("client", 0664, dent, hc, &hist_client_fops);
+
 	return dent;
 }
 
@@ -1268,6 +1537,34 @@ exynos_debugfs_add_matrix(struct matrix_debug_override *matrix,
 	return dent;
 }
 
+static int lut_stats_show(struct seq_file *s, void *unused)
+{
+	struct exynos_dqe *dqe = s->private;
+	int i;
+
+	seq_printf(s, "%-16s %12s %12s %12s\n", "lut", "skipped", "partial", "full");
+	for (i = 0; i < DQE_LUT_MAX; i++) {
+		const struct dqe_lut_stats *stats = &dqe->shadow.lut[i].stats;
+
+		seq_printf(s, "%-16s %12llu %12llu %12llu\n", exynos_dqe_lut_name(i),
+				stats->skipped, stats->partial, stats->full);
+	}
+
+	return 0;
+}
+
+static int lut_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, lut_stats_show, inode->i_private);
+}
+
+static const struct file_operations lut_stats_fops = {
+	.open = lut_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = seq_release,
+};
+
 static void
 exynos_debugfs_add_dqe(struct exynos_dqe *dqe, struct dentry *parent)
 {
@@ -1315,6 +1612,7 @@ exynos_debugfs_add_dqe(struct exynos_dqe *dqe, struct dentry *parent)
 
 	debugfs_create_bool("force_disabled", 0664, dent_dir,
 			&dqe->force_disabled);
+	debugfs_create_file("lut_stats", 0444, dent_dir, dqe, &lut_stats_fops);
 
 	return;
 
@@ -1375,6 +1673,45 @@ static const struct file_operations hibernation_fops = {
 	.release = seq_release,
 };
 
+static int hibernation_latency_show(struct seq_file *s, void *unused)
+{
+	struct decon_device *decon = s->private;
+
+	exynos_hibernation_latency_print(decon->hibernation, s);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(hibernation_latency);
+
+static int kickoff_show(struct seq_file *s, void *unused)
+{
+	struct decon_device *decon = s->private;
+	const struct decon_kickoff *kickoff = &decon->kickoff;
+	struct decon_kickoff_slot slots[DECON_KICKOFF_SLOTS];
+	u32 deferred_cnt, miss_cnt;
+	unsigned long flags;
+	int i;
+
+	spin_lock_irqsave(&decon->slock, flags);
+	memcpy(slots, kickoff->slots, sizeof(slots));
+	deferred_cnt = kickoff->deferred_cnt;
+	miss_cnt = kickoff->miss_cnt;
+	spin_unlock_irqrestore(&decon->slock, flags);
+
+	seq_printf(s, "deferred: %u, missed: %u\n", deferred_cnt, miss_cnt);
+	for (i = 0; i < DECON_KICKOFF_SLOTS; i++) {
+		if (!slots[i].vrefresh)
+			continue;
+
+		seq_printf(s, "%uhz: latency %lldus, reserved %uus\n", slots[i].vrefresh,
+				div_s64(slots[i].latency_ns, NSEC_PER_USEC),
+				decon_kickoff_reserved_ns(&slots[i]) / 1000);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(kickoff);
+
 static int recovery_show(struct seq_file *s, void *unused)
 {
 	struct decon_device *decon = s->private;
@@ -1389,6 +1726,16 @@ static int recovery_open(struct inode *inode, struct file *file)
 	return single_open(file, recovery_show, inode->i_private);
 }
 
+static int recovery_latency_show(struct seq_file *s, void *unused)
+{
+	struct decon_device *decon = s->private;
+
+	exynos_recovery_latency_print(&decon->recovery, s);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(recovery_latency);
+
 static ssize_t recovery_write(struct file *file, const char *user_buf,
 			      size_t count, loff_t *f_pos)
 {
@@ -1408,6 +1755,76 @@ static const struct file_operations recovery_fops = {
 	.release = seq_release,
 };
 
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_CAL_REGS_BACKEND)
+#define CAL_RECORD_LOG_SIZE	1024
+
+static int cal_record_show(struct seq_file *s, void *unused)
+{
+	struct decon_device *decon = s->private;
+	struct drm_printer p = drm_seq_file_printer(s);
+
+	if (!decon->d.cal_rec) {
+		seq_puts(s, "not attached\n");
+		return 0;
+	}
+
+	drm_printf(&p, "attached: %d\n",
+			READ_ONCE(decon_regs_desc(decon->id)->backend) != NULL);
+	cal_regs_recorder_print(decon->d.cal_rec, &p);
+
+	return 0;
+}
+
+static int cal_record_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, cal_record_show, inode->i_private);
+}
+
+/* writing 1 starts a new recording of decon and dqe writes, 0 stops it */
+static ssize_t cal_record_write(struct file *file, const char __user *buffer,
+				size_t len, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	struct decon_device *decon = s->private;
+	struct cal_regs_desc *dqe_desc = decon->dqe ? &regs_dqe[decon->id].desc : NULL;
+	bool en;
+	int ret;
+
+	ret = kstrtobool_from_user(buffer, len, &en);
+	if (ret)
+		return ret;
+
+	if (!en) {
+		cal_regs_recorder_detach(decon_regs_desc(decon->id));
+		if (dqe_desc)
+			cal_regs_recorder_detach(dqe_desc);
+		return len;
+	}
+
+	if (!decon->d.cal_rec) {
+		decon->d.cal_rec = cal_regs_recorder_create(decon->dev, 0,
+				CAL_RECORD_LOG_SIZE, true);
+		if (!decon->d.cal_rec)
+			return -ENOMEM;
+	}
+
+	cal_regs_recorder_reset(decon->d.cal_rec);
+	cal_regs_recorder_attach(decon->d.cal_rec, decon_regs_desc(decon->id));
+	if (dqe_desc)
+		cal_regs_recorder_attach(decon->d.cal_rec, dqe_desc);
+
+	return len;
+}
+
+static const struct file_operations cal_record_fops = {
+	.open = cal_record_open,
+	.read = seq_read,
+	.write = cal_record_write,
+	.llseek = seq_lseek,
+	.release = seq_release,
+};
+#endif
+
 static void buf_dump_all(const struct decon_device *decon)
 {
 	int i;
@@ -1469,34 +1886,81 @@ static const struct file_operations force_te_fops = {
 	.release = seq_release,
 };
 
-int dpu_init_debug(struct decon_device *decon)
+static void dpu_event_log_free(struct decon_device *decon)
+{
+	int cpu;
+
+	if (!decon->d.event_log)
+		return;
+
+	for_each_possible_cpu(cpu)
+		vfree(per_cpu_ptr(decon->d.event_log, cpu)->logs);
+
+	free_percpu(decon->d.event_log);
+	decon->d.event_log = NULL;
+}
+
+/*
+ * Allocate event log rings, each able to hold event_log_max logs so that a cpu taking all
+ * display interrupts keeps as much history as the single shared log used to. Rings are
+ * only written from their own cpu so logging doesn't need any locks, logs are merged by
+ * timestamp only when they're dumped.
+ */
+static void dpu_event_log_alloc(struct decon_device *decon)
 {
-	int i;
 	u32 event_cnt;
+	int i, cpu;
+
+	decon->d.event_log = alloc_percpu(struct dpu_log_ring);
+	if (!decon->d.event_log) {
+		DRM_WARN("failed to alloc event log rings\n");
+		return;
+	}
+
+	event_cnt = max_t(u32, dpu_event_log_max, DPU_EVENT_LOG_PERCPU_MIN);
+	event_cnt = rounddown_pow_of_two(event_cnt);
+
+	for (i = 0; i < DPU_EVENT_LOG_RETRY; ++i, event_cnt >>= 1) {
+		bool failed = false;
+
+		for_each_possible_cpu(cpu) {
+			struct dpu_log_ring *ring = per_cpu_ptr(decon->d.event_log, cpu);
+
+			ring->logs = vzalloc(sizeof(struct dpu_log) * event_cnt);
+			if (!ring->logs) {
+				failed = true;
+				break;
+			}
+			atomic_set(&ring->idx, -1);
+		}
+
+		if (!failed) {
+			DRM_INFO("#%d event log buffers are allocated per cpu\n", event_cnt);
+			decon->d.event_log_cnt = event_cnt;
+			return;
+		}
+
+		DRM_WARN("failed to alloc event log buf[%d]. retry\n", event_cnt);
+		for_each_possible_cpu(cpu) {
+			struct dpu_log_ring *ring = per_cpu_ptr(decon->d.event_log, cpu);
+
+			vfree(ring->logs);
+			ring->logs = NULL;
+		}
+	}
+
+	dpu_event_log_free(decon);
+}
+
+int dpu_init_debug(struct decon_device *decon)
+{
 	struct drm_crtc *crtc;
 	struct exynos_dqe *dqe = decon->dqe;
 	struct dentry *debug_event;
 	struct dentry *urgent_dent;
 
-	decon->d.event_log = NULL;
-	event_cnt = dpu_event_log_max;
-
-	for (i = 0; i < DPU_EVENT_LOG_RETRY; ++i) {
-		event_cnt = event_cnt >> i;
-		decon->d.event_log =
-			vzalloc(sizeof(struct dpu_log) * event_cnt);
-		if (IS_ERR_OR_NULL(decon->d.event_log)) {
-			DRM_WARN("failed to alloc event log buf[%d]. retry\n",
-					event_cnt);
-			continue;
-		}
-
-		DRM_INFO("#%d event log buffers are allocated\n", event_cnt);
-		break;
-	}
 	spin_lock_init(&decon->d.event_lock);
-	decon->d.event_log_cnt = event_cnt;
-	atomic_set(&decon->d.event_log_idx, -1);
+	dpu_event_log_alloc(decon);
 
 	kthread_init_work(&decon->buf_dump_work, buf_dump_handler);
 
@@ -1512,17 +1976,31 @@ int dpu_init_debug(struct decon_device *decon)
 		goto err_event_log;
 	}
 
-	if (decon->hibernation)
+	if (decon->d.event_log)
+		debugfs_create_file("event_raw", 0400, crtc->debugfs_entry, decon,
+				&dpu_event_raw_fops);
+
+	if (decon->hibernation) {
 		debugfs_create_file("hibernation", 0664, crtc->debugfs_entry, decon,
 				&hibernation_fops);
+		debugfs_create_file("hibernation_latency", 0444, crtc->debugfs_entry, decon,
+				&hibernation_latency_fops);
+	}
+
+	debugfs_create_file("kickoff", 0444, crtc->debugfs_entry, decon, &kickoff_fops);
 
 	if (!debugfs_create_file("recovery", 0644, crtc->debugfs_entry, decon,
 				&recovery_fops)) {
 		DRM_ERROR("failed to create debugfs recovery file\n");
 		goto err_debugfs;
 	}
+	debugfs_create_file("recovery_latency", 0444, crtc->debugfs_entry, decon,
+			&recovery_latency_fops);
 
 	debugfs_create_file("force_te_on", 0664, crtc->debugfs_entry, decon, &force_te_fops);
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_CAL_REGS_BACKEND)
+	debugfs_create_file("cal_record", 0664, crtc->debugfs_entry, decon, &cal_record_fops);
+#endif
 	debugfs_create_u32("underrun_cnt", 0664, crtc->debugfs_entry, &decon->d.underrun_cnt);
 	debugfs_create_u32("crc_cnt", 0444, crtc->debugfs_entry, &decon->d.crc_cnt);
 	debugfs_create_u32("ecc_cnt", 0444, crtc->debugfs_entry, &decon->d.ecc_cnt);
@@ -1553,7 +2031,7 @@ int dpu_init_debug(struct decon_device *decon)
 err_debugfs:
 	debugfs_remove(debug_event);
 err_event_log:
-	vfree(decon->d.event_log);
+	dpu_event_log_free(decon);
 	return -ENOENT;
 }
 
@@ -1827,6 +2305,21 @@ static int dphy_diag_text_show(struct seq_file *m, void *p)
 
 DEFINE_SHOW_ATTRIBUTE(dphy_diag_text);
 
+static int dsim_cmd_timeouts_show(struct seq_file *s, void *unused)
+{
+	const struct dsim_device *dsim = s->private;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(dsim->cmd_timeout_cnt); i++) {
+		if (dsim->cmd_timeout_cnt[i])
+			seq_printf(s, "0x%02x: %u\n", i, dsim->cmd_timeout_cnt[i]);
+	}
+
+	return 0;
+}
+
+DEFINE_SHOW_ATTRIBUTE(dsim_cmd_timeouts);
+
 static ssize_t dphy_diag_reg_write(struct file *file, const char *user_buf,
 			      size_t count, loff_t *f_pos)
 {
@@ -1894,6 +2387,8 @@ void dsim_diag_create_debugfs(struct dsim_device *dsim) {
 	}
 
 	debugfs_create_u32("state", 0400, dsim->debugfs_entry, &dsim->state);
+	debugfs_create_file("cmd_timeouts", 0400, dsim->debugfs_entry, dsim,
+			    &dsim_cmd_timeouts_fops);
 
 	if (dsim->config.num_dphy_diags == 0)
 		return;
@@ -1927,3 +2422,7 @@ void dsim_diag_remove_debugfs(struct dsim_device *dsim) {
 	dsim->debugfs_entry = NULL;
 }
 #endif
+
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_KUNIT_TEST)
+#include "exynos_drm_debug_test.c"
+#endif
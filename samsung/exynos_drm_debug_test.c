@@ -0,0 +1,220 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the per-cpu event log, included from exynos_drm_debug.c.
+ *
+ * Copyright (C) 2020 Samsung Electronics Co.Ltd
+ */
+
+#include <kunit/test.h>
+#include <linux/hrtimer.h>
+
+#define DPU_EVENT_TEST_ITERS	4096
+
+static int dpu_event_test_init(struct kunit *test)
+{
+	struct decon_device *decon;
+
+	decon = kunit_kzalloc(test, sizeof(*decon), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, decon);
+
+	spin_lock_init(&decon->d.event_lock);
+	dpu_event_log_alloc(decon);
+	KUNIT_ASSERT_NOT_NULL(test, decon->d.event_log);
+	test->priv = decon;
+
+	return 0;
+}
+
+static void dpu_event_test_exit(struct kunit *test)
+{
+	dpu_event_log_free(test->priv);
+}
+
+static void dpu_event_test_fill(struct decon_device *decon, int cpu, u32 first, u32 cnt,
+				ktime_t time, ktime_t step)
+{
+	struct dpu_log_ring *ring = per_cpu_ptr(decon->d.event_log, cpu);
+	u32 pos;
+
+	for (pos = first; pos < first + cnt; pos++, time += step) {
+		struct dpu_log *log = &ring->logs[dpu_event_ring_idx(decon, pos)];
+
+		log->time = time;
+		log->type = DPU_EVT_TE_INTERRUPT;
+	}
+	atomic_set(&ring->idx, first + cnt - 1);
+}
+
+/*
+ * One cpu wrapped its ring while another only logged a few events. Logs of the quiet cpu
+ * older than the oldest log left on the busy one are dropped from the dump, the rest come
+ * out merged in time order.
+ */
+static void dpu_event_test_merge_clip(struct kunit *test)
+{
+	struct decon_device *decon = test->priv;
+	const u32 cnt = decon->d.event_log_cnt;
+	const ktime_t busy_start = 1000;
+	struct dpu_log log;
+	ktime_t prev = 0;
+	int busy, quiet;
+	u32 dumped = 0;
+
+	if (num_possible_cpus() < 2)
+		kunit_skip(test, "needs at least two possible cpus");
+
+	busy = cpumask_first(cpu_possible_mask);
+	quiet = cpumask_next(busy, cpu_possible_mask);
+
+	/* 1.5 rings worth of logs, 10ns apart, the oldest half has been overwritten */
+	dpu_event_test_fill(decon, busy, cnt / 2, cnt, busy_start + (cnt / 2) * 10, 10);
+	/* one log from before the busy ring's window, three inside it */
+	dpu_event_test_fill(decon, quiet, 0, 1, busy_start, 0);
+	dpu_event_test_fill(decon, quiet, 1, 3, busy_start + cnt * 10 + 5, 100);
+
+	dpu_event_log_select(decon, 4 * cnt);
+	while (dpu_event_log_next(decon, &log)) {
+		KUNIT_EXPECT_EQ(test, log.type, DPU_EVT_TE_INTERRUPT);
+		KUNIT_EXPECT_GE(test, log.time, prev);
+		KUNIT_EXPECT_GE(test, log.time, busy_start + (cnt / 2) * 10);
+		prev = log.time;
+		dumped++;
+	}
+
+	KUNIT_EXPECT_EQ(test, dumped, cnt + 3);
+}
+
+/* the dump is limited to the latest logs across all rings */
+static void dpu_event_test_merge_max(struct kunit *test)
+{
+	struct decon_device *decon = test->priv;
+	struct dpu_log log;
+	ktime_t prev = 0;
+	u32 dumped = 0;
+	int cpu, last_cpu = 0;
+
+	for_each_possible_cpu(cpu) {
+		dpu_event_test_fill(decon, cpu, 0, 8, 100 + cpu, 1000);
+		last_cpu = cpu;
+	}
+
+	dpu_event_log_select(decon, 8);
+	while (dpu_event_log_next(decon, &log)) {
+		KUNIT_EXPECT_GE(test, log.time, prev);
+		prev = log.time;
+		dumped++;
+	}
+
+	KUNIT_EXPECT_EQ(test, dumped, 8);
+	KUNIT_EXPECT_EQ(test, prev, 100 + 7 * 1000 + last_cpu);
+}
+
+/*
+ * Per-event cost from hard irq context, for the lock-free per-cpu ring and for a model of
+ * the single ring it replaced: spin_lock_irqsave() around every log, all cpus sharing one
+ * array and one index.
+ */
+struct dpu_event_test_bench {
+	struct hrtimer timer;
+	struct completion done;
+	struct decon_device *decon;
+	struct dpu_log *shared;
+	spinlock_t shared_lock;
+	int shared_idx;
+	u64 percpu_ns;
+	u64 shared_ns;
+};
+
+static void dpu_event_test_shared_log(struct dpu_event_test_bench *b, u32 i)
+{
+	struct dpu_log *log;
+	unsigned long flags;
+
+	spin_lock_irqsave(&b->shared_lock, flags);
+	if (++b->shared_idx >= b->decon->d.event_log_cnt)
+		b->shared_idx = 0;
+	log = &b->shared[b->shared_idx];
+	log->time = ktime_get();
+	log->type = DPU_EVT_TE_INTERRUPT;
+	log->data.value = i;
+	spin_unlock_irqrestore(&b->shared_lock, flags);
+}
+
+static enum hrtimer_restart dpu_event_test_bench_fn(struct hrtimer *timer)
+{
+	struct dpu_event_test_bench *b = container_of(timer, struct dpu_event_test_bench, timer);
+	struct dpu_log *log;
+	ktime_t start;
+	u32 i;
+
+	start = ktime_get();
+	for (i = 0; i < DPU_EVENT_TEST_ITERS; i++) {
+		log = dpu_event_get(b->decon);
+		log->data.value = i;
+		dpu_event_put(b->decon, log, DPU_EVT_TE_INTERRUPT);
+	}
+	b->percpu_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	start = ktime_get();
+	for (i = 0; i < DPU_EVENT_TEST_ITERS; i++)
+		dpu_event_test_shared_log(b, i);
+	b->shared_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	complete(&b->done);
+
+	return HRTIMER_NORESTART;
+}
+
+static void dpu_event_test_irq_cost(struct kunit *test)
+{
+	struct decon_device *decon = test->priv;
+	struct dpu_event_test_bench *b;
+	unsigned long done;
+	u32 logged = 0;
+	int cpu;
+
+	b = kunit_kzalloc(test, sizeof(*b), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, b);
+	b->shared = kunit_kcalloc(test, decon->d.event_log_cnt, sizeof(*b->shared),
+				  GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, b->shared);
+
+	b->decon = decon;
+	b->shared_idx = -1;
+	spin_lock_init(&b->shared_lock);
+	init_completion(&b->done);
+	hrtimer_init(&b->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_HARD);
+	b->timer.function = dpu_event_test_bench_fn;
+
+	hrtimer_start(&b->timer, ns_to_ktime(1), HRTIMER_MODE_REL_HARD);
+	done = wait_for_completion_timeout(&b->done, HZ);
+	/* also waits for the callback to return before the bench state goes away */
+	hrtimer_cancel(&b->timer);
+	KUNIT_ASSERT_TRUE(test, done);
+
+	for_each_possible_cpu(cpu)
+		logged += atomic_read(&per_cpu_ptr(decon->d.event_log, cpu)->idx) + 1;
+	KUNIT_EXPECT_EQ(test, logged, DPU_EVENT_TEST_ITERS);
+
+	kunit_info(test, "per-event cost in irq: per-cpu ring %llu.%02llu ns, shared ring %llu.%02llu ns\n",
+		   div_u64(b->percpu_ns, DPU_EVENT_TEST_ITERS),
+		   div_u64(b->percpu_ns * 100, DPU_EVENT_TEST_ITERS) % 100,
+		   div_u64(b->shared_ns, DPU_EVENT_TEST_ITERS),
+		   div_u64(b->shared_ns * 100, DPU_EVENT_TEST_ITERS) % 100);
+}
+
+static struct kunit_case dpu_event_test_cases[] = {
+	KUNIT_CASE(dpu_event_test_merge_clip),
+	KUNIT_CASE(dpu_event_test_merge_max),
+	KUNIT_CASE(dpu_event_test_irq_cost),
+	{}
+};
+
+static struct kunit_suite dpu_event_test_suite = {
+	.name = "exynos-drm-event-log",
+	.init = dpu_event_test_init,
+	.exit = dpu_event_test_exit,
+	.test_cases = dpu_event_test_cases,
+};
+
+kunit_test_suite(dpu_event_test_suite);
@@ -472,7 +472,8 @@ static int decon_atomic_check(struct exynos_drm_crtc *exynos_crtc,
 	return ret;
 }
 
-static void decon_atomic_begin(struct exynos_drm_crtc *crtc)
+static void decon_atomic_begin(struct exynos_drm_crtc *crtc,
+			       struct drm_crtc_state *old_crtc_state)
 {
 	struct decon_device *decon = crtc->ctx;
 
@@ -480,6 +481,7 @@ static void decon_atomic_begin(struct exynos_drm_crtc *crtc)
 	DPU_EVENT_LOG(DPU_EVT_ATOMIC_BEGIN, decon->id, NULL);
 	decon_reg_wait_update_done_and_mask(decon->id, &decon->config.mode,
 			SHADOW_UPDATE_TIMEOUT_US);
+	hibernation_fast_restore(decon->hibernation, old_crtc_state);
 	decon_debug(decon, "%s -\n", __func__);
 }
 
@@ -686,37 +688,223 @@ static void decon_arm_event_locked(struct exynos_drm_crtc *exynos_crtc)
 }
 
 #define RESERVED_TIME_FOR_KICKOFF_NS		3500000
-static void decon_wait_earliest_process_time(
+#define MIN_RESERVED_TIME_FOR_KICKOFF_NS	500000
+#define KICKOFF_MARGIN_NS			250000
+#define KICKOFF_EWMA_SHIFT			3
+#define KICKOFF_WAIT_TIMEOUT_MS			200
+#define KICKOFF_CGC_DMA_POLL_US			20
+
+u32 decon_kickoff_reserved_ns(const struct decon_kickoff_slot *slot)
+{
+	const s64 margin = max_t(s64, slot->latency_ns >> 2, KICKOFF_MARGIN_NS);
+
+	return clamp_t(s64, slot->latency_ns + margin, MIN_RESERVED_TIME_FOR_KICKOFF_NS,
+		       RESERVED_TIME_FOR_KICKOFF_NS);
+}
+
+static struct decon_kickoff_slot *
+decon_kickoff_get_slot(struct decon_kickoff *kickoff, u32 vrefresh)
+{
+	struct decon_kickoff_slot *slot;
+	int i;
+
+	for (i = 0; i < DECON_KICKOFF_SLOTS; i++) {
+		slot = &kickoff->slots[i];
+		if (slot->vrefresh == vrefresh)
+			return slot;
+	}
+
+	/* start learning a new refresh rate from the fixed reservation */
+	slot = &kickoff->slots[kickoff->next_slot];
+	kickoff->next_slot = (kickoff->next_slot + 1) % DECON_KICKOFF_SLOTS;
+	slot->vrefresh = vrefresh;
+	slot->latency_ns = RESERVED_TIME_FOR_KICKOFF_NS;
+
+	return slot;
+}
+
+static void decon_kickoff_locked(struct decon_device *decon)
+{
+	struct decon_kickoff *kickoff = &decon->kickoff;
+
+	decon_reg_start(decon->id, &decon->config);
+	atomic_inc(&decon->frames_pending);
+	if (kickoff->arm_event)
+		decon_arm_event_locked(decon->crtc);
+
+	kickoff->kick_time = ktime_get();
+	kickoff->measure = kickoff->present_time != 0;
+	kickoff->armed = false;
+	complete_all(&kickoff->done);
+
+	if (kickoff->tail_work) {
+		kthread_queue_work(&decon->worker, kickoff->tail_work);
+		kickoff->tail_work = NULL;
+	}
+}
+
+static enum hrtimer_restart decon_kickoff_timer_fn(struct hrtimer *timer)
+{
+	struct decon_device *decon = container_of(timer, struct decon_device, kickoff.timer);
+	enum hrtimer_restart ret = HRTIMER_NORESTART;
+	unsigned long flags;
+
+	spin_lock_irqsave(&decon->slock, flags);
+	if (decon->kickoff.armed) {
+		/* frame start depends on the CGC DMA kicked during flush */
+		if (exynos_dqe_cgc_dma_done(decon->dqe)) {
+			decon_kickoff_locked(decon);
+		} else {
+			hrtimer_forward_now(timer, us_to_ktime(KICKOFF_CGC_DMA_POLL_US));
+			ret = HRTIMER_RESTART;
+		}
+	}
+	spin_unlock_irqrestore(&decon->slock, flags);
+
+	return ret;
+}
+
+/*
+ * Requests frame start right away, or arms a timer to request it at the latest point
+ * that still makes expected present time. The reservation before present time is
+ * learned per refresh rate from the observed frame start latency.
+ */
+static void decon_schedule_kickoff_locked(struct decon_device *decon,
 		const struct exynos_drm_crtc_state *new_exynos_crtc_state)
 {
-	ktime_t earliest_process_time, now;
+	struct decon_kickoff *kickoff = &decon->kickoff;
+	const struct drm_crtc_state *crtc_state = &new_exynos_crtc_state->base;
+	const ktime_t present_time = new_exynos_crtc_state->expected_present_time;
+	const int vrefresh = drm_mode_vrefresh(&crtc_state->mode);
+	ktime_t kick_time, now;
+	s64 max_delay_ns;
+	u32 reserved_ns;
+
+	reinit_completion(&kickoff->done);
+	kickoff->arm_event = !crtc_state->no_vblank;
+	kickoff->slot = decon_kickoff_get_slot(kickoff, vrefresh);
+	kickoff->present_time = 0;
+
+	reserved_ns = decon_kickoff_reserved_ns(kickoff->slot);
+	if (ktime_compare(present_time, reserved_ns) <= 0)
+		goto kick_now;
+
+	kickoff->present_time = present_time;
+	kick_time = ktime_sub_ns(present_time, reserved_ns);
+	now = ktime_get();
+	if (!ktime_after(kick_time, now))
+		goto kick_now;
+
+	max_delay_ns = div_s64(10 * NSEC_PER_SEC, vrefresh ? : 60); // 10 * vsync period
+	if (ktime_to_ns(ktime_sub(kick_time, now)) > max_delay_ns) {
+		pr_warn("expected present time seems incorrect(now %llu, earliest %llu)\n",
+				now, kick_time);
+		kick_time = ktime_add_ns(now, max_delay_ns);
+	}
+
+	DPU_ATRACE_INT("decon_kickoff_delay_us", ktime_us_delta(kick_time, now));
+	kickoff->sched_time = kick_time;
+	kickoff->armed = true;
+	kickoff->deferred_cnt++;
+	hrtimer_start(&kickoff->timer, kick_time, HRTIMER_MODE_ABS);
+
+	return;
+
+kick_now:
+	if (!exynos_dqe_cgc_dma_done(decon->dqe)) {
+		/* let the CGC DMA land in the background instead of blocking flush */
+		kickoff->sched_time = ktime_add_us(ktime_get(), KICKOFF_CGC_DMA_POLL_US);
+		kickoff->armed = true;
+		hrtimer_start(&kickoff->timer, kickoff->sched_time, HRTIMER_MODE_ABS);
+		return;
+	}
+
+	decon_kickoff_locked(decon);
+}
+
+/* requests a scheduled frame start right away, e.g. when the display is going down */
+static void decon_flush_kickoff(struct decon_device *decon)
+{
+	unsigned long flags;
+
+	hrtimer_cancel(&decon->kickoff.timer);
+	exynos_dqe_wait_cgc_dma(decon->dqe);
+
+	spin_lock_irqsave(&decon->slock, flags);
+	if (decon->kickoff.armed)
+		decon_kickoff_locked(decon);
+	spin_unlock_irqrestore(&decon->slock, flags);
+}
+
+void decon_wait_kickoff(struct decon_device *decon)
+{
+	unsigned long timeout = msecs_to_jiffies(KICKOFF_WAIT_TIMEOUT_MS);
+	unsigned long flags;
+	s64 delay_us;
 
-	if (ktime_compare(new_exynos_crtc_state->expected_present_time,
-				RESERVED_TIME_FOR_KICKOFF_NS) <= 0)
+	if (try_wait_for_completion(&decon->kickoff.done))
 		return;
 
-	earliest_process_time = ktime_sub_ns(new_exynos_crtc_state->expected_present_time,
-					RESERVED_TIME_FOR_KICKOFF_NS);
-	now = ktime_get();
+	/* the timeout only starts once the frame start is due */
+	spin_lock_irqsave(&decon->slock, flags);
+	delay_us = decon->kickoff.armed ?
+		ktime_us_delta(decon->kickoff.sched_time, ktime_get()) : 0;
+	spin_unlock_irqrestore(&decon->slock, flags);
+	if (delay_us > 0)
+		timeout += usecs_to_jiffies(delay_us);
 
-	if (ktime_after(earliest_process_time, now)) {
-		const struct drm_crtc_state *crtc_state = &new_exynos_crtc_state->base;
-		int32_t vrefresh = drm_mode_vrefresh(&crtc_state->mode);
-		int32_t max_delay_us = mult_frac(10000, 1000, vrefresh);  // 10 * vsync period
-		int32_t delay_until_process;
+	DPU_ATRACE_BEGIN(__func__);
+	if (!wait_for_completion_timeout(&decon->kickoff.done, timeout)) {
+		decon_warn(decon, "scheduled frame start timed out\n");
+		decon_flush_kickoff(decon);
+	}
+	DPU_ATRACE_END(__func__);
+}
 
-		DPU_ATRACE_BEGIN("wait for earliest present time");
+/*
+ * Hands @work over to be queued on the decon worker once the scheduled frame start has
+ * been requested.
+ * Returns false if frame start has already been requested, @work is not queued then.
+ */
+bool decon_kickoff_defer_work(struct decon_device *decon, struct kthread_work *work)
+{
+	unsigned long flags;
+	bool deferred = false;
 
-		delay_until_process = (int32_t)ktime_us_delta(earliest_process_time, now);
-		if (delay_until_process > max_delay_us) {
-			delay_until_process = max_delay_us;
-			pr_warn("expected present time seems incorrect(now %llu, earliest %llu)\n",
-					now, earliest_process_time);
-		}
-		usleep_range(delay_until_process, delay_until_process + 10);
+	spin_lock_irqsave(&decon->slock, flags);
+	if (decon->kickoff.armed && !decon->kickoff.tail_work) {
+		decon->kickoff.tail_work = work;
+		deferred = true;
+	}
+	spin_unlock_irqrestore(&decon->slock, flags);
+
+	return deferred;
+}
 
-		DPU_ATRACE_END("wait for earliest process time");
+/* called at frame start to learn how early frame start has to be requested */
+static void decon_kickoff_account_locked(struct decon_device *decon)
+{
+	struct decon_kickoff *kickoff = &decon->kickoff;
+	struct decon_kickoff_slot *slot = kickoff->slot;
+	const ktime_t now = ktime_get();
+	s64 latency_ns;
+
+	if (!kickoff->measure || !slot)
+		return;
+
+	kickoff->measure = false;
+
+	if (ktime_after(now, kickoff->present_time)) {
+		kickoff->miss_cnt++;
+		/* back off to the fixed reservation and learn again from there */
+		slot->latency_ns = RESERVED_TIME_FOR_KICKOFF_NS;
+	} else {
+		latency_ns = min_t(s64, ktime_to_ns(ktime_sub(now, kickoff->kick_time)),
+				   RESERVED_TIME_FOR_KICKOFF_NS);
+		slot->latency_ns += (latency_ns - slot->latency_ns) / (1 << KICKOFF_EWMA_SHIFT);
 	}
+
+	DPU_ATRACE_INT("decon_kickoff_reserved_us", decon_kickoff_reserved_ns(slot) / 1000);
 }
 
 static void decon_atomic_flush(struct exynos_drm_crtc *exynos_crtc,
@@ -801,17 +989,13 @@ static void decon_atomic_flush(struct exynos_drm_crtc *exynos_crtc,
 				&new_exynos_crtc_state->partial_region);
 
 	decon_reg_all_win_shadow_update_req(decon->id);
+	cal_regs_recorder_commit(decon_regs_desc(decon->id));
 
 	if (new_exynos_crtc_state->seamless_mode_changed)
 		decon_seamless_mode_set(exynos_crtc, old_crtc_state);
 
-	decon_wait_earliest_process_time(new_exynos_crtc_state);
-
 	spin_lock_irqsave(&decon->slock, flags);
-	decon_reg_start(decon->id, &decon->config);
-	atomic_inc(&decon->frames_pending);
-	if (!new_crtc_state->no_vblank)
-		decon_arm_event_locked(exynos_crtc);
+	decon_schedule_kickoff_locked(decon, new_exynos_crtc_state);
 	spin_unlock_irqrestore(&decon->slock, flags);
 
 	DPU_EVENT_LOG(DPU_EVT_ATOMIC_FLUSH, decon->id, NULL);
@@ -1036,7 +1220,7 @@ static void _decon_stop(struct decon_device *decon, bool reset, u32 vrefresh)
 		exynos_dqe_reset(decon->dqe);
 }
 
-static void decon_exit_hibernation(struct decon_device *decon)
+void decon_exit_hibernation(struct decon_device *decon)
 {
 	if (decon->state != DECON_STATE_HIBERNATION)
 		return;
@@ -1138,6 +1322,8 @@ static void _decon_disable(struct decon_device *decon)
 	const u64 timeout = fps_timeout(fps);
 	u64 ret;
 
+	decon_flush_kickoff(decon);
+
 	ret = wait_event_timeout(decon->framedone_wait,
 				 atomic_read(&decon->frames_pending) == 0 ||
 				 decon_reg_is_idle(decon->id),
@@ -1156,7 +1342,7 @@ static void _decon_disable(struct decon_device *decon)
 	decon->state = DECON_STATE_HIBERNATION;
 }
 
-static void decon_enter_hibernation(struct decon_device *decon)
+void decon_enter_hibernation(struct decon_device *decon)
 {
 	if (decon->state != DECON_STATE_ON)
 		return;
@@ -1218,6 +1404,35 @@ static void decon_disable(struct exynos_drm_crtc *crtc)
 	decon_info(decon, "%s -\n", __func__);
 }
 
+/*
+ * Takes all windows off the screen at register level and waits up to @timeout_us for
+ * the shadow update to be taken, which tells whether the pipeline still runs frames.
+ * Caller must keep commits away from the decon.
+ */
+int decon_recovery_disable_windows(struct decon_device *decon, u32 timeout_us)
+{
+	struct decon_mode *mode = &decon->config.mode;
+	int i, ret;
+
+	hibernation_block(decon->hibernation);
+
+	if (decon->state != DECON_STATE_ON) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	for (i = 0; i < decon->win_cnt; i++)
+		decon_reg_set_win_enable(decon->id, i, 0);
+	decon_reg_all_win_shadow_update_req(decon->id);
+	decon_reg_update_req_and_unmask(decon->id, mode);
+
+	ret = decon_reg_wait_update_done_and_mask(decon->id, mode, timeout_us);
+out:
+	hibernation_unblock_enter(decon->hibernation);
+
+	return ret;
+}
+
 static void decon_wait_for_flip_done(struct exynos_drm_crtc *crtc,
 				const struct drm_crtc_state *old_crtc_state,
 				const struct drm_crtc_state *new_crtc_state)
@@ -1237,6 +1452,9 @@ static void decon_wait_for_flip_done(struct exynos_drm_crtc *crtc,
 	if (old_crtc_state->active)
 		fps = min(fps, drm_mode_vrefresh(&old_crtc_state->mode));
 
+	/* frame start may still be scheduled, time out from the actual request only */
+	decon_wait_kickoff(decon);
+
 	if (!wait_for_completion_timeout(&commit->flip_done, fps_timeout(fps))) {
 		unsigned long flags;
 		bool fs_irq_pending;
@@ -1247,6 +1465,7 @@ static void decon_wait_for_flip_done(struct exynos_drm_crtc *crtc,
 
 		if (!fs_irq_pending) {
 			DPU_EVENT_LOG(DPU_EVT_FRAMESTART_TIMEOUT, decon->id, NULL);
+			atomic_inc(&decon->recovery.fs_timeouts);
 			recovering = atomic_read(&decon->recovery.recovering);
 			decon_err(decon, "framestart timeout (%dhz), recovering: %d, pending: %d\n",
 				    fps, recovering, atomic_read(&decon->frames_pending));
@@ -1465,6 +1684,9 @@ static bool decon_check_fs_pending_locked(struct decon_device *decon)
 
 	if (pending_irq & DPU_FRAME_START_INT_PEND) {
 		DPU_EVENT_LOG(DPU_EVT_DECON_FRAMESTART, decon->id, decon);
+		if (decon->dqe)
+			handle_histogram_frame_start(decon->dqe);
+		decon_kickoff_account_locked(decon);
 		decon_send_vblank_event_locked(decon);
 		if (decon->config.mode.op_mode == DECON_VIDEO_MODE)
 			drm_crtc_handle_vblank(&decon->crtc->base);
@@ -1937,6 +2159,11 @@ static int decon_probe(struct platform_device *pdev)
 	spin_lock_init(&decon->slock);
 	init_waitqueue_head(&decon->framedone_wait);
 
+	hrtimer_init(&decon->kickoff.timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	decon->kickoff.timer.function = decon_kickoff_timer_fn;
+	init_completion(&decon->kickoff.done);
+	complete_all(&decon->kickoff.done);
+
 	decon->state = DECON_STATE_INIT;
 	pm_runtime_enable(decon->dev);
 
@@ -1958,7 +2185,12 @@ static int decon_probe(struct platform_device *pdev)
 	sched_setscheduler_nocheck(decon->thread, SCHED_FIFO, &param);
 
 	decon->hibernation = exynos_hibernation_register(decon);
-	exynos_recovery_register(decon);
+	ret = exynos_recovery_register(decon);
+	if (ret) {
+		kthread_stop(decon->thread);
+		decon->thread = NULL;
+		goto err;
+	}
 
 	decon->dqe = exynos_dqe_register(decon);
 
@@ -1982,6 +2214,9 @@ static int decon_remove(struct platform_device *pdev)
 	if (decon->thread)
 		kthread_stop(decon->thread);
 
+	hrtimer_cancel(&decon->kickoff.timer);
+
+	exynos_recovery_unregister(decon);
 	exynos_hibernation_destroy(decon->hibernation);
 
 	component_del(&pdev->dev, &decon_component_ops);
@@ -20,6 +20,8 @@
 #include <linux/device.h>
 #include <linux/pm_runtime.h>
 #include <linux/spinlock.h>
+#include <linux/hrtimer.h>
+#include <linux/completion.h>
 #if IS_ENABLED(CONFIG_EXYNOS_PM_QOS) || IS_ENABLED(CONFIG_EXYNOS_PM_QOS_MODULE)
 #include <soc/google/exynos_pm_qos.h>
 #endif
@@ -32,6 +34,7 @@
 #include <video/videomode.h>
 
 #include <decon_cal.h>
+#include <cal_regs_record.h>
 
 #include "exynos_drm_dpp.h"
 #include "exynos_drm_dqe.h"
@@ -387,14 +390,49 @@ struct dpu_log {
 	} data;
 };
 
+/*
+ * Binary event log dump layout, as exposed through "event_raw" debugfs file:
+ * one struct dpu_log_raw_header, followed by ring_cnt per-cpu rings each made of
+ * one struct dpu_log_raw_ring and ring_size struct dpu_log records (oldest first,
+ * unused records have type DPU_EVT_NONE). Callers of DPU_EVT_DSIM_COMMAND records
+ * are always zero. Version must be bumped whenever layout of struct dpu_log or
+ * enum dpu_event_type changes.
+ */
+#define DPU_EVENT_LOG_RAW_MAGIC		0x44505545 /* "DPUE" */
+#define DPU_EVENT_LOG_RAW_VERSION	2
+
+struct dpu_log_raw_header {
+	u32 magic;
+	u16 version;
+	u16 record_size;
+	u32 ring_cnt;
+	u32 ring_size;
+};
+
+struct dpu_log_raw_ring {
+	u32 cpu;
+	u32 record_cnt;
+};
+
+/* per-cpu ring buffer of event log, only written from its own cpu */
+struct dpu_log_ring {
+	struct dpu_log *logs;
+	/* array index of last log written in this ring */
+	atomic_t idx;
+	/* cursor and count of logs to be dumped, protected by event_lock */
+	u32 dump_pos;
+	u32 dump_cnt;
+	u32 dump_avail;
+};
+
 /* Definitions below are used in the DECON */
 #define DPU_EVENT_LOG_RETRY	3
 #define DPU_EVENT_KEEP_CNT	3
 
 struct decon_debug {
-	/* ring buffer of event log */
-	struct dpu_log *event_log;
-	/* count of log buffers in each event log */
+	/* per-cpu ring buffers of event log */
+	struct dpu_log_ring __percpu *event_log;
+	/* count of log buffers in each per-cpu event log */
 	u32 event_log_cnt;
 	/* count of underrun interrupt */
 	u32 underrun_cnt;
@@ -404,15 +442,45 @@ struct decon_debug {
 	u32 ecc_cnt;
 	/* count of idma error interrupt */
 	u32 idma_err_cnt;
-	/* array index of log buffer in event log */
-	atomic_t event_log_idx;
-	/* lock for saving log to event log buffer */
+	/* lock for merging per-cpu event logs at dump time */
 	spinlock_t event_lock;
 
 	u32 auto_refresh_frames;
 
 	u32 te_cnt;
 	bool force_te_on;
+
+	/* records decon and dqe register writes, see cal_regs_record.h */
+	struct cal_regs_recorder *cal_rec;
+};
+
+#define DECON_KICKOFF_SLOTS	4
+
+/* learned latency from frame start request to actual frame start, per refresh rate */
+struct decon_kickoff_slot {
+	u32 vrefresh;
+	s64 latency_ns;
+};
+
+/* frame start scheduling against expected present time, protected by decon slock */
+struct decon_kickoff {
+	struct hrtimer timer;
+	/* signaled once the pending frame start has been requested */
+	struct completion done;
+	bool armed;
+	bool arm_event;
+	bool measure;
+	/* when a deferred frame start is due */
+	ktime_t sched_time;
+	ktime_t kick_time;
+	ktime_t present_time;
+	/* rest of the commit, queued once frame start has been requested */
+	struct kthread_work *tail_work;
+	struct decon_kickoff_slot slots[DECON_KICKOFF_SLOTS];
+	struct decon_kickoff_slot *slot;
+	u32 next_slot;
+	u32 deferred_cnt;
+	u32 miss_cnt;
 };
 
 struct decon_device {
@@ -459,6 +527,7 @@ struct decon_device {
 
 	atomic_t frames_pending;
 	wait_queue_head_t framedone_wait;
+	struct decon_kickoff kickoff;
 
 	bool keep_unmask;
 	struct exynos_partial *partial;
@@ -486,6 +555,12 @@ void DPU_EVENT_LOG(enum dpu_event_type type, int index, void *priv);
 void DPU_EVENT_LOG_ATOMIC_COMMIT(int index);
 void DPU_EVENT_LOG_CMD(struct dsim_device *dsim, u8 type, u8 d0, u16 len);
 void decon_force_vblank_event(struct decon_device *decon);
+void decon_wait_kickoff(struct decon_device *decon);
+int decon_recovery_disable_windows(struct decon_device *decon, u32 timeout_us);
+bool decon_kickoff_defer_work(struct decon_device *decon, struct kthread_work *work);
+u32 decon_kickoff_reserved_ns(const struct decon_kickoff_slot *slot);
+void decon_enter_hibernation(struct decon_device *decon);
+void decon_exit_hibernation(struct decon_device *decon);
 
 #if IS_ENABLED(CONFIG_EXYNOS_BTS)
 void decon_mode_bts_pre_update(struct decon_device *decon,
@@ -578,8 +653,9 @@ static inline void decon_trigger_recovery(struct decon_device *decon)
 {
 	struct exynos_recovery *recovery = &decon->recovery;
 
-	atomic_inc(&recovery->recovering);
-	queue_work(system_highpri_wq, &recovery->work);
+	if (atomic_inc_return(&recovery->recovering) == 1)
+		recovery->trigger_time = ktime_get();
+	kthread_queue_work(&recovery->worker, &recovery->work);
 }
 
 #endif /* __EXYNOS_DRM_DECON_H__ */
@@ -331,8 +331,10 @@ static void dpp_test_fixed_config_params(struct dpp_params_info *config, u32 w,
 	config->y_hd_y2_stride = 0;
 	config->y_pl_c2_stride = 0;
 
-	config->h_ratio = mult_frac(1 << 20, config->src.w, config->dst.w);
-	config->v_ratio = mult_frac(1 << 20, config->src.h, config->dst.h);
+	config->h_ratio = dpp_scale_ratio(config->src.w, config->dst.w);
+	config->v_ratio = dpp_scale_ratio(config->src.h, config->dst.h);
+	config->h_pos = 0;
+	config->v_pos = 0;
 
 	config->is_block = false;
 	config->rcv_num = exynos_devfreq_get_domain_freq(DEVFREQ_DISP) ? : 0x7FFFFFFF;
@@ -426,13 +428,19 @@ static void dpp_convert_plane_state_to_config(struct dpp_params_info *config,
 		config->addr[3] = exynos_drm_fb_dma_addr(fb, 3);
 	}
 
-	if (config->rot & DPP_ROT) {
-		config->h_ratio = mult_frac(1 << 20, config->src.h, config->dst.w);
-		config->v_ratio = mult_frac(1 << 20, config->src.w, config->dst.h);
+	if (state->partial_scl.h_ratio) {
+		/* keep the ratio of the whole plane, partial update fetches a part of it */
+		config->h_ratio = state->partial_scl.h_ratio;
+		config->v_ratio = state->partial_scl.v_ratio;
+	} else if (config->rot & DPP_ROT) {
+		config->h_ratio = dpp_scale_ratio(config->src.h, config->dst.w);
+		config->v_ratio = dpp_scale_ratio(config->src.w, config->dst.h);
 	} else {
-		config->h_ratio = mult_frac(1 << 20, config->src.w, config->dst.w);
-		config->v_ratio = mult_frac(1 << 20, config->src.h, config->dst.h);
+		config->h_ratio = dpp_scale_ratio(config->src.w, config->dst.w);
+		config->v_ratio = dpp_scale_ratio(config->src.h, config->dst.h);
 	}
+	config->h_pos = state->partial_scl.h_pos;
+	config->v_pos = state->partial_scl.v_pos;
 
 	config->is_block = false;
 	config->rcv_num = exynos_devfreq_get_domain_freq(DEVFREQ_DISP) ? : 0x7FFFFFFF;
@@ -444,6 +452,8 @@ static void __dpp_enable(struct dpp_device *dpp)
 		return;
 
 	dpp_reg_init(dpp->id, dpp->attr);
+	/* HDR LUT registers may have lost their content while powered off */
+	hdr_reg_shadow_invalidate(dpp->id);
 
 	dpp->state = DPP_STATE_ON;
 	enable_irq(dpp->dma_irq);
@@ -608,23 +618,14 @@ static int dpp_check_scale(struct dpp_device *dpp,
 			struct dpp_params_info *config)
 {
 	struct dpp_restriction *res;
-	struct decon_frame *src, *dst;
-	u32 src_w, src_h;
 
 	res = &dpp->restriction;
-	src = &config->src;
-	dst = &config->dst;
-
-	if (config->rot & DPP_ROT) {
-		src_w = src->h;
-		src_h = src->w;
-	} else {
-		src_w = src->w;
-		src_h = src->h;
-	}
 
-	/* If scaling is not requested, it doesn't need to check limitation */
-	if ((src_w == dst->w) && (src_h == dst->h))
+	/*
+	 * Check the ratios rather than the sizes, a plane clipped by partial update fetches
+	 * the filter footprint around the region and keeps the ratio of the whole plane.
+	 */
+	if ((config->h_ratio == (1 << 20)) && (config->v_ratio == (1 << 20)))
 		return 0;
 
 	/* Scaling is requested. need to check limitation */
@@ -633,15 +634,15 @@ static int dpp_check_scale(struct dpp_device *dpp,
 		return -ENOTSUPP;
 	}
 
-	if ((src_w > dst->w * res->scale_down) ||
-			(src_h > dst->h * res->scale_down)) {
+	if ((config->h_ratio > (res->scale_down << 20)) ||
+			(config->v_ratio > (res->scale_down << 20))) {
 		dpp_err(dpp, "not support under 1/%dx scale-down\n",
 				res->scale_down);
 		return -ENOTSUPP;
 	}
 
-	if ((src_w * res->scale_up < dst->w) ||
-			(src_h * res->scale_up < dst->h)) {
+	if ((config->h_ratio * res->scale_up < (1 << 20)) ||
+			(config->v_ratio * res->scale_up < (1 << 20))) {
 		dpp_err(dpp, "not support over %dx scale-up\n", res->scale_up);
 		return -ENOTSUPP;
 	}
@@ -655,13 +656,11 @@ static int dpp_check_size(struct dpp_device *dpp,
 	struct decon_frame *src, *dst;
 	const struct dpu_fmt *fmt_info;
 	struct dpp_restriction *res;
-	u32 mul = 1; /* factor to multiply alignment */
+	u32 mul; /* factor to multiply alignment */
 	u32 src_h_max;
 
 	fmt_info = dpu_find_fmt_info(config->format);
-
-	if (IS_YUV(fmt_info))
-		mul = 2;
+	mul = fmt_info->align_mul;
 
 	res = &dpp->restriction;
 	src = &config->src;
@@ -1150,8 +1149,10 @@ static irqreturn_t cgc_irq_handler(int irq, void *priv)
 
 	irqs = cgc_reg_get_irq_and_clear(dma->id);
 
-	if (irqs & IDMA_STATUS_FRAMEDONE_IRQ)
+	if (irqs & IDMA_STATUS_FRAMEDONE_IRQ) {
 		DPU_EVENT_LOG(DPU_EVT_CGC_FRAMEDONE, decon->id, NULL);
+		complete(&dma->done);
+	}
 
 	spin_unlock(&dma->dma_slock);
 	return IRQ_HANDLED;
@@ -1275,6 +1276,7 @@ struct exynos_dma *exynos_cgc_dma_register(struct decon_device *decon)
 	dpp_regs_desc_init(dma->regs, res.start, "cgc-dma", REGS_DMA, dma->id);
 
 	spin_lock_init(&dma->dma_slock);
+	init_completion(&dma->done);
 	dma->dma_irq = of_irq_get_byname(np, "cgc-dma");
 	ret = devm_request_irq(dev, dma->dma_irq, cgc_irq_handler, 0,
 			pdev->name, decon);
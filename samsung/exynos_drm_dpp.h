@@ -32,6 +32,12 @@ enum EXYNOS9_DPP_FEATURES {
 	DPP_SUPPORT_FLIP	= 1 << 2,
 };
 
+/* scaler step in 1.20 fixed point for scaling @src pixels into @dst pixels */
+static inline int dpp_scale_ratio(u32 src, u32 dst)
+{
+	return mult_frac(1 << 20, src, dst);
+}
+
 enum dpp_state {
 	DPP_STATE_OFF = 0,
 	DPP_STATE_ON,
@@ -128,6 +134,7 @@ struct exynos_dma {
 	void __iomem *regs;
 	int dma_irq;
 	spinlock_t dma_slock;
+	struct completion done;
 };
 
 #ifdef CONFIG_OF
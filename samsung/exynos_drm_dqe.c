@@ -13,9 +13,11 @@
 
 #include <linux/of_address.h>
 #include <linux/device.h>
+#include <linux/jhash.h>
 #include <drm/drm_drv.h>
 #include <drm/drm_modeset_lock.h>
 #include <drm/drm_atomic_helper.h>
+#include <trace/dpu_trace.h>
 
 #include <dqe_cal.h>
 #include <decon_cal.h>
@@ -23,6 +25,11 @@
 
 #include "exynos_drm_decon.h"
 
+static bool cgc_dma_async = true;
+module_param(cgc_dma_async, bool, 0644);
+MODULE_PARM_DESC(cgc_dma_async,
+		 "wait for CGC DMA completion right before frame start instead of after kick");
+
 static inline u8 get_actual_dstep(u8 dstep, int vrefresh)
 {
 	return dstep * vrefresh / 60;
@@ -67,6 +74,34 @@ exynos_atc_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 		dqe_reg_print_atc(id, &p);
 }
 
+static struct exynos_histogram_slot *
+exynos_histogram_slot_locked(struct exynos_dqe *dqe, u32 i)
+{
+	return &dqe->hist_slots[(dqe->hist_slot_head + i) % HIST_SLOT_CNT];
+}
+
+static void exynos_histogram_slot_pop_locked(struct exynos_dqe *dqe)
+{
+	dqe->hist_slot_head = (dqe->hist_slot_head + 1) % HIST_SLOT_CNT;
+	dqe->hist_slot_cnt--;
+}
+
+/* drops the outstanding frames armed for @client or @event */
+static void exynos_histogram_disarm_locked(struct exynos_dqe *dqe,
+		const struct exynos_histogram_client *client,
+		const struct exynos_drm_pending_histogram_event *event)
+{
+	struct exynos_histogram_slot *slot;
+	u32 i;
+
+	for (i = 0; i < dqe->hist_slot_cnt; i++) {
+		slot = exynos_histogram_slot_locked(dqe, i);
+		if ((client && slot->client == client) ||
+		    (event && slot->event == event))
+			slot->armed = false;
+	}
+}
+
 static struct exynos_drm_pending_histogram_event *create_histogram_event(
 		struct drm_device *dev, struct drm_file *file)
 {
@@ -92,6 +127,8 @@ static struct exynos_drm_pending_histogram_event *create_histogram_event(
 int histogram_request_ioctl(struct drm_device *dev, void *data,
 				struct drm_file *file)
 {
+	struct exynos_drm_pending_histogram_event *e, *pending;
+	unsigned long flags;
 	struct drm_mode_object *obj;
 	struct exynos_drm_crtc *exynos_crtc;
 	struct decon_device *decon;
@@ -114,23 +151,25 @@ int histogram_request_ioctl(struct drm_device *dev, void *data,
 		return -ENODEV;
 	}
 
-	/*
-	 * TODO: Now only one observer is allowed at a time at the moment.
-	 * This will be allowed for multiple observer in the future.
-	 */
-	if (dqe->state.event) {
-		pr_warn("decon%u histogram already registered\n", decon->id);
-		return -EBUSY;
-	}
-	dqe->state.event = create_histogram_event(dev, file);
-	if (IS_ERR_OR_NULL(dqe->state.event)) {
-		dqe->state.event = NULL;
+	e = create_histogram_event(dev, file);
+	if (IS_ERR_OR_NULL(e)) {
 		pr_err("failed to create a histogram event\n");
 		return -EINVAL;
 	}
 
-	pr_debug("created histogram event(0x%pK) of decon%u\n",
-			dqe->state.event, decon->id);
+	spin_lock_irqsave(&dqe->hist_lock, flags);
+	list_for_each_entry(pending, &dqe->hist_events, node) {
+		if (pending->base.file_priv == file) {
+			spin_unlock_irqrestore(&dqe->hist_lock, flags);
+			pr_warn("decon%u histogram already requested\n", decon->id);
+			drm_event_cancel_free(dev, &e->base);
+			return -EBUSY;
+		}
+	}
+	list_add_tail(&e->node, &dqe->hist_events);
+	spin_unlock_irqrestore(&dqe->hist_lock, flags);
+
+	pr_debug("created histogram event(0x%pK) of decon%u\n", e, decon->id);
 
 	return 0;
 }
@@ -138,6 +177,8 @@ int histogram_request_ioctl(struct drm_device *dev, void *data,
 int histogram_cancel_ioctl(struct drm_device *dev, void *data,
 				struct drm_file *file)
 {
+	struct exynos_drm_pending_histogram_event *e, *tmp;
+	unsigned long flags;
 	struct drm_mode_object *obj;
 	struct exynos_drm_crtc *exynos_crtc;
 	struct decon_device *decon;
@@ -160,31 +201,348 @@ int histogram_cancel_ioctl(struct drm_device *dev, void *data,
 		return -ENODEV;
 	}
 
-	if (dqe->state.event) {
-		pr_debug("remained event(0x%pK)\n", dqe->state.event);
-		drm_event_cancel_free(dev, &dqe->state.event->base);
-		dqe->state.event = NULL;
+	spin_lock_irqsave(&dqe->hist_lock, flags);
+	list_for_each_entry_safe(e, tmp, &dqe->hist_events, node) {
+		if (e->base.file_priv != file)
+			continue;
+		pr_debug("remained event(0x%pK)\n", e);
+		exynos_histogram_disarm_locked(dqe, NULL, e);
+		list_del(&e->node);
+		drm_event_cancel_free(dev, &e->base);
 	}
+	spin_unlock_irqrestore(&dqe->hist_lock, flags);
 
 	pr_debug("terminated histogram event of decon%u\n", decon->id);
 
 	return 0;
 }
 
+/*
+ * A frame which didn't start yet is replaced like the hardware configuration
+ * is. Its client is due again, so it doesn't lose its turn.
+ */
+static void exynos_histogram_unarm_next_locked(struct exynos_dqe *dqe)
+{
+	const u64 frame = dqe->hist_frame_start + 1;
+	struct exynos_histogram_slot *slot;
+
+	if (!dqe->hist_slot_cnt)
+		return;
+
+	slot = exynos_histogram_slot_locked(dqe, dqe->hist_slot_cnt - 1);
+	if (slot->frame != frame)
+		return;
+
+	if (slot->armed && slot->client)
+		slot->client->next_frame = frame;
+	dqe->hist_slot_cnt--;
+}
+
+/* records the consumer of the frame following the next frame start */
+static void exynos_histogram_arm_locked(struct exynos_dqe *dqe,
+		struct exynos_histogram_client *client,
+		struct exynos_drm_pending_histogram_event *event)
+{
+	const u64 frame = dqe->hist_frame_start + 1;
+	struct exynos_histogram_slot *slot;
+
+	if (dqe->hist_slot_cnt == HIST_SLOT_CNT) {
+		pr_debug("histogram of frame %llu was not delivered\n",
+			 exynos_histogram_slot_locked(dqe, 0)->frame);
+		exynos_histogram_slot_pop_locked(dqe);
+	}
+
+	slot = exynos_histogram_slot_locked(dqe, dqe->hist_slot_cnt++);
+	slot->client = client;
+	slot->event = event;
+	slot->frame = frame;
+	slot->armed = true;
+
+	if (client)
+		client->next_frame = frame + client->interval + 1;
+	dqe->hist_last_client = client != NULL;
+}
+
+void handle_histogram_frame_start(struct exynos_dqe *dqe)
+{
+	spin_lock(&dqe->hist_lock);
+	dqe->hist_frame_start++;
+	/* only the previous frame can still be waiting for its frame done */
+	if (dqe->hist_frame_done + 2 < dqe->hist_frame_start)
+		dqe->hist_frame_done = dqe->hist_frame_start - 2;
+	spin_unlock(&dqe->hist_lock);
+}
+
 void handle_histogram_event(struct exynos_dqe *dqe)
 {
-	struct exynos_drm_pending_histogram_event *e = dqe->state.event;
+	struct exynos_drm_pending_histogram_event *e;
+	struct exynos_histogram_slot *slot;
+	struct exynos_histogram_client *client;
 	struct drm_device *dev = dqe->decon->drm_dev;
 	u32 id = dqe->decon->id;
 
-	if (!e)
-		return;
+	spin_lock(&dqe->hist_lock);
+	dqe->hist_frame_done++;
+
+	/* frames whose frame done got lost, e.g. across a reset */
+	while (dqe->hist_slot_cnt &&
+	       exynos_histogram_slot_locked(dqe, 0)->frame < dqe->hist_frame_done)
+		exynos_histogram_slot_pop_locked(dqe);
+
+	if (!dqe->hist_slot_cnt)
+		goto out;
+
+	slot = exynos_histogram_slot_locked(dqe, 0);
+	if (slot->frame != dqe->hist_frame_done)
+		goto out;
+
+	exynos_histogram_slot_pop_locked(dqe);
+	if (!slot->armed)
+		goto out;
+
+	client = slot->client;
+	if (client) {
+		dqe_reg_get_histogram_bins(id, &dqe->hist_bins);
+		client->notify(client, &dqe->hist_bins);
+		pr_debug("histogram client(0x%pK) of decon%u notified\n", client, id);
+		goto out;
+	}
 
-	pr_debug("Histogram event(0x%pK) will be handled\n", dqe->state.event);
+	/* each request gets its own frame, bins are read straight into its event */
+	e = slot->event;
+	pr_debug("Histogram event(0x%pK) will be handled\n", e);
 	dqe_reg_get_histogram_bins(id, &e->event.bins);
+	list_del(&e->node);
 	drm_send_event(dev, &e->base);
-	pr_debug("histogram event of decon%u signalled\n", dqe->decon->id);
-	dqe->state.event = NULL;
+	pr_debug("histogram event of decon%u signalled\n", id);
+out:
+	spin_unlock(&dqe->hist_lock);
+}
+
+/**
+ * exynos_histogram_subscribe - register an in-kernel histogram client
+ * @dqe: dqe to sample
+ * @client: client with roi, weights, interval and notify set by the caller
+ *
+ * Client is sampled from the next commit on, sharing the hardware with other
+ * clients and userspace requests in a round robin fashion.
+ */
+int exynos_histogram_subscribe(struct exynos_dqe *dqe,
+			       struct exynos_histogram_client *client)
+{
+	unsigned long flags;
+
+	if (!dqe || !client->notify)
+		return -EINVAL;
+
+	spin_lock_irqsave(&dqe->hist_lock, flags);
+	client->next_frame = 0;
+	list_add_tail(&client->node, &dqe->hist_clients);
+	spin_unlock_irqrestore(&dqe->hist_lock, flags);
+
+	return 0;
+}
+
+void exynos_histogram_unsubscribe(struct exynos_dqe *dqe,
+				  struct exynos_histogram_client *client)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&dqe->hist_lock, flags);
+	list_del_init(&client->node);
+	exynos_histogram_disarm_locked(dqe, client, NULL);
+	spin_unlock_irqrestore(&dqe->hist_lock, flags);
+}
+
+static bool exynos_histogram_event_armed_locked(struct exynos_dqe *dqe,
+		const struct exynos_drm_pending_histogram_event *e)
+{
+	struct exynos_histogram_slot *slot;
+	u32 i;
+
+	for (i = 0; i < dqe->hist_slot_cnt; i++) {
+		slot = exynos_histogram_slot_locked(dqe, i);
+		if (slot->armed && slot->event == e)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Picks the consumer of the next frame. Clients which are due are served in
+ * order of their due frame, userspace requests in order of arrival, and both
+ * sides alternate so neither can starve the other. Returns true if histogram
+ * is needed and sets either @client or @event.
+ */
+static bool exynos_histogram_next_locked(struct exynos_dqe *dqe,
+		struct exynos_histogram_client **client,
+		struct exynos_drm_pending_histogram_event **event)
+{
+	struct exynos_histogram_client *c, *due = NULL;
+	struct exynos_drm_pending_histogram_event *e, *pending = NULL;
+	const u64 frame = dqe->hist_frame_start + 1;
+
+	list_for_each_entry(c, &dqe->hist_clients, node) {
+		if (c->next_frame > frame)
+			continue;
+		if (!due || c->next_frame < due->next_frame)
+			due = c;
+	}
+
+	/* a request still waiting for the frame done of the previous frame */
+	list_for_each_entry(e, &dqe->hist_events, node) {
+		if (!exynos_histogram_event_armed_locked(dqe, e)) {
+			pending = e;
+			break;
+		}
+	}
+
+	if (due && pending) {
+		if (dqe->hist_last_client)
+			due = NULL;
+		else
+			pending = NULL;
+	}
+
+	*client = due;
+	*event = pending;
+
+	return due || pending;
+}
+
+enum dqe_lut_write {
+	DQE_LUT_WRITE_SKIP = 0,
+	DQE_LUT_WRITE_PARTIAL,
+	DQE_LUT_WRITE_FULL,
+};
+
+static const char * const dqe_lut_names[DQE_LUT_MAX] = {
+	[DQE_LUT_DEGAMMA] = "degamma",
+	[DQE_LUT_REGAMMA] = "regamma",
+	[DQE_LUT_CGC] = "cgc",
+	[DQE_LUT_LINEAR_MATRIX] = "linear_matrix",
+	[DQE_LUT_GAMMA_MATRIX] = "gamma_matrix",
+};
+
+const char *exynos_dqe_lut_name(enum dqe_lut_type type)
+{
+	if (type >= DQE_LUT_MAX)
+		return "unknown";
+
+	return dqe_lut_names[type];
+}
+
+/* finds the range [*start, *end) of elements that differ between two arrays */
+static void exynos_dqe_find_span(const void *old, const void *new, size_t elem_size,
+				 u32 cnt, u32 *start, u32 *end)
+{
+	u32 first, last;
+
+	for (first = 0; first < cnt; first++)
+		if (memcmp(old + first * elem_size, new + first * elem_size, elem_size))
+			break;
+
+	for (last = cnt; last > first; last--)
+		if (memcmp(old + (last - 1) * elem_size, new + (last - 1) * elem_size,
+				elem_size))
+			break;
+
+	*start = first;
+	*end = last;
+}
+
+static void exynos_color_lut_span(const void *old, const void *new, u32 cnt,
+				  u32 *start, u32 *end)
+{
+	exynos_dqe_find_span(old, new, sizeof(struct drm_color_lut), cnt, start, end);
+}
+
+/*
+ * Compares @lut with the contents last programmed for @type and updates the shadow copy.
+ * Returns whether the LUT can be skipped, needs only [*start, *end) of its @cnt elements
+ * to be rewritten, or has to be programmed in full. @find_span may be NULL for LUTs that
+ * are always written as a whole.
+ */
+static enum dqe_lut_write
+exynos_dqe_lut_check(struct exynos_dqe *dqe, enum dqe_lut_type type, void *copy,
+		const void *lut, size_t size, u32 cnt,
+		void (*find_span)(const void *old, const void *new, u32 cnt, u32 *start, u32 *end),
+		u32 *start, u32 *end)
+{
+	struct dqe_lut_shadow *shadow = &dqe->shadow.lut[type];
+	enum dqe_lut_write ret = DQE_LUT_WRITE_FULL;
+	u32 hash;
+
+	*start = 0;
+	*end = cnt;
+
+	if (!lut) {
+		shadow->valid = false;
+		shadow->stats.full++;
+		return DQE_LUT_WRITE_FULL;
+	}
+
+	hash = jhash(lut, size, 0);
+
+	if (shadow->valid) {
+		if (hash == shadow->hash && !memcmp(copy, lut, size)) {
+			shadow->stats.skipped++;
+			return DQE_LUT_WRITE_SKIP;
+		}
+
+		if (find_span) {
+			find_span(copy, lut, cnt, start, end);
+			if (*start >= *end) {
+				/* padding or ignored fields changed only */
+				ret = DQE_LUT_WRITE_SKIP;
+			} else if (*start > 0 || *end < cnt) {
+				ret = DQE_LUT_WRITE_PARTIAL;
+			}
+		}
+	}
+
+	memcpy(copy, lut, size);
+	shadow->hash = hash;
+	shadow->valid = true;
+
+	if (ret == DQE_LUT_WRITE_SKIP)
+		shadow->stats.skipped++;
+	else if (ret == DQE_LUT_WRITE_PARTIAL)
+		shadow->stats.partial++;
+	else
+		shadow->stats.full++;
+
+	return ret;
+}
+
+static void exynos_dqe_lut_invalidate(struct exynos_dqe *dqe)
+{
+	int i;
+
+	for (i = 0; i < DQE_LUT_MAX; i++)
+		dqe->shadow.lut[i].valid = false;
+
+	bitmap_zero(dqe->shadow.cgc_pending, CGC_LUT_BLOCK_CNT);
+}
+
+static void exynos_degamma_write(struct exynos_dqe *dqe, const struct drm_color_lut *lut)
+{
+	u32 id = dqe->decon->id;
+	u32 start, end;
+
+	switch (exynos_dqe_lut_check(dqe, DQE_LUT_DEGAMMA, dqe->shadow.degamma_lut, lut,
+			sizeof(dqe->shadow.degamma_lut), DEGAMMA_LUT_SIZE,
+			exynos_color_lut_span, &start, &end)) {
+	case DQE_LUT_WRITE_SKIP:
+		break;
+	case DQE_LUT_WRITE_PARTIAL:
+		dqe_reg_set_degamma_lut_range(id, lut, start, end);
+		break;
+	case DQE_LUT_WRITE_FULL:
+		dqe_reg_set_degamma_lut(id, lut);
+		break;
+	}
 }
 
 static void
@@ -202,7 +560,7 @@ exynos_degamma_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 		state->degamma_lut = degamma->force_lut;
 
 	if (dqe->state.degamma_lut != state->degamma_lut || info->dirty) {
-		dqe_reg_set_degamma_lut(id, state->degamma_lut);
+		exynos_degamma_write(dqe, state->degamma_lut);
 		dqe->state.degamma_lut = state->degamma_lut;
 		info->dirty = false;
 	}
@@ -211,6 +569,117 @@ exynos_degamma_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 		dqe_reg_print_degamma_lut(id, &p);
 }
 
+static bool exynos_cgc_block_changed(const struct cgc_lut *old, const struct cgc_lut *new,
+				     u32 block)
+{
+	const u32 start = block * CGC_LUT_BLOCK_REG_CNT;
+	const u32 cnt = min_t(u32, CGC_LUT_BLOCK_REG_CNT,
+			      DRM_SAMSUNG_CGC_LUT_REG_CNT - start);
+	const size_t size = cnt * sizeof(new->r_values[0]);
+
+	return memcmp(&old->r_values[start], &new->r_values[start], size) ||
+		memcmp(&old->g_values[start], &new->g_values[start], size) ||
+		memcmp(&old->b_values[start], &new->b_values[start], size);
+}
+
+/*
+ * Programs CGC LUT @lut through registers, rewriting only the blocks that differ from the
+ * contents programmed before. If the other LUT copy has not caught up with the previous
+ * update yet, the blocks it is missing are rewritten as well. Returns false if nothing
+ * had to be written.
+ */
+static bool exynos_cgc_write(struct exynos_dqe *dqe, const struct cgc_lut *lut)
+{
+	struct exynos_dqe_shadow *s = &dqe->shadow;
+	struct dqe_lut_shadow *shadow = &s->lut[DQE_LUT_CGC];
+	DECLARE_BITMAP(dirty, CGC_LUT_BLOCK_CNT);
+	DECLARE_BITMAP(blocks, CGC_LUT_BLOCK_CNT);
+	u32 id = dqe->decon->id;
+	ktime_t start = ktime_get();
+	u32 hash, block, cnt = 0;
+
+	if (!lut) {
+		dqe_reg_set_cgc_lut(id, NULL);
+		shadow->valid = false;
+		shadow->stats.full++;
+		bitmap_fill(s->cgc_pending, CGC_LUT_BLOCK_CNT);
+		return true;
+	}
+
+	hash = jhash(lut, sizeof(*lut), 0);
+	if (shadow->valid && hash == shadow->hash && !memcmp(&s->cgc_lut, lut, sizeof(*lut))) {
+		shadow->stats.skipped++;
+		return false;
+	}
+
+	if (shadow->valid) {
+		bitmap_zero(dirty, CGC_LUT_BLOCK_CNT);
+		for (block = 0; block < CGC_LUT_BLOCK_CNT; block++) {
+			if (exynos_cgc_block_changed(&s->cgc_lut, lut, block)) {
+				set_bit(block, dirty);
+				cnt++;
+			}
+		}
+	} else {
+		bitmap_fill(dirty, CGC_LUT_BLOCK_CNT);
+		cnt = CGC_LUT_BLOCK_CNT;
+	}
+
+	memcpy(&s->cgc_lut, lut, sizeof(*lut));
+	shadow->hash = hash;
+
+	if (!cnt) {
+		/* only padding differs */
+		shadow->stats.skipped++;
+		return false;
+	}
+
+	bitmap_copy(blocks, dirty, CGC_LUT_BLOCK_CNT);
+	if (dqe->cgc.first_write) {
+		bitmap_or(blocks, blocks, s->cgc_pending, CGC_LUT_BLOCK_CNT);
+		cnt = bitmap_weight(blocks, CGC_LUT_BLOCK_CNT);
+	}
+
+	DPU_ATRACE_BEGIN(__func__);
+	if (cnt == CGC_LUT_BLOCK_CNT) {
+		dqe_reg_set_cgc_lut(id, lut);
+		shadow->stats.full++;
+	} else {
+		dqe_reg_set_cgc_lut_blocks(id, lut, blocks);
+		shadow->stats.partial++;
+	}
+	DPU_ATRACE_END(__func__);
+
+	shadow->valid = true;
+	/* the copy written now is complete, the other one only misses this update */
+	bitmap_copy(s->cgc_pending, dirty, CGC_LUT_BLOCK_CNT);
+
+	DPU_ATRACE_INT("dqe_cgc_update_us", ktime_us_delta(ktime_get(), start));
+
+	return true;
+}
+
+/* writes the blocks changed by the previous updates once more for the other LUT copy */
+static void exynos_cgc_write_pending(struct exynos_dqe *dqe, const struct cgc_lut *lut)
+{
+	struct exynos_dqe_shadow *s = &dqe->shadow;
+	struct dqe_lut_shadow *shadow = &s->lut[DQE_LUT_CGC];
+	u32 id = dqe->decon->id;
+	ktime_t start = ktime_get();
+
+	if (lut && shadow->valid && !bitmap_full(s->cgc_pending, CGC_LUT_BLOCK_CNT)) {
+		dqe_reg_set_cgc_lut_blocks(id, lut, s->cgc_pending);
+		shadow->stats.partial++;
+	} else {
+		dqe_reg_set_cgc_lut(id, lut);
+		shadow->stats.full++;
+	}
+
+	bitmap_zero(s->cgc_pending, CGC_LUT_BLOCK_CNT);
+
+	DPU_ATRACE_INT("dqe_cgc_update_us", ktime_us_delta(ktime_get(), start));
+}
+
 static void
 exynos_cgc_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 {
@@ -229,13 +698,14 @@ exynos_cgc_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 		state->cgc_lut = &cgc->force_lut;
 
 	if (dqe->state.cgc_lut != state->cgc_lut || info->dirty) {
-		dqe_reg_set_cgc_lut(id, state->cgc_lut);
+		if (exynos_cgc_write(dqe, state->cgc_lut)) {
+			cgc->first_write = true;
+			updated = true;
+		}
 		dqe->state.cgc_lut = state->cgc_lut;
-		cgc->first_write = true;
 		info->dirty = false;
-		updated = true;
 	} else if (cgc->first_write) {
-		dqe_reg_set_cgc_lut(id, dqe->state.cgc_lut);
+		exynos_cgc_write_pending(dqe, dqe->state.cgc_lut);
 		cgc->first_write = false;
 		updated = true;
 	}
@@ -247,6 +717,25 @@ exynos_cgc_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 		decon_reg_update_req_cgc(id);
 }
 
+static void exynos_regamma_write(struct exynos_dqe *dqe, const struct drm_color_lut *lut)
+{
+	u32 id = dqe->decon->id;
+	u32 start, end;
+
+	switch (exynos_dqe_lut_check(dqe, DQE_LUT_REGAMMA, dqe->shadow.regamma_lut, lut,
+			sizeof(dqe->shadow.regamma_lut), REGAMMA_LUT_SIZE,
+			exynos_color_lut_span, &start, &end)) {
+	case DQE_LUT_WRITE_SKIP:
+		break;
+	case DQE_LUT_WRITE_PARTIAL:
+		dqe_reg_set_regamma_lut_range(id, lut, start, end);
+		break;
+	case DQE_LUT_WRITE_FULL:
+		dqe_reg_set_regamma_lut(id, lut);
+		break;
+	}
+}
+
 static void
 exynos_regamma_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 {
@@ -262,7 +751,7 @@ exynos_regamma_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 		state->regamma_lut = regamma->force_lut;
 
 	if (dqe->state.regamma_lut != state->regamma_lut || info->dirty) {
-		dqe_reg_set_regamma_lut(id, state->regamma_lut);
+		exynos_regamma_write(dqe, state->regamma_lut);
 		dqe->state.regamma_lut = state->regamma_lut;
 		info->dirty = false;
 	}
@@ -279,6 +768,7 @@ static void exynos_gamma_matrix_update(struct exynos_dqe *dqe,
 	struct decon_device *decon = dqe->decon;
 	struct drm_printer p = drm_info_printer(decon->dev);
 	u32 id = decon->id;
+	u32 start, end;
 
 	pr_debug("en(%d) dirty(%d)\n", info->force_en, info->dirty);
 
@@ -286,7 +776,10 @@ static void exynos_gamma_matrix_update(struct exynos_dqe *dqe,
 		state->gamma_matrix = &gamma->force_matrix;
 
 	if (dqe->state.gamma_matrix != state->gamma_matrix || info->dirty) {
-		dqe_reg_set_gamma_matrix(id, state->gamma_matrix);
+		if (exynos_dqe_lut_check(dqe, DQE_LUT_GAMMA_MATRIX,
+				&dqe->shadow.gamma_matrix, state->gamma_matrix,
+				sizeof(dqe->shadow.gamma_matrix), 1, NULL, &start, &end))
+			dqe_reg_set_gamma_matrix(id, state->gamma_matrix);
 		dqe->state.gamma_matrix = state->gamma_matrix;
 		info->dirty = false;
 	}
@@ -303,6 +796,7 @@ static void exynos_linear_matrix_update(struct exynos_dqe *dqe,
 	struct decon_device *decon = dqe->decon;
 	struct drm_printer p = drm_info_printer(decon->dev);
 	u32 id = decon->id;
+	u32 start, end;
 
 	pr_debug("en(%d) dirty(%d)\n", info->force_en, info->dirty);
 
@@ -310,7 +804,10 @@ static void exynos_linear_matrix_update(struct exynos_dqe *dqe,
 		state->linear_matrix = &linear->force_matrix;
 
 	if (dqe->state.linear_matrix != state->linear_matrix || info->dirty) {
-		dqe_reg_set_linear_matrix(id, state->linear_matrix);
+		if (exynos_dqe_lut_check(dqe, DQE_LUT_LINEAR_MATRIX,
+				&dqe->shadow.linear_matrix, state->linear_matrix,
+				sizeof(dqe->shadow.linear_matrix), 1, NULL, &start, &end))
+			dqe_reg_set_linear_matrix(id, state->linear_matrix);
 		dqe->state.linear_matrix = state->linear_matrix;
 		info->dirty = false;
 	}
@@ -372,16 +869,49 @@ exynos_histogram_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 	enum histogram_state hist_state;
 	struct decon_device *decon = dqe->decon;
 	struct drm_printer p = drm_info_printer(decon->dev);
+	struct exynos_histogram_client *client;
+	struct exynos_drm_pending_histogram_event *event;
+	struct histogram_roi *roi = state->roi;
+	struct histogram_weights *weights = state->weights;
+	struct histogram_roi client_roi;
+	struct histogram_weights client_weights;
+	unsigned long flags;
+	bool enable;
 	u32 id = decon->id;
 
-	if (dqe->state.roi != state->roi) {
-		dqe_reg_set_histogram_roi(id, state->roi);
-		dqe->state.roi = state->roi;
+	spin_lock_irqsave(&dqe->hist_lock, flags);
+	exynos_histogram_unarm_next_locked(dqe);
+	enable = exynos_histogram_next_locked(dqe, &client, &event);
+	if (enable)
+		exynos_histogram_arm_locked(dqe, client, event);
+	if (client) {
+		roi = NULL;
+		if (client->roi) {
+			client_roi = *client->roi;
+			roi = &client_roi;
+		}
+		if (client->weights) {
+			client_weights = *client->weights;
+			weights = &client_weights;
+		}
+	}
+	spin_unlock_irqrestore(&dqe->hist_lock, flags);
+
+	/*
+	 * Compared by content: blobs and clients can reuse the same memory for a
+	 * different configuration, and consumers taking turns often share one.
+	 */
+	if (roi && (!dqe->state.roi || memcmp(dqe->state.roi, roi, sizeof(*roi)))) {
+		dqe->hist_roi = *roi;
+		dqe->state.roi = &dqe->hist_roi;
+		dqe_reg_set_histogram_roi(id, dqe->state.roi);
 	}
 
-	if (dqe->state.weights != state->weights) {
-		dqe_reg_set_histogram_weights(id, state->weights);
-		dqe->state.weights = state->weights;
+	if (weights && (!dqe->state.weights ||
+			memcmp(dqe->state.weights, weights, sizeof(*weights)))) {
+		dqe->hist_weights = *weights;
+		dqe->state.weights = &dqe->hist_weights;
+		dqe_reg_set_histogram_weights(id, dqe->state.weights);
 	}
 
 	if (dqe->state.histogram_threshold != state->histogram_threshold) {
@@ -389,9 +919,9 @@ exynos_histogram_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state)
 		dqe->state.histogram_threshold = state->histogram_threshold;
 	}
 
-	if (dqe->state.event && state->roi)
+	if (enable && roi)
 		hist_state = HISTOGRAM_ROI;
-	else if (dqe->state.event && !state->roi)
+	else if (enable && !roi)
 		hist_state = HISTOGRAM_FULL;
 	else
 		hist_state = HISTOGRAM_OFF;
@@ -418,8 +948,18 @@ static void exynos_rcd_update(struct exynos_dqe *dqe, struct exynos_dqe_state *s
 static void exynos_set_cgc_dma(struct decon_device *decon, struct exynos_dqe_state *state)
 {
 	struct exynos_drm_gem *exynos_cgc_gem;
+	struct exynos_dqe *dqe = decon->dqe;
 	u32 id = decon->id;
 	u32 cgc_dma_id = decon->cgc_dma->id;
+	ktime_t start = ktime_get();
+
+	/* previous transfer must land before the configuration is changed */
+	exynos_dqe_wait_cgc_dma(dqe);
+
+	/* the DMA overwrites whatever the register path programmed */
+	dqe->shadow.lut[DQE_LUT_CGC].valid = false;
+	bitmap_zero(dqe->shadow.cgc_pending, CGC_LUT_BLOCK_CNT);
+	dqe->state.cgc_lut = NULL;
 
 	if (!state->cgc_gem) {
 		dqe_reg_set_cgc_en(id, 0);
@@ -428,10 +968,72 @@ static void exynos_set_cgc_dma(struct decon_device *decon, struct exynos_dqe_sta
 		dqe_reg_set_cgc_en(id, 1);
 		exynos_cgc_gem = to_exynos_gem(state->cgc_gem);
 		cgc_reg_set_config(cgc_dma_id, 1, exynos_cgc_gem->dma_addr);
+		reinit_completion(&decon->cgc_dma->done);
 		dqe_reg_set_cgc_coef_dma_req(id);
 		cgc_reg_set_cgc_start(cgc_dma_id);
-		dqe_reg_wait_cgc_dma_done(id, CGC_DMA_REQ_TIMEOUT_US);
+		dqe->cgc_dma_kick_time = start;
+		dqe->cgc_dma_pending = true;
+
+		if (!cgc_dma_async)
+			exynos_dqe_wait_cgc_dma(dqe);
 	}
+
+	DPU_ATRACE_INT("dqe_cgc_update_us", ktime_us_delta(ktime_get(), start));
+}
+
+#define CGC_DMA_DONE_POLL_US 2
+
+/*
+ * Blocks until the CGC DMA kicked by the current commit has landed. The DMA request bit,
+ * which is what the frame start depends on, is polled for what is left of the budget
+ * since the kick. A jiffy based wait would round the budget up to several milliseconds.
+ */
+void exynos_dqe_wait_cgc_dma(struct exynos_dqe *dqe)
+{
+	ktime_t wait_start;
+	s64 elapsed_us;
+
+	if (!dqe || !dqe->cgc_dma_pending)
+		return;
+
+	wait_start = ktime_get();
+	elapsed_us = ktime_us_delta(wait_start, dqe->cgc_dma_kick_time);
+
+	DPU_ATRACE_BEGIN(__func__);
+	dqe_reg_wait_cgc_dma_done(dqe->decon->id, elapsed_us < CGC_DMA_REQ_TIMEOUT_US ?
+				  CGC_DMA_REQ_TIMEOUT_US - elapsed_us : CGC_DMA_DONE_POLL_US);
+	DPU_ATRACE_END(__func__);
+
+	DPU_ATRACE_INT("dqe_cgc_dma_wait_us", ktime_us_delta(ktime_get(), wait_start));
+	DPU_ATRACE_INT("dqe_cgc_dma_us", ktime_us_delta(ktime_get(), dqe->cgc_dma_kick_time));
+
+	dqe->cgc_dma_pending = false;
+}
+
+/*
+ * Non-blocking check for the scheduled frame start, which cannot sleep. Returns true once
+ * the CGC DMA kicked by the current commit has landed, or once it has run past its budget
+ * and frame start should not be held back any longer.
+ */
+bool exynos_dqe_cgc_dma_done(struct exynos_dqe *dqe)
+{
+	s64 elapsed_us;
+
+	if (!dqe || !dqe->cgc_dma_pending)
+		return true;
+
+	elapsed_us = ktime_us_delta(ktime_get(), dqe->cgc_dma_kick_time);
+	if (!completion_done(&dqe->decon->cgc_dma->done) &&
+			elapsed_us < CGC_DMA_REQ_TIMEOUT_US)
+		return false;
+
+	dqe_reg_wait_cgc_dma_done(dqe->decon->id, CGC_DMA_DONE_POLL_US);
+
+	DPU_ATRACE_INT("dqe_cgc_dma_us", elapsed_us);
+
+	dqe->cgc_dma_pending = false;
+
+	return true;
 }
 
 static void exynos_cgc_dma_update(struct exynos_dqe *dqe,
@@ -527,6 +1129,8 @@ void exynos_dqe_reset(struct exynos_dqe *dqe)
 	dqe->state.weights = NULL;
 	dqe->state.rcd_enabled = false;
 	dqe->state.cgc_gem = NULL;
+	dqe->cgc_dma_pending = false;
+	exynos_dqe_lut_invalidate(dqe);
 }
 
 void exynos_dqe_save_lpd_data(struct exynos_dqe *dqe)
@@ -722,6 +1326,63 @@ static ssize_t dstep_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(dstep);
 
+/* brightness HAL polls the apl next to the ambient and backlight levels */
+#define HIST_APL_INTERVAL	5
+#define HIST_APL_NONE		U32_MAX
+
+static void exynos_histogram_apl_notify(struct exynos_histogram_client *client,
+					const struct histogram_bins *bins)
+{
+	struct exynos_dqe *dqe =
+		container_of(client, struct exynos_dqe, hist_apl_client);
+	u64 sum = 0, cnt = 0;
+	int i;
+
+	for (i = 0; i < HISTOGRAM_BIN_COUNT; i++) {
+		sum += (u64)i * bins->data[i];
+		cnt += bins->data[i];
+	}
+
+	WRITE_ONCE(dqe->hist_apl, cnt ? div64_u64(sum, cnt) : 0);
+}
+
+static ssize_t histogram_apl_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct exynos_dqe *dqe = dev_get_drvdata(dev);
+	const u32 apl = READ_ONCE(dqe->hist_apl);
+
+	if (!READ_ONCE(dqe->hist_apl_en) || apl == HIST_APL_NONE)
+		return -ENODATA;
+
+	return snprintf(buf, PAGE_SIZE, "%u\n", apl);
+}
+
+static ssize_t histogram_apl_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct exynos_dqe *dqe = dev_get_drvdata(dev);
+	int ret = 0;
+	bool en;
+
+	if (kstrtobool(buf, &en))
+		return -EINVAL;
+
+	mutex_lock(&dqe->hist_apl_lock);
+	if (en && !dqe->hist_apl_en) {
+		WRITE_ONCE(dqe->hist_apl, HIST_APL_NONE);
+		ret = exynos_histogram_subscribe(dqe, &dqe->hist_apl_client);
+		WRITE_ONCE(dqe->hist_apl_en, !ret);
+	} else if (!en && dqe->hist_apl_en) {
+		exynos_histogram_unsubscribe(dqe, &dqe->hist_apl_client);
+		WRITE_ONCE(dqe->hist_apl_en, false);
+	}
+	mutex_unlock(&dqe->hist_apl_lock);
+
+	return ret ? : count;
+}
+static DEVICE_ATTR_RW(histogram_apl);
+
 static struct attribute *atc_attrs[] = {
 	&dev_attr_force_update.attr,
 	&dev_attr_en.attr,
@@ -745,6 +1406,7 @@ static struct attribute *atc_attrs[] = {
 	&dev_attr_threshold_3.attr,
 	&dev_attr_gain_limit.attr,
 	&dev_attr_lt_calc_ab_shift.attr,
+	&dev_attr_histogram_apl.attr,
 	NULL,
 };
 ATTRIBUTE_GROUPS(atc);
@@ -803,6 +1465,12 @@ struct exynos_dqe *exynos_dqe_register(struct decon_device *decon)
 	dqe->funcs = &dqe_funcs;
 	dqe->initialized = false;
 	dqe->decon = decon;
+	spin_lock_init(&dqe->hist_lock);
+	INIT_LIST_HEAD(&dqe->hist_events);
+	INIT_LIST_HEAD(&dqe->hist_clients);
+	mutex_init(&dqe->hist_apl_lock);
+	dqe->hist_apl_client.interval = HIST_APL_INTERVAL;
+	dqe->hist_apl_client.notify = exynos_histogram_apl_notify;
 
 	scnprintf(dqe_name, MAX_DQE_NAME_SIZE, "dqe%u", decon->id);
 	dqe->dqe_class = class_create(THIS_MODULE, dqe_name);
@@ -825,3 +1493,7 @@ struct exynos_dqe *exynos_dqe_register(struct decon_device *decon)
 
 	return dqe;
 }
+
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_KUNIT_TEST)
+#include "exynos_drm_dqe_test.c"
+#endif
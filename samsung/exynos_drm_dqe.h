@@ -20,6 +20,7 @@
 struct decon_device;
 struct exynos_dqe;
 struct exynos_dqe_state;
+struct exynos_drm_pending_histogram_event;
 
 struct exynos_dqe_funcs {
 	void (*update)(struct exynos_dqe *dqe, struct exynos_dqe_state *state,
@@ -38,7 +39,6 @@ struct exynos_dqe_state {
 	struct histogram_roi *roi;
 	struct histogram_weights *weights;
 	struct histogram_bins *bins;
-	struct exynos_drm_pending_histogram_event *event;
 	u32 histogram_threshold;
 	bool rcd_enabled;
 	struct drm_gem_object *cgc_gem;
@@ -106,6 +106,42 @@ enum dump_type {
 	DUMP_TYPE_HDR_TONEMAP,
 };
 
+enum dqe_lut_type {
+	DQE_LUT_DEGAMMA = 0,
+	DQE_LUT_REGAMMA,
+	DQE_LUT_CGC,
+	DQE_LUT_LINEAR_MATRIX,
+	DQE_LUT_GAMMA_MATRIX,
+	DQE_LUT_MAX,
+};
+
+struct dqe_lut_stats {
+	u64 skipped;
+	u64 partial;
+	u64 full;
+};
+
+/*
+ * Tracks the contents last programmed into one of the DQE LUTs, so that a new blob with
+ * identical or mostly identical contents doesn't have to be written out in full.
+ */
+struct dqe_lut_shadow {
+	bool valid;
+	u32 hash;
+	struct dqe_lut_stats stats;
+};
+
+struct exynos_dqe_shadow {
+	struct dqe_lut_shadow lut[DQE_LUT_MAX];
+	struct drm_color_lut degamma_lut[DEGAMMA_LUT_SIZE];
+	struct drm_color_lut regamma_lut[REGAMMA_LUT_SIZE];
+	struct cgc_lut cgc_lut;
+	/* CGC blocks written since CGC was last written twice to keep its LUT copies in sync */
+	DECLARE_BITMAP(cgc_pending, CGC_LUT_BLOCK_CNT);
+	struct exynos_matrix linear_matrix;
+	struct exynos_matrix gamma_matrix;
+};
+
 struct debugfs_dump {
 	enum dump_type type;
 	u32 id;
@@ -113,6 +149,47 @@ struct debugfs_dump {
 	void *priv;
 };
 
+/**
+ * struct exynos_histogram_client - in-kernel histogram consumer
+ * @roi: region of interest, NULL for the full frame
+ * @weights: weights, NULL to use the ones from the crtc state
+ *
+ * @interval: minimum number of frames between two samples, 0 for every frame
+ * @notify: called from the frame done irq with the bins of a frame sampled with
+ *	    this client's configuration, @bins is only valid during the call
+ *
+ * The single hardware histogram is time multiplexed between subscribed clients
+ * and userspace requests, one configuration per frame. @roi and @weights may be
+ * updated in place while subscribed, they are copied under the histogram lock
+ * whenever a frame is armed for this client.
+ */
+struct exynos_histogram_client {
+	struct histogram_roi *roi;
+	struct histogram_weights *weights;
+	u32 interval;
+	void (*notify)(struct exynos_histogram_client *client,
+		       const struct histogram_bins *bins);
+
+	/* private to dqe */
+	struct list_head node;
+	u64 next_frame;
+};
+
+/*
+ * Consumer of one frame's histogram. A commit arms the frame following the next
+ * frame start while the frame in flight may still be waiting for its frame done,
+ * so two of them can be outstanding.
+ */
+struct exynos_histogram_slot {
+	/* exactly one of them is set */
+	struct exynos_histogram_client *client;
+	struct exynos_drm_pending_histogram_event *event;
+	u64 frame;
+	bool armed;
+};
+
+#define HIST_SLOT_CNT	2
+
 struct exynos_dqe {
 	void __iomem *regs;
 	bool initialized;
@@ -131,8 +208,40 @@ struct exynos_dqe {
 	struct matrix_debug_override gamma;
 	struct matrix_debug_override linear;
 
+	struct exynos_dqe_shadow shadow;
+
+	/* CGC DMA kicked from the commit and not waited for yet */
+	bool cgc_dma_pending;
+	ktime_t cgc_dma_kick_time;
+
 	bool verbose_hist;
 
+	/* protects the histogram consumers below */
+	spinlock_t hist_lock;
+	/* pending userspace requests, sampled with the crtc state config one at a time */
+	struct list_head hist_events;
+	struct list_head hist_clients;
+	/* frame starts and frame dones seen so far, frame numbers start at 1 */
+	u64 hist_frame_start;
+	u64 hist_frame_done;
+	/* ring of armed frames, oldest first */
+	struct exynos_histogram_slot hist_slots[HIST_SLOT_CNT];
+	u32 hist_slot_head;
+	u32 hist_slot_cnt;
+	/* last armed frame went to a client, next turn goes to userspace */
+	bool hist_last_client;
+	struct histogram_bins hist_bins;
+	/* configuration programmed to the hardware, pointed by state.roi/weights */
+	struct histogram_roi hist_roi;
+	struct histogram_weights hist_weights;
+
+	/* average picture level of the full frame, for the brightness HAL */
+	struct exynos_histogram_client hist_apl_client;
+	/* serializes enabling and disabling the apl client */
+	struct mutex hist_apl_lock;
+	bool hist_apl_en;
+	u32 hist_apl;
+
 	bool force_disabled;
 
 	bool verbose_atc;
@@ -146,11 +255,19 @@ int histogram_request_ioctl(struct drm_device *drm_dev, void *data,
 int histogram_cancel_ioctl(struct drm_device *drm_dev, void *data,
 				struct drm_file *file);
 void handle_histogram_event(struct exynos_dqe *dqe);
+void handle_histogram_frame_start(struct exynos_dqe *dqe);
+int exynos_histogram_subscribe(struct exynos_dqe *dqe,
+			       struct exynos_histogram_client *client);
+void exynos_histogram_unsubscribe(struct exynos_dqe *dqe,
+				  struct exynos_histogram_client *client);
 void exynos_dqe_update(struct exynos_dqe *dqe, struct exynos_dqe_state *state,
 			u32 width, u32 height);
 void exynos_dqe_reset(struct exynos_dqe *dqe);
+void exynos_dqe_wait_cgc_dma(struct exynos_dqe *dqe);
+bool exynos_dqe_cgc_dma_done(struct exynos_dqe *dqe);
 struct exynos_dqe *exynos_dqe_register(struct decon_device *decon);
 void exynos_dqe_save_lpd_data(struct exynos_dqe *dqe);
 void exynos_dqe_restore_lpd_data(struct exynos_dqe *dqe);
+const char *exynos_dqe_lut_name(enum dqe_lut_type type);
 
 #endif /* __EXYNOS_DRM_DQE_H__ */
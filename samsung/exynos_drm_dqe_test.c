@@ -0,0 +1,463 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for skipping unchanged DQE LUTs and sharing the histogram, included
+ * from exynos_drm_dqe.c.
+ *
+ * Copyright (C) 2020 Samsung Electronics Co.Ltd
+ */
+
+#include <kunit/test.h>
+#include <cal_regs_record.h>
+
+#define DQE_LUT_TEST_REGS_SIZE	SZ_64K
+
+struct dqe_lut_test {
+	struct device *dev;
+	struct cal_regs_recorder *rec;
+	enum dqe_version version;
+	struct exynos_dqe *dqe;
+	struct drm_color_lut *lut;
+	struct cgc_lut *cgc;
+};
+
+static int dqe_lut_test_init(struct kunit *test)
+{
+	struct dqe_lut_test *t;
+	struct decon_device *decon;
+	int i;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t);
+
+	decon = kunit_kzalloc(test, sizeof(*decon), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, decon);
+	t->dqe = kunit_kzalloc(test, sizeof(*t->dqe), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t->dqe);
+	decon->id = REGS_DQE0_ID;
+	t->dqe->decon = decon;
+	exynos_dqe_lut_invalidate(t->dqe);
+
+	t->lut = kunit_kcalloc(test, REGAMMA_LUT_SIZE, sizeof(*t->lut), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t->lut);
+	for (i = 0; i < REGAMMA_LUT_SIZE; i++) {
+		t->lut[i].red = i * 100;
+		t->lut[i].green = i * 100 + 10;
+		t->lut[i].blue = i * 100 + 20;
+	}
+
+	t->cgc = kunit_kzalloc(test, sizeof(*t->cgc), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t->cgc);
+	for (i = 0; i < DRM_SAMSUNG_CGC_LUT_REG_CNT; i++) {
+		t->cgc->r_values[i] = i;
+		t->cgc->g_values[i] = i + 1;
+		t->cgc->b_values[i] = i + 2;
+	}
+
+	t->dev = root_device_register("dqe_lut_test");
+	KUNIT_ASSERT_FALSE(test, IS_ERR(t->dev));
+
+	t->rec = cal_regs_recorder_create(t->dev, DQE_LUT_TEST_REGS_SIZE, 0, false);
+	KUNIT_ASSERT_NOT_NULL(test, t->rec);
+
+	cal_regs_recorder_attach(t->rec, dqe_regs_desc(REGS_DQE0_ID));
+	t->version = regs_dqe[REGS_DQE0_ID].version;
+	regs_dqe[REGS_DQE0_ID].version = DQE_V1;
+	test->priv = t;
+
+	return 0;
+}
+
+static void dqe_lut_test_exit(struct kunit *test)
+{
+	struct dqe_lut_test *t = test->priv;
+
+	regs_dqe[REGS_DQE0_ID].version = t->version;
+	cal_regs_recorder_detach(dqe_regs_desc(REGS_DQE0_ID));
+	root_device_unregister(t->dev);
+}
+
+static u32 dqe_lut_test_commit(void)
+{
+	return cal_regs_recorder_commit(dqe_regs_desc(REGS_DQE0_ID));
+}
+
+/* userspace hands over a new blob every commit, even if the contents are the same */
+static void *dqe_lut_test_dup(struct kunit *test, const void *lut, size_t size)
+{
+	void *dup = kunit_kmalloc(test, size, GFP_KERNEL);
+
+	KUNIT_ASSERT_NOT_NULL(test, dup);
+	memcpy(dup, lut, size);
+
+	return dup;
+}
+
+static void dqe_lut_test_degamma(struct kunit *test)
+{
+	struct dqe_lut_test *t = test->priv;
+	const struct dqe_lut_stats *stats = &t->dqe->shadow.lut[DQE_LUT_DEGAMMA].stats;
+	const size_t size = DEGAMMA_LUT_SIZE * sizeof(*t->lut);
+	struct drm_color_lut *lut;
+
+	exynos_degamma_write(t->dqe, t->lut);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), DQE_DEGAMMALUT_REG_CNT + 1);
+	KUNIT_EXPECT_EQ(test, stats->full, 1);
+
+	lut = dqe_lut_test_dup(test, t->lut, size);
+	exynos_degamma_write(t->dqe, lut);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), 0);
+	KUNIT_EXPECT_EQ(test, stats->skipped, 1);
+
+	/* one point changed, only the register holding it is rewritten */
+	lut = dqe_lut_test_dup(test, lut, size);
+	lut[20].red = 0x1fff;
+	exynos_degamma_write(t->dqe, lut);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), 1);
+	KUNIT_EXPECT_EQ(test, stats->partial, 1);
+	KUNIT_EXPECT_EQ(test, dqe_read(REGS_DQE0_ID, DQE_DEGAMMALUT(10)),
+			DEGAMMA_LUT_L(0x1fff) | DEGAMMA_LUT_H(lut[21].red));
+
+	/* everything between the first and the last changed point goes out, registers 1 to 25 */
+	lut = dqe_lut_test_dup(test, lut, size);
+	lut[3].red = 0;
+	lut[50].red = 0;
+	exynos_degamma_write(t->dqe, lut);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), 25);
+	KUNIT_EXPECT_EQ(test, stats->partial, 2);
+
+	/* a disabled LUT is programmed in full when it comes back */
+	exynos_degamma_write(t->dqe, NULL);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), 1);
+	exynos_degamma_write(t->dqe, lut);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), DQE_DEGAMMALUT_REG_CNT + 1);
+	KUNIT_EXPECT_EQ(test, stats->full, 3);
+
+	/* so is one that was lost to a reset of the block */
+	exynos_dqe_lut_invalidate(t->dqe);
+	exynos_degamma_write(t->dqe, lut);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), DQE_DEGAMMALUT_REG_CNT + 1);
+	KUNIT_EXPECT_EQ(test, stats->full, 4);
+}
+
+static void dqe_lut_test_regamma(struct kunit *test)
+{
+	struct dqe_lut_test *t = test->priv;
+	const struct dqe_lut_stats *stats = &t->dqe->shadow.lut[DQE_LUT_REGAMMA].stats;
+	const size_t size = REGAMMA_LUT_SIZE * sizeof(*t->lut);
+	struct drm_color_lut *lut;
+
+	exynos_regamma_write(t->dqe, t->lut);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), 3 * DQE_REGAMMALUT_REG_CNT + 1);
+
+	lut = dqe_lut_test_dup(test, t->lut, size);
+	exynos_regamma_write(t->dqe, lut);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), 0);
+
+	/* a single channel changed still rewrites the register of every channel */
+	lut = dqe_lut_test_dup(test, lut, size);
+	lut[0].green = 0;
+	exynos_regamma_write(t->dqe, lut);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), 3);
+	KUNIT_EXPECT_EQ(test, dqe_read(REGS_DQE0_ID, DQE_REGAMMALUT_G(0)),
+			REGAMMA_LUT_H(lut[1].green));
+
+	KUNIT_EXPECT_EQ(test, stats->full, 1);
+	KUNIT_EXPECT_EQ(test, stats->skipped, 1);
+	KUNIT_EXPECT_EQ(test, stats->partial, 1);
+}
+
+/* mirrors exynos_cgc_update(): one write per commit, the other LUT copy catches up next */
+static void dqe_lut_test_cgc_commit(struct kunit *test, const struct cgc_lut *lut,
+		u32 expected)
+{
+	struct dqe_lut_test *t = test->priv;
+	struct cgc_debug_override *cgc = &t->dqe->cgc;
+
+	if (exynos_cgc_write(t->dqe, lut))
+		cgc->first_write = true;
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), expected);
+}
+
+static void dqe_lut_test_cgc_flush(struct kunit *test, u32 expected)
+{
+	struct dqe_lut_test *t = test->priv;
+	struct cgc_debug_override *cgc = &t->dqe->cgc;
+
+	KUNIT_ASSERT_TRUE(test, cgc->first_write);
+	exynos_cgc_write_pending(t->dqe, &t->dqe->shadow.cgc_lut);
+	cgc->first_write = false;
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), expected);
+}
+
+static void dqe_lut_test_cgc(struct kunit *test)
+{
+	struct dqe_lut_test *t = test->priv;
+	const struct dqe_lut_stats *stats = &t->dqe->shadow.lut[DQE_LUT_CGC].stats;
+	const u32 full = 3 * DRM_SAMSUNG_CGC_LUT_REG_CNT + 1;
+	const u32 block = 3 * CGC_LUT_BLOCK_REG_CNT;
+	struct cgc_lut *lut;
+
+	/* both copies of the LUT start out empty */
+	dqe_lut_test_cgc_commit(test, t->cgc, full);
+	dqe_lut_test_cgc_flush(test, full);
+	KUNIT_EXPECT_EQ(test, stats->full, 2);
+
+	lut = dqe_lut_test_dup(test, t->cgc, sizeof(*lut));
+	dqe_lut_test_cgc_commit(test, lut, 0);
+	KUNIT_EXPECT_FALSE(test, t->dqe->cgc.first_write);
+	KUNIT_EXPECT_EQ(test, stats->skipped, 1);
+
+	lut = dqe_lut_test_dup(test, lut, sizeof(*lut));
+	lut->r_values[5 * CGC_LUT_BLOCK_REG_CNT + 3] = 0;
+	dqe_lut_test_cgc_commit(test, lut, block);
+	dqe_lut_test_cgc_flush(test, block);
+	KUNIT_EXPECT_EQ(test, dqe_read(REGS_DQE0_ID,
+			DQE_CGC_LUT_R(5 * CGC_LUT_BLOCK_REG_CNT + 3)), 0);
+
+	/*
+	 * A new LUT before the other copy caught up with the last one: the blocks that copy
+	 * is missing are written along with the new ones.
+	 */
+	lut = dqe_lut_test_dup(test, lut, sizeof(*lut));
+	lut->g_values[7 * CGC_LUT_BLOCK_REG_CNT] = 0;
+	dqe_lut_test_cgc_commit(test, lut, block);
+	lut = dqe_lut_test_dup(test, lut, sizeof(*lut));
+	lut->b_values[9 * CGC_LUT_BLOCK_REG_CNT] = 0;
+	dqe_lut_test_cgc_commit(test, lut, 2 * block);
+	dqe_lut_test_cgc_flush(test, block);
+
+	KUNIT_EXPECT_EQ(test, stats->full, 2);
+	KUNIT_EXPECT_EQ(test, stats->partial, 5);
+	KUNIT_EXPECT_LT(test, t->rec->total_writes, (u64)5 * full);
+}
+
+static struct kunit_case dqe_lut_test_cases[] = {
+	KUNIT_CASE(dqe_lut_test_degamma),
+	KUNIT_CASE(dqe_lut_test_regamma),
+	KUNIT_CASE(dqe_lut_test_cgc),
+	{}
+};
+
+static struct kunit_suite dqe_lut_test_suite = {
+	.name = "exynos-drm-dqe-lut",
+	.init = dqe_lut_test_init,
+	.exit = dqe_lut_test_exit,
+	.test_cases = dqe_lut_test_cases,
+};
+
+struct dqe_hist_test_client {
+	struct exynos_histogram_client client;
+	u32 count;
+};
+
+struct dqe_hist_test {
+	struct device *dev;
+	struct cal_regs_recorder *rec;
+	enum dqe_version version;
+	struct exynos_dqe *dqe;
+	struct exynos_dqe_state state;
+	struct dqe_hist_test_client a;
+	struct dqe_hist_test_client b;
+};
+
+static void dqe_hist_test_notify(struct exynos_histogram_client *client,
+		const struct histogram_bins *bins)
+{
+	struct dqe_hist_test_client *c =
+		container_of(client, struct dqe_hist_test_client, client);
+
+	c->count++;
+}
+
+static int dqe_hist_test_init(struct kunit *test)
+{
+	struct dqe_hist_test *t;
+	struct decon_device *decon;
+	struct exynos_dqe *dqe;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t);
+
+	decon = kunit_kzalloc(test, sizeof(*decon), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, decon);
+	dqe = kunit_kzalloc(test, sizeof(*dqe), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, dqe);
+	decon->id = REGS_DQE0_ID;
+	dqe->decon = decon;
+	spin_lock_init(&dqe->hist_lock);
+	INIT_LIST_HEAD(&dqe->hist_events);
+	INIT_LIST_HEAD(&dqe->hist_clients);
+	mutex_init(&dqe->hist_apl_lock);
+	dqe->hist_apl_client.interval = HIST_APL_INTERVAL;
+	dqe->hist_apl_client.notify = exynos_histogram_apl_notify;
+	t->dqe = dqe;
+
+	t->a.client.notify = dqe_hist_test_notify;
+	t->b.client.notify = dqe_hist_test_notify;
+
+	t->dev = root_device_register("dqe_hist_test");
+	KUNIT_ASSERT_FALSE(test, IS_ERR(t->dev));
+
+	t->rec = cal_regs_recorder_create(t->dev, DQE_LUT_TEST_REGS_SIZE, 0, false);
+	KUNIT_ASSERT_NOT_NULL(test, t->rec);
+
+	cal_regs_recorder_attach(t->rec, dqe_regs_desc(REGS_DQE0_ID));
+	t->version = regs_dqe[REGS_DQE0_ID].version;
+	regs_dqe[REGS_DQE0_ID].version = DQE_V1;
+	test->priv = t;
+
+	return 0;
+}
+
+static void dqe_hist_test_exit(struct kunit *test)
+{
+	struct dqe_hist_test *t = test->priv;
+
+	regs_dqe[REGS_DQE0_ID].version = t->version;
+	cal_regs_recorder_detach(dqe_regs_desc(REGS_DQE0_ID));
+	root_device_unregister(t->dev);
+}
+
+/* one commit followed by the frame it armed */
+static void dqe_hist_test_frame(struct kunit *test)
+{
+	struct dqe_hist_test *t = test->priv;
+
+	exynos_histogram_update(t->dqe, &t->state);
+	handle_histogram_frame_start(t->dqe);
+	handle_histogram_event(t->dqe);
+}
+
+static void dqe_hist_test_set_bin(u32 bin, u32 cnt)
+{
+	u32 val = hist_read(REGS_DQE0_ID, DQE_HIST_BIN(bin / 2));
+
+	val &= ~HIST_BIN(bin, 0xffff);
+	hist_write(REGS_DQE0_ID, DQE_HIST_BIN(bin / 2), val | HIST_BIN(bin, cnt));
+}
+
+/*
+ * A client sampling every frame and one every 4th frame share the histogram. The slow
+ * one is served once its interval expired, the fast one gets the remaining frames.
+ */
+static void dqe_hist_test_multiplex(struct kunit *test)
+{
+	struct dqe_hist_test *t = test->priv;
+	int i;
+
+	t->b.client.interval = 3;
+	KUNIT_ASSERT_EQ(test, exynos_histogram_subscribe(t->dqe, &t->a.client), 0);
+	KUNIT_ASSERT_EQ(test, exynos_histogram_subscribe(t->dqe, &t->b.client), 0);
+
+	for (i = 0; i < 12; i++)
+		dqe_hist_test_frame(test);
+	KUNIT_EXPECT_EQ(test, t->a.count, 9);
+	KUNIT_EXPECT_EQ(test, t->b.count, 3);
+
+	/* the frame armed for a client which went away is not delivered */
+	exynos_histogram_update(t->dqe, &t->state);
+	exynos_histogram_unsubscribe(t->dqe, &t->a.client);
+	handle_histogram_frame_start(t->dqe);
+	handle_histogram_event(t->dqe);
+	KUNIT_EXPECT_EQ(test, t->a.count, 9);
+
+	for (i = 0; i < 3; i++)
+		dqe_hist_test_frame(test);
+	KUNIT_EXPECT_EQ(test, t->a.count, 9);
+	KUNIT_EXPECT_EQ(test, t->b.count, 4);
+}
+
+/* ROI and weights are only written when their contents change, wherever they live */
+static void dqe_hist_test_config(struct kunit *test)
+{
+	struct dqe_hist_test *t = test->priv;
+	struct histogram_roi *roi;
+	struct histogram_weights *weights;
+
+	roi = kunit_kzalloc(test, sizeof(*roi), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, roi);
+	roi->start_x = 100;
+	roi->start_y = 200;
+	roi->hsize = 300;
+	roi->vsize = 400;
+	t->a.client.roi = roi;
+	KUNIT_ASSERT_EQ(test, exynos_histogram_subscribe(t->dqe, &t->a.client), 0);
+
+	/* ROI registers and the histogram enable */
+	dqe_hist_test_frame(test);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), 3);
+	KUNIT_EXPECT_EQ(test, hist_read(REGS_DQE0_ID, DQE_HIST_START),
+			HIST_START_X(100) | HIST_START_Y(200));
+
+	t->a.client.roi = dqe_lut_test_dup(test, roi, sizeof(*roi));
+	dqe_hist_test_frame(test);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), 1);
+
+	t->a.client.roi->hsize = 320;
+	dqe_hist_test_frame(test);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), 3);
+	KUNIT_EXPECT_EQ(test, hist_read(REGS_DQE0_ID, DQE_HIST_SIZE),
+			HIST_HSIZE(320) | HIST_VSIZE(400));
+
+	/* a client without weights is sampled with the crtc state ones */
+	weights = kunit_kzalloc(test, sizeof(*weights), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, weights);
+	weights->weight_r = 1;
+	weights->weight_g = 2;
+	weights->weight_b = 3;
+	t->state.weights = weights;
+	dqe_hist_test_frame(test);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), 3);
+
+	t->state.weights = dqe_lut_test_dup(test, weights, sizeof(*weights));
+	dqe_hist_test_frame(test);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), 1);
+	KUNIT_EXPECT_EQ(test, t->a.count, 5);
+
+	/* nobody is interested any more: only the histogram is turned off */
+	exynos_histogram_unsubscribe(t->dqe, &t->a.client);
+	dqe_hist_test_frame(test);
+	KUNIT_EXPECT_EQ(test, dqe_lut_test_commit(), 1);
+	KUNIT_EXPECT_EQ(test, hist_read(REGS_DQE0_ID, DQE_HIST), 0);
+}
+
+static void dqe_hist_test_apl(struct kunit *test)
+{
+	struct dqe_hist_test *t = test->priv;
+	struct exynos_dqe *dqe = t->dqe;
+	int i;
+
+	dqe_hist_test_set_bin(128, 1000);
+	KUNIT_ASSERT_EQ(test, exynos_histogram_subscribe(dqe, &dqe->hist_apl_client), 0);
+	dqe_hist_test_frame(test);
+	KUNIT_EXPECT_EQ(test, dqe->hist_apl, 128);
+
+	/* half of the frame black, the other half at level 200 */
+	dqe_hist_test_set_bin(128, 0);
+	dqe_hist_test_set_bin(0, 500);
+	dqe_hist_test_set_bin(200, 500);
+	for (i = 0; i < HIST_APL_INTERVAL; i++) {
+		dqe_hist_test_frame(test);
+		KUNIT_EXPECT_EQ(test, dqe->hist_apl, 128);
+	}
+	dqe_hist_test_frame(test);
+	KUNIT_EXPECT_EQ(test, dqe->hist_apl, 100);
+
+	exynos_histogram_unsubscribe(dqe, &dqe->hist_apl_client);
+}
+
+static struct kunit_case dqe_hist_test_cases[] = {
+	KUNIT_CASE(dqe_hist_test_multiplex),
+	KUNIT_CASE(dqe_hist_test_config),
+	KUNIT_CASE(dqe_hist_test_apl),
+	{}
+};
+
+static struct kunit_suite dqe_hist_test_suite = {
+	.name = "exynos-drm-dqe-histogram",
+	.init = dqe_hist_test_init,
+	.exit = dqe_hist_test_exit,
+	.test_cases = dqe_hist_test_cases,
+};
+
+kunit_test_suites(&dqe_lut_test_suite, &dqe_hist_test_suite);
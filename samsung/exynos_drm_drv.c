@@ -32,6 +32,7 @@
 #include "exynos_drm_drv.h"
 #include "exynos_drm_dsim.h"
 #include "exynos_drm_fb.h"
+#include "exynos_drm_format.h"
 #include "exynos_drm_gem.h"
 #include "exynos_drm_plane.h"
 #include "exynos_drm_writeback.h"
@@ -200,9 +201,9 @@ static int exynos_atomic_check_windows(struct drm_device *dev, struct drm_atomic
 			 exynos_priv_state->available_win_mask, freed_win_mask);
 
 		/*
-		 * FIXME: these windows will be made available for next atomic commit as soon as
-		 * atomic state is swapped. This can lead to a (very rare) race condition if commit
-		 * to hw hasn't finished before an atomic commit comes in for a different crtc.
+		 * these windows will be made available for next atomic commit as soon as
+		 * atomic state is swapped, a commit for a different crtc picking them up
+		 * will wait for this commit to be done with hw (see win_commit).
 		 */
 		exynos_priv_state->available_win_mask |= freed_win_mask;
 	}
@@ -365,6 +366,8 @@ static struct drm_private_state *exynos_atomic_duplicate_priv_state(struct drm_p
 
 	__drm_atomic_helper_private_obj_duplicate_state(obj, &new_state->base);
 
+	new_state->win_commit = NULL;
+
 	return &new_state->base;
 }
 
@@ -373,6 +376,9 @@ static void exynos_atomic_destroy_priv_state(struct drm_private_obj *obj,
 {
 	struct exynos_drm_priv_state *priv_state = to_exynos_priv_state(state);
 
+	if (priv_state->win_commit)
+		drm_crtc_commit_put(priv_state->win_commit);
+
 	kfree(priv_state);
 }
 
@@ -381,7 +387,109 @@ static const struct drm_private_state_funcs exynos_priv_state_funcs = {
 	.atomic_destroy_state = exynos_atomic_destroy_priv_state,
 };
 
-static void commit_tail(struct drm_atomic_state *old_state)
+/*
+ * Find the commit that should own window pool changes done by this state. This is the commit
+ * of the crtc which had its reserved windows changed, or first crtc in state if none changed.
+ */
+static struct drm_crtc_commit *exynos_atomic_get_win_commit(struct drm_atomic_state *state)
+{
+	struct drm_crtc *crtc;
+	struct drm_crtc_state *old_crtc_state, *new_crtc_state;
+	struct drm_crtc_commit *commit = NULL;
+	int i;
+
+	for_each_oldnew_crtc_in_state(state, crtc, old_crtc_state, new_crtc_state, i) {
+		const struct exynos_drm_crtc_state *old_exynos_crtc_state =
+			to_exynos_crtc_state(old_crtc_state);
+		const struct exynos_drm_crtc_state *new_exynos_crtc_state =
+			to_exynos_crtc_state(new_crtc_state);
+
+		if (!new_crtc_state->commit)
+			continue;
+
+		if (old_exynos_crtc_state->reserved_win_mask !=
+		    new_exynos_crtc_state->reserved_win_mask)
+			return new_crtc_state->commit;
+
+		if (!commit)
+			commit = new_crtc_state->commit;
+	}
+
+	return commit;
+}
+
+/*
+ * Track which commit last changed the window pool. Commits for different crtcs are otherwise
+ * independent (drm helpers only track shared crtcs, planes and connectors) and run in parallel
+ * on each decon worker, but windows released by one crtc may not be reused by another crtc
+ * until the releasing commit is done with the hw.
+ */
+static void exynos_atomic_setup_win_commit(struct drm_atomic_state *state)
+{
+	struct exynos_drm_private *priv = drm_to_exynos_dev(state->dev);
+	const struct drm_private_state *old_state, *new_state;
+	const struct exynos_drm_priv_state *old_priv_state;
+	struct exynos_drm_priv_state *new_priv_state;
+	struct drm_crtc_commit *commit;
+
+	old_state = drm_atomic_get_old_private_obj_state(state, &priv->obj);
+	new_state = drm_atomic_get_new_private_obj_state(state, &priv->obj);
+	if (!old_state || !new_state)
+		return;
+
+	old_priv_state = to_exynos_priv_state(old_state);
+	new_priv_state = to_exynos_priv_state(new_state);
+
+	if (old_priv_state->available_win_mask != new_priv_state->available_win_mask)
+		commit = exynos_atomic_get_win_commit(state);
+	else
+		commit = old_priv_state->win_commit;
+
+	if (commit)
+		new_priv_state->win_commit = drm_crtc_commit_get(commit);
+}
+
+static void exynos_atomic_wait_for_win_commit(struct drm_atomic_state *old_state)
+{
+	struct exynos_drm_private *priv = drm_to_exynos_dev(old_state->dev);
+	const struct drm_private_state *old_state_base, *new_state_base;
+	const struct exynos_drm_priv_state *old_priv_state, *new_priv_state;
+	struct drm_crtc_commit *commit;
+	int ret;
+
+	old_state_base = drm_atomic_get_old_private_obj_state(old_state, &priv->obj);
+	new_state_base = drm_atomic_get_new_private_obj_state(old_state, &priv->obj);
+	if (!old_state_base || !new_state_base)
+		return;
+
+	old_priv_state = to_exynos_priv_state(old_state_base);
+	new_priv_state = to_exynos_priv_state(new_state_base);
+
+	/* only commits taking windows out of (or back into) the pool depend on each other */
+	if (old_priv_state->available_win_mask == new_priv_state->available_win_mask)
+		return;
+
+	commit = old_priv_state->win_commit;
+	if (!commit || commit == new_priv_state->win_commit)
+		return;
+
+	DPU_ATRACE_BEGIN("wait_for_win_commit");
+	ret = wait_for_completion_timeout(&commit->hw_done, 10 * HZ);
+	if (ret == 0)
+		DRM_ERROR("[CRTC:%d:%s] window pool hw_done timed out\n",
+			  commit->crtc->base.id, commit->crtc->name);
+	DPU_ATRACE_END("wait_for_win_commit");
+}
+
+/* completes a commit once the commit tail has run, possibly outside the commit worker */
+void exynos_atomic_commit_done(struct drm_atomic_state *old_state)
+{
+	drm_atomic_helper_commit_cleanup_done(old_state);
+
+	drm_atomic_state_put(old_state);
+}
+
+static void commit_tail(struct drm_atomic_state *old_state, bool nonblock)
 {
 	struct drm_device *dev = old_state->dev;
 	const struct drm_mode_config_helper_funcs *funcs;
@@ -393,15 +501,19 @@ static void commit_tail(struct drm_atomic_state *old_state)
 	DPU_ATRACE_END("wait_for_fences");
 
 	drm_atomic_helper_wait_for_dependencies(old_state);
+	exynos_atomic_wait_for_win_commit(old_state);
+
+	if (nonblock) {
+		exynos_atomic_commit_tail_nonblock(old_state);
+		return;
+	}
 
 	if (funcs && funcs->atomic_commit_tail)
 		funcs->atomic_commit_tail(old_state);
 	else
 		drm_atomic_helper_commit_tail(old_state);
 
-	drm_atomic_helper_commit_cleanup_done(old_state);
-
-	drm_atomic_state_put(old_state);
+	exynos_atomic_commit_done(old_state);
 }
 
 static void commit_kthread_work(struct kthread_work *work)
@@ -410,7 +522,7 @@ static void commit_kthread_work(struct kthread_work *work)
 		container_of(work, struct exynos_drm_priv_state, commit_work);
 	struct drm_atomic_state *old_state = exynos_priv_state->old_state;
 
-	commit_tail(old_state);
+	commit_tail(old_state, true);
 }
 
 static void commit_work(struct work_struct *work)
@@ -418,7 +530,7 @@ static void commit_work(struct work_struct *work)
 	struct drm_atomic_state *old_state =
 		container_of(work, struct drm_atomic_state, commit_work);
 
-	commit_tail(old_state);
+	commit_tail(old_state, true);
 }
 
 static void exynos_atomic_queue_work(struct drm_atomic_state *old_state, bool nonblock,
@@ -429,10 +541,10 @@ static void exynos_atomic_queue_work(struct drm_atomic_state *old_state, bool no
 	int i;
 
 	/*
-	 * queuing to first decon worker in atomic commit even if there are
-	 * multiple displays updated within same commit
-	 *
-	 * TODO: can work be split per display?
+	 * each decon has its own worker, so commits for different displays run in parallel and
+	 * are only serialized on shared crtcs, planes, connectors or window pool changes (see
+	 * exynos_atomic_wait_for_win_commit). A single commit updating multiple displays runs
+	 * on the worker of the first crtc in the commit.
 	 */
 	for_each_old_crtc_in_state(old_state, crtc, old_crtc_state, i) {
 		struct exynos_drm_crtc *exynos_crtc =
@@ -485,6 +597,8 @@ int exynos_atomic_commit(struct drm_device *dev, struct drm_atomic_state *state,
 	kthread_init_work(&exynos_priv_state->commit_work, commit_kthread_work);
 	exynos_priv_state->old_state = state;
 
+	exynos_atomic_setup_win_commit(state);
+
 	ret = drm_atomic_helper_prepare_planes(dev, state);
 	if (ret)
 		goto err;
@@ -523,7 +637,7 @@ int exynos_atomic_commit(struct drm_device *dev, struct drm_atomic_state *state,
 
 	drm_atomic_state_get(state);
 	if (!nonblock)
-		commit_tail(state);
+		commit_tail(state, false);
 	else
 		exynos_atomic_queue_work(state, nonblock, &exynos_priv_state->commit_work);
 
@@ -1096,6 +1210,8 @@ static int exynos_drm_init(void)
 {
 	int ret;
 
+	dpu_init_fmt_info();
+
 	ret = exynos_drm_register_devices();
 	if (ret)
 		return ret;
@@ -106,6 +106,18 @@ struct exynos_hdr_state {
  * specific overlay info.
  */
 
+/*
+ * Scaler setup of a scaled plane clipped by a partial update region. The ratios are the
+ * ones of the whole plane, the positions of the first output pixel within the fetched
+ * source are in 12.20 fixed point.
+ */
+struct exynos_plane_scl {
+	u32 h_ratio;
+	u32 v_ratio;
+	u32 h_pos;
+	u32 v_pos;
+};
+
 struct exynos_drm_plane_state {
 	struct drm_plane_state base;
 	uint32_t blob_id_restriction;
@@ -115,11 +127,14 @@ struct exynos_drm_plane_state {
 	uint32_t transfer;
 	uint32_t range;
 	uint32_t colormap;
+	uint32_t hdr_preset;
 	struct exynos_hdr_state hdr_state;
 	struct drm_property_blob *eotf_lut;
 	struct drm_property_blob *oetf_lut;
 	struct drm_property_blob *gm;
 	struct drm_property_blob *tm;
+	/* set by partial update, all zero if the plane isn't clipped by it */
+	struct exynos_plane_scl partial_scl;
 };
 
 static inline struct exynos_drm_plane_state *
@@ -154,6 +169,7 @@ struct exynos_drm_plane {
 		struct drm_property *oetf_lut;
 		struct drm_property *gm;
 		struct drm_property *tm;
+		struct drm_property *hdr_preset;
 		struct drm_property *colormap;
 	} props;
 };
@@ -216,7 +232,8 @@ struct exynos_drm_crtc_ops {
 		const struct drm_display_mode *adjusted_mode);
 	int (*atomic_check)(struct exynos_drm_crtc *crtc,
 			    struct drm_crtc_state *state);
-	void (*atomic_begin)(struct exynos_drm_crtc *crtc);
+	void (*atomic_begin)(struct exynos_drm_crtc *crtc,
+			     struct drm_crtc_state *old_crtc_state);
 	void (*update_plane)(struct exynos_drm_crtc *crtc,
 			     struct exynos_drm_plane *plane);
 	void (*disable_plane)(struct exynos_drm_crtc *crtc,
@@ -229,6 +246,12 @@ struct exynos_drm_crtc_ops {
 			const struct drm_crtc_state *new_crtc_state);
 };
 
+/* crtcs whose hibernation and runtime votes are held until the end of the commit tail */
+struct exynos_commit_tail_masks {
+	unsigned int hibernation_crtc_mask;
+	unsigned int disabling_crtc_mask;
+};
+
 struct exynos_drm_crtc_state {
 	struct drm_crtc_state base;
 	uint32_t color_mode;
@@ -276,6 +299,14 @@ struct exynos_drm_crtc_state {
 	struct drm_rect partial_region;
 	struct drm_property_blob *partial;
 	bool needs_reconfigure;
+
+	/**
+	 * @tail_work: runs the rest of a nonblocking commit tail on the decon worker
+	 *	       once the scheduled frame start of @tail_state is requested
+	 */
+	struct kthread_work tail_work;
+	struct drm_atomic_state *tail_state;
+	struct exynos_commit_tail_masks tail_masks;
 };
 
 static inline struct exynos_drm_crtc_state *
@@ -327,13 +358,26 @@ struct drm_exynos_file_private {
 struct exynos_drm_pending_histogram_event {
 	struct drm_pending_event base;
 	struct exynos_drm_histogram_event event;
+	/* entry in the dqe list of pending histogram requests */
+	struct list_head node;
 };
 
+/*
+ * Exynos drm private state structure.
+ *
+ * @old_state: atomic state being committed by @commit_work
+ * @commit_work: work used to run commit tail on the decon worker
+ * @win_commit: commit that last changed @available_win_mask, any later commit
+ *		that takes over windows from the pool must wait for it to be
+ *		programmed to hw before touching the same windows
+ * @available_win_mask: windows which are not reserved by any crtc
+ */
 struct exynos_drm_priv_state {
 	struct drm_private_state base;
 
 	struct drm_atomic_state *old_state;
 	struct kthread_work commit_work;
+	struct drm_crtc_commit *win_commit;
 
 	unsigned int available_win_mask;
 };
@@ -395,6 +439,8 @@ static inline int exynos_dpi_bind(struct drm_device *dev,
 
 int exynos_atomic_commit(struct drm_device *dev, struct drm_atomic_state *state,
 			 bool nonblock);
+void exynos_atomic_commit_done(struct drm_atomic_state *old_state);
+void exynos_atomic_commit_tail_nonblock(struct drm_atomic_state *old_state);
 int exynos_atomic_check(struct drm_device *dev, struct drm_atomic_state *state);
 int exynos_atomic_enter_tui(void);
 int exynos_atomic_exit_tui(void);
@@ -94,6 +94,8 @@ pr_debug("%s[%d]: "fmt, dsim->dev->driver->name, dsim->id, ##__VA_ARGS__)
 
 #define host_to_dsi(host) container_of(host, struct dsim_device, dsi_host)
 
+static void dsim_cmd_queue_flush_locked(struct dsim_device *dsim);
+
 #define DSIM_ESCAPE_CLK_20MHZ	20
 
 //#define DSIM_BIST
@@ -404,6 +406,9 @@ static void _dsim_disable(struct dsim_device *dsim)
 
 	/* Wait for current read & write CMDs. */
 	mutex_lock(&dsim->cmd_lock);
+	/* queued commands were accepted already, send them before the link goes down */
+	if (dsim->state == DSIM_STATE_HSCLKEN)
+		dsim_cmd_queue_flush_locked(dsim);
 	/* TODO: 0x1F will be changed */
 	dsim_reg_stop(dsim->id, 0x1F);
 	disable_irq(dsim->irq);
@@ -413,6 +418,10 @@ static void _dsim_disable(struct dsim_device *dsim)
 	mutex_unlock(&dsim->cmd_lock);
 	mutex_unlock(&dsim->state_lock);
 
+	/* the queue is empty now, drain_work would only find it suspended */
+	hrtimer_cancel(&dsim->cmdq.drain_timer);
+	cancel_work_sync(&dsim->cmdq.drain_work);
+
 	dsim_phy_power_off(dsim);
 
 #if defined(CONFIG_CPU_IDLE)
@@ -1533,6 +1542,9 @@ static irqreturn_t dsim_irq_handler(int irq, void *dev_id)
 		dsim_debug(dsim, "framedone irq occurs\n");
 		if (decon)
 			DPU_EVENT_LOG(DPU_EVT_DSIM_FRAMEDONE, decon->id, NULL);
+		/* frame is out, queued commands won't tear it anymore */
+		if (READ_ONCE(dsim->cmdq.depth))
+			queue_work(system_highpri_wq, &dsim->cmdq.drain_work);
 	}
 
 	if (int_src & DSIM_INTSRC_RX_CRC) {
@@ -1764,12 +1776,14 @@ static int dsim_wait_for_cmd_fifo_empty(struct dsim_device *dsim, bool is_long)
 	return ret;
 }
 
+#define DSIM_PAYLOAD_BURST_WORDS	32
 static void
 dsim_write_payload(struct dsim_device *dsim, const u8* buf, size_t len)
 {
+	u32 words[DSIM_PAYLOAD_BURST_WORDS];
 	const u8 *p = buf;
 	const u8 *end = buf + len;
-	u32 payload;
+	u32 cnt = 0;
 
 	dsim_debug(dsim, "payload length(%lu)\n", len);
 
@@ -1777,18 +1791,20 @@ dsim_write_payload(struct dsim_device *dsim, const u8* buf, size_t len)
 		size_t pkt_size = min_t(size_t, 4, end - p);
 
 		if (pkt_size >= 4)
-			payload = p[0] | p[1] << 8 | p[2] << 16 | p[3] << 24;
+			words[cnt] = get_unaligned_le32(p);
 		else if (pkt_size == 3)
-			payload = p[0] | p[1] << 8 | p[2] << 16;
+			words[cnt] = p[0] | p[1] << 8 | p[2] << 16;
 		else if (pkt_size == 2)
-			payload = p[0] | p[1] << 8;
-		else if (pkt_size == 1)
-			payload = p[0];
-
-		dsim_reg_wr_tx_payload(dsim->id, payload);
-		dsim_debug(dsim, "payload: 0x%x\n", payload);
+			words[cnt] = p[0] | p[1] << 8;
+		else
+			words[cnt] = p[0];
 
 		p += pkt_size;
+
+		if (++cnt == DSIM_PAYLOAD_BURST_WORDS || p >= end) {
+			dsim_reg_wr_tx_payload_burst(dsim->id, words, cnt);
+			cnt = 0;
+		}
 	}
 }
 
@@ -1846,23 +1862,30 @@ static int dsim_write_single_cmd_locked(struct dsim_device *dsim,
  * at once.
  */
 #define PKTGO_READY_MARGIN_NS	1000000
-static void need_wait_vblank(struct dsim_device *dsim)
+/*
+ * Returns true if stacked commands can be released now without crossing a
+ * vblank. Otherwise returns false and sets @next_vblank to the predicted start
+ * of the next vblank.
+ */
+static bool dsim_pktgo_ready_allowed(struct dsim_device *dsim,
+				     ktime_t *next_vblank)
 {
 	const struct decon_device *decon = dsim_get_decon(dsim);
 	struct drm_vblank_crtc *vblank;
 	struct drm_crtc *crtc;
 	ktime_t last_vblanktime, diff, cur_time;
 	int ready_allow_period;
+	bool allowed;
 
 	if (!decon)
-		return;
+		return true;
 
 	crtc = &decon->crtc->base;
 	if (!crtc)
-		return;
+		return true;
 
 	if (drm_crtc_vblank_get(crtc))
-		return;
+		return true;
 
 	vblank = &crtc->dev->vblank[crtc->index];
 	ready_allow_period =
@@ -1875,9 +1898,27 @@ static void need_wait_vblank(struct dsim_device *dsim)
 	dsim_debug(dsim, "last(%lld) cur(%lld) diff(%lld) ready allow period(%d)\n",
 			last_vblanktime, cur_time, diff, ready_allow_period);
 
-	if (diff > ready_allow_period)
-		drm_crtc_wait_one_vblank(crtc);
+	allowed = diff <= ready_allow_period;
+	if (!allowed && next_vblank) {
+		*next_vblank = ktime_add_ns(last_vblanktime, vblank->framedur_ns);
+		/* timestamp is stale if vblank irq was off, assume a full frame */
+		if (ktime_compare(*next_vblank, cur_time) <= 0)
+			*next_vblank = ktime_add_ns(cur_time, vblank->framedur_ns);
+	}
 	drm_crtc_vblank_put(crtc);
+
+	return allowed;
+}
+
+static void need_wait_vblank(struct dsim_device *dsim)
+{
+	const struct decon_device *decon;
+
+	if (dsim_pktgo_ready_allowed(dsim, NULL))
+		return;
+
+	decon = dsim_get_decon(dsim);
+	drm_crtc_wait_one_vblank(&decon->crtc->base);
 }
 
 #define PL_FIFO_THRESHOLD	mult_frac(MAX_PL_FIFO, 75, 100) /* 75% */
@@ -2089,6 +2130,468 @@ dsim_write_data_dual(struct dsim_device *dsim, const struct mipi_dsi_msg *msg)
 
 	return ret;
 }
+static void dsim_account_cmd_result(struct dsim_device *dsim,
+				    const struct mipi_dsi_msg *msg, int ret)
+{
+	const u8 *tx_buf = msg->tx_buf;
+
+	if (ret != -ETIMEDOUT || !msg->tx_len)
+		return;
+
+	dsim->cmd_timeout_cnt[tx_buf[0]]++;
+	dsim_warn(dsim, "cmd 0x%02x timed out (%u)\n", tx_buf[0],
+		  dsim->cmd_timeout_cnt[tx_buf[0]]);
+}
+
+/*
+ * Asynchronous command queue
+ *
+ * Writes flagged with EXYNOS_DSI_MSG_ASYNC are copied and queued instead of
+ * blocking the caller until packetgo can be released. The queue is drained
+ * from a worker in FIFO sized segments, kicked either by an hrtimer armed at
+ * the predicted start of the next vblank or by framedone. Each segment is
+ * released with a single packetgo so it never spans two vblank intervals.
+ * Synchronous messages drain the queue first so ordering is preserved.
+ */
+static void dsim_cmd_queue_complete(struct dsim_cmd_queue *cmdq, u64 seq,
+				    int err)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&cmdq->lock, flags);
+	if (seq > cmdq->done_seq)
+		cmdq->done_seq = seq;
+	if (err)
+		cmdq->err = err;
+	spin_unlock_irqrestore(&cmdq->lock, flags);
+
+	wake_up_all(&cmdq->done_wait);
+}
+
+static void dsim_cmd_queue_fail(struct dsim_device *dsim, int err)
+{
+	struct dsim_cmd_queue *cmdq = &dsim->cmdq;
+	struct dsim_cmd_desc *desc, *tmp;
+	unsigned long flags;
+	LIST_HEAD(list);
+	u64 seq;
+
+	spin_lock_irqsave(&cmdq->lock, flags);
+	list_splice_init(&cmdq->pending, &list);
+	cmdq->depth = 0;
+	seq = cmdq->queued_seq;
+	spin_unlock_irqrestore(&cmdq->lock, flags);
+
+	if (list_empty(&list))
+		return;
+
+	list_for_each_entry_safe(desc, tmp, &list, node) {
+		list_del(&desc->node);
+		kfree(desc);
+	}
+
+	dsim_warn(dsim, "dropped queued commands (%d)\n", err);
+	dsim_cmd_queue_complete(cmdq, seq, err);
+}
+
+/*
+ * Moves the oldest pending commands that fit the FIFOs into @segment and marks
+ * the last of them to release packetgo. Returns the number of commands moved.
+ */
+static u32 dsim_cmd_queue_take_segment(struct dsim_cmd_queue *cmdq,
+				       struct list_head *segment,
+				       bool in_ready_allow)
+{
+	struct dsim_cmd_desc *desc, *tmp;
+	unsigned long flags;
+	u32 ph = 0, pl = 0;
+
+	spin_lock_irqsave(&cmdq->lock, flags);
+	list_for_each_entry_safe(desc, tmp, &cmdq->pending, node) {
+		const u32 len = ALIGN(desc->msg.tx_len, 4);
+
+		/* same limits dsim_write_data uses to force the last command */
+		if (ph && ((ph + 1) >= MAX_PH_FIFO ||
+				(pl + len) > PL_FIFO_THRESHOLD))
+			break;
+
+		list_move_tail(&desc->node, segment);
+		cmdq->depth--;
+		ph++;
+		pl += len;
+	}
+	spin_unlock_irqrestore(&cmdq->lock, flags);
+
+	list_for_each_entry(desc, segment, node) {
+		struct mipi_dsi_msg *msg = &desc->msg;
+
+		msg->flags &= ~(MIPI_DSI_MSG_LASTCOMMAND | EXYNOS_DSI_MSG_ASYNC);
+		if (list_is_last(&desc->node, segment)) {
+			msg->flags |= MIPI_DSI_MSG_LASTCOMMAND;
+			if (in_ready_allow)
+				msg->flags |= EXYNOS_DSI_MSG_IGNORE_VBLANK;
+		} else {
+			msg->flags &= ~EXYNOS_DSI_MSG_IGNORE_VBLANK;
+		}
+	}
+
+	return ph;
+}
+
+static void dsim_cmd_queue_send_segment_locked(struct dsim_device *dsim,
+					       bool in_ready_allow)
+{
+	struct dsim_cmd_queue *cmdq = &dsim->cmdq;
+	struct dsim_cmd_desc *desc, *tmp;
+	LIST_HEAD(segment);
+	u32 ph;
+	u64 seq = 0;
+	int ret, err = 0;
+
+	WARN_ON(!mutex_is_locked(&dsim->cmd_lock));
+
+	ph = dsim_cmd_queue_take_segment(cmdq, &segment, in_ready_allow);
+	if (!ph)
+		return;
+
+	DPU_ATRACE_INT("dsim_cmdq_segment", ph);
+
+	list_for_each_entry_safe(desc, tmp, &segment, node) {
+		struct mipi_dsi_msg *msg = &desc->msg;
+
+		ret = dsim_write_data(dsim, msg);
+		if (ret) {
+			dsim_account_cmd_result(dsim, msg, ret);
+			err = ret;
+		}
+
+		seq = desc->seq;
+		list_del(&desc->node);
+		kfree(desc);
+	}
+
+	DPU_ATRACE_INT("dsim_cmdq_segment", 0);
+
+	dsim_cmd_queue_complete(cmdq, seq, err);
+}
+
+/* synchronously send everything queued, waiting for vblank as needed */
+static void dsim_cmd_queue_flush_locked(struct dsim_device *dsim)
+{
+	while (READ_ONCE(dsim->cmdq.depth))
+		dsim_cmd_queue_send_segment_locked(dsim, false);
+}
+
+static void dsim_cmd_queue_schedule(struct dsim_device *dsim)
+{
+	struct dsim_cmd_queue *cmdq = &dsim->cmdq;
+	ktime_t next_vblank;
+
+	if (dsim_pktgo_ready_allowed(dsim, &next_vblank))
+		queue_work(system_highpri_wq, &cmdq->drain_work);
+	else
+		hrtimer_start(&cmdq->drain_timer, next_vblank, HRTIMER_MODE_ABS);
+}
+
+/* copies @msg to the tail of the queue */
+static int dsim_cmd_queue_insert(struct dsim_cmd_queue *cmdq,
+				 const struct mipi_dsi_msg *msg)
+{
+	struct dsim_cmd_desc *desc;
+	unsigned long flags;
+
+	desc = kmalloc(struct_size(desc, tx_buf, msg->tx_len), GFP_KERNEL);
+	if (!desc)
+		return -ENOMEM;
+
+	desc->msg = *msg;
+	memcpy(desc->tx_buf, msg->tx_buf, msg->tx_len);
+	desc->msg.tx_buf = desc->tx_buf;
+	desc->msg.rx_buf = NULL;
+	desc->msg.rx_len = 0;
+
+	spin_lock_irqsave(&cmdq->lock, flags);
+	desc->seq = ++cmdq->queued_seq;
+	list_add_tail(&desc->node, &cmdq->pending);
+	cmdq->depth++;
+	spin_unlock_irqrestore(&cmdq->lock, flags);
+
+	return 0;
+}
+
+static int dsim_cmd_queue_add(struct dsim_device *dsim,
+			      const struct mipi_dsi_msg *msg)
+{
+	int ret;
+
+	ret = dsim_cmd_queue_insert(&dsim->cmdq, msg);
+	if (ret)
+		return ret;
+
+	DPU_ATRACE_INT("dsim_cmdq_depth", dsim->cmdq.depth);
+
+	dsim_cmd_queue_schedule(dsim);
+
+	return 0;
+}
+
+static bool dsim_cmd_queue_can_defer(const struct dsim_device *dsim,
+				     const struct mipi_dsi_msg *msg)
+{
+	if (!(msg->flags & EXYNOS_DSI_MSG_ASYNC))
+		return false;
+
+	/* packetgo is only used in command mode, dual dsi must stay in lockstep */
+	if (dsim->config.mode != DSIM_COMMAND_MODE ||
+			dsim->dual_dsi != DSIM_DUAL_DSI_NONE)
+		return false;
+
+	return READ_ONCE(dsim->cmdq.depth) < DSIM_CMD_QUEUE_MAX_DEPTH;
+}
+
+static void dsim_cmd_queue_drain_work(struct work_struct *work)
+{
+	struct dsim_device *dsim = container_of(work, struct dsim_device,
+						cmdq.drain_work);
+	bool allowed;
+	int ret;
+
+	if (!READ_ONCE(dsim->cmdq.depth))
+		return;
+
+	DPU_ATRACE_BEGIN(__func__);
+
+	ret = pm_runtime_resume_and_get(dsim->dev);
+	if (ret) {
+		dsim_cmd_queue_fail(dsim, ret);
+		goto out;
+	}
+
+	mutex_lock(&dsim->cmd_lock);
+	if (dsim->state != DSIM_STATE_HSCLKEN) {
+		dsim_cmd_queue_fail(dsim, -EPERM);
+	} else if (!dsim->total_pend_ph) {
+		/*
+		 * While a synchronous batch is in progress nothing is appended to
+		 * it, the transfer releasing the batch kicks the queue again.
+		 *
+		 * If the worker ran late, the last command of the segment waits
+		 * for vblank here rather than in the caller's context.
+		 */
+		allowed = dsim_pktgo_ready_allowed(dsim, NULL);
+		dsim_cmd_queue_send_segment_locked(dsim, allowed);
+		if (READ_ONCE(dsim->cmdq.depth))
+			dsim_cmd_queue_schedule(dsim);
+	}
+	mutex_unlock(&dsim->cmd_lock);
+
+	pm_runtime_mark_last_busy(dsim->dev);
+	pm_runtime_put_sync_autosuspend(dsim->dev);
+out:
+	DPU_ATRACE_INT("dsim_cmdq_depth", dsim->cmdq.depth);
+	DPU_ATRACE_END(__func__);
+}
+
+static enum hrtimer_restart dsim_cmd_queue_timer_fn(struct hrtimer *timer)
+{
+	struct dsim_cmd_queue *cmdq = container_of(timer, struct dsim_cmd_queue,
+						   drain_timer);
+
+	queue_work(system_highpri_wq, &cmdq->drain_work);
+
+	return HRTIMER_NORESTART;
+}
+
+/**
+ * exynos_dsi_cmd_queue_fence - get a fence for commands queued so far
+ * @dsi: dsi device the commands were sent to
+ *
+ * Returns a value that can be passed to exynos_dsi_cmd_queue_wait() to wait
+ * until every EXYNOS_DSI_MSG_ASYNC command queued before this call is sent.
+ */
+u64 exynos_dsi_cmd_queue_fence(struct mipi_dsi_device *dsi)
+{
+	struct dsim_cmd_queue *cmdq = &host_to_dsi(dsi->host)->cmdq;
+	unsigned long flags;
+	u64 fence;
+
+	spin_lock_irqsave(&cmdq->lock, flags);
+	fence = cmdq->queued_seq;
+	spin_unlock_irqrestore(&cmdq->lock, flags);
+
+	return fence;
+}
+EXPORT_SYMBOL(exynos_dsi_cmd_queue_fence);
+
+/**
+ * exynos_dsi_cmd_queue_wait - wait for queued commands up to @fence
+ * @dsi: dsi device the commands were sent to
+ * @fence: value returned by exynos_dsi_cmd_queue_fence()
+ *
+ * Returns 0 on success, -ETIMEDOUT if the commands were not sent in time, or
+ * the first error hit while sending queued commands since the last wait.
+ */
+int exynos_dsi_cmd_queue_wait(struct mipi_dsi_device *dsi, u64 fence)
+{
+	struct dsim_cmd_queue *cmdq = &host_to_dsi(dsi->host)->cmdq;
+	unsigned long flags;
+	long ret;
+	int err;
+
+	ret = wait_event_timeout(cmdq->done_wait,
+				 READ_ONCE(cmdq->done_seq) >= fence,
+				 DSIM_CMD_QUEUE_TIMEOUT);
+	if (!ret)
+		return -ETIMEDOUT;
+
+	spin_lock_irqsave(&cmdq->lock, flags);
+	err = cmdq->err;
+	cmdq->err = 0;
+	spin_unlock_irqrestore(&cmdq->lock, flags);
+
+	return err;
+}
+EXPORT_SYMBOL(exynos_dsi_cmd_queue_wait);
+
+static void dsim_read_finish(struct exynos_dsi_read_req *req, ssize_t ret)
+{
+	req->ret = ret;
+	if (req->complete)
+		req->complete(req);
+	complete_all(&req->done);
+}
+
+static void dsim_read_fail(struct dsim_device *dsim, int err)
+{
+	struct dsim_cmd_queue *cmdq = &dsim->cmdq;
+	struct exynos_dsi_read_req *req, *tmp;
+	unsigned long flags;
+	LIST_HEAD(list);
+
+	spin_lock_irqsave(&cmdq->lock, flags);
+	list_splice_init(&cmdq->reads, &list);
+	spin_unlock_irqrestore(&cmdq->lock, flags);
+
+	list_for_each_entry_safe(req, tmp, &list, node) {
+		list_del_init(&req->node);
+		dsim_read_finish(req, err);
+	}
+}
+
+static void dsim_read_work(struct work_struct *work)
+{
+	struct dsim_device *dsim = container_of(work, struct dsim_device,
+						cmdq.read_work);
+	struct dsim_cmd_queue *cmdq = &dsim->cmdq;
+	struct exynos_dsi_read_req *req;
+	unsigned long flags;
+	ssize_t ret;
+
+	DPU_ATRACE_BEGIN(__func__);
+
+	for (;;) {
+		spin_lock_irqsave(&cmdq->lock, flags);
+		req = list_first_entry_or_null(&cmdq->reads,
+					       struct exynos_dsi_read_req, node);
+		if (req)
+			list_del_init(&req->node);
+		spin_unlock_irqrestore(&cmdq->lock, flags);
+
+		if (!req)
+			break;
+
+		ret = pm_runtime_resume_and_get(dsim->dev);
+		if (ret) {
+			dsim_read_finish(req, ret);
+			dsim_read_fail(dsim, ret);
+			break;
+		}
+
+		/* cmd_lock is taken per read so writes can go in between */
+		mutex_lock(&dsim->cmd_lock);
+		if (dsim->state != DSIM_STATE_HSCLKEN) {
+			ret = -EPERM;
+		} else {
+			if (!dsim->total_pend_ph)
+				dsim_cmd_queue_flush_locked(dsim);
+			ret = dsim_read_data(dsim, &req->msg);
+			dsim_account_cmd_result(dsim, &req->msg, ret);
+		}
+		mutex_unlock(&dsim->cmd_lock);
+
+		pm_runtime_mark_last_busy(dsim->dev);
+		pm_runtime_put_sync_autosuspend(dsim->dev);
+
+		dsim_read_finish(req, ret);
+	}
+
+	DPU_ATRACE_END(__func__);
+}
+
+static int dsim_read_data_async(struct dsim_device *dsim,
+				struct exynos_dsi_read_req *req)
+{
+	struct dsim_cmd_queue *cmdq = &dsim->cmdq;
+	unsigned long flags;
+
+	if (req->msg.rx_len > MAX_RX_FIFO || !req->msg.rx_buf ||
+			!req->msg.tx_len) {
+		dsim_err(dsim, "invalid async read rx len(%lu)\n",
+			 req->msg.rx_len);
+		return -EINVAL;
+	}
+
+	init_completion(&req->done);
+	req->ret = 0;
+
+	spin_lock_irqsave(&cmdq->lock, flags);
+	list_add_tail(&req->node, &cmdq->reads);
+	spin_unlock_irqrestore(&cmdq->lock, flags);
+
+	queue_work(system_highpri_wq, &cmdq->read_work);
+
+	return 0;
+}
+
+/**
+ * exynos_dsi_read_async - queue a read without waiting for the response
+ * @dsi: dsi device to read from
+ * @req: read request, must stay valid until @req->done is signaled
+ *
+ * Reads are issued in order from a host worker, after any write queued before
+ * them. Returns 0 if the request was queued, @req->ret holds the result once
+ * @req->done is signaled.
+ */
+int exynos_dsi_read_async(struct mipi_dsi_device *dsi,
+			  struct exynos_dsi_read_req *req)
+{
+	return dsim_read_data_async(host_to_dsi(dsi->host), req);
+}
+EXPORT_SYMBOL(exynos_dsi_read_async);
+
+static void dsim_cmd_queue_init(struct dsim_device *dsim)
+{
+	struct dsim_cmd_queue *cmdq = &dsim->cmdq;
+
+	spin_lock_init(&cmdq->lock);
+	INIT_LIST_HEAD(&cmdq->pending);
+	INIT_WORK(&cmdq->drain_work, dsim_cmd_queue_drain_work);
+	INIT_LIST_HEAD(&cmdq->reads);
+	INIT_WORK(&cmdq->read_work, dsim_read_work);
+	hrtimer_init(&cmdq->drain_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	cmdq->drain_timer.function = dsim_cmd_queue_timer_fn;
+	init_waitqueue_head(&cmdq->done_wait);
+}
+
+static void dsim_cmd_queue_deinit(struct dsim_device *dsim)
+{
+	hrtimer_cancel(&dsim->cmdq.drain_timer);
+	cancel_work_sync(&dsim->cmdq.drain_work);
+	cancel_work_sync(&dsim->cmdq.read_work);
+	dsim_cmd_queue_fail(dsim, -ENODEV);
+	dsim_read_fail(dsim, -ENODEV);
+}
+
 static ssize_t dsim_host_transfer(struct mipi_dsi_host *host,
 			    const struct mipi_dsi_msg *msg)
 {
@@ -2115,10 +2618,22 @@ static ssize_t dsim_host_transfer(struct mipi_dsi_host *host,
 	case MIPI_DSI_GENERIC_READ_REQUEST_0_PARAM:
 	case MIPI_DSI_GENERIC_READ_REQUEST_1_PARAM:
 	case MIPI_DSI_GENERIC_READ_REQUEST_2_PARAM:
+		if (!dsim->total_pend_ph)
+			dsim_cmd_queue_flush_locked(dsim);
 		ret = dsim_read_data(dsim, msg);
+		dsim_account_cmd_result(dsim, msg, ret);
 		break;
 	default:
+		if (dsim_cmd_queue_can_defer(dsim, msg)) {
+			ret = dsim_cmd_queue_add(dsim, msg);
+			break;
+		}
+
+		/* a batch already started was ordered after the queue at its start */
+		if (!dsim->total_pend_ph)
+			dsim_cmd_queue_flush_locked(dsim);
 		ret = dsim_write_data(dsim, msg);
+		dsim_account_cmd_result(dsim, msg, ret);
 		if (dsim->dual_dsi == DSIM_DUAL_DSI_MAIN) {
 			sec_dsi = exynos_get_dual_dsi(DSIM_DUAL_DSI_SEC);
 			if (sec_dsi)
@@ -2129,6 +2644,10 @@ static ssize_t dsim_host_transfer(struct mipi_dsi_host *host,
 		break;
 	}
 
+	/* commands queued while a batch was open were held back by drain_work */
+	if (!dsim->total_pend_ph && READ_ONCE(dsim->cmdq.depth))
+		dsim_cmd_queue_schedule(dsim);
+
 abort:
 	mutex_unlock(&dsim->cmd_lock);
 
@@ -2463,6 +2982,7 @@ static int dsim_probe(struct platform_device *pdev)
 	spin_lock_init(&dsim->slock);
 	mutex_init(&dsim->cmd_lock);
 	mutex_init(&dsim->state_lock);
+	dsim_cmd_queue_init(dsim);
 	init_completion(&dsim->ph_wr_comp);
 	init_completion(&dsim->pl_wr_comp);
 	init_completion(&dsim->rd_comp);
@@ -2519,6 +3039,7 @@ static int dsim_remove(struct platform_device *pdev)
 
 	device_remove_file(dsim->dev, &dev_attr_bist_mode);
 	device_remove_file(dsim->dev, &dev_attr_hs_clock);
+	dsim_cmd_queue_deinit(dsim);
 	pm_runtime_disable(&pdev->dev);
 
 	component_del(&pdev->dev, &dsim_component_ops);
@@ -2629,3 +3150,7 @@ MODULE_SOFTDEP("pre: phy-exynos-mipi");
 MODULE_AUTHOR("Donghwa Lee <dh09.lee@samsung.com>");
 MODULE_DESCRIPTION("Samsung SoC MIPI DSI Master");
 MODULE_LICENSE("GPL v2");
+
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_KUNIT_TEST)
+#include "exynos_drm_dsim_test.c"
+#endif
@@ -20,6 +20,9 @@
 #include <drm/drm_mipi_dsi.h>
 #include <drm/drm_property.h>
 #include <drm/drm_panel.h>
+#include <linux/hrtimer.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
 #include <video/videomode.h>
 
 #include <dsim_cal.h>
@@ -65,6 +68,37 @@ struct dsim_resources {
 	struct phy *phy_ex;
 };
 
+/* copy of an asynchronous command waiting to be released to the FIFO */
+struct dsim_cmd_desc {
+	struct list_head node;
+	struct mipi_dsi_msg msg;
+	u64 seq;
+	u8 tx_buf[];
+};
+
+#define DSIM_CMD_QUEUE_MAX_DEPTH	64
+
+struct dsim_cmd_queue {
+	/* protects pending, depth and the sequence numbers */
+	spinlock_t lock;
+	struct list_head pending;
+	u32 depth;
+
+	/* drains one FIFO sized segment per run */
+	struct work_struct drain_work;
+	/* kicks drain_work at the predicted start of the next vblank */
+	struct hrtimer drain_timer;
+
+	wait_queue_head_t done_wait;
+	u64 queued_seq;
+	u64 done_seq;
+	int err;
+
+	/* asynchronous reads, also protected by lock */
+	struct list_head reads;
+	struct work_struct read_work;
+};
+
 struct dsim_device {
 	struct drm_encoder encoder;
 	struct mipi_dsi_host dsi_host;
@@ -113,6 +147,9 @@ struct dsim_device {
 	int idle_ip_index;
 	u8 total_pend_ph;
 	u16 total_pend_pl;
+	struct dsim_cmd_queue cmdq;
+	/* timeouts accounted by the first byte of the command */
+	u32 cmd_timeout_cnt[256];
 
 	enum dsim_dual_dsi dual_dsi;
 };
@@ -123,6 +160,7 @@ extern struct dsim_device *dsim_drvdata[MAX_DSI_CNT];
 
 #define MIPI_WR_TIMEOUT				msecs_to_jiffies(80)
 #define MIPI_RD_TIMEOUT				msecs_to_jiffies(100)
+#define DSIM_CMD_QUEUE_TIMEOUT			msecs_to_jiffies(200)
 
 struct decon_device;
 
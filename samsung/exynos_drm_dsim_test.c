@@ -0,0 +1,359 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the DSIM asynchronous command queue and payload writes,
+ * included from exynos_drm_dsim.c.
+ *
+ * Copyright (c) 2018 Samsung Electronics Co., Ltd.
+ */
+
+#include <kunit/test.h>
+#include <cal_regs_record.h>
+
+static int dsim_cmdq_test_init(struct kunit *test)
+{
+	struct dsim_cmd_queue *cmdq;
+
+	cmdq = kunit_kzalloc(test, sizeof(*cmdq), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, cmdq);
+
+	spin_lock_init(&cmdq->lock);
+	INIT_LIST_HEAD(&cmdq->pending);
+	INIT_LIST_HEAD(&cmdq->reads);
+	init_waitqueue_head(&cmdq->done_wait);
+	test->priv = cmdq;
+
+	return 0;
+}
+
+static void dsim_cmdq_test_exit(struct kunit *test)
+{
+	struct dsim_cmd_queue *cmdq = test->priv;
+	struct dsim_cmd_desc *desc, *tmp;
+
+	list_for_each_entry_safe(desc, tmp, &cmdq->pending, node) {
+		list_del(&desc->node);
+		kfree(desc);
+	}
+}
+
+/* queues a write of @len bytes, all set to @tag */
+static void dsim_cmdq_test_insert(struct kunit *test, u8 tag, size_t len, u16 flags)
+{
+	struct mipi_dsi_msg msg = {
+		.type = MIPI_DSI_GENERIC_LONG_WRITE,
+		.flags = flags | EXYNOS_DSI_MSG_ASYNC,
+		.tx_len = len,
+	};
+	u8 *buf;
+
+	buf = kunit_kmalloc(test, len, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, buf);
+	memset(buf, tag, len);
+	msg.tx_buf = buf;
+
+	KUNIT_ASSERT_EQ(test, dsim_cmd_queue_insert(test->priv, &msg), 0);
+}
+
+/*
+ * Takes one segment and checks it continues the FIFO order at *@next_seq, fits the
+ * FIFOs unless it is a single command, and that only its last command releases
+ * packetgo. Returns the number of commands taken.
+ */
+static u32 dsim_cmdq_test_take(struct kunit *test, bool in_ready_allow, u64 *next_seq)
+{
+	struct dsim_cmd_queue *cmdq = test->priv;
+	struct dsim_cmd_desc *desc, *tmp;
+	const u32 depth = cmdq->depth;
+	LIST_HEAD(segment);
+	u32 ph, cnt = 0, pl = 0;
+
+	ph = dsim_cmd_queue_take_segment(cmdq, &segment, in_ready_allow);
+	KUNIT_EXPECT_EQ(test, cmdq->depth, depth - ph);
+
+	list_for_each_entry_safe(desc, tmp, &segment, node) {
+		const struct mipi_dsi_msg *msg = &desc->msg;
+		const bool last = list_is_last(&desc->node, &segment);
+		const u8 *buf = msg->tx_buf;
+
+		KUNIT_EXPECT_EQ(test, desc->seq, (*next_seq)++);
+		/* the payload is the queue's own copy and tagged with the sequence */
+		KUNIT_EXPECT_PTR_EQ(test, msg->tx_buf, (const void *)desc->tx_buf);
+		KUNIT_EXPECT_EQ(test, buf[0], (u8)desc->seq);
+		KUNIT_EXPECT_EQ(test, buf[msg->tx_len - 1], (u8)desc->seq);
+
+		KUNIT_EXPECT_FALSE(test, msg->flags & EXYNOS_DSI_MSG_ASYNC);
+		KUNIT_EXPECT_EQ(test, !!(msg->flags & MIPI_DSI_MSG_LASTCOMMAND), last);
+		KUNIT_EXPECT_EQ(test, !!(msg->flags & EXYNOS_DSI_MSG_IGNORE_VBLANK),
+				last && in_ready_allow);
+
+		cnt++;
+		pl += ALIGN(msg->tx_len, 4);
+		list_del(&desc->node);
+		kfree(desc);
+	}
+
+	KUNIT_EXPECT_EQ(test, cnt, ph);
+	if (cnt > 1) {
+		KUNIT_EXPECT_LT(test, cnt, MAX_PH_FIFO);
+		KUNIT_EXPECT_LE(test, pl, PL_FIFO_THRESHOLD);
+	}
+
+	/* segments are as large as the FIFOs allow */
+	desc = list_first_entry_or_null(&cmdq->pending, struct dsim_cmd_desc, node);
+	if (desc && cnt)
+		KUNIT_EXPECT_TRUE(test, cnt + 1 >= MAX_PH_FIFO ||
+				pl + ALIGN(desc->msg.tx_len, 4) > PL_FIFO_THRESHOLD);
+
+	return cnt;
+}
+
+static void dsim_cmdq_test_fifo_order(struct kunit *test)
+{
+	struct dsim_cmd_queue *cmdq = test->priv;
+	const size_t lens[] = { 1, 3, 4, 17, 2, 255, 8, 1 };
+	u64 next_seq = 1;
+	int i;
+
+	/* caller flags must not leak into the middle of a segment */
+	for (i = 0; i < ARRAY_SIZE(lens); i++)
+		dsim_cmdq_test_insert(test, i + 1, lens[i],
+				MIPI_DSI_MSG_LASTCOMMAND | EXYNOS_DSI_MSG_IGNORE_VBLANK);
+
+	KUNIT_EXPECT_EQ(test, cmdq->depth, ARRAY_SIZE(lens));
+	KUNIT_EXPECT_EQ(test, cmdq->queued_seq, ARRAY_SIZE(lens));
+
+	KUNIT_EXPECT_EQ(test, dsim_cmdq_test_take(test, false, &next_seq), ARRAY_SIZE(lens));
+	KUNIT_EXPECT_EQ(test, dsim_cmdq_test_take(test, false, &next_seq), 0);
+	KUNIT_EXPECT_TRUE(test, list_empty(&cmdq->pending));
+}
+
+static void dsim_cmdq_test_ready_allow(struct kunit *test)
+{
+	u64 next_seq = 1;
+	int i;
+
+	for (i = 0; i < 3; i++)
+		dsim_cmdq_test_insert(test, i + 1, 4, 0);
+
+	KUNIT_EXPECT_EQ(test, dsim_cmdq_test_take(test, true, &next_seq), 3);
+}
+
+/* more headers than the PH FIFO holds are split in order */
+static void dsim_cmdq_test_ph_limit(struct kunit *test)
+{
+	struct dsim_cmd_queue *cmdq = test->priv;
+	const int cnt = MAX_PH_FIFO * 2 + 5;
+	u64 next_seq = 1;
+	int i, segments = 0;
+
+	for (i = 0; i < cnt; i++)
+		dsim_cmdq_test_insert(test, i + 1, 2, 0);
+
+	while (cmdq->depth) {
+		KUNIT_ASSERT_GT(test, dsim_cmdq_test_take(test, false, &next_seq), 0);
+		segments++;
+	}
+
+	KUNIT_EXPECT_EQ(test, next_seq, cnt + 1);
+	KUNIT_EXPECT_EQ(test, segments, DIV_ROUND_UP(cnt, MAX_PH_FIFO - 1));
+}
+
+/* payloads beyond the PL threshold are split in order, oversized ones go alone */
+static void dsim_cmdq_test_pl_limit(struct kunit *test)
+{
+	struct dsim_cmd_queue *cmdq = test->priv;
+	const size_t lens[] = { 500, 500, 500, 500, PL_FIFO_THRESHOLD + 4, 6, 700, 700 };
+	u64 next_seq = 1;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(lens); i++)
+		dsim_cmdq_test_insert(test, i + 1, lens[i], 0);
+
+	KUNIT_EXPECT_EQ(test, dsim_cmdq_test_take(test, false, &next_seq), 3);
+	KUNIT_EXPECT_EQ(test, dsim_cmdq_test_take(test, false, &next_seq), 1);
+	KUNIT_EXPECT_EQ(test, dsim_cmdq_test_take(test, false, &next_seq), 1);
+	KUNIT_EXPECT_EQ(test, dsim_cmdq_test_take(test, false, &next_seq), 3);
+	KUNIT_EXPECT_EQ(test, cmdq->depth, 0);
+}
+
+/* commands queued while a segment is out go behind everything queued before */
+static void dsim_cmdq_test_interleaved(struct kunit *test)
+{
+	struct dsim_cmd_queue *cmdq = test->priv;
+	u64 next_seq = 1;
+	int i;
+
+	for (i = 0; i < MAX_PH_FIFO + 2; i++)
+		dsim_cmdq_test_insert(test, i + 1, 2, 0);
+
+	KUNIT_EXPECT_EQ(test, dsim_cmdq_test_take(test, false, &next_seq), MAX_PH_FIFO - 1);
+
+	for (; i < MAX_PH_FIFO + 6; i++)
+		dsim_cmdq_test_insert(test, i + 1, 2, 0);
+
+	KUNIT_EXPECT_EQ(test, dsim_cmdq_test_take(test, false, &next_seq), 7);
+	KUNIT_EXPECT_EQ(test, next_seq, cmdq->queued_seq + 1);
+}
+
+static void dsim_cmdq_test_complete(struct kunit *test)
+{
+	struct dsim_cmd_queue *cmdq = test->priv;
+
+	dsim_cmd_queue_complete(cmdq, 5, 0);
+	KUNIT_EXPECT_EQ(test, cmdq->done_seq, 5);
+
+	/* completions never move the fence backwards, errors stick until consumed */
+	dsim_cmd_queue_complete(cmdq, 3, -EIO);
+	KUNIT_EXPECT_EQ(test, cmdq->done_seq, 5);
+	KUNIT_EXPECT_EQ(test, cmdq->err, -EIO);
+
+	dsim_cmd_queue_complete(cmdq, 8, 0);
+	KUNIT_EXPECT_EQ(test, cmdq->done_seq, 8);
+	KUNIT_EXPECT_EQ(test, cmdq->err, -EIO);
+}
+
+static struct kunit_case dsim_cmdq_test_cases[] = {
+	KUNIT_CASE(dsim_cmdq_test_fifo_order),
+	KUNIT_CASE(dsim_cmdq_test_ready_allow),
+	KUNIT_CASE(dsim_cmdq_test_ph_limit),
+	KUNIT_CASE(dsim_cmdq_test_pl_limit),
+	KUNIT_CASE(dsim_cmdq_test_interleaved),
+	KUNIT_CASE(dsim_cmdq_test_complete),
+	{}
+};
+
+static struct kunit_suite dsim_cmdq_test_suite = {
+	.name = "exynos-drm-dsim-cmdq",
+	.init = dsim_cmdq_test_init,
+	.exit = dsim_cmdq_test_exit,
+	.test_cases = dsim_cmdq_test_cases,
+};
+
+#define DSIM_PAYLOAD_TEST_ID		REGS_DSIM0_ID
+#define DSIM_PAYLOAD_TEST_LEN		SZ_2K
+#define DSIM_PAYLOAD_TEST_LOG_SIZE	(DSIM_PAYLOAD_TEST_LEN / 4 + 1)
+
+struct dsim_payload_test {
+	struct device *dev;
+	struct cal_regs_recorder *rec;
+	struct dsim_device *dsim;
+	u8 *buf;
+};
+
+/* dsim_debug() names the driver of the DSIM device */
+static struct device_driver dsim_payload_test_driver = {
+	.name = "dsim_payload_test",
+};
+
+static int dsim_payload_test_init(struct kunit *test)
+{
+	struct dsim_payload_test *t;
+	struct device *dsim_dev;
+	int i;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t);
+
+	dsim_dev = kunit_kzalloc(test, sizeof(*dsim_dev), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, dsim_dev);
+	dsim_dev->driver = &dsim_payload_test_driver;
+
+	t->dsim = kunit_kzalloc(test, sizeof(*t->dsim), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t->dsim);
+	t->dsim->id = DSIM_PAYLOAD_TEST_ID;
+	t->dsim->dev = dsim_dev;
+
+	t->buf = kunit_kmalloc(test, DSIM_PAYLOAD_TEST_LEN + 1, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t->buf);
+	for (i = 0; i < DSIM_PAYLOAD_TEST_LEN + 1; i++)
+		t->buf[i] = i * 7 + 1;
+
+	t->dev = root_device_register("dsim_payload_test");
+	KUNIT_ASSERT_FALSE(test, IS_ERR(t->dev));
+
+	t->rec = cal_regs_recorder_create(t->dev, SZ_4K, DSIM_PAYLOAD_TEST_LOG_SIZE, false);
+	KUNIT_ASSERT_NOT_NULL(test, t->rec);
+
+	cal_regs_recorder_attach(t->rec, dsim_regs_desc(DSIM_PAYLOAD_TEST_ID));
+	test->priv = t;
+
+	return 0;
+}
+
+static void dsim_payload_test_exit(struct kunit *test)
+{
+	struct dsim_payload_test *t = test->priv;
+
+	cal_regs_recorder_detach(dsim_regs_desc(DSIM_PAYLOAD_TEST_ID));
+	root_device_unregister(t->dev);
+}
+
+/*
+ * Writes @len bytes of the test buffer and checks the payload port received one store
+ * per word, little endian and zero padded, and nothing else.
+ */
+static void dsim_payload_test_write(struct kunit *test, size_t len)
+{
+	struct dsim_payload_test *t = test->priv;
+	const u32 words = DIV_ROUND_UP(len, 4);
+	u32 i;
+
+	cal_regs_recorder_reset(t->rec);
+	dsim_write_payload(t->dsim, t->buf, len);
+
+	KUNIT_EXPECT_EQ(test, cal_regs_recorder_commit(dsim_regs_desc(DSIM_PAYLOAD_TEST_ID)),
+			words);
+	KUNIT_ASSERT_EQ(test, t->rec->log_cnt, words);
+	KUNIT_EXPECT_EQ(test, t->rec->log_dropped, 0);
+
+	for (i = 0; i < words; i++) {
+		u8 bytes[4] = { 0 };
+
+		memcpy(bytes, t->buf + i * 4, min_t(size_t, 4, len - i * 4));
+		KUNIT_EXPECT_EQ(test, t->rec->log[i].offset, DSIM_PAYLOAD);
+		KUNIT_EXPECT_EQ_MSG(test, t->rec->log[i].val, get_unaligned_le32(bytes),
+				"word %u of %zu bytes", i, len);
+	}
+}
+
+/* a 2 KiB payload, a full PL FIFO, is 512 stores in 16 bursts of 32 words */
+static void dsim_payload_test_2k(struct kunit *test)
+{
+	struct dsim_payload_test *t = test->priv;
+
+	dsim_payload_test_write(test, DSIM_PAYLOAD_TEST_LEN);
+	KUNIT_EXPECT_EQ(test, t->rec->log_cnt, 16 * DSIM_PAYLOAD_BURST_WORDS);
+	KUNIT_EXPECT_EQ(test, t->rec->total_writes, (u64)DSIM_PAYLOAD_TEST_LEN / 4);
+}
+
+/* the last word may be partial, bursts may end anywhere */
+static void dsim_payload_test_unaligned(struct kunit *test)
+{
+	const size_t lens[] = {
+		1, 2, 3, 4, 5,
+		4 * DSIM_PAYLOAD_BURST_WORDS - 1,
+		4 * DSIM_PAYLOAD_BURST_WORDS,
+		4 * DSIM_PAYLOAD_BURST_WORDS + 1,
+		DSIM_PAYLOAD_TEST_LEN - 1,
+		DSIM_PAYLOAD_TEST_LEN + 1,
+	};
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(lens); i++)
+		dsim_payload_test_write(test, lens[i]);
+}
+
+static struct kunit_case dsim_payload_test_cases[] = {
+	KUNIT_CASE(dsim_payload_test_2k),
+	KUNIT_CASE(dsim_payload_test_unaligned),
+	{}
+};
+
+static struct kunit_suite dsim_payload_test_suite = {
+	.name = "exynos-drm-dsim-payload",
+	.init = dsim_payload_test_init,
+	.exit = dsim_payload_test_exit,
+	.test_cases = dsim_payload_test_cases,
+};
+
+kunit_test_suites(&dsim_cmdq_test_suite, &dsim_payload_test_suite);
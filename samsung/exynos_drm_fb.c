@@ -453,16 +453,36 @@ static void exynos_atomic_bts_post_update(struct drm_device *dev,
 	}
 }
 
-static void exynos_atomic_commit_tail(struct drm_atomic_state *old_state)
+/* share of the display updated by a commit in percent, used to pace panel idle */
+static unsigned int exynos_atomic_update_pct(const struct drm_crtc_state *crtc_state)
+{
+	const struct exynos_drm_crtc_state *exynos_crtc_state =
+					to_exynos_crtc_state(crtc_state);
+	const struct drm_display_mode *mode = &crtc_state->mode;
+	const struct drm_rect *region = &exynos_crtc_state->partial_region;
+	u64 area;
+
+	if (!exynos_crtc_state->planes_updated)
+		return 0;
+
+	if (!exynos_crtc_state->partial || !mode->hdisplay || !mode->vdisplay ||
+	    drm_rect_width(region) <= 0 || drm_rect_height(region) <= 0)
+		return 100;
+
+	area = (u64)drm_rect_width(region) * drm_rect_height(region) * 100;
+
+	return clamp_t(u32, DIV_ROUND_UP_ULL(area, mode->hdisplay * mode->vdisplay), 1, 100);
+}
+
+/* runs the commit tail up to flushing the hw, which requests or schedules frame start */
+static void exynos_atomic_commit_tail_begin(struct drm_atomic_state *old_state,
+					    struct exynos_commit_tail_masks *masks)
 {
 	int i;
 	struct drm_device *dev = old_state->dev;
 	struct decon_device *decon;
 	struct drm_crtc *crtc;
 	struct drm_crtc_state *old_crtc_state, *new_crtc_state;
-	struct drm_connector *connector;
-	struct drm_connector_state *old_conn_state;
-	struct drm_connector_state *new_conn_state;
 	unsigned int hibernation_crtc_mask = 0;
 	unsigned int disabling_crtc_mask = 0;
 
@@ -494,7 +514,7 @@ static void exynos_atomic_commit_tail(struct drm_atomic_state *old_state)
 				new_crtc_state);
 
 		if (new_crtc_state->active || old_crtc_state->active) {
-			hibernation_block(decon->hibernation);
+			hibernation_block_fast_exit(decon->hibernation, new_crtc_state);
 
 			hibernation_crtc_mask |= drm_crtc_mask(crtc);
 		}
@@ -544,6 +564,29 @@ static void exynos_atomic_commit_tail(struct drm_atomic_state *old_state)
 
 	drm_atomic_helper_fake_vblank(old_state);
 
+	masks->hibernation_crtc_mask = hibernation_crtc_mask;
+	masks->disabling_crtc_mask = disabling_crtc_mask;
+
+	DPU_ATRACE_END("exynos_atomic_commit_tail");
+}
+
+/* runs the rest of the commit tail once frame start has been requested */
+static void exynos_atomic_commit_tail_end(struct drm_atomic_state *old_state,
+					  const struct exynos_commit_tail_masks *masks)
+{
+	int i;
+	struct drm_device *dev = old_state->dev;
+	struct decon_device *decon;
+	struct drm_crtc *crtc;
+	struct drm_crtc_state *new_crtc_state;
+	struct drm_connector *connector;
+	struct drm_connector_state *old_conn_state;
+	struct drm_connector_state *new_conn_state;
+	const unsigned int hibernation_crtc_mask = masks->hibernation_crtc_mask;
+	const unsigned int disabling_crtc_mask = masks->disabling_crtc_mask;
+
+	DPU_ATRACE_BEGIN("exynos_atomic_commit_tail_end");
+
 	for_each_oldnew_connector_in_state(old_state, connector,
 				 old_conn_state, new_conn_state, i) {
 		if (new_conn_state->writeback_job || !new_conn_state->crtc)
@@ -559,6 +602,13 @@ static void exynos_atomic_commit_tail(struct drm_atomic_state *old_state)
 			const struct exynos_drm_connector_helper_funcs *funcs =
 				exynos_connector->helper_private;
 
+			/* keep panel property updates behind the frame start of this commit */
+			if (to_exynos_connector_state(new_conn_state)->pending_update_flags)
+				decon_wait_kickoff(crtc_to_decon(new_conn_state->crtc));
+
+			to_exynos_connector_state(new_conn_state)->update_pct =
+				exynos_atomic_update_pct(new_crtc_state);
+
 			funcs->atomic_commit(exynos_connector,
 					to_exynos_connector_state(old_conn_state),
 					to_exynos_connector_state(new_conn_state));
@@ -587,7 +637,68 @@ static void exynos_atomic_commit_tail(struct drm_atomic_state *old_state)
 
 	drm_atomic_helper_cleanup_planes(dev, old_state);
 
-	DPU_ATRACE_END("exynos_atomic_commit_tail");
+	DPU_ATRACE_END("exynos_atomic_commit_tail_end");
+}
+
+static void exynos_atomic_commit_tail(struct drm_atomic_state *old_state)
+{
+	struct exynos_commit_tail_masks masks;
+
+	exynos_atomic_commit_tail_begin(old_state, &masks);
+	exynos_atomic_commit_tail_end(old_state, &masks);
+}
+
+static void exynos_atomic_commit_tail_work(struct kthread_work *work)
+{
+	struct exynos_drm_crtc_state *exynos_crtc_state =
+		container_of(work, struct exynos_drm_crtc_state, tail_work);
+	/* the crtc state is only guaranteed to stay around until hw_done */
+	struct drm_atomic_state *old_state = exynos_crtc_state->tail_state;
+	const struct exynos_commit_tail_masks masks = exynos_crtc_state->tail_masks;
+
+	exynos_atomic_commit_tail_end(old_state, &masks);
+	exynos_atomic_commit_done(old_state);
+}
+
+/*
+ * Nonblocking commits on a single crtc whose frame start is scheduled for later leave the
+ * rest of the commit tail, which mostly waits for flip done, to the decon worker once frame
+ * start is requested. The commit worker is free in the meantime.
+ *
+ * The next nonblocking commit on the crtc can't be set up before flip done, which comes
+ * after frame start, so its commit work is always queued behind this tail. Commits without
+ * vblank events may signal flip done before frame start and always run the tail in place.
+ */
+void exynos_atomic_commit_tail_nonblock(struct drm_atomic_state *old_state)
+{
+	struct exynos_drm_crtc_state *exynos_crtc_state = NULL;
+	struct exynos_commit_tail_masks masks;
+	struct drm_crtc_state *new_crtc_state;
+	struct drm_crtc *crtc;
+	int i;
+
+	for_each_new_crtc_in_state(old_state, crtc, new_crtc_state, i) {
+		if (exynos_crtc_state || new_crtc_state->no_vblank) {
+			exynos_crtc_state = NULL;
+			break;
+		}
+		exynos_crtc_state = to_exynos_crtc_state(new_crtc_state);
+	}
+
+	exynos_atomic_commit_tail_begin(old_state, &masks);
+
+	if (exynos_crtc_state) {
+		kthread_init_work(&exynos_crtc_state->tail_work, exynos_atomic_commit_tail_work);
+		exynos_crtc_state->tail_state = old_state;
+		exynos_crtc_state->tail_masks = masks;
+
+		if (decon_kickoff_defer_work(crtc_to_decon(exynos_crtc_state->base.crtc),
+					     &exynos_crtc_state->tail_work))
+			return;
+	}
+
+	exynos_atomic_commit_tail_end(old_state, &masks);
+	exynos_atomic_commit_done(old_state);
 }
 
 static struct drm_mode_config_helper_funcs exynos_drm_mode_config_helpers = {
@@ -10,6 +10,9 @@
  * published by the Free Software Foundation.
  */
 
+#include <linux/bsearch.h>
+#include <linux/cache.h>
+#include <linux/sort.h>
 #include <drm/drm_print.h>
 #include <uapi/drm/drm_fourcc.h>
 
@@ -18,7 +21,7 @@
 
 #include "exynos_drm_format.h"
 
-static const struct dpu_fmt dpu_formats_list[] = {
+static struct dpu_fmt dpu_formats_list[] __ro_after_init = {
 	{
 		.name = "C8",
 		.fmt = DRM_FORMAT_C8,
@@ -249,16 +252,71 @@ static const struct dpu_fmt dpu_formats_list[] = {
         },
 };
 
-const struct dpu_fmt *dpu_find_fmt_info(u32 fmt)
+/* dpu_formats_list sorted by fourcc, built once by dpu_init_fmt_info() */
+static const struct dpu_fmt *dpu_formats_index[ARRAY_SIZE(dpu_formats_list)] __ro_after_init;
+
+static int dpu_fmt_index_cmp(const void *a, const void *b)
+{
+	const struct dpu_fmt *fa = *(const struct dpu_fmt * const *)a;
+	const struct dpu_fmt *fb = *(const struct dpu_fmt * const *)b;
+
+	if (fa->fmt == fb->fmt)
+		return 0;
+
+	return fa->fmt < fb->fmt ? -1 : 1;
+}
+
+static int dpu_fmt_key_cmp(const void *key, const void *elt)
+{
+	const u32 fmt = *(const u32 *)key;
+	const struct dpu_fmt *f = *(const struct dpu_fmt * const *)elt;
+
+	if (fmt == f->fmt)
+		return 0;
+
+	return fmt < f->fmt ? -1 : 1;
+}
+
+static void dpu_fmt_precompute(struct dpu_fmt *f)
+{
+	f->total_bpp = f->bpp + f->padding;
+	f->align_mul = IS_YUV(f) ? 2 : 1;
+	f->hsub_shift = IS_YUV(f) ? 1 : 0;
+	f->vsub_shift = IS_YUV420(f) ? 1 : 0;
+}
+
+void dpu_init_fmt_info(void)
 {
 	int i;
 
-	for (i = 0; i < ARRAY_SIZE(dpu_formats_list); i++)
-		if (dpu_formats_list[i].fmt == fmt)
-			return &dpu_formats_list[i];
+	for (i = 0; i < ARRAY_SIZE(dpu_formats_list); i++) {
+		dpu_fmt_precompute(&dpu_formats_list[i]);
+		dpu_formats_index[i] = &dpu_formats_list[i];
+	}
+
+	sort(dpu_formats_index, ARRAY_SIZE(dpu_formats_index),
+			sizeof(dpu_formats_index[0]), dpu_fmt_index_cmp, NULL);
+
+	for (i = 1; i < ARRAY_SIZE(dpu_formats_index); i++)
+		WARN(dpu_formats_index[i - 1]->fmt == dpu_formats_index[i]->fmt,
+				"duplicated format %s\n", dpu_formats_index[i]->name);
+}
+
+const struct dpu_fmt *dpu_find_fmt_info(u32 fmt)
+{
+	const struct dpu_fmt * const *f;
+
+	f = bsearch(&fmt, dpu_formats_index, ARRAY_SIZE(dpu_formats_index),
+			sizeof(dpu_formats_index[0]), dpu_fmt_key_cmp);
+	if (likely(f))
+		return *f;
 
 	DRM_INFO("%s: can't find format(%d) in supported format list\n",
 			__func__, fmt);
 
 	return NULL;
 }
+
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_KUNIT_TEST)
+#include "exynos_drm_format_test.c"
+#endif
@@ -36,6 +36,12 @@ struct dpu_fmt {
 	u8 num_planes;		   /* plane(s) count of color format */
 	u8 len_alpha;		   /* length of alpha bits */
 	enum dpu_colorspace cs;
+
+	/* derived from the above by dpu_init_fmt_info() */
+	u8 total_bpp;		   /* bits fetched per pixel, bpp + padding */
+	u8 align_mul;		   /* factor to multiply source alignment/size */
+	u8 hsub_shift;		   /* horizontal chroma subsampling shift */
+	u8 vsub_shift;		   /* vertical chroma subsampling shift */
 };
 
 /* format */
@@ -46,7 +52,7 @@ struct dpu_fmt {
 #define IS_YUV10(f)		(IS_YUV(f) && ((f)->bpc == 10))
 #define IS_RGB(f)		((f)->cs == DPU_COLORSPACE_RGB)
 #define IS_RGB32(f)	\
-	(((f)->cs == DPU_COLORSPACE_RGB) && (((f)->bpp + (f)->padding) == 32))
+	(((f)->cs == DPU_COLORSPACE_RGB) && ((f)->total_bpp == 32))
 #define IS_10BPC(f)		((f)->bpc == 10)
 #define IS_OPAQUE(f)		((f)->len_alpha == 0)
 
@@ -76,6 +82,7 @@ struct dpu_fmt {
 #define PL_STRIDE_SIZE_SBWC(w, bpc)	((bpc) ? SBWC_10B_STRIDE(w) :	\
 						SBWC_8B_STRIDE(w))
 
+void dpu_init_fmt_info(void);
 const struct dpu_fmt *dpu_find_fmt_info(u32 fmt);
 
 #endif /* __EXYNOS_FORMAT_H__ */
@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the format lookup and the per-format values derived at init,
+ * included from exynos_drm_format.c.
+ *
+ * Copyright (C) 2020 Samsung Electronics Co.Ltd
+ */
+
+#include <kunit/test.h>
+#include <linux/ktime.h>
+
+#define DPU_FMT_TEST_ROUNDS	10000
+
+/* lookup as it was done before the index, the baseline of the benchmark */
+static const struct dpu_fmt *dpu_fmt_test_find_linear(u32 fmt)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(dpu_formats_list); i++)
+		if (dpu_formats_list[i].fmt == fmt)
+			return &dpu_formats_list[i];
+
+	return NULL;
+}
+
+static int dpu_fmt_test_init(struct kunit *test)
+{
+	/* built by dpu_init_fmt_info() from the module init */
+	KUNIT_ASSERT_NOT_NULL(test, dpu_formats_index[0]);
+
+	return 0;
+}
+
+static void dpu_fmt_test_lookup(struct kunit *test)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(dpu_formats_list); i++)
+		KUNIT_EXPECT_PTR_EQ(test, dpu_find_fmt_info(dpu_formats_list[i].fmt),
+				&dpu_formats_list[i]);
+
+	for (i = 1; i < ARRAY_SIZE(dpu_formats_index); i++)
+		KUNIT_EXPECT_LT(test, dpu_formats_index[i - 1]->fmt, dpu_formats_index[i]->fmt);
+
+	KUNIT_EXPECT_PTR_EQ(test, dpu_find_fmt_info(0), NULL);
+	KUNIT_EXPECT_PTR_EQ(test, dpu_find_fmt_info(fourcc_code('X', 'X', 'X', 'X')), NULL);
+}
+
+static void dpu_fmt_test_derived(struct kunit *test)
+{
+	const struct dpu_fmt *f;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(dpu_formats_list); i++) {
+		f = &dpu_formats_list[i];
+
+		KUNIT_EXPECT_EQ(test, f->total_bpp, f->bpp + f->padding);
+		switch (f->cs) {
+		case DPU_COLORSPACE_RGB:
+			KUNIT_EXPECT_EQ(test, f->align_mul, 1);
+			KUNIT_EXPECT_EQ(test, f->hsub_shift, 0);
+			KUNIT_EXPECT_EQ(test, f->vsub_shift, 0);
+			break;
+		case DPU_COLORSPACE_YUV422:
+			KUNIT_EXPECT_EQ(test, f->align_mul, 2);
+			KUNIT_EXPECT_EQ(test, f->hsub_shift, 1);
+			KUNIT_EXPECT_EQ(test, f->vsub_shift, 0);
+			break;
+		case DPU_COLORSPACE_YUV420:
+			KUNIT_EXPECT_EQ(test, f->align_mul, 2);
+			KUNIT_EXPECT_EQ(test, f->hsub_shift, 1);
+			KUNIT_EXPECT_EQ(test, f->vsub_shift, 1);
+			break;
+		}
+	}
+}
+
+/*
+ * Looks up every supported fourcc the way a commit does, once per plane, with both
+ * the linear scan and the index.
+ */
+static void dpu_fmt_test_lookup_cost(struct kunit *test)
+{
+	const u32 cnt = ARRAY_SIZE(dpu_formats_list);
+	const u64 lookups = (u64)DPU_FMT_TEST_ROUNDS * cnt;
+	uintptr_t linear_sum = 0, index_sum = 0;
+	u64 linear_ns, index_ns;
+	ktime_t start;
+	u32 i, r;
+
+	start = ktime_get();
+	for (r = 0; r < DPU_FMT_TEST_ROUNDS; r++)
+		for (i = 0; i < cnt; i++)
+			linear_sum += (uintptr_t)dpu_fmt_test_find_linear(dpu_formats_list[i].fmt);
+	linear_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	start = ktime_get();
+	for (r = 0; r < DPU_FMT_TEST_ROUNDS; r++)
+		for (i = 0; i < cnt; i++)
+			index_sum += (uintptr_t)dpu_find_fmt_info(dpu_formats_list[i].fmt);
+	index_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	KUNIT_EXPECT_EQ(test, linear_sum, index_sum);
+
+	kunit_info(test, "lookup over %u fourccs: linear %llu.%02llu ns, index %llu.%02llu ns\n",
+		   cnt, div64_u64(linear_ns, lookups),
+		   div64_u64(linear_ns * 100, lookups) % 100,
+		   div64_u64(index_ns, lookups),
+		   div64_u64(index_ns * 100, lookups) % 100);
+}
+
+static struct kunit_case dpu_fmt_test_cases[] = {
+	KUNIT_CASE(dpu_fmt_test_lookup),
+	KUNIT_CASE(dpu_fmt_test_derived),
+	KUNIT_CASE(dpu_fmt_test_lookup_cost),
+	{}
+};
+
+static struct kunit_suite dpu_fmt_test_suite = {
+	.name = "exynos-drm-format",
+	.init = dpu_fmt_test_init,
+	.test_cases = dpu_fmt_test_cases,
+};
+
+kunit_test_suite(dpu_fmt_test_suite);
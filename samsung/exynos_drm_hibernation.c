@@ -20,11 +20,16 @@
 #include <linux/sched.h>
 #include <linux/err.h>
 #include <linux/atomic.h>
+#include <linux/jhash.h>
+#include <linux/ktime.h>
+#include <linux/moduleparam.h>
+#include <linux/seq_file.h>
 
 #include <trace/dpu_trace.h>
 
 #include <dqe_cal.h>
 
+#include "exynos_drm_connector.h"
 #include "exynos_drm_decon.h"
 #include "exynos_drm_hibernation.h"
 #include "exynos_drm_writeback.h"
@@ -32,6 +37,11 @@
 #define HIBERNATION_ENTRY_MIN_TIME_MS		50
 #define CAMERA_OPERATION_MASK	0xF
 
+static bool hibernation_fast_path = true;
+module_param(hibernation_fast_path, bool, 0644);
+MODULE_PARM_DESC(hibernation_fast_path,
+		 "power gate and restore display directly instead of through an atomic commit");
+
 static bool is_camera_operating(struct exynos_hibernation *hiber)
 {
 	/* No need to check camera operation status. It depends on SoC */
@@ -166,15 +176,225 @@ out_drop_locks:
 	return ret;
 }
 
+static void exynos_hibernation_record_exit(struct exynos_hibernation *hiber,
+		enum exynos_hibernation_path path, ktime_t start)
+{
+	struct exynos_hibernation_latency *lat = &hiber->exit_latency[path];
+	const u64 us = ktime_us_delta(ktime_get(), start);
+	const int bucket = min(fls64(us >> 7), HIBERNATION_LATENCY_BUCKETS - 1);
+
+	lockdep_assert_held(&hiber->fast_lock);
+
+	lat->count++;
+	lat->total_us += us;
+	lat->max_us = max(lat->max_us, us);
+	lat->buckets[bucket]++;
+}
+
+static inline u32 exynos_hibernation_config_hash(const struct decon_device *decon)
+{
+	return jhash(&decon->config, sizeof(decon->config), 0);
+}
+
+/*
+ * Fast path is only used for plain command mode self refresh. Anything that needs
+ * connector or writeback handling on the way in or out goes through the atomic path.
+ */
+static bool exynos_hibernation_fast_allowed(const struct exynos_hibernation *hiber,
+					    const struct drm_crtc_state *crtc_state)
+{
+	struct decon_device *decon = hiber->decon;
+	const struct exynos_drm_crtc_state *exynos_crtc_state;
+
+	if (!hibernation_fast_path)
+		return false;
+
+	if (!crtc_state->active || crtc_state->self_refresh_active)
+		return false;
+
+	exynos_crtc_state = to_exynos_crtc_state(crtc_state);
+	if (exynos_crtc_state->bypass || exynos_crtc_state->wb_type != EXYNOS_WB_NONE)
+		return false;
+
+	return decon_get_dsim(decon) != NULL;
+}
+
+/*
+ * The panel has to follow self refresh like it does through the bridge on the atomic path,
+ * so every connector of the crtc must be self refresh aware and able to be told directly.
+ */
+static struct exynos_drm_connector *
+exynos_hibernation_get_connector(struct drm_crtc *crtc)
+{
+	struct drm_connector_list_iter conn_iter;
+	struct drm_connector *connector;
+	struct exynos_drm_connector *exynos_connector = NULL;
+	bool supported = true;
+
+	drm_connector_list_iter_begin(crtc->dev, &conn_iter);
+	drm_for_each_connector_iter(connector, &conn_iter) {
+		if (connector->state->crtc != crtc)
+			continue;
+
+		if (!connector->state->self_refresh_aware || !is_exynos_drm_connector(connector) ||
+		    !to_exynos_connector(connector)->helper_private->set_self_refresh) {
+			supported = false;
+			break;
+		}
+		exynos_connector = to_exynos_connector(connector);
+	}
+	drm_connector_list_iter_end(&conn_iter);
+
+	return supported ? exynos_connector : NULL;
+}
+
+static void exynos_hibernation_set_self_refresh(struct exynos_drm_connector *exynos_connector,
+						bool enable)
+{
+	exynos_connector->helper_private->set_self_refresh(exynos_connector, enable);
+}
+
+/* true if a commit has been swapped in for the crtc but hasn't reached the hardware yet */
+static bool exynos_hibernation_commit_pending(struct drm_crtc *crtc)
+{
+	struct drm_crtc_commit *commit;
+	bool pending;
+
+	spin_lock(&crtc->commit_lock);
+	commit = list_first_entry_or_null(&crtc->commit_list, struct drm_crtc_commit,
+					  commit_entry);
+	pending = commit && !completion_done(&commit->hw_done);
+	spin_unlock(&crtc->commit_lock);
+
+	return pending;
+}
+
+static void exynos_hibernation_disable_planes(struct exynos_hibernation *hiber,
+					      const struct drm_crtc_state *crtc_state)
+{
+	struct exynos_drm_crtc *exynos_crtc = hiber->decon->crtc;
+	struct drm_plane *plane;
+
+	if (!exynos_crtc->ops->disable_plane)
+		return;
+
+	drm_for_each_plane_mask(plane, exynos_crtc->base.dev, crtc_state->plane_mask) {
+		if (plane->state->visible)
+			exynos_crtc->ops->disable_plane(exynos_crtc, to_exynos_plane(plane));
+	}
+}
+
+static int exynos_hibernation_fast_enter(struct exynos_hibernation *hiber)
+{
+	struct decon_device *decon = hiber->decon;
+	struct drm_crtc *crtc = &decon->crtc->base;
+	const struct drm_crtc_state *crtc_state;
+	struct exynos_drm_connector *connector;
+	int ret = 0;
+
+	mutex_lock(&hiber->fast_lock);
+
+	/*
+	 * Commits take a block before exiting fast hibernation under fast_lock, so the
+	 * block held by the caller must be the only one for the snapshot to be current.
+	 */
+	if (atomic_read(&hiber->block_cnt) > 1 || exynos_hibernation_commit_pending(crtc)) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	/*
+	 * Any commit replacing an active crtc state goes through fast_lock in its commit
+	 * tail before the old state is released, so the state can be used until unlock.
+	 */
+	crtc_state = READ_ONCE(crtc->state);
+	if (!exynos_hibernation_fast_allowed(hiber, crtc_state)) {
+		ret = -EOPNOTSUPP;
+		goto out;
+	}
+
+	connector = exynos_hibernation_get_connector(crtc);
+	if (!connector) {
+		ret = -EOPNOTSUPP;
+		goto out;
+	}
+
+	DPU_ATRACE_BEGIN(__func__);
+
+	hiber->snapshot.config_hash = exynos_hibernation_config_hash(decon);
+	hiber->snapshot.connector = connector;
+
+	/* same order as the atomic path, the panel goes first while dsim is still up */
+	exynos_hibernation_set_self_refresh(connector, true);
+
+	/* DPPs lose their context, disable them so that they are fully set up on restore */
+	exynos_hibernation_disable_planes(hiber, crtc_state);
+
+	decon_enter_hibernation(decon);
+	if (IS_ENABLED(CONFIG_EXYNOS_BTS))
+		decon->bts.ops->release_bw(decon);
+
+	/* drop dsim vote as in regular self refresh, dsim enters ULPS on runtime suspend */
+	pm_runtime_put_sync(decon_get_dsim(decon)->dev);
+
+	hiber->fast_entered = true;
+	hiber->fast_restore_pending = true;
+
+	DPU_ATRACE_END(__func__);
+out:
+	mutex_unlock(&hiber->fast_lock);
+
+	return ret;
+}
+
+static void exynos_hibernation_fast_exit_locked(struct exynos_hibernation *hiber)
+{
+	struct decon_device *decon = hiber->decon;
+	ktime_t start;
+
+	lockdep_assert_held(&hiber->fast_lock);
+
+	if (!hiber->fast_entered)
+		return;
+
+	DPU_ATRACE_BEGIN(__func__);
+	start = ktime_get();
+
+	decon_exit_hibernation(decon);
+	pm_runtime_get_sync(decon_get_dsim(decon)->dev);
+	exynos_hibernation_set_self_refresh(hiber->snapshot.connector, false);
+	hiber->fast_entered = false;
+
+	exynos_hibernation_record_exit(hiber, HIBERNATION_PATH_FAST, start);
+
+	DPU_ATRACE_END(__func__);
+}
+
+static bool exynos_hibernation_fast_exit(struct exynos_hibernation *hiber)
+{
+	bool fast_entered;
+
+	mutex_lock(&hiber->fast_lock);
+	fast_entered = hiber->fast_entered;
+	exynos_hibernation_fast_exit_locked(hiber);
+	mutex_unlock(&hiber->fast_lock);
+
+	return fast_entered;
+}
+
 static int exynos_hibernation_enter(struct exynos_hibernation *hiber, bool nonblock)
 {
 	struct decon_device *decon = hiber->decon;
-	int ret;
+	int ret = -EOPNOTSUPP;
 
 	pr_debug("%s +\n", __func__);
 
 	DPU_ATRACE_BEGIN(__func__);
-	ret = exynos_crtc_self_refresh_update(&decon->crtc->base, true, nonblock);
+	/* synchronous entry is used for system suspend, keep it on the atomic path */
+	if (nonblock)
+		ret = exynos_hibernation_fast_enter(hiber);
+	if (ret == -EOPNOTSUPP)
+		ret = exynos_crtc_self_refresh_update(&decon->crtc->base, true, nonblock);
 	DPU_ATRACE_END(__func__);
 
 	return ret;
@@ -183,9 +403,17 @@ static int exynos_hibernation_enter(struct exynos_hibernation *hiber, bool nonbl
 static void exynos_hibernation_exit(struct exynos_hibernation *hiber)
 {
 	struct decon_device *decon = hiber->decon;
+	ktime_t start;
 
 	DPU_ATRACE_BEGIN(__func__);
-	exynos_crtc_self_refresh_update(&decon->crtc->base, false, false);
+	if (!exynos_hibernation_fast_exit(hiber)) {
+		start = ktime_get();
+		if (!exynos_crtc_self_refresh_update(&decon->crtc->base, false, false)) {
+			mutex_lock(&hiber->fast_lock);
+			exynos_hibernation_record_exit(hiber, HIBERNATION_PATH_ATOMIC, start);
+			mutex_unlock(&hiber->fast_lock);
+		}
+	}
 	DPU_ATRACE_END(__func__);
 
 	pr_debug("%s: DPU power %s\n", __func__,
@@ -254,6 +482,62 @@ void hibernation_block_exit(struct exynos_hibernation *hiber)
 		hiber->funcs->exit(hiber);
 }
 
+void hibernation_block_fast_exit(struct exynos_hibernation *hiber,
+				 const struct drm_crtc_state *crtc_state)
+{
+	if (!hiber)
+		return;
+
+	hibernation_block(hiber);
+
+	mutex_lock(&hiber->fast_lock);
+	exynos_hibernation_fast_exit_locked(hiber);
+	/* a disabled crtc has nothing to restore, and enabling it again reprograms everything */
+	if (!crtc_state->active)
+		hiber->fast_restore_pending = false;
+	mutex_unlock(&hiber->fast_lock);
+}
+
+/*
+ * Command mode only sends out a frame on commit, so restoring the planes can wait for the
+ * next commit, which is the only context where the crtc state is stable. Doing it inside
+ * the commit's update, after any modeset, also covers planes a modeset or a changed DECON
+ * config wouldn't touch because they aren't part of the commit.
+ */
+void hibernation_fast_restore(struct exynos_hibernation *hiber,
+			      const struct drm_crtc_state *old_crtc_state)
+{
+	struct exynos_drm_crtc *exynos_crtc;
+	const struct drm_crtc_state *crtc_state;
+	struct drm_atomic_state *state = old_crtc_state->state;
+	struct drm_plane *plane;
+
+	if (!hiber)
+		return;
+
+	mutex_lock(&hiber->fast_lock);
+	if (!hiber->fast_restore_pending)
+		goto out;
+
+	hiber->fast_restore_pending = false;
+
+	exynos_crtc = hiber->decon->crtc;
+	crtc_state = exynos_crtc->base.state;
+	if (drm_atomic_crtc_needs_modeset(crtc_state) ||
+	    hiber->snapshot.config_hash != exynos_hibernation_config_hash(hiber->decon))
+		hiber->fast_reconfig_cnt++;
+
+	if (!exynos_crtc->ops->update_plane)
+		goto out;
+
+	drm_for_each_plane_mask(plane, exynos_crtc->base.dev, crtc_state->plane_mask) {
+		if (plane->state->visible && !drm_atomic_get_new_plane_state(state, plane))
+			exynos_crtc->ops->update_plane(exynos_crtc, to_exynos_plane(plane));
+	}
+out:
+	mutex_unlock(&hiber->fast_lock);
+}
+
 void hibernation_unblock_enter(struct exynos_hibernation *hiber)
 {
 	if (!hiber)
@@ -377,6 +661,7 @@ exynos_hibernation_register(struct decon_device *decon)
 	hibernation->enabled = true;
 
 	mutex_init(&hibernation->lock);
+	mutex_init(&hibernation->fast_lock);
 
 	atomic_set(&hibernation->block_cnt, 0);
 
@@ -387,6 +672,34 @@ exynos_hibernation_register(struct decon_device *decon)
 	return hibernation;
 }
 
+void exynos_hibernation_latency_print(struct exynos_hibernation *hiber, struct seq_file *s)
+{
+	static const char * const path_names[HIBERNATION_PATH_MAX] = {
+		[HIBERNATION_PATH_ATOMIC] = "atomic",
+		[HIBERNATION_PATH_FAST] = "fast",
+	};
+	int i, j;
+
+	mutex_lock(&hiber->fast_lock);
+
+	seq_printf(s, "fast path: %s, reconfig: %u\n",
+			hibernation_fast_path ? "enabled" : "disabled", hiber->fast_reconfig_cnt);
+	seq_puts(s, "path    count   avg_us  max_us  [<128us, x2 ..., >=16ms]\n");
+
+	for (i = 0; i < HIBERNATION_PATH_MAX; i++) {
+		const struct exynos_hibernation_latency *lat = &hiber->exit_latency[i];
+
+		seq_printf(s, "%-7s %-7llu %-7llu %-7llu", path_names[i], lat->count,
+				lat->count ? div64_u64(lat->total_us, lat->count) : 0,
+				lat->max_us);
+		for (j = 0; j < HIBERNATION_LATENCY_BUCKETS; j++)
+			seq_printf(s, " %llu", lat->buckets[j]);
+		seq_puts(s, "\n");
+	}
+
+	mutex_unlock(&hiber->fast_lock);
+}
+
 void exynos_hibernation_destroy(struct exynos_hibernation *hiber)
 {
 	if (!is_hibernation_enabled(hiber))
@@ -22,8 +22,11 @@
 #include <linux/io.h>
 
 struct decon_device;
+struct drm_crtc_state;
 struct dsim_device;
+struct exynos_drm_connector;
 struct exynos_hibernation;
+struct seq_file;
 struct writeback_device;
 
 struct exynos_hibernation_funcs {
@@ -33,6 +36,29 @@ struct exynos_hibernation_funcs {
 	bool (*check)(struct exynos_hibernation *hiber);
 };
 
+enum exynos_hibernation_path {
+	HIBERNATION_PATH_ATOMIC,
+	HIBERNATION_PATH_FAST,
+	HIBERNATION_PATH_MAX,
+};
+
+/* log2 buckets of exit latency, starting below 128us and ending at 16ms and above */
+#define HIBERNATION_LATENCY_BUCKETS	9
+
+struct exynos_hibernation_latency {
+	u64 count;
+	u64 total_us;
+	u64 max_us;
+	u64 buckets[HIBERNATION_LATENCY_BUCKETS];
+};
+
+/* configuration committed to hardware at the time of fast hibernation entry */
+struct exynos_hibernation_snapshot {
+	u32 config_hash;
+	/* connector told about self refresh on entry, to be told again on exit */
+	struct exynos_drm_connector *connector;
+};
+
 struct exynos_hibernation {
 	atomic_t block_cnt;
 	/* register to check whether camera is operating or not */
@@ -44,6 +70,16 @@ struct exynos_hibernation {
 	struct writeback_device *wb;
 	const struct exynos_hibernation_funcs *funcs;
 	bool enabled;
+
+	/* protects fast path state and exit latency statistics */
+	struct mutex fast_lock;
+	bool fast_entered;
+	/* planes are disabled and still need to be restored by the next commit */
+	bool fast_restore_pending;
+	struct exynos_hibernation_snapshot snapshot;
+	/* restores done by a commit that also reconfigured the crtc */
+	u32 fast_reconfig_cnt;
+	struct exynos_hibernation_latency exit_latency[HIBERNATION_PATH_MAX];
 };
 
 /**
@@ -66,6 +102,32 @@ static inline int hibernation_block(struct exynos_hibernation *hiber)
  */
 void hibernation_block_exit(struct exynos_hibernation *hiber);
 
+/**
+ * hibernation_block_fast_exit - block hibernation, and exit hibernation if it was entered
+ *	through the fast path
+ * @hiber: hibernation block ptr
+ * @crtc_state: new crtc state of the commit being applied
+ *
+ * Unlike hibernation_block_exit() this doesn't wait for pending hibernation work, and is
+ * meant for the commit path, which handles exit from regular self refresh by itself.
+ * Planes left disabled by fast hibernation are restored later by hibernation_fast_restore(),
+ * unless @crtc_state disables the crtc.
+ */
+void hibernation_block_fast_exit(struct exynos_hibernation *hiber,
+				 const struct drm_crtc_state *crtc_state);
+
+/**
+ * hibernation_fast_restore - restore planes disabled by fast hibernation
+ * @hiber: hibernation block ptr
+ * @old_crtc_state: old crtc state of the commit being applied
+ *
+ * Called by the crtc once the shadow update of the previous frame is done and before the
+ * planes of the commit are programmed. Every visible plane of the crtc that isn't part of
+ * the commit is programmed from its current state, the commit takes care of the rest.
+ */
+void hibernation_fast_restore(struct exynos_hibernation *hiber,
+			      const struct drm_crtc_state *old_crtc_state);
+
 /**
  * hibernation_unblock_enter - unblock hibernation and schedule hibernation work if no one
  *	else is blocking it
@@ -77,5 +139,6 @@ struct exynos_hibernation *
 exynos_hibernation_register(struct decon_device *decon);
 void exynos_hibernation_destroy(struct exynos_hibernation *hiber);
 int exynos_hibernation_suspend(struct exynos_hibernation *hiber);
+void exynos_hibernation_latency_print(struct exynos_hibernation *hiber, struct seq_file *s);
 
 #endif /* __EXYNOS_DRM_HIBERNATION__ */
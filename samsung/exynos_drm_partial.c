@@ -23,6 +23,10 @@
 #define pr_region(str, r)	\
 	pr_debug("%s["DRM_RECT_FMT"]\n", (str), DRM_RECT_ARG(r))
 
+/* tap counts of the DPP scaler filters, see h_coef_8t and v_coef_4t */
+#define DPP_SCL_H_TAPS		8
+#define DPP_SCL_V_TAPS		4
+
 static int exynos_partial_init(struct exynos_partial *partial,
 		const struct exynos_display_partial *partial_mode,
 		const struct drm_display_mode *mode)
@@ -57,10 +61,34 @@ void exynos_partial_set_full(const struct drm_display_mode *mode,
 	partial_r->y2 = mode->vdisplay;
 }
 
+/*
+ * With DSC, columns can only be dropped in units of slices and every encoder has to be fed
+ * the same number of slices. The only narrower layout DSC can be reconfigured for is the
+ * two inner slices of a 4 slice / 2 encoder setup, one slice per encoder. Anything else
+ * falls back to full width.
+ */
+static void exynos_partial_adjust_dsc_width(const struct exynos_dsc *dsc,
+			const struct drm_display_mode *mode, struct drm_rect *r)
+{
+	const int slice_w = dsc->slice_width;
+
+	if (dsc->slice_count == 4 && dsc->dsc_count == 2 &&
+			r->x1 >= slice_w && r->x2 <= slice_w * 3) {
+		r->x1 = slice_w;
+		r->x2 = slice_w * 3;
+		return;
+	}
+
+	r->x1 = 0;
+	r->x2 = mode->hdisplay;
+}
+
 static int exynos_partial_adjust_region(struct exynos_partial *partial,
 			const struct drm_display_mode *mode,
 			const struct drm_rect *req, struct drm_rect *r)
 {
+	const struct exynos_dsc *dsc = &partial->decon->config.dsc;
+
 	pr_region("requested update region", req);
 
 	if (!req->x1 && !req->y1 && !req->x2 && !req->y2) {
@@ -76,12 +104,11 @@ static int exynos_partial_adjust_region(struct exynos_partial *partial,
 	/* adjusted update region */
 	r->y1 = rounddown(req->y1, partial->min_h);
 	r->y2 = roundup(req->y2, partial->min_h);
-	/*
-	 * TODO: Currently, partial width is fixed by LCD width. This will be
-	 * changed to be configurable in the future.
-	 */
-	r->x1 = 0;
-	r->x2 = mode->hdisplay;
+	r->x1 = rounddown(req->x1, partial->min_w);
+	r->x2 = roundup(req->x2, partial->min_w);
+
+	if (dsc->enabled)
+		exynos_partial_adjust_dsc_width(dsc, mode, r);
 
 	pr_region("adjusted update region", r);
 
@@ -116,44 +143,124 @@ exynos_plane_state_rotation(const struct drm_plane_state *state)
 	return (simplified_rot & DRM_MODE_ROTATE_90) != 0;
 }
 
-static inline bool
-exynos_plane_state_scaling(const struct drm_plane_state *state)
+/*
+ * Maps output pixels [@c1, @c2) of a scaled plane starting at @d1 back into its source
+ * [@s1, @s2), the way the scaler walks the source from @s1 in steps of @ratio (1.20 fixed
+ * point). The fetched source [@f1, @f2) is widened by the footprint of a @taps filter and
+ * kept aligned to @align, so each output pixel is filtered from the same source pixels as
+ * in a full update. @pos gets the scaler position of @c1 relative to @f1 (12.20).
+ */
+static void exynos_partial_map_scaled(int s1, int s2, int d1, int c1, int c2,
+		u32 ratio, int taps, int align, int *f1, int *f2, u32 *pos)
+{
+	const u64 first = ((u64)s1 << 20) + (u64)(c1 - d1) * ratio;
+	const u64 last = ((u64)s1 << 20) + (u64)(c2 - 1 - d1) * ratio;
+	int x;
+
+	x = (int)(first >> 20) - (taps / 2 - 1);
+	*f1 = x > s1 ? max_t(int, rounddown(x, align), s1) : s1;
+
+	x = (int)(last >> 20) + taps / 2 + 1;
+	*f2 = min_t(int, roundup(x, align), s2);
+
+	*pos = first - ((u64)*f1 << 20);
+}
+
+/*
+ * Clips @dst to @partial_r and maps the clipped area back into the source, taking
+ * scaling, rotation and reflection into account. @src is in 16.16 fixed point. A scaled
+ * plane keeps the ratio of the whole plane, which is returned in @scl along with the
+ * initial scaler position, rather than having it recomputed from a truncated source.
+ * Returns false if nothing of the plane is left inside @partial_r.
+ */
+static bool exynos_partial_clip_plane(const struct drm_plane_state *state,
+		struct drm_rect *src, struct drm_rect *dst,
+		const struct drm_rect *partial_r, struct exynos_plane_scl *scl)
+{
+	const struct drm_framebuffer *fb = state->fb;
+	const struct dpu_fmt *fmt_info = dpu_find_fmt_info(fb->format->format);
+	const int align = IS_YUV(fmt_info) ? fmt_info->align_mul : 1;
+	struct exynos_plane_scl s = { 0 };
+	struct drm_rect r, f, d;
+	bool visible;
+
+	/* source window fetched by the DPP, see dpp_convert_plane_state_to_config() */
+	r.x1 = src->x1 >> 16;
+	r.y1 = src->y1 >> 16;
+	r.x2 = r.x1 + (drm_rect_width(src) >> 16);
+	r.y2 = r.y1 + (drm_rect_height(src) >> 16);
+	drm_rect_rotate(&r, fb->width, fb->height, state->rotation);
+
+	if (drm_rect_width(&r) == drm_rect_width(dst) &&
+			drm_rect_height(&r) == drm_rect_height(dst)) {
+		/* clip in destination orientation, then rotate the result back into the buffer */
+		drm_rect_rotate(src, fb->width << 16, fb->height << 16, state->rotation);
+		visible = drm_rect_clip_scaled(src, dst, partial_r);
+		drm_rect_rotate_inv(src, fb->width << 16, fb->height << 16, state->rotation);
+		goto out;
+	}
+
+	d = *dst;
+	visible = drm_rect_intersect(&d, partial_r);
+	if (!visible)
+		goto out;
+
+	s.h_ratio = dpp_scale_ratio(drm_rect_width(&r), drm_rect_width(dst));
+	s.v_ratio = dpp_scale_ratio(drm_rect_height(&r), drm_rect_height(dst));
+	exynos_partial_map_scaled(r.x1, r.x2, dst->x1, d.x1, d.x2, s.h_ratio,
+			DPP_SCL_H_TAPS, align, &f.x1, &f.x2, &s.h_pos);
+	exynos_partial_map_scaled(r.y1, r.y2, dst->y1, d.y1, d.y2, s.v_ratio,
+			DPP_SCL_V_TAPS, align, &f.y1, &f.y2, &s.v_pos);
+	drm_rect_rotate_inv(&f, fb->width, fb->height, state->rotation);
+
+	src->x1 = f.x1 << 16;
+	src->y1 = f.y1 << 16;
+	src->x2 = f.x2 << 16;
+	src->y2 = f.y2 << 16;
+	*dst = d;
+
+out:
+	if (scl)
+		*scl = s;
+
+	return visible;
+}
+
+/* plane coordinates clipped to @mode, as drm_atomic_helper_check_plane_state() does */
+static void exynos_partial_plane_rects(const struct drm_plane_state *state,
+		const struct drm_display_mode *mode, struct drm_rect *src,
+		struct drm_rect *dst)
 {
-	return (state->src_w >> 16 != state->crtc_w) ||
-		(state->src_h >> 16 != state->crtc_h);
+	const struct drm_framebuffer *fb = state->fb;
+	const struct drm_rect clip = { 0, 0, mode->hdisplay, mode->vdisplay };
+
+	*src = drm_plane_state_src(state);
+	*dst = drm_plane_state_dest(state);
+
+	drm_rect_rotate(src, fb->width << 16, fb->height << 16, state->rotation);
+	drm_rect_clip_scaled(src, dst, &clip);
+	drm_rect_rotate_inv(src, fb->width << 16, fb->height << 16, state->rotation);
 }
 
 static bool is_partial_supported(const struct drm_plane_state *state,
-		const struct drm_rect *crtc_r, const struct drm_rect *partial_r,
-		const struct dpp_restriction *res)
+		const struct drm_display_mode *mode, const struct drm_rect *crtc_r,
+		const struct drm_rect *partial_r, const struct dpp_restriction *res)
 {
 	const struct dpu_fmt *fmt_info;
 	unsigned int adj_src_x = 0, adj_src_y = 0;
+	struct drm_rect src, dst;
 	u32 format;
-	int sz_align = 1;
-
-	if (exynos_plane_state_rotation(state)) {
-		pr_debug("rotation is detected. partial->full\n");
-		goto not_supported;
-	}
-
-	if (exynos_plane_state_scaling(state)) {
-		pr_debug("scaling is detected. partial->full\n");
-		goto not_supported;
-	}
+	int sz_align;
 
 	format = state->fb->format->format;
 	fmt_info = dpu_find_fmt_info(format);
+	sz_align = fmt_info->align_mul;
 	if (IS_YUV(fmt_info)) {
-		adj_src_x = state->src_x >> 16;
-		adj_src_y = state->src_y >> 16;
-		sz_align = 2;
+		exynos_partial_plane_rects(state, mode, &src, &dst);
+		exynos_partial_clip_plane(state, &src, &dst, partial_r, NULL);
 
-		if (partial_r->x1 > state->crtc_x)
-			adj_src_x += partial_r->x1 - state->crtc_x;
-
-		if (partial_r->y1 > state->crtc_y)
-			adj_src_y += partial_r->y1 - state->crtc_y;
+		adj_src_x = src.x1 >> 16;
+		adj_src_y = src.y1 >> 16;
 
 		/* YUV format must be aligned to 2 */
 		if (!IS_ALIGNED(adj_src_x, sz_align) ||
@@ -204,7 +311,7 @@ static bool exynos_partial_check(struct exynos_partial *partial,
 		res = &dpp->restriction;
 		pr_debug("checking plane%d ...\n", drm_plane_index(plane));
 
-		if (!is_partial_supported(plane_state, &r, partial_r, res))
+		if (!is_partial_supported(plane_state, &crtc_state->mode, &r, partial_r, res))
 			return false;
 	}
 
@@ -281,6 +388,8 @@ static void exynos_partial_set_size(struct exynos_partial *partial,
 	partial_h = drm_rect_height(partial_r);
 
 	memcpy(&dsim_config, &dsim->config, sizeof(struct dsim_reg_config));
+	if (dsc_en)
+		dsim_config.dsc.slice_count = partial_w / dsim->config.dsc.slice_width;
 	dsim_config.p_timing.hactive = partial_w;
 	dsim_config.p_timing.vactive = partial_h;
 	dsim_config.p_timing.hfp +=
@@ -456,8 +565,9 @@ void exynos_partial_reconfig_coords(struct exynos_partial *partial,
 			struct drm_plane_state *plane_state,
 			const struct drm_rect *partial_r)
 {
-	plane_state->visible = drm_rect_clip_scaled(&plane_state->src,
-			&plane_state->dst, partial_r);
+	plane_state->visible = exynos_partial_clip_plane(plane_state, &plane_state->src,
+			&plane_state->dst, partial_r,
+			&to_exynos_plane_state(plane_state)->partial_scl);
 	if (!plane_state->visible)
 		return;
 
@@ -508,3 +618,7 @@ void exynos_partial_restore(struct exynos_partial *partial)
 	DPU_EVENT_LOG(DPU_EVT_PARTIAL_RESTORE, decon->id, old_partial_region);
 	pr_region("restored partial region", old_partial_region);
 }
+
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_KUNIT_TEST)
+#include "exynos_drm_partial_test.c"
+#endif
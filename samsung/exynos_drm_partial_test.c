@@ -0,0 +1,457 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for partial update plane clipping and region rounding, included
+ * from exynos_drm_partial.c.
+ *
+ * Copyright (C) 2020 Samsung Electronics Co.Ltd
+ */
+
+#include <kunit/test.h>
+
+/*
+ * Software model of a DPP: the DMA fetches @fetch out of the buffer and rotates it
+ * into output orientation, the scaler then walks it from @h_pos/@v_pos in steps of
+ * the ratios (12.20) with an 8 tap H and a 4 tap V filter clamped to the fetched
+ * window. Filter weights depend on the phase, so any phase error shows up.
+ */
+struct partial_test_scl {
+	const struct drm_framebuffer *fb;
+	unsigned int rotation;
+	struct drm_rect fetch;
+	u32 h_ratio, v_ratio;
+	u32 h_pos, v_pos;
+};
+
+static u32 partial_test_pixel(int x, int y)
+{
+	return ((x * 2654435761u) ^ (y * 40503u)) & 0xffff;
+}
+
+static u64 partial_test_weight(int tap, u32 pos)
+{
+	return (tap + 5) * (((pos & 0xfffff) >> 10) + 1);
+}
+
+static void partial_test_scale(const struct partial_test_scl *scl, int out_w,
+		int out_h, u64 *out)
+{
+	const struct drm_framebuffer *fb = scl->fb;
+	struct drm_rect r = scl->fetch, pt;
+	int i, j, tx, ty, w, h;
+
+	drm_rect_rotate(&r, fb->width, fb->height, scl->rotation);
+	w = drm_rect_width(&r);
+	h = drm_rect_height(&r);
+
+	/* at 1:1 without phase the scaler passes pixels through */
+	if (scl->h_ratio == (1 << 20) && scl->v_ratio == (1 << 20) &&
+			!scl->h_pos && !scl->v_pos) {
+		for (j = 0; j < out_h; j++) {
+			for (i = 0; i < out_w; i++) {
+				pt.x1 = r.x1 + i;
+				pt.y1 = r.y1 + j;
+				pt.x2 = pt.x1 + 1;
+				pt.y2 = pt.y1 + 1;
+				drm_rect_rotate_inv(&pt, fb->width, fb->height,
+						scl->rotation);
+				out[j * out_w + i] = partial_test_pixel(pt.x1, pt.y1);
+			}
+		}
+		return;
+	}
+
+	for (j = 0; j < out_h; j++) {
+		const u64 py = scl->v_pos + (u64)j * scl->v_ratio;
+
+		for (i = 0; i < out_w; i++) {
+			const u64 px = scl->h_pos + (u64)i * scl->h_ratio;
+			u64 acc = 0;
+
+			for (ty = -(DPP_SCL_V_TAPS / 2 - 1); ty <= DPP_SCL_V_TAPS / 2; ty++) {
+				const int y = clamp_t(int, (int)(py >> 20) + ty, 0, h - 1);
+
+				for (tx = -(DPP_SCL_H_TAPS / 2 - 1); tx <= DPP_SCL_H_TAPS / 2;
+						tx++) {
+					const int x = clamp_t(int, (int)(px >> 20) + tx, 0, w - 1);
+
+					pt.x1 = r.x1 + x;
+					pt.y1 = r.y1 + y;
+					pt.x2 = pt.x1 + 1;
+					pt.y2 = pt.y1 + 1;
+					drm_rect_rotate_inv(&pt, fb->width, fb->height,
+							scl->rotation);
+
+					acc += partial_test_pixel(pt.x1, pt.y1) *
+						partial_test_weight(tx, px) *
+						partial_test_weight(ty, py);
+				}
+			}
+
+			out[j * out_w + i] = acc;
+		}
+	}
+}
+
+/* source size in output orientation and destination size of a plane */
+struct partial_test_ratio {
+	const char *name;
+	int src_w, src_h;
+	int dst_w, dst_h;
+};
+
+static const struct partial_test_ratio partial_test_ratios[] = {
+	{ "1:1",		40, 30, 40, 30 },
+	{ "2x down",		64, 48, 32, 24 },
+	{ "1.5x up",		40, 30, 60, 45 },
+	{ "4x up",		16, 12, 64, 48 },
+	{ "uneven down",	63, 47, 41, 29 },
+	{ "h up, v down",	48, 48, 96, 24 },
+};
+
+/* update regions as x1, y1, x2, y2 */
+static const struct drm_rect partial_test_regions[] = {
+	{ 20, 15, 37, 28 },
+	{ 13, 9, 14, 10 },
+	{ 31, 0, 32, 200 },
+	{ 0, 30, 200, 33 },
+	{ 40, 30, 200, 200 },
+	{ 0, 0, 200, 200 },
+};
+
+#define PARTIAL_TEST_FB_SIZE	128
+
+struct partial_test_plane {
+	struct drm_framebuffer fb;
+	struct drm_plane_state state;
+	struct drm_rect src;	/* integer, buffer coordinates */
+	u64 *full;
+};
+
+/* places the plane at an odd offset within the buffer and on the crtc */
+static void partial_test_plane_init(struct kunit *test, struct partial_test_plane *p,
+		u32 format, unsigned int rotation, const struct partial_test_ratio *ratio,
+		int src_x, int src_y)
+{
+	const bool rotated = drm_rotation_90_or_270(rotation);
+	struct partial_test_scl scl = { 0 };
+
+	memset(p, 0, sizeof(*p));
+	p->fb.width = PARTIAL_TEST_FB_SIZE;
+	p->fb.height = PARTIAL_TEST_FB_SIZE;
+	p->fb.format = drm_format_info(format);
+
+	drm_rect_init(&p->src, src_x, src_y,
+			rotated ? ratio->src_h : ratio->src_w,
+			rotated ? ratio->src_w : ratio->src_h);
+
+	p->state.fb = &p->fb;
+	p->state.rotation = rotation;
+	drm_rect_init(&p->state.src, p->src.x1 << 16, p->src.y1 << 16,
+			drm_rect_width(&p->src) << 16, drm_rect_height(&p->src) << 16);
+	drm_rect_init(&p->state.dst, 13, 9, ratio->dst_w, ratio->dst_h);
+
+	p->full = kunit_kcalloc(test, ratio->dst_w * ratio->dst_h, sizeof(u64),
+			GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, p->full);
+
+	scl.fb = &p->fb;
+	scl.rotation = rotation;
+	scl.fetch = p->src;
+	scl.h_ratio = dpp_scale_ratio(ratio->src_w, ratio->dst_w);
+	scl.v_ratio = dpp_scale_ratio(ratio->src_h, ratio->dst_h);
+	partial_test_scale(&scl, ratio->dst_w, ratio->dst_h, p->full);
+}
+
+/*
+ * Clips the plane to @region and checks that the partial frame is pixel exact with
+ * the same area of the full frame, and that the fetch stays on the @align grid.
+ */
+static void partial_test_check_region(struct kunit *test, struct partial_test_plane *p,
+		const struct partial_test_ratio *ratio, const struct drm_rect *region,
+		int align)
+{
+	const struct drm_rect *plane_dst = &p->state.dst;
+	struct exynos_plane_scl s;
+	struct partial_test_scl scl = { 0 };
+	struct drm_rect src = p->state.src, dst = p->state.dst, expected = *plane_dst;
+	int i, j, out_w, out_h;
+	u64 *out;
+
+	KUNIT_EXPECT_EQ_MSG(test, exynos_partial_clip_plane(&p->state, &src, &dst, region,
+				&s), drm_rect_intersect(&expected, region),
+			"%s region " DRM_RECT_FMT, ratio->name, DRM_RECT_ARG(region));
+	if (!drm_rect_visible(&expected))
+		return;
+
+	KUNIT_EXPECT_TRUE_MSG(test, drm_rect_equals(&dst, &expected),
+			"%s dst " DRM_RECT_FMT, ratio->name, DRM_RECT_ARG(&dst));
+
+	/* the DPP only takes whole source pixels */
+	KUNIT_EXPECT_EQ(test, (src.x1 | src.y1 | src.x2 | src.y2) & 0xffff, 0);
+	scl.fb = &p->fb;
+	scl.rotation = p->state.rotation;
+	drm_rect_init(&scl.fetch, src.x1 >> 16, src.y1 >> 16, drm_rect_width(&src) >> 16,
+			drm_rect_height(&src) >> 16);
+
+	KUNIT_EXPECT_GE(test, scl.fetch.x1, p->src.x1);
+	KUNIT_EXPECT_GE(test, scl.fetch.y1, p->src.y1);
+	KUNIT_EXPECT_LE(test, scl.fetch.x2, p->src.x2);
+	KUNIT_EXPECT_LE(test, scl.fetch.y2, p->src.y2);
+	KUNIT_EXPECT_TRUE(test, IS_ALIGNED(scl.fetch.x1, align));
+	KUNIT_EXPECT_TRUE(test, IS_ALIGNED(scl.fetch.y1, align));
+
+	out_w = drm_rect_width(&dst);
+	out_h = drm_rect_height(&dst);
+
+	if (s.h_ratio) {
+		scl.h_ratio = s.h_ratio;
+		scl.v_ratio = s.v_ratio;
+		scl.h_pos = s.h_pos;
+		scl.v_pos = s.v_pos;
+	} else {
+		/* unscaled planes keep the ratio dpp_convert_plane_state_to_config() gives */
+		KUNIT_EXPECT_EQ(test, ratio->src_w, ratio->dst_w);
+		KUNIT_EXPECT_EQ(test, ratio->src_h, ratio->dst_h);
+		scl.h_ratio = 1 << 20;
+		scl.v_ratio = 1 << 20;
+	}
+
+	out = kunit_kcalloc(test, out_w * out_h, sizeof(u64), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, out);
+	partial_test_scale(&scl, out_w, out_h, out);
+
+	for (j = 0; j < out_h; j++) {
+		for (i = 0; i < out_w; i++) {
+			const int x = dst.x1 - plane_dst->x1 + i;
+			const int y = dst.y1 - plane_dst->y1 + j;
+
+			if (out[j * out_w + i] == p->full[y * ratio->dst_w + x])
+				continue;
+
+			KUNIT_FAIL(test, "%s region " DRM_RECT_FMT ": pixel %d,%d differs",
+					ratio->name, DRM_RECT_ARG(region), x, y);
+			return;
+		}
+	}
+}
+
+static const unsigned int partial_test_rotations[] = {
+	DRM_MODE_ROTATE_0,
+	DRM_MODE_ROTATE_90,
+	DRM_MODE_ROTATE_180,
+	DRM_MODE_ROTATE_270,
+	DRM_MODE_ROTATE_0 | DRM_MODE_REFLECT_X,
+	DRM_MODE_ROTATE_0 | DRM_MODE_REFLECT_Y,
+	DRM_MODE_ROTATE_90 | DRM_MODE_REFLECT_X,
+	DRM_MODE_ROTATE_270 | DRM_MODE_REFLECT_Y,
+};
+
+static void partial_test_rotation_desc(const unsigned int *rotation, char *desc)
+{
+	snprintf(desc, KUNIT_PARAM_DESC_SIZE, "rotate %d%s%s",
+			90 * (ffs(*rotation & DRM_MODE_ROTATE_MASK) - 1),
+			(*rotation & DRM_MODE_REFLECT_X) ? " reflect x" : "",
+			(*rotation & DRM_MODE_REFLECT_Y) ? " reflect y" : "");
+}
+
+KUNIT_ARRAY_PARAM(partial_test_rotation, partial_test_rotations,
+		partial_test_rotation_desc);
+
+static int partial_test_init(struct kunit *test)
+{
+	/* the format table is built at driver init */
+	if (!dpu_find_fmt_info(DRM_FORMAT_ARGB8888))
+		kunit_skip(test, "format table not initialized");
+
+	return 0;
+}
+
+/* every ratio and region under the rotation given by the parameter */
+static void partial_test_clip_scaled(struct kunit *test)
+{
+	const unsigned int *rotation = test->param_value;
+	struct partial_test_plane *p;
+	int i, j;
+
+	p = kunit_kzalloc(test, sizeof(*p), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, p);
+
+	for (i = 0; i < ARRAY_SIZE(partial_test_ratios); i++) {
+		partial_test_plane_init(test, p, DRM_FORMAT_ARGB8888, *rotation,
+				&partial_test_ratios[i], 5, 7);
+
+		for (j = 0; j < ARRAY_SIZE(partial_test_regions); j++)
+			partial_test_check_region(test, p, &partial_test_ratios[i],
+					&partial_test_regions[j], 1);
+	}
+}
+
+/* YUV fetches must stay on the chroma grid while staying pixel exact */
+static void partial_test_clip_scaled_yuv(struct kunit *test)
+{
+	const unsigned int *rotation = test->param_value;
+	struct partial_test_plane *p;
+	int i, j;
+
+	if (!dpu_find_fmt_info(DRM_FORMAT_NV12))
+		kunit_skip(test, "NV12 not supported");
+
+	p = kunit_kzalloc(test, sizeof(*p), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, p);
+
+	for (i = 0; i < ARRAY_SIZE(partial_test_ratios); i++) {
+		const struct partial_test_ratio *ratio = &partial_test_ratios[i];
+
+		/* the full plane has to be on the chroma grid to begin with */
+		if ((ratio->src_w | ratio->src_h) & 1)
+			continue;
+
+		/* unscaled planes are clipped as is, is_partial_supported() rejects odd ones */
+		if (ratio->src_w == ratio->dst_w && ratio->src_h == ratio->dst_h)
+			continue;
+
+		partial_test_plane_init(test, p, DRM_FORMAT_NV12, *rotation, ratio, 4, 6);
+
+		for (j = 0; j < ARRAY_SIZE(partial_test_regions); j++)
+			partial_test_check_region(test, p, ratio,
+					&partial_test_regions[j], 2);
+	}
+}
+
+/*
+ * DSC geometry of the emulator panel (panel-samsung-emul.c): 1440x2960 with 40 line
+ * slices, fed by two encoders. The partial minimum size is derived from it the way
+ * exynos_panel_set_partial() does, one slice wide and one slice high.
+ */
+#define PARTIAL_TEST_EMUL_W		1440
+#define PARTIAL_TEST_EMUL_H		2960
+#define PARTIAL_TEST_EMUL_SLICE_H	40
+
+#define PARTIAL_TEST_RECT(l, t, r, b)	{ .x1 = (l), .y1 = (t), .x2 = (r), .y2 = (b) }
+
+struct partial_test_dsc_case {
+	u32 slice_count;
+	u32 dsc_count;
+	struct drm_rect req;
+	struct drm_rect expected;
+};
+
+static const struct partial_test_dsc_case partial_test_dsc_cases[] = {
+	/* a single slice can't be narrowed, only the height is rounded to slices */
+	{ 1, 1, PARTIAL_TEST_RECT(100, 45, 300, 90), PARTIAL_TEST_RECT(0, 40, 1440, 120) },
+	{ 1, 1, PARTIAL_TEST_RECT(0, 2950, 1440, 2960), PARTIAL_TEST_RECT(0, 2920, 1440, 2960) },
+	/* one slice per encoder, dropping either would starve one encoder */
+	{ 2, 2, PARTIAL_TEST_RECT(800, 0, 1000, 40), PARTIAL_TEST_RECT(0, 0, 1440, 40) },
+	{ 2, 2, PARTIAL_TEST_RECT(0, 100, 700, 101), PARTIAL_TEST_RECT(0, 80, 1440, 120) },
+	/* inner two of four slices, one per encoder */
+	{ 4, 2, PARTIAL_TEST_RECT(400, 1000, 1000, 1020), PARTIAL_TEST_RECT(360, 1000, 1080, 1040) },
+	{ 4, 2, PARTIAL_TEST_RECT(360, 0, 1080, 2960), PARTIAL_TEST_RECT(360, 0, 1080, 2960) },
+	/* reaching into an outer slice */
+	{ 4, 2, PARTIAL_TEST_RECT(359, 1000, 459, 1020), PARTIAL_TEST_RECT(0, 1000, 1440, 1040) },
+	{ 4, 2, PARTIAL_TEST_RECT(400, 1000, 1081, 1020), PARTIAL_TEST_RECT(0, 1000, 1440, 1040) },
+	{ 4, 2, PARTIAL_TEST_RECT(0, 0, 100, 20), PARTIAL_TEST_RECT(0, 0, 1440, 40) },
+	/* the inner slices would both land on the same encoder */
+	{ 4, 1, PARTIAL_TEST_RECT(400, 1000, 1000, 1020), PARTIAL_TEST_RECT(0, 1000, 1440, 1040) },
+};
+
+static void partial_test_dsc_width(struct kunit *test)
+{
+	const struct drm_display_mode mode = {
+		.hdisplay = PARTIAL_TEST_EMUL_W,
+		.vdisplay = PARTIAL_TEST_EMUL_H,
+	};
+	struct exynos_display_partial partial_mode = { .enabled = true };
+	struct exynos_partial partial = { 0 };
+	struct decon_device *decon;
+	struct exynos_dsc *dsc;
+	int i;
+
+	decon = kunit_kzalloc(test, sizeof(*decon), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, decon);
+	partial.decon = decon;
+	dsc = &decon->config.dsc;
+
+	for (i = 0; i < ARRAY_SIZE(partial_test_dsc_cases); i++) {
+		const struct partial_test_dsc_case *c = &partial_test_dsc_cases[i];
+		struct drm_rect r;
+		u32 slices;
+
+		dsc->enabled = true;
+		dsc->slice_count = c->slice_count;
+		dsc->dsc_count = c->dsc_count;
+		dsc->slice_width = DIV_ROUND_UP(mode.hdisplay, dsc->slice_count);
+		dsc->slice_height = PARTIAL_TEST_EMUL_SLICE_H;
+
+		partial_mode.min_width = DIV_ROUND_UP(mode.hdisplay, dsc->slice_count);
+		partial_mode.min_height = dsc->slice_height;
+		KUNIT_ASSERT_EQ(test, exynos_partial_init(&partial, &partial_mode, &mode), 0);
+
+		KUNIT_ASSERT_EQ_MSG(test, exynos_partial_adjust_region(&partial, &mode, &c->req,
+				&r), 0, "case %d", i);
+		KUNIT_EXPECT_TRUE_MSG(test, drm_rect_equals(&r, &c->expected),
+				"case %d: got "DRM_RECT_FMT" expected "DRM_RECT_FMT, i,
+				DRM_RECT_ARG(&r), DRM_RECT_ARG(&c->expected));
+
+		/* whatever the region, it is made of whole slices split evenly over encoders */
+		slices = drm_rect_width(&r) / dsc->slice_width;
+		KUNIT_EXPECT_EQ_MSG(test, r.x1 % dsc->slice_width, 0, "case %d", i);
+		KUNIT_EXPECT_EQ_MSG(test, drm_rect_width(&r) % dsc->slice_width, 0, "case %d", i);
+		KUNIT_EXPECT_EQ_MSG(test, slices % dsc->dsc_count, 0, "case %d", i);
+		KUNIT_EXPECT_EQ_MSG(test, r.y1 % dsc->slice_height, 0, "case %d", i);
+		KUNIT_EXPECT_EQ_MSG(test, drm_rect_height(&r) % dsc->slice_height, 0, "case %d", i);
+	}
+}
+
+/* regions outside the panel are rejected and updated in full by the caller */
+static void partial_test_dsc_outside(struct kunit *test)
+{
+	const struct drm_display_mode mode = {
+		.hdisplay = PARTIAL_TEST_EMUL_W,
+		.vdisplay = PARTIAL_TEST_EMUL_H,
+	};
+	const struct drm_rect wide = PARTIAL_TEST_RECT(0, 0, PARTIAL_TEST_EMUL_W + 1, 40);
+	const struct drm_rect tall = PARTIAL_TEST_RECT(0, 40, 360, PARTIAL_TEST_EMUL_H + 1);
+	const struct drm_rect empty = { 0 };
+	struct exynos_partial partial = { 0 };
+	struct decon_device *decon;
+	struct drm_rect r;
+
+	decon = kunit_kzalloc(test, sizeof(*decon), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, decon);
+	decon->config.dsc.enabled = true;
+	decon->config.dsc.slice_count = 4;
+	decon->config.dsc.dsc_count = 2;
+	decon->config.dsc.slice_width = PARTIAL_TEST_EMUL_W / 4;
+	partial.decon = decon;
+	partial.min_w = PARTIAL_TEST_EMUL_W / 4;
+	partial.min_h = PARTIAL_TEST_EMUL_SLICE_H;
+
+	KUNIT_EXPECT_EQ(test, exynos_partial_adjust_region(&partial, &mode, &wide, &r), -EINVAL);
+	KUNIT_EXPECT_EQ(test, exynos_partial_adjust_region(&partial, &mode, &tall, &r), -EINVAL);
+	KUNIT_EXPECT_EQ(test, exynos_partial_adjust_region(&partial, &mode, &empty, &r), -EINVAL);
+}
+
+static struct kunit_case partial_test_cases[] = {
+	KUNIT_CASE_PARAM(partial_test_clip_scaled, partial_test_rotation_gen_params),
+	KUNIT_CASE_PARAM(partial_test_clip_scaled_yuv, partial_test_rotation_gen_params),
+	{}
+};
+
+static struct kunit_suite partial_test_suite = {
+	.name = "exynos-drm-partial",
+	.init = partial_test_init,
+	.test_cases = partial_test_cases,
+};
+
+static struct kunit_case partial_dsc_test_cases[] = {
+	KUNIT_CASE(partial_test_dsc_width),
+	KUNIT_CASE(partial_test_dsc_outside),
+	{}
+};
+
+static struct kunit_suite partial_dsc_test_suite = {
+	.name = "exynos-drm-partial-dsc",
+	.test_cases = partial_dsc_test_cases,
+};
+
+kunit_test_suites(&partial_test_suite, &partial_dsc_test_suite);
@@ -15,6 +15,8 @@
 #include <drm/drm_plane_helper.h>
 #include <drm/exynos_drm.h>
 
+#include <hdr_cal.h>
+
 #include "exynos_drm_crtc.h"
 #include "exynos_drm_dpp.h"
 #include "exynos_drm_drv.h"
@@ -35,6 +37,7 @@ exynos_drm_plane_duplicate_state(struct drm_plane *plane)
 		return NULL;
 
 	memcpy(copy, exynos_state, sizeof(*exynos_state));
+	memset(&copy->partial_scl, 0, sizeof(copy->partial_scl));
 
 	if (copy->eotf_lut)
 		drm_property_blob_get(copy->eotf_lut);
@@ -130,6 +133,8 @@ static int exynos_drm_plane_set_property(struct drm_plane *plane,
 		exynos_state->range = val;
 	} else if (property == exynos_plane->props.colormap) {
 		exynos_state->colormap = val;
+	} else if (property == exynos_plane->props.hdr_preset) {
+		exynos_state->hdr_preset = val;
 	} else if (property == exynos_plane->props.eotf_lut) {
 		ret = exynos_drm_replace_property_blob_from_id(
 				state->plane->dev, &exynos_state->eotf_lut,
@@ -176,6 +181,8 @@ static int exynos_drm_plane_get_property(struct drm_plane *plane,
 		*val = exynos_state->range;
 	else if (property == exynos_plane->props.colormap)
 		*val = exynos_state->colormap;
+	else if (property == exynos_plane->props.hdr_preset)
+		*val = exynos_state->hdr_preset;
 	else if (property == exynos_plane->props.eotf_lut)
 		*val = (exynos_state->eotf_lut) ?
 			exynos_state->eotf_lut->base.id : 0;
@@ -262,34 +269,41 @@ exynos_drm_plane_check_format(struct exynos_drm_plane_state *state)
 	return 0;
 }
 
+/*
+ * A LUT blob set on the plane takes precedence over the same stage of the
+ * selected hdr_preset.
+ */
 static void
 exynos_plane_update_hdr_params(struct exynos_drm_plane_state *exynos_state)
 {
 	struct exynos_hdr_state *hdr_state = &exynos_state->hdr_state;
+	const struct hdr_preset_luts *preset;
 	struct hdr_eotf_lut *eotf_lut;
 	struct hdr_oetf_lut *oetf_lut;
 	struct hdr_gm_data *gm;
 	struct hdr_tm_data *tm;
 
+	preset = hdr_reg_get_preset(exynos_state->hdr_preset);
+
 	if (exynos_state->eotf_lut) {
 		eotf_lut = (struct hdr_eotf_lut *)exynos_state->eotf_lut->data;
 		hdr_state->eotf_lut = eotf_lut;
 	} else {
-		hdr_state->eotf_lut = NULL;
+		hdr_state->eotf_lut = preset ? preset->eotf_lut : NULL;
 	}
 
 	if (exynos_state->oetf_lut) {
 		oetf_lut = (struct hdr_oetf_lut *)exynos_state->oetf_lut->data;
 		hdr_state->oetf_lut = oetf_lut;
 	} else {
-		hdr_state->oetf_lut = NULL;
+		hdr_state->oetf_lut = preset ? preset->oetf_lut : NULL;
 	}
 
 	if (exynos_state->gm) {
 		gm = (struct hdr_gm_data *)exynos_state->gm->data;
 		hdr_state->gm = gm;
 	} else {
-		hdr_state->gm = NULL;
+		hdr_state->gm = preset ? preset->gm : NULL;
 	}
 
 	if (exynos_state->tm) {
@@ -665,6 +679,35 @@ exynos_drm_plane_create_tm_property(struct exynos_drm_plane *exynos_plane)
 	return 0;
 }
 
+static int
+exynos_drm_plane_create_hdr_preset_property(struct exynos_drm_plane *exynos_plane)
+{
+	struct drm_plane *plane = &exynos_plane->base;
+	struct drm_property *prop;
+	static const struct drm_prop_enum_list hdr_preset_list[] = {
+		{ HDR_PRESET_NONE, "None" },
+		{ HDR_PRESET_PQ1000_P3, "PQ 1000nit to P3" },
+		{ HDR_PRESET_PQ4000_P3, "PQ 4000nit to P3" },
+		{ HDR_PRESET_HLG_P3, "HLG to P3" },
+		{ HDR_PRESET_SRGB_P3, "sRGB to P3" },
+	};
+	int ret;
+
+	ret = hdr_reg_init_presets();
+	if (ret)
+		return ret;
+
+	prop = drm_property_create_enum(plane->dev, 0, "hdr_preset",
+			hdr_preset_list, ARRAY_SIZE(hdr_preset_list));
+	if (!prop)
+		return -ENOMEM;
+
+	drm_object_attach_property(&plane->base, prop, HDR_PRESET_NONE);
+	exynos_plane->props.hdr_preset = prop;
+
+	return 0;
+}
+
 int exynos_plane_init(struct drm_device *dev,
 		      struct exynos_drm_plane *exynos_plane, unsigned int index,
 		      const struct exynos_drm_plane_config *config)
@@ -717,6 +760,7 @@ int exynos_plane_init(struct drm_device *dev,
 		exynos_drm_plane_create_eotf_lut_property(exynos_plane);
 		exynos_drm_plane_create_oetf_lut_property(exynos_plane);
 		exynos_drm_plane_create_gm_property(exynos_plane);
+		exynos_drm_plane_create_hdr_preset_property(exynos_plane);
 	}
 
 	if (test_bit(DPP_ATTR_HDR10_PLUS, &dpp->attr))
@@ -19,50 +19,160 @@
 #include <linux/device.h>
 #include <linux/kthread.h>
 #include <linux/export.h>
+#include <linux/math64.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <uapi/linux/sched/types.h>
 #include <drm/drm_drv.h>
 #include <drm/drm_device.h>
 #include <drm/drm_atomic.h>
 #include <drm/drm_atomic_helper.h>
 #include <drm/drm_atomic_uapi.h>
 #include <drm/drm_modeset_lock.h>
+#include <trace/dpu_trace.h>
+
 #include "exynos_drm_decon.h"
 #include "exynos_drm_recovery.h"
 
-static void exynos_recovery_handler(struct work_struct *work)
+/* frames the pipeline gets to take the shadow update of the minimal stage */
+#define RECOVERY_MINIMAL_FRAMES		2
+#define RECOVERY_HW_DONE_TIMEOUT_MS	100
+
+static void exynos_recovery_record(struct exynos_recovery *recovery,
+				   enum exynos_recovery_stage stage, int ret)
+{
+	struct exynos_recovery_latency *lat = &recovery->latency[stage];
+	const u64 us = ktime_us_delta(ktime_get(), recovery->trigger_time);
+	const int bucket = min_t(int, fls64(us >> 10), RECOVERY_LATENCY_BUCKETS - 1);
+
+	mutex_lock(&recovery->lock);
+	lat->count++;
+	if (ret)
+		lat->failed++;
+	lat->total_us += us;
+	lat->max_us = max(lat->max_us, us);
+	lat->buckets[bucket]++;
+	mutex_unlock(&recovery->lock);
+
+	pr_info("stage %d %s in %lluus\n", stage, ret ? "failed" : "done", us);
+}
+
+static int exynos_recovery_detach_planes(struct drm_atomic_state *state,
+					 struct drm_crtc *crtc)
 {
-	struct exynos_recovery *recovery = container_of(work,
-					struct exynos_recovery, work);
-	struct decon_device *decon = container_of(recovery, struct decon_device,
-					recovery);
-	struct drm_device *dev = decon->drm_dev;
-	struct drm_modeset_acquire_ctx ctx;
-	struct drm_atomic_state *state, *rcv_state;
-	struct drm_crtc_state *crtc_state;
-	struct drm_crtc *crtc = &decon->crtc->base;
-	struct drm_connector *conn;
-	struct drm_connector_state *conn_state;
 	struct drm_plane *plane;
 	struct drm_plane_state *plane_state;
 	int ret, i;
 
-	pr_info("starting recovery...\n");
+	ret = drm_atomic_add_affected_planes(state, crtc);
+	if (ret)
+		return ret;
 
-	drm_modeset_acquire_init(&ctx, 0);
+	for_each_new_plane_in_state(state, plane, plane_state, i) {
+		ret = drm_atomic_set_crtc_for_plane(plane_state, NULL);
+		if (ret)
+			return ret;
 
-	rcv_state = drm_atomic_helper_duplicate_state(dev, &ctx);
-	if (IS_ERR(rcv_state)) {
-		ret = PTR_ERR(rcv_state);
-		goto out_drop_locks;
+		drm_atomic_set_fb_for_plane(plane_state, NULL);
 	}
 
+	return 0;
+}
+
+static int exynos_recovery_wait_hw_done(struct drm_crtc *crtc)
+{
+	struct drm_crtc_commit *commit;
+	long ret;
+
+	spin_lock(&crtc->commit_lock);
+	commit = list_first_entry_or_null(&crtc->commit_list,
+					  struct drm_crtc_commit, commit_entry);
+	if (commit)
+		drm_crtc_commit_get(commit);
+	spin_unlock(&crtc->commit_lock);
+
+	if (!commit)
+		return 0;
+
+	ret = wait_for_completion_timeout(&commit->hw_done,
+					  msecs_to_jiffies(RECOVERY_HW_DONE_TIMEOUT_MS));
+	drm_crtc_commit_put(commit);
+
+	return ret ? 0 : -ETIMEDOUT;
+}
+
+/*
+ * Disables all windows at register level and checks that the shadow update is taken
+ * within a couple of frames, then restores the previous state with a regular commit.
+ * Nothing is reset, so this only helps if the pipeline comes back once the windows are
+ * out of the way. A pipeline that doesn't take the update fails fast instead of waiting
+ * out framestart timeouts in commits.
+ */
+static int exynos_recovery_minimal(struct decon_device *decon,
+				   struct drm_modeset_acquire_ctx *ctx)
+{
+	struct exynos_recovery *recovery = &decon->recovery;
+	struct drm_device *dev = decon->drm_dev;
+	struct drm_crtc *crtc = &decon->crtc->base;
+	struct drm_atomic_state *rcv_state;
+	int fs_timeouts = atomic_read(&recovery->fs_timeouts);
+	u32 timeout_us;
+	int ret;
+
+	/* locks everything, no new commit can touch the decon from here on */
+	rcv_state = drm_atomic_helper_duplicate_state(dev, ctx);
+	if (IS_ERR(rcv_state))
+		return PTR_ERR(rcv_state);
+
+	if (!crtc->state->active) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	ret = exynos_recovery_wait_hw_done(crtc);
+	if (ret)
+		goto out;
+
+	timeout_us = RECOVERY_MINIMAL_FRAMES * USEC_PER_SEC /
+		     (drm_mode_vrefresh(&crtc->state->mode) ? : 60);
+	ret = decon_recovery_disable_windows(decon, timeout_us);
+	if (ret)
+		goto out;
+
+	/* every plane is in the duplicated state, so all windows are programmed again */
+	ret = drm_atomic_helper_commit_duplicated_state(rcv_state, ctx);
+	if (ret)
+		goto out;
+
+	if (atomic_read(&recovery->fs_timeouts) != fs_timeouts)
+		ret = -ETIMEDOUT;
+out:
+	drm_atomic_state_put(rcv_state);
+
+	return ret;
+}
+
+static int exynos_recovery_full(struct decon_device *decon,
+				struct drm_modeset_acquire_ctx *ctx)
+{
+	struct drm_device *dev = decon->drm_dev;
+	struct drm_crtc *crtc = &decon->crtc->base;
+	struct drm_atomic_state *state, *rcv_state;
+	struct drm_crtc_state *crtc_state;
+	struct drm_connector *conn;
+	struct drm_connector_state *conn_state;
+	int ret, i;
+
+	rcv_state = drm_atomic_helper_duplicate_state(dev, ctx);
+	if (IS_ERR(rcv_state))
+		return PTR_ERR(rcv_state);
+
 	state = drm_atomic_state_alloc(dev);
 	if (!state) {
 		ret = -ENOMEM;
-		goto out_drop_locks;
+		goto out;
 	}
-
-retry:
-	state->acquire_ctx = &ctx;
+	state->acquire_ctx = ctx;
 
 	crtc_state = drm_atomic_get_crtc_state(state, crtc);
 	if (IS_ERR(crtc_state)) {
@@ -76,10 +186,6 @@ retry:
 	if (ret)
 		goto out;
 
-	ret = drm_atomic_add_affected_planes(state, crtc);
-	if (ret)
-		goto out;
-
 	ret = drm_atomic_add_affected_connectors(state, crtc);
 	if (ret)
 		goto out;
@@ -90,52 +196,146 @@ retry:
 			goto out;
 	}
 
-	for_each_new_plane_in_state(state, plane, plane_state, i) {
-		ret = drm_atomic_set_crtc_for_plane(plane_state, NULL);
-		if (ret)
-			goto out;
-
-		drm_atomic_set_fb_for_plane(plane_state, NULL);
-	}
+	ret = exynos_recovery_detach_planes(state, crtc);
+	if (ret)
+		goto out;
 
 	ret = drm_atomic_commit(state);
 	if (ret)
 		goto out;
 
 	drm_mode_config_reset(dev);
-	ret = drm_atomic_helper_commit_duplicated_state(rcv_state, &ctx);
-	if (ret)
-		goto out;
+	ret = drm_atomic_helper_commit_duplicated_state(rcv_state, ctx);
+out:
+	if (state)
+		drm_atomic_state_put(state);
+	drm_atomic_state_put(rcv_state);
 
-	recovery->count++;
-	pr_info("recovery is successfully finished(%d)\n", recovery->count);
+	return ret;
+}
+
+static int exynos_recovery_run_stage(struct decon_device *decon,
+				     enum exynos_recovery_stage stage)
+{
+	struct drm_modeset_acquire_ctx ctx;
+	int ret;
+
+	DPU_ATRACE_BEGIN(stage == RECOVERY_STAGE_MINIMAL ?
+			 "recovery_minimal" : "recovery_full");
+
+	drm_modeset_acquire_init(&ctx, 0);
+retry:
+	if (stage == RECOVERY_STAGE_MINIMAL)
+		ret = exynos_recovery_minimal(decon, &ctx);
+	else
+		ret = exynos_recovery_full(decon, &ctx);
 
-out:
 	if (ret == -EDEADLK) {
-		drm_atomic_state_clear(state);
-		drm_atomic_state_clear(rcv_state);
 		ret = drm_modeset_backoff(&ctx);
 		if (!ret)
 			goto retry;
 	}
 
-	drm_atomic_state_put(state);
-	drm_atomic_state_put(rcv_state);
-
-out_drop_locks:
-	atomic_set(&recovery->recovering, 0);
 	drm_modeset_drop_locks(&ctx);
 	drm_modeset_acquire_fini(&ctx);
+
+	exynos_recovery_record(&decon->recovery, stage, ret);
+
+	DPU_ATRACE_END(stage == RECOVERY_STAGE_MINIMAL ?
+		       "recovery_minimal" : "recovery_full");
+
+	return ret;
+}
+
+static void exynos_recovery_handler(struct kthread_work *work)
+{
+	struct exynos_recovery *recovery = container_of(work,
+					struct exynos_recovery, work);
+	struct decon_device *decon = container_of(recovery, struct decon_device,
+					recovery);
+	int ret;
+
+	pr_info("starting recovery...\n");
+
+	ret = exynos_recovery_run_stage(decon, RECOVERY_STAGE_MINIMAL);
+	if (ret) {
+		pr_info("minimal recovery failed (%d), trying full recovery\n", ret);
+		ret = exynos_recovery_run_stage(decon, RECOVERY_STAGE_FULL);
+	}
+
+	if (!ret) {
+		recovery->count++;
+		pr_info("recovery is successfully finished(%d)\n", recovery->count);
+	}
+
+	atomic_set(&recovery->recovering, 0);
+}
+
+void exynos_recovery_latency_print(struct exynos_recovery *recovery, struct seq_file *s)
+{
+	static const char * const stage_names[RECOVERY_STAGE_MAX] = {
+		[RECOVERY_STAGE_MINIMAL] = "minimal",
+		[RECOVERY_STAGE_FULL] = "full",
+	};
+	int i, j;
+
+	mutex_lock(&recovery->lock);
+
+	seq_puts(s, "stage   count   failed  avg_us  max_us  [<1ms, x2 ..., >=256ms]\n");
+	for (i = 0; i < RECOVERY_STAGE_MAX; i++) {
+		const struct exynos_recovery_latency *lat = &recovery->latency[i];
+
+		seq_printf(s, "%-7s %-7llu %-7llu %-7llu %-7llu", stage_names[i],
+			   lat->count, lat->failed,
+			   lat->count ? div64_u64(lat->total_us, lat->count) : 0,
+			   lat->max_us);
+		for (j = 0; j < RECOVERY_LATENCY_BUCKETS; j++)
+			seq_printf(s, " %llu", lat->buckets[j]);
+		seq_puts(s, "\n");
+	}
+
+	mutex_unlock(&recovery->lock);
 }
 
-void exynos_recovery_register(struct decon_device *decon)
+int exynos_recovery_register(struct decon_device *decon)
 {
 	struct exynos_recovery *recovery = &decon->recovery;
+	struct sched_param param = {
+		.sched_priority = 20
+	};
 
-	INIT_WORK(&recovery->work, exynos_recovery_handler);
+	kthread_init_work(&recovery->work, exynos_recovery_handler);
+	kthread_init_worker(&recovery->worker);
+	mutex_init(&recovery->lock);
 	recovery->count = 0;
 	atomic_set(&recovery->recovering, 0);
+	atomic_set(&recovery->fs_timeouts, 0);
+
+	recovery->thread = kthread_run(kthread_worker_fn, &recovery->worker,
+				       "decon%u_recovery", decon->id);
+	if (IS_ERR(recovery->thread)) {
+		int ret = PTR_ERR(recovery->thread);
+
+		pr_err("failed to run recovery thread\n");
+		recovery->thread = NULL;
+		return ret;
+	}
+	sched_setscheduler_nocheck(recovery->thread, SCHED_FIFO, &param);
 
 	pr_info("ESD recovery is supported\n");
+
+	return 0;
 }
 EXPORT_SYMBOL(exynos_recovery_register);
+
+void exynos_recovery_unregister(struct decon_device *decon)
+{
+	struct exynos_recovery *recovery = &decon->recovery;
+
+	if (!recovery->thread)
+		return;
+
+	kthread_flush_worker(&recovery->worker);
+	kthread_stop(recovery->thread);
+	recovery->thread = NULL;
+}
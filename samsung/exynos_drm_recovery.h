@@ -16,14 +16,48 @@
 #define __EXYNOS_DRM_RECOVERY__
 
 #include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
 
+enum exynos_recovery_stage {
+	/* windows off at register level, then back on, pipeline stays active */
+	RECOVERY_STAGE_MINIMAL,
+	/* full disable and enable modeset */
+	RECOVERY_STAGE_FULL,
+	RECOVERY_STAGE_MAX,
+};
+
+/* log2 buckets of latency from trigger, starting below 1ms and ending at 256ms and above */
+#define RECOVERY_LATENCY_BUCKETS	10
+
+struct exynos_recovery_latency {
+	u64 count;
+	u64 failed;
+	u64 total_us;
+	u64 max_us;
+	u64 buckets[RECOVERY_LATENCY_BUCKETS];
+};
+
+struct seq_file;
 struct decon_device;
 struct exynos_recovery {
-	struct work_struct work;
+	/* dedicated RT worker so recovery never queues behind unrelated work */
+	struct kthread_worker worker;
+	struct task_struct *thread;
+	struct kthread_work work;
 	int count;
 	atomic_t recovering;
+	/* framestart timeouts, tells whether a stage brought the pipeline back */
+	atomic_t fs_timeouts;
+	ktime_t trigger_time;
+
+	/* protects latency */
+	struct mutex lock;
+	struct exynos_recovery_latency latency[RECOVERY_STAGE_MAX];
 };
 
-void exynos_recovery_register(struct decon_device *decon);
+int exynos_recovery_register(struct decon_device *decon);
+void exynos_recovery_unregister(struct decon_device *decon);
+void exynos_recovery_latency_print(struct exynos_recovery *recovery, struct seq_file *s);
 
 #endif /* __EXYNOS_DRM_RECOVERY__ */
@@ -621,6 +621,7 @@ static void nt37290_trigger_early_exit(struct exynos_panel *ctx)
 {
 	const ktime_t delta = ktime_sub(ktime_get(), ctx->last_commit_ts);
 	const s64 delta_us = ktime_to_us(delta);
+	enum exynos_panel_early_exit ee;
 
 	if (delta_us < EARLY_EXIT_THRESHOLD_US) {
 		dev_dbg(ctx->dev, "skip early exit. %lldus since last commit\n",
@@ -628,12 +629,19 @@ static void nt37290_trigger_early_exit(struct exynos_panel *ctx)
 		return;
 	}
 
-	/* triggering early exit causes a switch to 120hz */
-	ctx->last_mode_set_ts = ktime_get();
+	ee = exynos_panel_predict_early_exit(ctx);
+	if (ee == EARLY_EXIT_SKIP) {
+		dev_dbg(ctx->dev, "skip early exit. no frame update\n");
+		return;
+	}
+
+	/* triggering full early exit causes a switch to 120hz */
+	if (ee == EARLY_EXIT_FULL)
+		ctx->last_mode_set_ts = ktime_get();
 
 	DPU_ATRACE_BEGIN(__func__);
 
-	if (ctx->idle_delay_ms && delta_us > IDLE_DELAY_THRESHOLD_US) {
+	if (ee == EARLY_EXIT_FULL && ctx->idle_delay_ms && delta_us > IDLE_DELAY_THRESHOLD_US) {
 		const struct exynos_panel_mode *pmode = ctx->current_mode;
 
 		dev_dbg(ctx->dev, "%s: disable auto idle mode for %s\n",
@@ -987,6 +995,7 @@ static const struct exynos_panel_funcs nt37290_exynos_funcs = {
 	.update_te2 = nt37290_update_te2,
 	.set_self_refresh = nt37290_set_self_refresh,
 	.commit_done = nt37290_commit_done,
+	.rr_switch_window_pct = 55,
 };
 
 const struct brightness_capability nt37290_brightness_capability = {
@@ -254,6 +254,135 @@ static int exynos_panel_parse_regulators(struct exynos_panel *ctx)
 	return 0;
 }
 
+static bool exynos_panel_cmd_match_rev(const struct exynos_panel *ctx,
+				       const struct exynos_dsi_cmd *c)
+{
+	return !ctx->panel_rev || (c->panel_rev & ctx->panel_rev);
+}
+
+static struct exynos_dsi_cmd_set_compiled *
+exynos_panel_compile_cmd_set(const struct exynos_panel *ctx,
+			     const struct exynos_dsi_cmd_set *cmd_set)
+{
+	struct exynos_dsi_cmd_set_compiled *cc;
+	struct exynos_dsi_cmd_step *step = NULL;
+	const u32 n = cmd_set->num_cmd;
+	u32 i;
+
+	cc = kzalloc(sizeof(*cc) + n * (sizeof(*cc->cmds) + sizeof(*cc->steps)),
+		     GFP_KERNEL);
+	if (!cc)
+		return NULL;
+
+	cc->cmds = (const struct exynos_dsi_cmd **)(cc + 1);
+	cc->steps = (struct exynos_dsi_cmd_step *)(cc->cmds + n);
+	cc->src = cmd_set;
+	cc->src_num_cmd = n;
+	cc->panel_rev = ctx->panel_rev;
+
+	for (i = 0; i < n; i++) {
+		const struct exynos_dsi_cmd *c = &cmd_set->cmds[i];
+
+		cc->src_delay_ms += c->delay_ms;
+
+		if (!exynos_panel_cmd_match_rev(ctx, c))
+			continue;
+
+		/* delay only entries are merged into the preceding delay */
+		if (!c->cmd_len) {
+			if (!c->delay_ms)
+				continue;
+			if (!step) {
+				step = &cc->steps[cc->num_step++];
+				step->first = cc->num_cmd;
+			}
+			step->delay_ms += c->delay_ms;
+			continue;
+		}
+
+		/* a delay ends the run, the next command starts a new one */
+		if (!step || step->delay_ms) {
+			step = &cc->steps[cc->num_step++];
+			step->first = cc->num_cmd;
+		}
+
+		cc->cmds[cc->num_cmd++] = c;
+		step->num_cmd++;
+		step->delay_ms = c->delay_ms;
+	}
+
+	for (i = 0; i < cc->num_step; i++)
+		cc->delay_ms += cc->steps[i].delay_ms;
+
+	return cc;
+}
+
+/*
+ * Only command sets owned by the panel descriptor are cached, they are compiled
+ * once the revision is known and live as long as the panel. Entries compiled for
+ * a previous panel_rev are kept until the panel is removed, so a returned set
+ * stays valid without holding the lock.
+ */
+static const struct exynos_dsi_cmd_set_compiled *
+exynos_panel_find_compiled_cmd_set(struct exynos_panel *ctx,
+				   const struct exynos_dsi_cmd_set *cmd_set)
+{
+	struct exynos_dsi_cmd_set_compiled *cc;
+
+	mutex_lock(&ctx->cmd_set_cache_lock);
+	hash_for_each_possible(ctx->cmd_set_cache, cc, node, (unsigned long)cmd_set) {
+		if (cc->src == cmd_set && cc->panel_rev == ctx->panel_rev)
+			goto out;
+	}
+	cc = NULL;
+out:
+	mutex_unlock(&ctx->cmd_set_cache_lock);
+
+	return cc;
+}
+
+static void exynos_panel_cache_cmd_set(struct exynos_panel *ctx,
+				       const struct exynos_dsi_cmd_set *cmd_set)
+{
+	struct exynos_dsi_cmd_set_compiled *cc;
+
+	if (!cmd_set || exynos_panel_find_compiled_cmd_set(ctx, cmd_set))
+		return;
+
+	cc = exynos_panel_compile_cmd_set(ctx, cmd_set);
+	if (!cc)
+		return;
+
+	mutex_lock(&ctx->cmd_set_cache_lock);
+	hash_add(ctx->cmd_set_cache, &cc->node, (unsigned long)cmd_set);
+	mutex_unlock(&ctx->cmd_set_cache_lock);
+}
+
+static void exynos_panel_compile_desc_cmd_sets(struct exynos_panel *ctx)
+{
+	const struct exynos_panel_desc *desc = ctx->desc;
+	int i;
+
+	exynos_panel_cache_cmd_set(ctx, desc->off_cmd_set);
+	exynos_panel_cache_cmd_set(ctx, desc->lp_cmd_set);
+	for (i = 0; i < desc->num_binned_lp; i++)
+		exynos_panel_cache_cmd_set(ctx, &desc->binned_lp[i].cmd_set);
+}
+
+static void exynos_panel_free_compiled_cmd_sets(struct exynos_panel *ctx)
+{
+	struct exynos_dsi_cmd_set_compiled *cc;
+	struct hlist_node *tmp;
+	int bkt;
+
+	mutex_lock(&ctx->cmd_set_cache_lock);
+	hash_for_each_safe(ctx->cmd_set_cache, bkt, tmp, cc, node) {
+		hash_del(&cc->node);
+		kfree(cc);
+	}
+	mutex_unlock(&ctx->cmd_set_cache_lock);
+}
+
 static int exynos_panel_read_id(struct exynos_panel *ctx)
 {
 	struct mipi_dsi_device *dsi = to_mipi_dsi_device(ctx->dev);
@@ -276,19 +405,31 @@ static int exynos_panel_read_id(struct exynos_panel *ctx)
 static int exynos_panel_read_extinfo(struct exynos_panel *ctx)
 {
 	struct mipi_dsi_device *dsi = to_mipi_dsi_device(ctx->dev);
+	struct exynos_dsi_read_req reqs[EXT_INFO_SIZE] = { 0 };
 	char buf[EXT_INFO_SIZE];
-	int i, ret;
+	int i, queued, ret = 0;
+
+	/* queue all reads at once, the host issues them back to back */
+	for (queued = 0; queued < EXT_INFO_SIZE; queued++) {
+		ret = exynos_dcs_read_async(dsi, ext_info_regs[queued],
+					    buf + queued, 1, &reqs[queued]);
+		if (ret)
+			break;
+	}
 
-	for (i = 0; i < EXT_INFO_SIZE; i++) {
-		ret = mipi_dsi_dcs_read(dsi, ext_info_regs[i], buf + i, 1);
-		if (ret != 1) {
+	for (i = 0; i < queued; i++) {
+		wait_for_completion(&reqs[i].done);
+		if (!ret && reqs[i].ret != 1) {
 			dev_warn(ctx->dev,
-				 "Unable to read panel extinfo (0x%x: %d)\n",
-				 ext_info_regs[i], ret);
-			return ret;
+				 "Unable to read panel extinfo (0x%x: %zd)\n",
+				 ext_info_regs[i], reqs[i].ret);
+			ret = reqs[i].ret;
 		}
-
 	}
+
+	if (ret)
+		return ret;
+
 	exynos_bin2hex(buf, i, ctx->panel_extinfo, sizeof(ctx->panel_extinfo));
 
 	return 0;
@@ -371,6 +512,8 @@ int exynos_panel_init(struct exynos_panel *ctx)
 		ctx->panel_rev = PANEL_REV_LATEST;
 	}
 
+	exynos_panel_compile_desc_cmd_sets(ctx);
+
 	if (funcs && funcs->panel_init)
 		funcs->panel_init(ctx);
 
@@ -684,53 +827,82 @@ void exynos_panel_send_cmd_set_flags(struct exynos_panel *ctx,
 				     const struct exynos_dsi_cmd_set *cmd_set, u32 flags)
 {
 	struct mipi_dsi_device *dsi = to_mipi_dsi_device(ctx->dev);
-	const struct exynos_dsi_cmd *c;
-	const struct exynos_dsi_cmd *last_cmd = NULL;
+	const struct exynos_dsi_cmd_set_compiled *cc;
+	struct exynos_dsi_cmd_set_compiled *tmp = NULL;
 	const u32 async_mask = PANEL_CMD_SET_BATCH | PANEL_CMD_SET_QUEUE;
 	u16 dsi_flags = 0;
+	u32 i, j;
 
 	if (!cmd_set || !cmd_set->num_cmd)
 		return;
 
 	/* shouldn't have both queue and batch set together */
 	WARN_ON((flags & async_mask) == async_mask);
+	/* async cmd set is segmented by the host, it can't be batched by caller */
+	WARN_ON((flags & PANEL_CMD_SET_ASYNC) && (flags & async_mask));
 
 	if (flags & PANEL_CMD_SET_IGNORE_VBLANK)
 		dsi_flags |= EXYNOS_DSI_MSG_IGNORE_VBLANK;
 
-	/* if not batched or queued, all commands should be sent out immediately */
-	if (!(flags & async_mask))
-		dsi_flags |= MIPI_DSI_MSG_LASTCOMMAND;
+	if (flags & PANEL_CMD_SET_ASYNC)
+		dsi_flags |= EXYNOS_DSI_MSG_ASYNC;
 
-	c = &cmd_set->cmds[cmd_set->num_cmd - 1];
-	if (!c->panel_rev) {
-		last_cmd = c;
-	} else {
-		for (; c >= cmd_set->cmds; c--) {
-			if (c->panel_rev & ctx->panel_rev) {
-				last_cmd = c;
-				break;
-			}
+	/* sets not owned by the descriptor may be short lived, don't cache them */
+	cc = exynos_panel_find_compiled_cmd_set(ctx, cmd_set);
+	if (!cc) {
+		tmp = exynos_panel_compile_cmd_set(ctx, cmd_set);
+		if (!tmp) {
+			dev_err(ctx->dev, "unable to compile cmd set %ps\n", cmd_set);
+			return;
 		}
+		cc = tmp;
 	}
 
-	/* no commands to transfer */
-	if (!last_cmd)
-		return;
-
-	for (c = cmd_set->cmds; c <= last_cmd; c++) {
-		u32 delay_ms = c->delay_ms;
+	for (i = 0; i < cc->num_step; i++) {
+		const struct exynos_dsi_cmd_step *step = &cc->steps[i];
+		const bool last_step = (i == cc->num_step - 1);
+
+		for (j = 0; j < step->num_cmd; j++) {
+			const struct exynos_dsi_cmd *c = cc->cmds[step->first + j];
+			const bool last_in_step = (j == step->num_cmd - 1);
+			u16 cmd_flags = dsi_flags;
+
+			if (!(flags & async_mask)) {
+				/*
+				 * Unbatched commands used to go out one at a time,
+				 * the first one releasing anything queued earlier
+				 * with the caller's vblank semantics. Keep that for
+				 * the first command. Nothing else is pending after
+				 * it, so the rest of each run goes out right away
+				 * with one packet-go. IGNORE_VBLANK is set on every
+				 * command so that a run the host has to split on
+				 * FIFO limits doesn't wait for vblank either.
+				 */
+				if (!i && !j && !(dsi_flags & EXYNOS_DSI_MSG_IGNORE_VBLANK))
+					cmd_flags |= MIPI_DSI_MSG_LASTCOMMAND;
+				else if (last_in_step)
+					cmd_flags |= MIPI_DSI_MSG_LASTCOMMAND |
+						     EXYNOS_DSI_MSG_IGNORE_VBLANK;
+				else
+					cmd_flags |= EXYNOS_DSI_MSG_IGNORE_VBLANK;
+			} else if ((flags & PANEL_CMD_SET_BATCH) && last_step &&
+				   last_in_step) {
+				cmd_flags |= MIPI_DSI_MSG_LASTCOMMAND;
+			}
 
-		if (ctx->panel_rev && !(c->panel_rev & ctx->panel_rev))
-			continue;
+			/* delayed command must be out before sleeping */
+			if (step->delay_ms && last_in_step)
+				cmd_flags &= ~EXYNOS_DSI_MSG_ASYNC;
 
-		if ((c == last_cmd) && !(flags & PANEL_CMD_SET_QUEUE))
-			dsi_flags |= MIPI_DSI_MSG_LASTCOMMAND;
+			exynos_dsi_dcs_write_buffer(dsi, c->cmd, c->cmd_len, cmd_flags);
+		}
 
-		exynos_dsi_dcs_write_buffer(dsi, c->cmd, c->cmd_len, dsi_flags);
-		if (delay_ms)
-			usleep_range(delay_ms * 1000, delay_ms * 1000 + 10);
+		if (step->delay_ms)
+			usleep_range(step->delay_ms * 1000,
+				     step->delay_ms * 1000 + 10);
 	}
+
+	kfree(tmp);
 }
 EXPORT_SYMBOL(exynos_panel_send_cmd_set_flags);
 
@@ -1129,6 +1301,212 @@ unsigned int panel_get_idle_time_delta(struct exynos_panel *ctx)
 }
 EXPORT_SYMBOL(panel_get_idle_time_delta);
 
+/*
+ * Idle governor policy, first matching entry wins. An entry matches when updates
+ * come in no faster than @min_interval_us and, if @max_update_pct is set, the
+ * last update touched no more than that share of the display. Small updates at a
+ * steady pace (clock, cursor) tolerate a deeper step than full screen ones, and
+ * anything faster than the last entry is treated as an animation.
+ */
+static const struct exynos_panel_idle_policy {
+	u32 min_interval_us;
+	u32 max_update_pct;
+	u32 idle_vrefresh;
+} panel_idle_policy[] = {
+	{ .min_interval_us = 200000, .idle_vrefresh = 10 },
+	{ .min_interval_us = 100000, .max_update_pct = 10, .idle_vrefresh = 10 },
+	{ .min_interval_us = 50000, .idle_vrefresh = 30 },
+	{ .min_interval_us = 33000, .max_update_pct = 25, .idle_vrefresh = 30 },
+	{ .min_interval_us = 25000, .idle_vrefresh = 60 },
+};
+
+/* updates further apart than this don't tell much about cadence */
+#define PANEL_IDLE_GOV_MAX_INTERVAL_US	1000000
+
+/* check the pending early exit prediction against the actual time to the next update */
+static void panel_early_exit_account(struct exynos_panel_idle_gov *gov, s64 interval_us)
+{
+	bool hit;
+
+	switch (gov->ee_pending) {
+	case EARLY_EXIT_FULL:
+		hit = interval_us < gov->ee_reentry_us;
+		break;
+	case EARLY_EXIT_PARTIAL:
+		hit = interval_us >= gov->ee_reentry_us;
+		break;
+	default:
+		return;
+	}
+
+	if (hit)
+		gov->ee_hit++;
+	else
+		gov->ee_miss++;
+
+	gov->ee_pending = EARLY_EXIT_SKIP;
+}
+
+static void panel_idle_gov_update(struct exynos_panel *ctx, ktime_t now, u32 update_pct)
+{
+	struct exynos_panel_idle_gov *gov = &ctx->idle_gov;
+	s64 interval_us;
+
+	gov->commit_pct = update_pct;
+	if (!update_pct)
+		return;
+
+	interval_us = ktime_us_delta(now, gov->last_update_ts);
+	interval_us = clamp_t(s64, interval_us, 0, PANEL_IDLE_GOV_MAX_INTERVAL_US);
+	panel_early_exit_account(gov, interval_us);
+
+	/* weigh the new sample by 1/4 so a single late frame doesn't end an animation */
+	gov->interval_us = (gov->interval_us * 3 + interval_us) / 4;
+	gov->update_pct = update_pct;
+	gov->last_update_ts = now;
+}
+
+/* lowest idle step allowed by min_vrefresh, 0 if idle should not lower refresh rate */
+static u32 panel_idle_min_step(const struct exynos_panel *ctx)
+{
+	const int min_vrefresh = ctx->min_vrefresh;
+
+	if (min_vrefresh < 0)
+		return 0;
+	if (min_vrefresh <= 10)
+		return 10;
+	if (min_vrefresh <= 30)
+		return 30;
+	if (min_vrefresh <= 60)
+		return 60;
+
+	return 0;
+}
+
+/*
+ * Returns the idle step for the given update cadence, taking the time since the
+ * last update into account so that the step gets deeper as the display stays idle.
+ */
+static u32 panel_idle_gov_step(const struct exynos_panel *ctx, ktime_t now)
+{
+	const struct exynos_panel_idle_gov *gov = &ctx->idle_gov;
+	const s64 idle_us = min_t(s64, ktime_us_delta(now, gov->last_update_ts),
+				  PANEL_IDLE_GOV_MAX_INTERVAL_US);
+	const u32 interval_us = max_t(s64, gov->interval_us, idle_us);
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(panel_idle_policy); i++) {
+		const struct exynos_panel_idle_policy *policy = &panel_idle_policy[i];
+
+		if (interval_us < policy->min_interval_us)
+			continue;
+		if (policy->max_update_pct && gov->update_pct > policy->max_update_pct)
+			continue;
+
+		return policy->idle_vrefresh;
+	}
+
+	return 0;
+}
+
+static bool panel_idle_allowed(struct exynos_panel *ctx)
+{
+	/* don't want to enable auto mode/early exit during hbm or dimming on */
+	if (IS_HBM_ON(ctx->hbm_mode) || ctx->dimming_on)
+		return false;
+
+	if (ctx->idle_delay_ms && panel_get_idle_time_delta(ctx) < ctx->idle_delay_ms)
+		return false;
+
+	return ctx->panel_idle_enabled;
+}
+
+static u32 panel_idle_clamp_step(struct exynos_panel *ctx,
+				 const struct exynos_panel_mode *pmode, u32 idle_vrefresh)
+{
+	const u32 vrefresh = drm_mode_vrefresh(&pmode->mode);
+	const u32 min_step = panel_idle_min_step(ctx);
+
+	if (!min_step || !idle_vrefresh)
+		return 0;
+
+	idle_vrefresh = max(idle_vrefresh, min_step);
+	if (idle_vrefresh >= vrefresh) {
+		dev_dbg(ctx->dev, "idle vrefresh (%u) higher than target (%u)\n",
+			idle_vrefresh, vrefresh);
+		return 0;
+	}
+
+	return idle_vrefresh;
+}
+
+/**
+ * exynos_panel_get_idle_vrefresh - get refresh rate the panel may drop to while idle
+ * @ctx: panel struct
+ * @pmode: mode the panel is running at
+ *
+ * Returns the idle step picked by the idle governor from the recent update cadence,
+ * damage and the dimming/hbm state, or 0 if the panel should stay at the mode
+ * refresh rate.
+ */
+u32 exynos_panel_get_idle_vrefresh(struct exynos_panel *ctx,
+				   const struct exynos_panel_mode *pmode)
+{
+	u32 idle_vrefresh = 0;
+
+	if (panel_idle_allowed(ctx))
+		idle_vrefresh = panel_idle_clamp_step(ctx, pmode,
+						      panel_idle_gov_step(ctx, ktime_get()));
+	ctx->idle_gov.idle_vrefresh = idle_vrefresh;
+
+	return idle_vrefresh;
+}
+EXPORT_SYMBOL(exynos_panel_get_idle_vrefresh);
+
+/**
+ * exynos_panel_predict_early_exit - decide how to exit the idle step for a new frame
+ * @ctx: panel struct
+ *
+ * Meant to be called from commit_done once a panel has decided that an early exit is
+ * due. A full exit (back to the mode refresh rate) only pays off if another frame is
+ * expected before the panel would re-enter its idle step, which is after idle_delay_ms
+ * if set or one idle frame otherwise. Otherwise only the current frame needs to be
+ * kicked out. Each prediction is checked against the next update and counted as a hit
+ * or a miss.
+ */
+enum exynos_panel_early_exit exynos_panel_predict_early_exit(struct exynos_panel *ctx)
+{
+	struct exynos_panel_idle_gov *gov = &ctx->idle_gov;
+	enum exynos_panel_early_exit ee;
+	u32 reentry_us = 0;
+
+	WARN_ON(!mutex_is_locked(&ctx->mode_lock));
+
+	if (!gov->commit_pct) {
+		ee = EARLY_EXIT_SKIP;
+	} else {
+		const u32 idle_vrefresh = gov->idle_vrefresh ? : ctx->panel_idle_vrefresh;
+
+		if (ctx->idle_delay_ms)
+			reentry_us = ctx->idle_delay_ms * USEC_PER_MSEC;
+		else if (idle_vrefresh)
+			reentry_us = USEC_PER_SEC / idle_vrefresh;
+
+		ee = (!reentry_us || gov->interval_us < reentry_us) ?
+			EARLY_EXIT_FULL : EARLY_EXIT_PARTIAL;
+	}
+
+	gov->ee_cnt[ee]++;
+	gov->ee_pending = ee;
+	gov->ee_reentry_us = reentry_us;
+
+	dev_dbg(ctx->dev, "%s: %d (interval %uus reentry %uus)\n", __func__, ee,
+		gov->interval_us, reentry_us);
+
+	return ee;
+}
+EXPORT_SYMBOL(exynos_panel_predict_early_exit);
+
 static bool panel_idle_queue_delayed_work(struct exynos_panel *ctx)
 {
 	const unsigned int delta_ms = panel_get_idle_time_delta(ctx);
@@ -1147,6 +1525,50 @@ static bool panel_idle_queue_delayed_work(struct exynos_panel *ctx)
 	return false;
 }
 
+/*
+ * Applies the idle step the governor picks at @now. Frames that arrive while the panel
+ * sits in an idle step are already taken care of by early exit, so a @commit never
+ * backs out of the step just because updates sped up: that would resend auto mode
+ * commands every time an animation crosses a policy boundary. Only hbm, dimming and
+ * idle_delay_ms take the panel out of its step right away.
+ */
+static void panel_update_idle_step_locked(struct exynos_panel *ctx, ktime_t now, bool commit)
+{
+	const struct exynos_panel_funcs *funcs = ctx->desc->exynos_panel_func;
+	const struct exynos_panel_mode *pmode = ctx->current_mode;
+	struct exynos_panel_idle_gov *gov = &ctx->idle_gov;
+	const bool allowed = panel_idle_allowed(ctx);
+	u32 idle_vrefresh = 0, deepest;
+
+	WARN_ON(!mutex_is_locked(&ctx->mode_lock));
+
+	if (allowed)
+		idle_vrefresh = panel_idle_clamp_step(ctx, pmode, panel_idle_gov_step(ctx, now));
+
+	if (commit && allowed && gov->idle_vrefresh &&
+	    (!idle_vrefresh || idle_vrefresh > gov->idle_vrefresh))
+		idle_vrefresh = gov->idle_vrefresh;
+
+	gov->idle_vrefresh = idle_vrefresh;
+
+	if (funcs->set_idle_step(ctx, idle_vrefresh))
+		exynos_panel_update_te2(ctx);
+
+	if (!allowed) {
+		if (ctx->idle_delay_ms && ctx->panel_idle_enabled)
+			panel_idle_queue_delayed_work(ctx);
+		return;
+	}
+
+	/* come back once the display has been idle long enough for the deepest step */
+	deepest = panel_idle_clamp_step(ctx, pmode, panel_idle_policy[0].idle_vrefresh);
+	if (idle_vrefresh != deepest)
+		mod_delayed_work(system_highpri_wq, &ctx->idle_work,
+				 usecs_to_jiffies(panel_idle_policy[0].min_interval_us));
+	else if (delayed_work_pending(&ctx->idle_work))
+		cancel_delayed_work(&ctx->idle_work);
+}
+
 static void panel_update_idle_mode_locked(struct exynos_panel *ctx)
 {
 	const struct exynos_panel_funcs *funcs = ctx->desc->exynos_panel_func;
@@ -1156,7 +1578,15 @@ static void panel_update_idle_mode_locked(struct exynos_panel *ctx)
 	if (unlikely(!ctx->current_mode || !funcs))
 		return;
 
-	if (!is_panel_active(ctx) || !funcs->set_self_refresh)
+	if (!is_panel_active(ctx))
+		return;
+
+	if (ctx->current_mode->idle_mode == IDLE_MODE_ON_INACTIVITY && funcs->set_idle_step) {
+		panel_update_idle_step_locked(ctx, ktime_get(), false);
+		return;
+	}
+
+	if (!funcs->set_self_refresh)
 		return;
 
 	if (ctx->idle_delay_ms && ctx->self_refresh_active && panel_idle_queue_delayed_work(ctx))
@@ -1623,6 +2053,7 @@ static void exynos_panel_connector_atomic_commit(
 {
 	struct exynos_panel *ctx = exynos_connector_to_panel(exynos_connector);
 	const struct exynos_panel_funcs *exynos_panel_func = ctx->desc->exynos_panel_func;
+	ktime_t now;
 
 	if (!exynos_panel_func)
 		return;
@@ -1630,15 +2061,41 @@ static void exynos_panel_connector_atomic_commit(
 	exynos_panel_commit_properties(ctx, exynos_new_state);
 
 	mutex_lock(&ctx->mode_lock);
+	/* update cadence first so that commit_done can predict early exit from it */
+	now = ktime_get();
+	panel_idle_gov_update(ctx, now, exynos_new_state->update_pct);
+
 	if (exynos_panel_func->commit_done)
 		exynos_panel_func->commit_done(ctx);
+
+	ctx->last_commit_ts = now;
+
+	/* a change in update cadence may call for a different idle step */
+	if (exynos_new_state->update_pct && exynos_panel_func->set_idle_step &&
+	    ctx->current_mode && ctx->current_mode->idle_mode == IDLE_MODE_ON_INACTIVITY &&
+	    is_panel_active(ctx))
+		panel_update_idle_step_locked(ctx, now, true);
 	mutex_unlock(&ctx->mode_lock);
+}
+
+static void exynos_panel_connector_set_self_refresh(struct exynos_drm_connector *exynos_connector,
+						    bool enable)
+{
+	struct exynos_panel *ctx = exynos_connector_to_panel(exynos_connector);
 
-	ctx->last_commit_ts = ktime_get();
+	mutex_lock(&ctx->mode_lock);
+	if (ctx->self_refresh_active != enable && is_panel_active(ctx)) {
+		dev_dbg(ctx->dev, "self refresh state : %s(%d)\n", __func__, enable);
+
+		ctx->self_refresh_active = enable;
+		panel_update_idle_mode_locked(ctx);
+	}
+	mutex_unlock(&ctx->mode_lock);
 }
 
 static const struct exynos_drm_connector_helper_funcs exynos_panel_connector_helper_funcs = {
 	.atomic_commit = exynos_panel_connector_atomic_commit,
+	.set_self_refresh = exynos_panel_connector_set_self_refresh,
 };
 
 static int exynos_drm_connector_modes(struct drm_connector *connector)
@@ -1851,6 +2308,41 @@ static int panel_cmdset_show(struct seq_file *m, void *data)
 }
 DEFINE_SHOW_ATTRIBUTE(panel_cmdset);
 
+static int panel_cmdset_compiled_show(struct seq_file *m, void *data)
+{
+	struct exynos_panel *ctx = m->private;
+	const struct exynos_dsi_cmd_set_compiled *cc;
+	int bkt;
+
+	mutex_lock(&ctx->cmd_set_cache_lock);
+	hash_for_each(ctx->cmd_set_cache, bkt, cc, node) {
+		seq_printf(m, "%ps rev 0x%x: cmds %u -> %u, packet-go %u -> %u, delay %ums -> %ums\n",
+			   cc->src, cc->panel_rev, cc->src_num_cmd, cc->num_cmd,
+			   cc->src_num_cmd, cc->num_step, cc->src_delay_ms, cc->delay_ms);
+	}
+	mutex_unlock(&ctx->cmd_set_cache_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(panel_cmdset_compiled);
+
+static int panel_early_exit_show(struct seq_file *m, void *data)
+{
+	struct exynos_panel *ctx = m->private;
+	const struct exynos_panel_idle_gov *gov = &ctx->idle_gov;
+
+	mutex_lock(&ctx->mode_lock);
+	seq_printf(m, "interval: %uus idle_vrefresh: %u\n", gov->interval_us,
+		   gov->idle_vrefresh);
+	seq_printf(m, "skip: %u partial: %u full: %u\n", gov->ee_cnt[EARLY_EXIT_SKIP],
+		   gov->ee_cnt[EARLY_EXIT_PARTIAL], gov->ee_cnt[EARLY_EXIT_FULL]);
+	seq_printf(m, "hit: %u miss: %u\n", gov->ee_hit, gov->ee_miss);
+	mutex_unlock(&ctx->mode_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(panel_early_exit);
+
 void exynos_panel_debugfs_create_cmdset(struct exynos_panel *ctx,
 					struct dentry *parent,
 					const struct exynos_dsi_cmd_set *cmdset,
@@ -1895,6 +2387,9 @@ static int panel_debugfs_add(struct exynos_panel *ctx, struct dentry *parent)
 	if (funcs->print_gamma)
 		debugfs_create_file("gamma", 0600, parent, ctx, &panel_gamma_fops);
 
+	if (funcs->commit_done)
+		debugfs_create_file("early_exit", 0400, parent, ctx, &panel_early_exit_fops);
+
 	root = debugfs_create_dir("cmdsets", ctx->debugfs_entry);
 	if (!root) {
 		dev_err(ctx->dev, "can't create cmdset dir\n");
@@ -1902,6 +2397,8 @@ static int panel_debugfs_add(struct exynos_panel *ctx, struct dentry *parent)
 	}
 	ctx->debugfs_cmdset_entry = root;
 
+	debugfs_create_file("compiled", 0400, root, ctx, &panel_cmdset_compiled_fops);
+
 	exynos_panel_debugfs_create_cmdset(ctx, root, desc->off_cmd_set, "off");
 
 	if (desc->lp_mode) {
@@ -1976,6 +2473,35 @@ ssize_t exynos_dsi_dcs_write_buffer(struct mipi_dsi_device *dsi,
 }
 EXPORT_SYMBOL(exynos_dsi_dcs_write_buffer);
 
+/**
+ * exynos_dcs_read_async - queue a DCS read without waiting for the response
+ * @dsi: dsi device to read from
+ * @cmd: DCS command to read
+ * @buf: buffer receiving the response, must stay valid until completion
+ * @len: number of bytes to read
+ * @req: request to use, req->complete is left as set by the caller
+ *
+ * Wait on req->done for completion, the number of bytes read or an error is
+ * returned in req->ret.
+ */
+int exynos_dcs_read_async(struct mipi_dsi_device *dsi, u8 cmd, void *buf,
+			  size_t len, struct exynos_dsi_read_req *req)
+{
+	memset(&req->msg, 0, sizeof(req->msg));
+	req->cmd = cmd;
+	req->msg.channel = dsi->channel;
+	req->msg.type = MIPI_DSI_DCS_READ;
+	req->msg.tx_buf = &req->cmd;
+	req->msg.tx_len = 1;
+	req->msg.rx_buf = buf;
+	req->msg.rx_len = len;
+	if (dsi->mode_flags & MIPI_DSI_MODE_LPM)
+		req->msg.flags |= MIPI_DSI_MSG_USE_LPM;
+
+	return exynos_dsi_read_async(dsi, req);
+}
+EXPORT_SYMBOL(exynos_dcs_read_async);
+
 static int exynos_dsi_name_show(struct seq_file *m, void *data)
 {
 	struct mipi_dsi_device *dsi = m->private;
@@ -3024,22 +3550,104 @@ static void exynos_panel_bridge_post_disable(struct drm_bridge *bridge,
 	exynos_panel_set_backlight_state(ctx, ctx->panel_state);
 }
 
+#define RR_SWITCH_WINDOW_PCT_DEFAULT	55
+
 /* Get the VSYNC start time within a TE period */
-static u64 exynos_panel_vsync_start_time_us(u32 te_period_us)
+static u32 exynos_panel_vsync_start_time_us(const struct exynos_panel *ctx,
+					    u32 te_period_us)
 {
-	/* Approximate the VSYNC start time with TE falling edge. Approximate
-	 * the TE falling edge with 55% TE width
-	 */
-	/* TODO: Change to ctx->current_mode->exynos_mode.vblank_usec when it's accurate */
-	return te_period_us * 55 / 100;
+	const struct exynos_panel_funcs *funcs = ctx->desc->exynos_panel_func;
+	u32 pct = RR_SWITCH_WINDOW_PCT_DEFAULT;
+
+	if (funcs && funcs->rr_switch_window_pct)
+		pct = funcs->rr_switch_window_pct;
+
+	return te_period_us * pct / 100;
 }
 
-static void exynos_panel_check_modeset_timing(struct drm_crtc *crtc,
-					 const struct drm_display_mode *old_mode)
+/* TE periods to wait for a TE the switch window can be found from before giving up */
+#define RR_SWITCH_TE_RETRY_MAX		3
+
+/*
+ * TE source a refresh rate switch is synchronized to. Outside of tests this is the crtc
+ * vblank, which the decon TE irq timestamps through drm_crtc_handle_vblank().
+ */
+struct exynos_panel_te_source {
+	ktime_t (*now)(void *priv);
+	ktime_t (*last_te)(void *priv);
+	void (*wait_te)(void *priv);
+	void (*sleep_until)(void *priv, ktime_t expires);
+};
+
+static ktime_t exynos_panel_crtc_now(void *priv)
+{
+	return ktime_get();
+}
+
+static ktime_t exynos_panel_crtc_last_te(void *priv)
+{
+	ktime_t last_te = 0;
+
+	drm_crtc_vblank_count_and_time(priv, &last_te);
+
+	return last_te;
+}
+
+static void exynos_panel_crtc_wait_te(void *priv)
+{
+	DPU_ATRACE_BEGIN("wait_te");
+	drm_crtc_wait_one_vblank(priv);
+	DPU_ATRACE_END("wait_te");
+}
+
+static void exynos_panel_crtc_sleep_until(void *priv, ktime_t expires)
+{
+	set_current_state(TASK_UNINTERRUPTIBLE);
+	schedule_hrtimeout_range(&expires, 100 * NSEC_PER_USEC, HRTIMER_MODE_ABS);
+}
+
+static const struct exynos_panel_te_source exynos_panel_crtc_te = {
+	.now = exynos_panel_crtc_now,
+	.last_te = exynos_panel_crtc_last_te,
+	.wait_te = exynos_panel_crtc_wait_te,
+	.sleep_until = exynos_panel_crtc_sleep_until,
+};
+
+/*
+ * Waits until it is between @left_us and 1ms before the end of the TE period of
+ * @te_period_us, measured from the last TE of @te. If the window of the current period
+ * is already missed, or was overslept, waits for the next TE. Returns -ETIMEDOUT if
+ * that didn't bring up a usable TE timestamp RR_SWITCH_TE_RETRY_MAX times in a row,
+ * e.g. because TE interrupts are off.
+ */
+static int exynos_panel_wait_rr_switch_window(const struct exynos_panel_te_source *te,
+					      void *priv, u32 te_period_us, u32 left_us)
+{
+	const s64 right_us = te_period_us - USEC_PER_MSEC;
+	int retry = 0;
+
+	for (;;) {
+		const ktime_t last_te = te->last_te(priv);
+		const s64 since_last_te_us = ktime_us_delta(te->now(priv), last_te);
+
+		if (since_last_te_us > right_us) {
+			if (retry++ == RR_SWITCH_TE_RETRY_MAX)
+				return -ETIMEDOUT;
+			te->wait_te(priv);
+		} else if (since_last_te_us < left_us) {
+			te->sleep_until(priv, ktime_add_us(last_te, left_us));
+		} else {
+			return 0;
+		}
+	}
+}
+
+static void exynos_panel_check_modeset_timing(struct exynos_panel *ctx,
+					      struct drm_crtc *crtc,
+					      const struct drm_display_mode *old_mode)
 {
 	u32 te_period_us;
-	int retry;
-	u64 left, right;
+	int ret;
 
 	DPU_ATRACE_BEGIN(__func__);
 	pr_debug("%s: check mode_set timing enter.\n", __func__);
@@ -3050,8 +3658,8 @@ static void exynos_panel_check_modeset_timing(struct drm_crtc *crtc,
 	 * and scanout need to happen in the same VSYNC period because the frame content might
 	 * be adjusted specific to this RR.
 	 *
-	 * An estimation is [55% * TE_duration, TE_duration - 1ms] before driver has the
-	 * accurate TE pulse width (VSYNC rising is a bit ahead of TE falling edge).
+	 * The window is [rr_switch_window_pct * TE_duration, TE_duration - 1ms], where the
+	 * start approximates VSYNC rising (a bit ahead of TE falling edge).
 	 *
 	 *         -->|     |<-- safe time window to send RR
 	 *
@@ -3064,30 +3672,17 @@ static void exynos_panel_check_modeset_timing(struct drm_crtc *crtc,
 	 *            |          |       |
 	 * VSYNC------+----------+-------+----
 	 *            RR1        RR2
+	 *
+	 * TE is timestamped by the vblank handling in the decon TE irq. If the window of the
+	 * current TE period is already missed, wait for the next TE and then sleep on an
+	 * hrtimer until the window opens. Without TE there is no window to find, the switch
+	 * is sent right away rather than holding up the commit.
 	 */
-	left = exynos_panel_vsync_start_time_us(te_period_us);
-	right = te_period_us - USEC_PER_MSEC;
-	/* check for next TE every 1ms */
-	retry = te_period_us / USEC_PER_MSEC + 1;
-
-	do {
-		ktime_t last_te = 0, now;
-		s64 since_last_te_us;
-
-		drm_crtc_vblank_count_and_time(crtc, &last_te);
-		now = ktime_get();
-		since_last_te_us = ktime_us_delta(now, last_te);
-		if (since_last_te_us <= right) {
-			if (since_last_te_us < left) {
-				u32 delay_us = left - since_last_te_us;
-
-				usleep_range(delay_us, delay_us + 100);
-			}
-			break;
-		}
-		/* retry in 1ms */
-		usleep_range(USEC_PER_MSEC, USEC_PER_MSEC + 100);
-	} while (--retry > 0);
+	ret = exynos_panel_wait_rr_switch_window(&exynos_panel_crtc_te, crtc, te_period_us,
+					exynos_panel_vsync_start_time_us(ctx, te_period_us));
+	if (ret)
+		dev_warn(ctx->dev, "%s: no TE in %d periods, switching outside the window\n",
+			 __func__, RR_SWITCH_TE_RETRY_MAX);
 
 	pr_debug("%s: check mode_set timing exit.\n", __func__);
 	DPU_ATRACE_END(__func__);
@@ -3185,7 +3780,7 @@ static void exynos_panel_bridge_mode_set(struct drm_bridge *bridge,
 			}
 		} else if (funcs->mode_set) {
 			if (exynos_connector_state->sync_rr_switch && is_active)
-				exynos_panel_check_modeset_timing(crtc, &current_mode->mode);
+				exynos_panel_check_modeset_timing(ctx, crtc, &current_mode->mode);
 			funcs->mode_set(ctx, pmode);
 			state_changed = is_active;
 		}
@@ -3249,7 +3844,7 @@ static void hbm_work(struct work_struct *work)
 	te_period_us = USEC_PER_SEC / fps;
 
 	/* delay begins at TE rising, ends at VSYNC rising */
-	delay_us = exynos_panel_vsync_start_time_us(te_period_us);
+	delay_us = exynos_panel_vsync_start_time_us(ctx, te_period_us);
 	timeout_ms = te_period_us / USEC_PER_MSEC + 20;
 
 	/* considering the variation */
@@ -3478,6 +4073,8 @@ int exynos_panel_common_init(struct mipi_dsi_device *dsi,
 	mutex_init(&ctx->mode_lock);
 	mutex_init(&ctx->bl_state_lock);
 	mutex_init(&ctx->lp_state_lock);
+	mutex_init(&ctx->cmd_set_cache_lock);
+	hash_init(ctx->cmd_set_cache);
 
 	drm_panel_init(&ctx->panel, dev, ctx->desc->panel_func, DRM_MODE_CONNECTOR_DSI);
 
@@ -3544,6 +4141,8 @@ int exynos_panel_remove(struct mipi_dsi_device *dsi)
 	sysfs_remove_groups(&ctx->bl->dev.kobj, bl_device_groups);
 	devm_backlight_device_unregister(ctx->dev, ctx->bl);
 
+	exynos_panel_free_compiled_cmd_sets(ctx);
+
 	return 0;
 }
 EXPORT_SYMBOL(exynos_panel_remove);
@@ -3551,3 +4150,7 @@ EXPORT_SYMBOL(exynos_panel_remove);
 MODULE_AUTHOR("Jiun Yu <jiun.yu@samsung.com>");
 MODULE_DESCRIPTION("MIPI-DSI based Samsung common panel driver");
 MODULE_LICENSE("GPL");
+
+#if IS_ENABLED(CONFIG_DRM_SAMSUNG_KUNIT_TEST)
+#include "panel-samsung-drv_test.c"
+#endif
@@ -19,6 +19,7 @@
 #include <linux/regulator/consumer.h>
 #include <linux/gpio/consumer.h>
 #include <linux/backlight.h>
+#include <linux/hashtable.h>
 #include <drm/drm_bridge.h>
 #include <drm/drm_connector.h>
 #include <drm/drm_crtc.h>
@@ -69,6 +70,12 @@
 /* packetgo feature to batch msgs can wait for vblank, use this flag to ignore explicitly */
 #define PANEL_CMD_SET_IGNORE_VBLANK BIT(2)
 
+/*
+ * return without waiting for the commands to be sent, they are released at the
+ * next vblank. Commands with a delay are still sent synchronously.
+ */
+#define PANEL_CMD_SET_ASYNC  BIT(3)
+
 
 #define HBM_FLAG_GHBM_UPDATE    BIT(0)
 #define HBM_FLAG_BL_UPDATE      BIT(1)
@@ -364,6 +371,18 @@ struct exynos_panel_funcs {
 	 */
 	bool (*set_self_refresh)(struct exynos_panel *exynos_panel, bool enable);
 
+	/**
+	 * @set_idle_step
+	 *
+	 * Called for modes with IDLE_MODE_ON_INACTIVITY whenever the idle governor
+	 * re-evaluates the refresh rate the panel may drop to while idle. @idle_vrefresh
+	 * is one of the governor steps (10, 30 or 60hz), or 0 if the panel should stay
+	 * at the mode refresh rate.
+	 *
+	 * Returns true if commands were sent to apply a new step, otherwise false.
+	 */
+	bool (*set_idle_step)(struct exynos_panel *exynos_panel, u32 idle_vrefresh);
+
 	/**
 	 * @set_op_hz
 	 *
@@ -372,6 +391,15 @@ struct exynos_panel_funcs {
 	 * Returns 0 if successfully setting operation rate.
 	 */
 	int (*set_op_hz)(struct exynos_panel *exynos_panel, unsigned int hz);
+
+	/**
+	 * @rr_switch_window_pct
+	 *
+	 * Start of the safe window to send a synchronized refresh rate switch, in percent of
+	 * the TE period from the TE rising edge. It should approximate VSYNC start, i.e. the
+	 * TE falling edge. A default of 55% is used if not set.
+	 */
+	u32 rr_switch_window_pct;
 };
 
 /**
@@ -399,6 +427,46 @@ struct exynos_dsi_cmd_set {
 	const struct exynos_dsi_cmd *cmds;
 };
 
+/**
+ * struct exynos_dsi_cmd_step - a run of commands released with one packet-go.
+ * @first:    Index of the first command of the run in the compiled set.
+ * @num_cmd:  Number of commands in the run.
+ * @delay_ms: Delay after the run is sent.
+ */
+struct exynos_dsi_cmd_step {
+	u16 first;
+	u16 num_cmd;
+	u32 delay_ms;
+};
+
+/**
+ * struct exynos_dsi_cmd_set_compiled - a dsi command sequence filtered for the
+ *					panel revision and split into runs.
+ * @node:         Entry in the panel command set cache.
+ * @src:          Command set this was compiled from.
+ * @src_num_cmd:  Number of commands in @src, each sent with its own packet-go
+ *		  before compiling.
+ * @panel_rev:    Panel revision used to filter @src.
+ * @num_cmd:      Number of commands left after filtering.
+ * @num_step:     Number of runs, i.e. packet-go releases.
+ * @src_delay_ms: Sum of all delays in @src.
+ * @delay_ms:     Sum of the delays of all runs.
+ * @cmds:         Filtered commands.
+ * @steps:        Runs of @cmds.
+ */
+struct exynos_dsi_cmd_set_compiled {
+	struct hlist_node node;
+	const struct exynos_dsi_cmd_set *src;
+	u32 src_num_cmd;
+	u32 panel_rev;
+	u32 num_cmd;
+	u32 num_step;
+	u32 src_delay_ms;
+	u32 delay_ms;
+	const struct exynos_dsi_cmd **cmds;
+	struct exynos_dsi_cmd_step *steps;
+};
+
 /**
  * struct exynos_binned_lp - information for binned lp mode.
  * @name:         Name of this binned lp mode.
@@ -467,6 +535,40 @@ struct te2_data {
 	struct te2_mode_data mode_data[MAX_TE2_TYPE];
 };
 
+/**
+ * enum exynos_panel_early_exit - how an early exit out of the idle step should be applied
+ * @EARLY_EXIT_SKIP: commit didn't update anything, no exit needed
+ * @EARLY_EXIT_PARTIAL: scan out this frame only and let the panel stay in its idle step,
+ *			no further frame is expected before the step would be re-entered
+ * @EARLY_EXIT_FULL: leave the idle step, more frames are expected shortly
+ */
+enum exynos_panel_early_exit {
+	EARLY_EXIT_SKIP,
+	EARLY_EXIT_PARTIAL,
+	EARLY_EXIT_FULL,
+};
+
+/* idle refresh rate governor state, protected by mode_lock */
+struct exynos_panel_idle_gov {
+	/* time of the last commit which updated any plane */
+	ktime_t last_update_ts;
+	/* moving average of the time between updates */
+	u32 interval_us;
+	/* share of the display updated by the last update, in percent */
+	u32 update_pct;
+	/* share of the display updated by the last commit, 0 if it updated nothing */
+	u32 commit_pct;
+	/* idle step last chosen by the governor, 0 for none */
+	u32 idle_vrefresh;
+
+	/* last early exit prediction, checked against the next update */
+	enum exynos_panel_early_exit ee_pending;
+	u32 ee_reentry_us;
+	u32 ee_cnt[EARLY_EXIT_FULL + 1];
+	u32 ee_hit;
+	u32 ee_miss;
+};
+
 struct exynos_panel {
 	struct device *dev;
 	struct drm_panel panel;
@@ -535,11 +637,15 @@ struct exynos_panel {
 	char panel_id[PANEL_ID_MAX];
 	char panel_extinfo[PANEL_EXTINFO_MAX];
 	u32 panel_rev;
+	/* descriptor command sets compiled per panel_rev, keyed by source set */
+	DECLARE_HASHTABLE(cmd_set_cache, 4);
+	struct mutex cmd_set_cache_lock;
 	enum drm_panel_orientation orientation;
 
 	struct device_node *touch_dev;
 
 	struct te2_data te2;
+	struct exynos_panel_idle_gov idle_gov;
 	ktime_t last_commit_ts;
 	ktime_t last_mode_set_ts;
 	ktime_t last_self_refresh_active_ts;
@@ -763,6 +869,9 @@ static inline void backlight_state_changed(struct backlight_device *bl)
 	i--, data++)									\
 
 unsigned int panel_get_idle_time_delta(struct exynos_panel *ctx);
+u32 exynos_panel_get_idle_vrefresh(struct exynos_panel *ctx,
+				   const struct exynos_panel_mode *pmode);
+enum exynos_panel_early_exit exynos_panel_predict_early_exit(struct exynos_panel *ctx);
 int exynos_panel_configure_te2_edges(struct exynos_panel *ctx,
 				     u32 *timings, bool lp_mode);
 ssize_t exynos_panel_get_te2_edges(struct exynos_panel *ctx,
@@ -795,6 +904,8 @@ int exynos_panel_common_init(struct mipi_dsi_device *dsi,
 				struct exynos_panel *ctx);
 ssize_t exynos_dsi_dcs_write_buffer(struct mipi_dsi_device *dsi,
 				const void *data, size_t len, u16 flags);
+int exynos_dcs_read_async(struct mipi_dsi_device *dsi, u8 cmd, void *buf,
+			  size_t len, struct exynos_dsi_read_req *req);
 
 int exynos_panel_probe(struct mipi_dsi_device *dsi);
 int exynos_panel_remove(struct mipi_dsi_device *dsi);
@@ -0,0 +1,530 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the idle refresh rate governor and the refresh rate switch window,
+ * included from panel-samsung-drv.c.
+ *
+ * Copyright (c) 2019 Samsung Electronics Co., Ltd
+ */
+
+#include <kunit/test.h>
+
+/* idle_work fires once the display has been idle long enough for the deepest step */
+#define PANEL_IDLE_TEST_WORK_US		(panel_idle_policy[0].min_interval_us)
+
+struct panel_idle_test {
+	struct exynos_panel ctx;
+	struct exynos_panel_desc desc;
+	struct exynos_panel_mode pmode;
+
+	/* idle step the fake panel is running at */
+	u32 step;
+	u32 step_changes;
+	u32 step_exits;
+};
+
+struct panel_idle_test_stats {
+	/* refresh rate integrated over time, in hz * us */
+	u64 refresh;
+	u64 duration_us;
+	u32 commits;
+	u32 jank;
+};
+
+static bool panel_idle_test_set_idle_step(struct exynos_panel *ctx, u32 idle_vrefresh)
+{
+	struct panel_idle_test *t = container_of(ctx, struct panel_idle_test, ctx);
+
+	if (t->step == idle_vrefresh)
+		return false;
+
+	t->step = idle_vrefresh;
+	t->step_changes++;
+	if (!idle_vrefresh)
+		t->step_exits++;
+
+	return true;
+}
+
+static const struct exynos_panel_funcs panel_idle_test_funcs = {
+	.set_idle_step = panel_idle_test_set_idle_step,
+};
+
+static int panel_idle_test_init(struct kunit *test)
+{
+	struct panel_idle_test *t;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t);
+
+	t->ctx.dev = root_device_register("panel_idle_test");
+	KUNIT_ASSERT_FALSE(test, IS_ERR(t->ctx.dev));
+
+	/* 1440x2960 @ 120 of the emulator panel */
+	t->pmode.mode.clock = 538560;
+	t->pmode.mode.hdisplay = 1440;
+	t->pmode.mode.htotal = 1440 + 32 + 12 + 16;
+	t->pmode.mode.vdisplay = 2960;
+	t->pmode.mode.vtotal = 2960 + 12 + 4 + 16;
+	t->pmode.idle_mode = IDLE_MODE_ON_INACTIVITY;
+
+	t->desc.exynos_panel_func = &panel_idle_test_funcs;
+	t->ctx.desc = &t->desc;
+	t->ctx.current_mode = &t->pmode;
+	t->ctx.panel_idle_enabled = true;
+	t->ctx.min_vrefresh = 10;
+	mutex_init(&t->ctx.mode_lock);
+	INIT_DELAYED_WORK(&t->ctx.idle_work, panel_idle_work);
+	test->priv = t;
+
+	return 0;
+}
+
+static void panel_idle_test_exit(struct kunit *test)
+{
+	struct panel_idle_test *t = test->priv;
+
+	cancel_delayed_work_sync(&t->ctx.idle_work);
+	root_device_unregister(t->ctx.dev);
+}
+
+/* a commit at @now as exynos_panel_connector_atomic_commit() and commit_done see it */
+static void panel_idle_test_commit(struct panel_idle_test *t, ktime_t now, u32 update_pct)
+{
+	struct exynos_panel *ctx = &t->ctx;
+
+	mutex_lock(&ctx->mode_lock);
+	panel_idle_gov_update(ctx, now, update_pct);
+	if (t->step)
+		exynos_panel_predict_early_exit(ctx);
+	ctx->last_commit_ts = now;
+	panel_update_idle_step_locked(ctx, now, true);
+	mutex_unlock(&ctx->mode_lock);
+}
+
+static void panel_idle_test_idle_work(struct panel_idle_test *t, ktime_t now)
+{
+	mutex_lock(&t->ctx.mode_lock);
+	panel_update_idle_step_locked(&t->ctx, now, false);
+	mutex_unlock(&t->ctx.mode_lock);
+}
+
+/*
+ * Refresh rate the panel runs at from @from to @to: the mode refresh rate until
+ * @busy_until, which covers the frame itself and a full early exit, then the idle
+ * step if there is one.
+ */
+static void panel_idle_test_account(struct panel_idle_test *t, struct panel_idle_test_stats *st,
+		ktime_t from, ktime_t to, ktime_t busy_until)
+{
+	const u32 vrefresh = drm_mode_vrefresh(&t->pmode.mode);
+	const ktime_t busy_end = clamp(busy_until, from, to);
+	const u64 busy_us = ktime_us_delta(busy_end, from);
+	const u64 idle_us = ktime_us_delta(to, busy_end);
+
+	st->refresh += busy_us * vrefresh + idle_us * (t->step ? : vrefresh);
+	st->duration_us += busy_us + idle_us;
+}
+
+static u32 panel_idle_test_avg_hz(const struct panel_idle_test_stats *st)
+{
+	return st->duration_us ? div64_u64(st->refresh, st->duration_us) : 0;
+}
+
+/*
+ * Replays @cnt commits @interval_us apart, running idle_work whenever it would have
+ * fired in between. A commit that arrives before the step would have been re-entered
+ * after a partial early exit found the panel on its way back into the idle step, and
+ * is counted as jank.
+ */
+static ktime_t panel_idle_test_replay(struct panel_idle_test *t, ktime_t now, u32 cnt,
+		u32 interval_us, u32 update_pct, struct panel_idle_test_stats *st)
+{
+	const struct exynos_panel_idle_gov *gov = &t->ctx.idle_gov;
+	const u32 frame_us = USEC_PER_SEC / drm_mode_vrefresh(&t->pmode.mode);
+	ktime_t busy_until = ktime_add_us(now, frame_us);
+	u32 i;
+
+	for (i = 0; i < cnt; i++) {
+		const ktime_t next = ktime_add_us(now, interval_us);
+		const ktime_t work = ktime_add_us(gov->last_update_ts, PANEL_IDLE_TEST_WORK_US);
+
+		if (ktime_before(work, next) && ktime_after(work, now)) {
+			panel_idle_test_account(t, st, now, work, busy_until);
+			panel_idle_test_idle_work(t, work);
+			now = work;
+		}
+		panel_idle_test_account(t, st, now, next, busy_until);
+		now = next;
+
+		if (gov->ee_pending == EARLY_EXIT_PARTIAL && interval_us < gov->ee_reentry_us)
+			st->jank++;
+
+		panel_idle_test_commit(t, now, update_pct);
+		st->commits++;
+
+		busy_until = ktime_add_us(now, gov->ee_pending == EARLY_EXIT_FULL ?
+					  max(gov->ee_reentry_us, frame_us) : frame_us);
+	}
+
+	return now;
+}
+
+struct panel_idle_test_seg {
+	const char *name;
+	u32 cnt;
+	u32 interval_us;
+	u32 update_pct;
+};
+
+/*
+ * Commit cadence of a short session: the status bar clock on the home screen, a
+ * fling that slows down, a 30fps video, typing with a blinking cursor and idle again.
+ */
+static const struct panel_idle_test_seg panel_idle_test_trace[] = {
+	{ "clock",	5,	1000000,	2 },
+	{ "fling",	90,	8333,		100 },
+	{ "fling tail",	12,	16667,		100 },
+	{ "settle",	4,	41667,		100 },
+	{ "video",	150,	33333,		60 },
+	{ "typing",	25,	150000,		5 },
+	{ "cursor",	6,	500000,		1 },
+	{ "clock",	5,	1000000,	2 },
+};
+
+/*
+ * Replays the trace and reports the predicted refresh rate, a proxy for panel power,
+ * next to the janky early exits. Cadence changes never take the panel out of its idle
+ * step, early exit covers the frames.
+ */
+static void panel_idle_test_trace_replay(struct kunit *test)
+{
+	struct panel_idle_test *t = test->priv;
+	const u32 vrefresh = drm_mode_vrefresh(&t->pmode.mode);
+	struct panel_idle_test_stats total = { 0 };
+	ktime_t now = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(panel_idle_test_trace); i++) {
+		const struct panel_idle_test_seg *seg = &panel_idle_test_trace[i];
+		struct panel_idle_test_stats st = { 0 };
+		const u32 changes = t->step_changes;
+
+		now = panel_idle_test_replay(t, now, seg->cnt, seg->interval_us,
+					     seg->update_pct, &st);
+
+		kunit_info(test, "%-10s %3u commits %4llums: %3u hz avg, step %2u, %u step changes, %u janky early exits\n",
+			   seg->name, st.commits, div_u64(st.duration_us, USEC_PER_MSEC),
+			   panel_idle_test_avg_hz(&st), t->step, t->step_changes - changes,
+			   st.jank);
+
+		total.refresh += st.refresh;
+		total.duration_us += st.duration_us;
+		total.commits += st.commits;
+		total.jank += st.jank;
+	}
+
+	kunit_info(test, "total: %u commits, %u hz avg against %u hz, %u janky early exits\n",
+		   total.commits, panel_idle_test_avg_hz(&total), vrefresh, total.jank);
+
+	KUNIT_EXPECT_EQ(test, t->step_exits, 0);
+	KUNIT_EXPECT_EQ(test, t->step, 10);
+	KUNIT_EXPECT_LT(test, panel_idle_test_avg_hz(&total), vrefresh);
+	/* at most one janky exit per change of pace */
+	KUNIT_EXPECT_LE(test, total.jank, ARRAY_SIZE(panel_idle_test_trace));
+}
+
+/* an animation jittering around the 25ms and 33ms policy boundaries only ever deepens */
+static void panel_idle_test_jitter(struct kunit *test)
+{
+	struct panel_idle_test *t = test->priv;
+	struct panel_idle_test_stats st = { 0 };
+	ktime_t now = 0;
+	u32 last = 0;
+	int i;
+
+	for (i = 0; i < 100; i++) {
+		now = panel_idle_test_replay(t, now, 1, 16667, 20, &st);
+		now = panel_idle_test_replay(t, now, 1, 34000, 20, &st);
+
+		if (last)
+			KUNIT_EXPECT_TRUE_MSG(test, t->step && t->step <= last,
+					      "step %u after %u", t->step, last);
+		last = t->step;
+	}
+
+	KUNIT_EXPECT_EQ(test, t->step_exits, 0);
+	KUNIT_EXPECT_LE(test, t->step_changes, ARRAY_SIZE(panel_idle_policy));
+}
+
+/* hbm and dimming take the panel out of its idle step from the commit path right away */
+static void panel_idle_test_disallowed(struct kunit *test)
+{
+	struct panel_idle_test *t = test->priv;
+	struct panel_idle_test_stats st = { 0 };
+	ktime_t now;
+
+	now = panel_idle_test_replay(t, 0, 3, 1000000, 2, &st);
+	KUNIT_ASSERT_EQ(test, t->step, 10);
+
+	t->ctx.hbm_mode = HBM_ON_IRC_ON;
+	now = panel_idle_test_replay(t, now, 1, 8333, 100, &st);
+	KUNIT_EXPECT_EQ(test, t->step, 0);
+	KUNIT_EXPECT_EQ(test, t->step_exits, 1);
+
+	/* idle_work brings the step back once the display idles */
+	t->ctx.hbm_mode = HBM_OFF;
+	now = panel_idle_test_replay(t, now, 1, 1000000, 2, &st);
+	KUNIT_EXPECT_EQ(test, t->step, 10);
+
+	t->ctx.dimming_on = true;
+	panel_idle_test_replay(t, now, 1, 1000000, 2, &st);
+	KUNIT_EXPECT_EQ(test, t->step, 0);
+	KUNIT_EXPECT_EQ(test, t->step_exits, 2);
+}
+
+static struct kunit_case panel_idle_test_cases[] = {
+	KUNIT_CASE(panel_idle_test_trace_replay),
+	KUNIT_CASE(panel_idle_test_jitter),
+	KUNIT_CASE(panel_idle_test_disallowed),
+	{}
+};
+
+static struct kunit_suite panel_idle_test_suite = {
+	.name = "exynos-panel-idle-gov",
+	.init = panel_idle_test_init,
+	.exit = panel_idle_test_exit,
+	.test_cases = panel_idle_test_cases,
+};
+
+/*
+ * Synthetic TE firing every @period_us from @first_te. Like the vblank timestamp taken
+ * in the decon TE irq, each TE is only seen and timestamped @irq_delay_us after it
+ * fires. After @te_cnt TEs, if set, it stops. Time only moves
+ * when the scheduler waits or sleeps, sleeps end @slack_us late and the first one
+ * @oversleep_us on top of that.
+ */
+struct rr_switch_test_te {
+	ktime_t now;
+	ktime_t first_te;
+	u32 period_us;
+	u32 irq_delay_us;
+	u32 slack_us;
+	u32 oversleep_us;
+	u32 te_cnt;
+
+	u32 waits;
+	u32 sleeps;
+};
+
+static s64 rr_switch_test_te_idx(const struct rr_switch_test_te *te)
+{
+	const s64 since_us = ktime_us_delta(te->now, te->first_te) - te->irq_delay_us;
+	s64 idx;
+
+	if (since_us < 0)
+		return -1;
+
+	idx = div_s64(since_us, te->period_us);
+	if (te->te_cnt && idx >= te->te_cnt)
+		idx = te->te_cnt - 1;
+
+	return idx;
+}
+
+static ktime_t rr_switch_test_te_time(const struct rr_switch_test_te *te, s64 idx)
+{
+	return ktime_add_us(te->first_te, idx * te->period_us);
+}
+
+static ktime_t rr_switch_test_now(void *priv)
+{
+	const struct rr_switch_test_te *te = priv;
+
+	return te->now;
+}
+
+static ktime_t rr_switch_test_last_te(void *priv)
+{
+	const struct rr_switch_test_te *te = priv;
+	const s64 idx = rr_switch_test_te_idx(te);
+
+	return idx < 0 ? 0 : ktime_add_us(rr_switch_test_te_time(te, idx), te->irq_delay_us);
+}
+
+/* drm_crtc_wait_one_vblank() gives up after 100ms */
+static void rr_switch_test_wait_te(void *priv)
+{
+	struct rr_switch_test_te *te = priv;
+	const s64 next = rr_switch_test_te_idx(te) + 1;
+
+	te->waits++;
+	if (te->te_cnt && next >= te->te_cnt)
+		te->now = ktime_add_ms(te->now, 100);
+	else
+		te->now = ktime_add_us(rr_switch_test_te_time(te, next), te->irq_delay_us);
+}
+
+static void rr_switch_test_sleep_until(void *priv, ktime_t expires)
+{
+	struct rr_switch_test_te *te = priv;
+
+	te->sleeps++;
+	te->now = ktime_add_us(max(te->now, expires), te->slack_us + te->oversleep_us);
+	te->oversleep_us = 0;
+}
+
+static const struct exynos_panel_te_source rr_switch_test_te_source = {
+	.now = rr_switch_test_now,
+	.last_te = rr_switch_test_last_te,
+	.wait_te = rr_switch_test_wait_te,
+	.sleep_until = rr_switch_test_sleep_until,
+};
+
+struct rr_switch_test {
+	struct exynos_panel ctx;
+	struct exynos_panel_desc desc;
+	struct exynos_panel_funcs funcs;
+	struct drm_display_mode modes[2];
+};
+
+static int rr_switch_test_init(struct kunit *test)
+{
+	struct rr_switch_test *t;
+	int i;
+
+	t = kunit_kzalloc(test, sizeof(*t), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, t);
+
+	/* 1440x2960 @ 60 and @ 120 of the emulator panel */
+	for (i = 0; i < ARRAY_SIZE(t->modes); i++) {
+		t->modes[i].clock = 269280 * (i + 1);
+		t->modes[i].hdisplay = 1440;
+		t->modes[i].htotal = 1440 + 32 + 12 + 16;
+		t->modes[i].vdisplay = 2960;
+		t->modes[i].vtotal = 2960 + 12 + 4 + 16;
+	}
+
+	t->desc.exynos_panel_func = &t->funcs;
+	t->ctx.desc = &t->desc;
+	test->priv = t;
+
+	return 0;
+}
+
+/* the first TE a while back, @offset_us into the current TE period */
+static void rr_switch_test_te_init(struct rr_switch_test_te *te, u32 period_us, u32 offset_us)
+{
+	memset(te, 0, sizeof(*te));
+	te->period_us = period_us;
+	te->irq_delay_us = 30;
+	te->slack_us = 50;
+	te->first_te = ms_to_ktime(1000);
+	te->now = ktime_add_us(te->first_te, 10 * period_us + offset_us);
+}
+
+static void rr_switch_test_check_window(struct kunit *test, const struct rr_switch_test_te *te,
+		u32 left_us)
+{
+	const s64 since_last_te_us = ktime_us_delta(te->now, rr_switch_test_last_te((void *)te));
+
+	KUNIT_EXPECT_GE(test, since_last_te_us, left_us);
+	KUNIT_EXPECT_LE(test, since_last_te_us, te->period_us - USEC_PER_MSEC);
+}
+
+/*
+ * From anywhere in the TE period the switch goes out within the window, at most one TE
+ * later, for each of the emulator refresh rates and window starts.
+ */
+static void rr_switch_test_window(struct kunit *test)
+{
+	static const u32 pcts[] = { 0, 30, 55, 80 };
+	struct rr_switch_test *t = test->priv;
+	struct rr_switch_test_te te;
+	int i, j;
+	u32 offset_us;
+
+	for (i = 0; i < ARRAY_SIZE(t->modes); i++) {
+		const u32 period_us = USEC_PER_SEC / drm_mode_vrefresh(&t->modes[i]);
+
+		for (j = 0; j < ARRAY_SIZE(pcts); j++) {
+			u32 left_us;
+
+			t->funcs.rr_switch_window_pct = pcts[j];
+			left_us = exynos_panel_vsync_start_time_us(&t->ctx, period_us);
+			KUNIT_EXPECT_EQ(test, left_us,
+					period_us * (pcts[j] ? : RR_SWITCH_WINDOW_PCT_DEFAULT) / 100);
+
+			for (offset_us = 0; offset_us < period_us; offset_us += 97) {
+				ktime_t start;
+
+				rr_switch_test_te_init(&te, period_us, offset_us);
+				start = te.now;
+
+				KUNIT_ASSERT_EQ(test, exynos_panel_wait_rr_switch_window(
+						&rr_switch_test_te_source, &te, period_us, left_us), 0);
+				rr_switch_test_check_window(test, &te, left_us);
+				KUNIT_EXPECT_LE(test, te.waits, 1);
+				KUNIT_EXPECT_LE(test, te.sleeps, 1);
+				KUNIT_EXPECT_LE(test, ktime_us_delta(te.now, start),
+						period_us + left_us + te.slack_us);
+			}
+		}
+	}
+}
+
+/* a sleep that runs past the window is caught and the switch moves to the next TE */
+static void rr_switch_test_oversleep(struct kunit *test)
+{
+	struct rr_switch_test *t = test->priv;
+	const u32 period_us = USEC_PER_SEC / drm_mode_vrefresh(&t->modes[1]);
+	const u32 left_us = exynos_panel_vsync_start_time_us(&t->ctx, period_us);
+	struct rr_switch_test_te te;
+
+	/* wakes up past the window but before the next TE */
+	rr_switch_test_te_init(&te, period_us, USEC_PER_MSEC);
+	te.oversleep_us = period_us - USEC_PER_MSEC - left_us + 200;
+
+	KUNIT_EXPECT_EQ(test, exynos_panel_wait_rr_switch_window(&rr_switch_test_te_source, &te,
+			period_us, left_us), 0);
+	rr_switch_test_check_window(test, &te, left_us);
+	KUNIT_EXPECT_EQ(test, te.waits, 1);
+	KUNIT_EXPECT_EQ(test, te.sleeps, 2);
+}
+
+/* with TE gone the wait is bounded and reported instead of blocking the commit */
+static void rr_switch_test_no_te(struct kunit *test)
+{
+	struct rr_switch_test *t = test->priv;
+	const u32 period_us = USEC_PER_SEC / drm_mode_vrefresh(&t->modes[1]);
+	const u32 left_us = exynos_panel_vsync_start_time_us(&t->ctx, period_us);
+	struct rr_switch_test_te te;
+
+	rr_switch_test_te_init(&te, period_us, period_us - 100);
+	te.te_cnt = 11;
+
+	KUNIT_EXPECT_EQ(test, exynos_panel_wait_rr_switch_window(&rr_switch_test_te_source, &te,
+			period_us, left_us), -ETIMEDOUT);
+	KUNIT_EXPECT_EQ(test, te.waits, RR_SWITCH_TE_RETRY_MAX);
+
+	/* never seen a TE at all */
+	rr_switch_test_te_init(&te, period_us, 0);
+	te.first_te = ktime_add_ms(te.now, 1000);
+	KUNIT_EXPECT_EQ(test, exynos_panel_wait_rr_switch_window(&rr_switch_test_te_source, &te,
+			period_us, left_us), 0);
+	KUNIT_EXPECT_GE(test, te.waits, 1);
+}
+
+static struct kunit_case rr_switch_test_cases[] = {
+	KUNIT_CASE(rr_switch_test_window),
+	KUNIT_CASE(rr_switch_test_oversleep),
+	KUNIT_CASE(rr_switch_test_no_te),
+	{}
+};
+
+static struct kunit_suite rr_switch_test_suite = {
+	.name = "exynos-panel-rr-switch",
+	.init = rr_switch_test_init,
+	.test_cases = rr_switch_test_cases,
+};
+
+kunit_test_suites(&panel_idle_test_suite, &rr_switch_test_suite);
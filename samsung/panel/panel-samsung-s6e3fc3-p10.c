@@ -794,6 +794,7 @@ static const struct exynos_panel_funcs s6e3fc3_p10_exynos_funcs = {
 	.configure_te2_edges = exynos_panel_configure_te2_edges,
 	.update_te2 = s6e3fc3_p10_update_te2,
 	.set_op_hz = s6e3fc3_p10_set_op_hz,
+	.rr_switch_window_pct = 55,
 };
 
 const struct brightness_capability s6e3fc3_p10_brightness_capability = {
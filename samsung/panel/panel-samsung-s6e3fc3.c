@@ -601,6 +601,7 @@ static const struct exynos_panel_funcs s6e3fc3_exynos_funcs = {
 	.get_te2_edges = exynos_panel_get_te2_edges,
 	.configure_te2_edges = exynos_panel_configure_te2_edges,
 	.update_te2 = s6e3fc3_update_te2,
+	.rr_switch_window_pct = 55,
 };
 
 const struct brightness_capability s6e3fc3_brightness_capability = {
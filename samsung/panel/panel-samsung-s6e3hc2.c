@@ -1242,6 +1242,7 @@ static const struct exynos_panel_funcs s6e3hc2_exynos_funcs = {
 	.print_gamma = s6e3hc2_print_gamma,
 	.gamma_store = s6e3hc2_overwrite_gamma_data,
 	.restore_native_gamma = s6e3hc2_restore_native_gamma,
+	.rr_switch_window_pct = 55,
 };
 
 const struct brightness_capability s6e3hc2_brightness_capability = {
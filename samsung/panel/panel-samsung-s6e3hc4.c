@@ -232,49 +232,6 @@ static void s6e3hc4_update_te2(struct exynos_panel *ctx)
 	EXYNOS_DCS_BUF_ADD_SET_AND_FLUSH(ctx, lock_cmd_f0);
 }
 
-static inline bool is_auto_mode_allowed(struct exynos_panel *ctx)
-{
-	/* don't want to enable auto mode/early exit during hbm or dimming on */
-	if (IS_HBM_ON(ctx->hbm_mode) || ctx->dimming_on)
-		return false;
-
-	if (ctx->idle_delay_ms) {
-		const unsigned int delta_ms = panel_get_idle_time_delta(ctx);
-
-		if (delta_ms < ctx->idle_delay_ms)
-			return false;
-	}
-
-	return ctx->panel_idle_enabled;
-}
-
-static u32 s6e3hc4_get_min_idle_vrefresh(struct exynos_panel *ctx,
-					const struct exynos_panel_mode *pmode)
-{
-	const int vrefresh = drm_mode_vrefresh(&pmode->mode);
-	int min_idle_vrefresh = ctx->min_vrefresh;
-
-	if ((min_idle_vrefresh < 0) || !is_auto_mode_allowed(ctx))
-		return 0;
-
-	if (min_idle_vrefresh <= 10)
-		min_idle_vrefresh = 10;
-	else if (min_idle_vrefresh <= 30)
-		min_idle_vrefresh = 30;
-	else if (min_idle_vrefresh <= 60)
-		min_idle_vrefresh = 60;
-	else
-		return 0;
-
-	if (min_idle_vrefresh >= vrefresh) {
-		dev_dbg(ctx->dev, "min idle vrefresh (%d) higher than target (%d)\n",
-				min_idle_vrefresh, vrefresh);
-		return 0;
-	}
-
-	return min_idle_vrefresh;
-}
-
 static void s6e3hc4_update_panel_feat(struct exynos_panel *ctx,
 	const struct exynos_panel_mode *pmode, bool enforce)
 {
@@ -509,13 +466,35 @@ static void s6e3hc4_change_frequency(struct exynos_panel *ctx,
 	}
 
 	if (pmode->idle_mode == IDLE_MODE_ON_INACTIVITY)
-		idle_vrefresh = s6e3hc4_get_min_idle_vrefresh(ctx, pmode);
+		idle_vrefresh = exynos_panel_get_idle_vrefresh(ctx, pmode);
 
 	s6e3hc4_update_refresh_mode(ctx, pmode, idle_vrefresh);
 
 	dev_dbg(ctx->dev, "change to %u hz)\n", vrefresh);
 }
 
+/*
+ * Update the target fps for auto mode, or switch to manual mode if idle should be
+ * disabled (idle_vrefresh=0)
+ */
+static bool s6e3hc4_set_idle_step(struct exynos_panel *ctx, u32 idle_vrefresh)
+{
+	const struct exynos_panel_mode *pmode = ctx->current_mode;
+	struct s6e3hc4_panel *spanel = to_spanel(ctx);
+
+	if (unlikely(!pmode) || pmode->exynos_mode.is_lp_mode)
+		return false;
+
+	if (spanel->auto_mode_vrefresh == idle_vrefresh)
+		return false;
+
+	dev_dbg(ctx->dev, "early exit update needed for mode: %s (idle_vrefresh: %u)\n",
+		pmode->mode.name, idle_vrefresh);
+	s6e3hc4_update_refresh_mode(ctx, pmode, idle_vrefresh);
+
+	return true;
+}
+
 static bool s6e3hc4_set_self_refresh(struct exynos_panel *ctx, bool enable)
 {
 	const struct exynos_panel_mode *pmode = ctx->current_mode;
@@ -529,21 +508,12 @@ static bool s6e3hc4_set_self_refresh(struct exynos_panel *ctx, bool enable)
 	if (pmode->exynos_mode.is_lp_mode)
 		return false;
 
-	idle_vrefresh = s6e3hc4_get_min_idle_vrefresh(ctx, pmode);
+	idle_vrefresh = exynos_panel_get_idle_vrefresh(ctx, pmode);
 
 	if (pmode->idle_mode != IDLE_MODE_ON_SELF_REFRESH) {
-		/*
-		 * if idle mode is on inactivity, may need to update the target fps for auto mode,
-		 * or switch to manual mode if idle should be disabled (idle_vrefresh=0)
-		 */
-		if ((pmode->idle_mode == IDLE_MODE_ON_INACTIVITY) &&
-			(spanel->auto_mode_vrefresh != idle_vrefresh)) {
-			dev_dbg(ctx->dev,
-				"early exit update needed for mode: %s (idle_vrefresh: %u)\n",
-				pmode->mode.name, idle_vrefresh);
-			s6e3hc4_update_refresh_mode(ctx, pmode, idle_vrefresh);
-			return true;
-		}
+		/* if idle mode is on inactivity, may need to update the target fps for auto mode */
+		if (pmode->idle_mode == IDLE_MODE_ON_INACTIVITY)
+			return s6e3hc4_set_idle_step(ctx, idle_vrefresh);
 		return false;
 	}
 
@@ -757,6 +727,7 @@ static void s6e3hc4_trigger_early_exit(struct exynos_panel *ctx)
 {
 	const ktime_t delta = ktime_sub(ktime_get(), ctx->last_commit_ts);
 	const s64 delta_us = ktime_to_us(delta);
+	enum exynos_panel_early_exit ee;
 
 	if (delta_us < EARLY_EXIT_THRESHOLD_US) {
 		dev_dbg(ctx->dev, "skip early exit. %lldus since last commit\n",
@@ -764,12 +735,19 @@ static void s6e3hc4_trigger_early_exit(struct exynos_panel *ctx)
 		return;
 	}
 
-	/* triggering early exit causes a switch to 120hz */
-	ctx->last_mode_set_ts = ktime_get();
+	ee = exynos_panel_predict_early_exit(ctx);
+	if (ee == EARLY_EXIT_SKIP) {
+		dev_dbg(ctx->dev, "skip early exit. no frame update\n");
+		return;
+	}
+
+	/* triggering full early exit causes a switch to 120hz */
+	if (ee == EARLY_EXIT_FULL)
+		ctx->last_mode_set_ts = ktime_get();
 
 	DPU_ATRACE_BEGIN(__func__);
 
-	if (ctx->idle_delay_ms) {
+	if (ee == EARLY_EXIT_FULL && ctx->idle_delay_ms) {
 		const struct exynos_panel_mode *pmode = ctx->current_mode;
 
 		dev_dbg(ctx->dev, "%s: disable auto idle mode for: %s\n",
@@ -1096,7 +1074,9 @@ static const struct exynos_panel_funcs s6e3hc4_exynos_funcs = {
 	.commit_done = s6e3hc4_commit_done,
 	.atomic_check = s6e3hc4_atomic_check,
 	.set_self_refresh = s6e3hc4_set_self_refresh,
+	.set_idle_step = s6e3hc4_set_idle_step,
 	.set_op_hz = s6e3hc4_set_op_hz,
+	.rr_switch_window_pct = 55,
 };
 
 const struct brightness_capability s6e3hc4_brightness_capability = {